@@ -28,6 +28,7 @@
 #include "SCXTProcessor.h"
 #include "SCXTPluginEditor.h"
 #include "sst/plugininfra/cpufeatures.h"
+#include "infrastructure/user_defaults.h"
 
 //==============================================================================
 SCXTProcessor::SCXTProcessor()
@@ -139,6 +140,7 @@ bool SCXTProcessor::isBusesLayoutSupported(const BusesLayout &layouts) const
 void SCXTProcessor::processBlock(juce::AudioBuffer<float> &buffer, juce::MidiBuffer &midiMessages)
 {
     auto ftzGuard = sst::plugininfra::cpufeatures::FPUStateGuard();
+    engine->isRenderingOffline = isNonRealtime();
 
     // TODO: TempoSync
     /*
@@ -316,6 +318,24 @@ void SCXTProcessor::setStateInformation(const void *data, int sizeInBytes)
 
     auto xml = std::string(cd);
 
+    if (engine->getMessageController()->isAudioRunning)
+    {
+        // Build the new state next to the playing one and switch over at a block boundary
+        try
+        {
+            auto mode = engine->defaults->getUserDefaultValue(
+                scxt::infrastructure::DefaultKeys::patchSwitchMode,
+                (int)scxt::engine::Engine::PatchSwapMode::CROSSFADE);
+            scxt::json::unstreamEngineStateInBackground(
+                *engine, xml, (scxt::engine::Engine::PatchSwapMode)std::clamp(mode, 0, 2));
+        }
+        catch (std::exception &e)
+        {
+            std::cerr << "Unstream exception " << e.what() << std::endl;
+        }
+        return;
+    }
+
     // TODO obviously fix this by pushing this xml to the serialization thread
     try
     {
@@ -61,6 +61,13 @@ struct HeaderRegion : juce::Component, HasEditor
         g.drawText(vc, getLocalBounds().reduced(3, 1), juce::Justification::centred);
 #endif
 
+        if (sampleLoadTotal > 0 && sampleLoadCompleted < sampleLoadTotal)
+        {
+            auto lp = fmt::format("Loading Samples {} / {}", sampleLoadCompleted, sampleLoadTotal);
+            g.setColour(juce::Colours::white);
+            g.drawText(lp, getLocalBounds().reduced(3, 1), juce::Justification::centred);
+        }
+
         return;
 #if BUILD_IS_DEBUG
         g.fillAll(juce::Colours::red);
@@ -87,6 +94,24 @@ struct HeaderRegion : juce::Component, HasEditor
         }
     }
 
+    int32_t sampleLoadCompleted{0}, sampleLoadTotal{0};
+    void setSampleLoadProgress(int32_t completed, int32_t total)
+    {
+        sampleLoadCompleted = completed;
+        sampleLoadTotal = total;
+        repaint();
+    }
+
+    // -1 when no background patch switch is running
+    int32_t patchSwitchStage{-1};
+    int64_t patchSwitchOverheadBytes{0};
+    void setPatchSwitchStatus(int32_t stage, int64_t overheadBytes)
+    {
+        patchSwitchStage = stage;
+        patchSwitchOverheadBytes = overheadBytes;
+        repaint();
+    }
+
     float vuLevel[2];
     void setVULevel(float L, float R);
 };
@@ -183,6 +183,10 @@ struct SCXTEditor : sst::jucegui::components::WindowPanel,
     void onMixerBusSendData(const scxt::messaging::client::busSendData_t &);
 
     void onBrowserRefresh(const bool);
+    void onSampleLoadProgress(const scxt::messaging::client::sampleLoadProgress_t &);
+    void onSampleResidencyStats(const scxt::messaging::client::sampleResidencyStats_t &);
+    void onPatchSwitchStatus(const scxt::messaging::client::patchSwitchStatus_t &);
+    void onPatchSamplesReady(const scxt::messaging::client::patchSamplesReady_t &);
 
     std::vector<dsp::processor::ProcessorDescription> allProcessors;
     void onAllProcessorDescriptions(const std::vector<dsp::processor::ProcessorDescription> &v)
@@ -225,6 +229,10 @@ struct SCXTEditor : sst::jucegui::components::WindowPanel,
     void addZoomMenu(juce::PopupMenu &into, bool addTitle = true);
     void addUIThemesMenu(juce::PopupMenu &p, bool addTitle = true);
 
+    // Pick a monolith bundle to write the current state to, or to load
+    void chooseMonolith(bool forSave);
+    std::unique_ptr<juce::FileChooser> fileChooser;
+
     std::mutex callbackMutex;
     std::queue<std::string> callbackQueue;
     engine::Engine::EngineStatusMessage engineStatus;
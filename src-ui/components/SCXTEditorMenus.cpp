@@ -37,6 +37,7 @@
 #include "components/AboutScreen.h"
 #include "connectors/SCXTStyleSheetCreator.h"
 #include "infrastructure/user_defaults.h"
+#include "sample/monolith.h"
 
 #include <version.h>
 
@@ -66,6 +67,33 @@ void SCXTEditor::showMainMenu()
     addUIThemesMenu(skin);
     m.addSubMenu("UI Behavior", skin);
 
+    if (headerRegion->sampleLoadCompleted < headerRegion->sampleLoadTotal)
+    {
+        m.addItem("Cancel Sample Loading", [w = juce::Component::SafePointer(this)] {
+            if (w)
+                w->sendToSerialization(cmsg::CancelSampleLoads(true));
+        });
+    }
+
+    m.addItem("Clear Sample Cache", [w = juce::Component::SafePointer(this)] {
+        if (w)
+            w->sendToSerialization(cmsg::ClearSampleCache(true));
+    });
+    m.addItem("Sample Memory...", [w = juce::Component::SafePointer(this)] {
+        if (w)
+            w->sendToSerialization(cmsg::SampleResidencyStats(true));
+    });
+
+    m.addSeparator();
+    m.addItem("Save Monolith...", [w = juce::Component::SafePointer(this)] {
+        if (w)
+            w->chooseMonolith(true);
+    });
+    m.addItem("Load Monolith...", [w = juce::Component::SafePointer(this)] {
+        if (w)
+            w->chooseMonolith(false);
+    });
+
     m.addSeparator();
     m.addItem(juce::String("Copy ") + scxt::build::FullVersionStr,
               [w = juce::Component::SafePointer(this)] {
@@ -87,6 +115,33 @@ void SCXTEditor::showMainMenu()
     m.showMenuAsync(defaultPopupMenuOptions());
 }
 
+void SCXTEditor::chooseMonolith(bool forSave)
+{
+    auto ext = juce::String(sample::MonolithBundle::extension);
+    fileChooser = std::make_unique<juce::FileChooser>(
+        forSave ? "Save Monolith" : "Load Monolith", juce::File(), "*" + ext);
+    auto flags = juce::FileBrowserComponent::canSelectFiles |
+                 (forSave ? juce::FileBrowserComponent::saveMode |
+                                juce::FileBrowserComponent::warnAboutOverwriting
+                          : juce::FileBrowserComponent::openMode);
+    fileChooser->launchAsync(
+        flags, [w = juce::Component::SafePointer(this), forSave, ext](const juce::FileChooser &c) {
+            auto f = c.getResult();
+            if (!w || f == juce::File())
+                return;
+            if (forSave)
+            {
+                if (!f.hasFileExtension(ext))
+                    f = f.withFileExtension(ext);
+                w->sendToSerialization(cmsg::SaveMonolith(f.getFullPathName().toStdString()));
+            }
+            else
+            {
+                w->sendToSerialization(cmsg::LoadMonolith(f.getFullPathName().toStdString()));
+            }
+        });
+}
+
 void SCXTEditor::addTuningMenu(juce::PopupMenu &p, bool addTitle)
 {
     if (addTitle)
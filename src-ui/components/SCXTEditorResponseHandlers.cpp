@@ -283,4 +283,41 @@ void SCXTEditor::onBrowserRefresh(const bool)
     multiScreen->browser->resetRoots();
     mixerScreen->browser->resetRoots();
 }
+
+void SCXTEditor::onSampleLoadProgress(const scxt::messaging::client::sampleLoadProgress_t &p)
+{
+    auto [completed, total, last] = p;
+    headerRegion->setSampleLoadProgress(completed, total);
+}
+
+void SCXTEditor::onPatchSwitchStatus(const scxt::messaging::client::patchSwitchStatus_t &s)
+{
+    auto [stage, completed, total, overheadBytes] = s;
+    if (stage == 0)
+        headerRegion->setSampleLoadProgress(completed, total);
+    headerRegion->setPatchSwitchStatus(stage == 2 ? -1 : stage, overheadBytes);
+}
+
+void SCXTEditor::onPatchSamplesReady(const scxt::messaging::client::patchSamplesReady_t &r)
+{
+    auto [loaded, failed] = r;
+    headerRegion->setSampleLoadProgress(loaded + failed, loaded + failed);
+}
+
+void SCXTEditor::onSampleResidencyStats(const scxt::messaging::client::sampleResidencyStats_t &s)
+{
+    auto [budget, resident, complete, heads, hits, misses, evictions, reloads] = s;
+    auto mb = [](int64_t b) { return juce::String(b / (1024.0 * 1024.0), 1) + " MB"; };
+
+    auto msg = juce::String("Resident sample data: ") + mb(resident) + "\n";
+    msg += juce::String("Budget: ") + (budget > 0 ? mb(budget) : juce::String("None")) + "\n";
+    msg += juce::String("Samples: ") + juce::String(complete) + " complete, " +
+           juce::String(heads) + " preload head only\n";
+    msg += juce::String("Notes: ") + juce::String(hits) + " hits, " + juce::String(misses) +
+           " misses\n";
+    msg += juce::String("Evictions: ") + juce::String(evictions) +
+           ", Reloads: " + juce::String(reloads);
+    juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::InfoIcon, "Sample Memory",
+                                           msg, "OK");
+}
 } // namespace scxt::ui
\ No newline at end of file
@@ -903,7 +903,8 @@ struct SampleWaveform : juce::Component, HasEditor
     SampleWaveform(SampleDisplay *d);
     void paint(juce::Graphics &g) override;
 
-    juce::Path pathForSample();
+    // min/max outline and RMS band of the first channel, one point per pixel
+    void pathsForSample(juce::Path &waveform, juce::Path &rms);
 
     juce::Rectangle<int> startSampleHZ, endSampleHZ, startLoopHZ, endLoopHZ;
     void rebuildHotZones();
@@ -932,7 +933,8 @@ struct SampleDisplay : juce::Component, HasEditor
         startP,
         endP,
         startL,
-        endL
+        endL,
+        fadeL
     };
 
     std::unordered_map<Ctrl, std::unique_ptr<connectors::SamplePointDataAttachment>>
@@ -961,6 +963,10 @@ struct SampleDisplay : juce::Component, HasEditor
         loopDirectionButton->onClick = [this]() { showLoopDirectionMenu(); };
         addAndMakeVisible(*loopDirectionButton);
 
+        interpolationButton = std::make_unique<juce::TextButton>("interpolation");
+        interpolationButton->onClick = [this]() { showInterpolationMenu(); };
+        addAndMakeVisible(*interpolationButton);
+
         auto attachSamplePoint = [this](Ctrl c, const std::string &aLabel, auto &v) {
             auto at = std::make_unique<connectors::SamplePointDataAttachment>(
                 v, [this](const auto &) { onSamplePointChangedFromGUI(); });
@@ -974,6 +980,7 @@ struct SampleDisplay : juce::Component, HasEditor
         attachSamplePoint(endP, "EndS", sampleView[0].endSample);
         attachSamplePoint(startL, "StartS", sampleView[0].startLoop);
         attachSamplePoint(endL, "EndS", sampleView[0].endLoop);
+        attachSamplePoint(fadeL, "Fade", sampleView[0].loopFade);
 
         loopAttachment = std::make_unique<
             connectors::BooleanPayloadDataAttachment<engine::Zone::AssociatedSampleArray>>(
@@ -1041,7 +1048,7 @@ struct SampleDisplay : juce::Component, HasEditor
         playModeButton->setBounds(p);
         p = p.translated(0, 20);
 
-        for (const auto m : {startP, endP, startL, endL})
+        for (const auto m : {startP, endP, startL, endL, fadeL})
         {
             sampleEditors[m]->setBounds(p);
             p = p.translated(0, 20);
@@ -1053,6 +1060,8 @@ struct SampleDisplay : juce::Component, HasEditor
         loopModeButton->setBounds(p);
         p = p.translated(0, 20);
         loopDirectionButton->setBounds(p);
+        p = p.translated(0, 20);
+        interpolationButton->setBounds(p);
     }
 
     bool active{false};
@@ -1064,6 +1073,7 @@ struct SampleDisplay : juce::Component, HasEditor
         loopModeButton->setVisible(b);
         reverseActive->setVisible(b);
         loopDirectionButton->setVisible(b);
+        interpolationButton->setVisible(b);
         for (const auto &[k, p] : sampleEditors)
             p->setVisible(b);
 
@@ -1108,12 +1118,13 @@ struct SampleDisplay : juce::Component, HasEditor
             loopDirectionButton->setButtonText("Loop Alternate");
             break;
         }
+        interpolationButton->setButtonText(interpolationName(sampleView[0].interpolationType));
 
         auto samp = editor->sampleManager.getSample(sampleView[0].sampleID);
         size_t end = 0;
         if (samp)
         {
-            end = samp->getSampleLength();
+            end = samp->getSourceSampleLength();
         }
 
         for (const auto &[k, p] : sampleAttachments)
@@ -1180,7 +1191,48 @@ struct SampleDisplay : juce::Component, HasEditor
         p.showMenuAsync(editor->defaultPopupMenuOptions());
     }
 
-    std::unique_ptr<juce::TextButton> playModeButton, loopModeButton, loopDirectionButton;
+    static std::string interpolationName(engine::Zone::InterpolationType t)
+    {
+        switch (t)
+        {
+        case engine::Zone::ZERO_ORDER_HOLD:
+            return "Zero Order Hold";
+        case engine::Zone::LINEAR:
+            return "Linear";
+        case engine::Zone::HERMITE_CUBIC:
+            return "Hermite Cubic";
+        case engine::Zone::SINC:
+            return "Sinc";
+        case engine::Zone::LONG_SINC:
+            return "Long Sinc (Offline)";
+        }
+        return "Sinc";
+    }
+    void showInterpolationMenu()
+    {
+        juce::PopupMenu p;
+        p.addSectionHeader("Interpolation");
+        p.addSeparator();
+
+        auto add = [&p, this](auto e) {
+            p.addItem(interpolationName(e), true, sampleView[0].interpolationType == e,
+                      [this, e]() {
+                          sampleView[0].interpolationType = e;
+                          onSamplePointChangedFromGUI();
+                          rebuild();
+                      });
+        };
+        add(engine::Zone::InterpolationType::ZERO_ORDER_HOLD);
+        add(engine::Zone::InterpolationType::LINEAR);
+        add(engine::Zone::InterpolationType::HERMITE_CUBIC);
+        add(engine::Zone::InterpolationType::SINC);
+        add(engine::Zone::InterpolationType::LONG_SINC);
+
+        p.showMenuAsync(editor->defaultPopupMenuOptions());
+    }
+
+    std::unique_ptr<juce::TextButton> playModeButton, loopModeButton, loopDirectionButton,
+        interpolationButton;
     engine::Zone::AssociatedSampleArray &sampleView;
     engine::Zone::ZoneMappingData &mappingView;
 };
@@ -1198,7 +1250,7 @@ void SampleWaveform::rebuildHotZones()
         return;
     }
     auto r = getLocalBounds();
-    auto l = samp->getSampleLength();
+    auto l = samp->getSourceSampleLength();
     auto fac = 1.0 * r.getWidth() / l;
     auto start = v.startSample * fac;
     auto end = v.endSample * fac;
@@ -1220,116 +1272,44 @@ int64_t SampleWaveform::sampleForXPixel(float xpos)
     auto r = getLocalBounds();
     auto &v = display->sampleView[0];
     auto samp = editor->sampleManager.getSample(v.sampleID);
-    auto l = samp->getSampleLength();
+    auto l = samp->getSourceSampleLength();
     return (int64_t)std::clamp(1.0 * l * xpos / r.getWidth(), 0.0, l * 1.0);
 }
 
-juce::Path SampleWaveform::pathForSample()
+void SampleWaveform::pathsForSample(juce::Path &waveform, juce::Path &rms)
 {
-    juce::Path res;
-
     auto r = getLocalBounds();
     auto &v = display->sampleView[0];
     auto samp = editor->sampleManager.getSample(v.sampleID);
     if (!samp)
     {
         SCLOG("Null Sample: Null Path");
-        return res;
-    }
-
-    auto l = samp->getSampleLength();
-    std::vector<float> topLine, bottomLine;
-
-    if (samp->bitDepth == sample::Sample::BD_I16)
-    {
-        auto fac = 1.0 * l / r.getWidth();
-        auto d = samp->GetSamplePtrI16(0);
-        double c = 0;
-        int ct = 0;
-        int16_t mx = std::numeric_limits<int16_t>::min();
-        int16_t mn = std::numeric_limits<int16_t>::max();
-
-        for (int s = 0; s < l; ++s)
-        {
-            if (c + fac < s)
-            {
-                double nmx = 1.0 - mx * 1.0 / std::numeric_limits<int16_t>::max();
-                double nmn = 1.0 - mn * 1.0 / std::numeric_limits<int16_t>::max();
-
-                nmx = (nmx + 1) * 0.25;
-                nmn = (nmn + 1) * 0.25;
-
-                topLine.push_back(nmx);
-                bottomLine.push_back(nmn);
-
-                c += fac;
-                ct++;
-                mx = std::numeric_limits<int16_t>::min();
-                mn = std::numeric_limits<int16_t>::max();
-            }
-            mx = std::max(d[s], mx);
-            mn = std::min(d[s], mn);
-        }
-    }
-    else if (samp->bitDepth == sample::Sample::BD_F32)
-    {
-        auto fac = 1.0 * l / r.getWidth();
-        auto d = samp->GetSamplePtrF32(0);
-        double c = 0;
-        int ct = 0;
-
-        float mx = -100.f, mn = 100.f;
-
-        for (int s = 0; s < l; ++s)
-        {
-            if (c + fac < s)
-            {
-                double nmx = 1.0 - mx;
-                double nmn = 1.0 - mn;
-
-                nmx = (nmx + 1) * 0.25;
-                nmn = (nmn + 1) * 0.25;
-
-                topLine.push_back(nmx);
-                bottomLine.push_back(nmn);
-                c += fac;
-                ct++;
-                mx = -100.f;
-                mn = 100.f;
-            }
-            mx = std::max(d[s], mx);
-            mn = std::min(d[s], mn);
-        }
-    }
-    else
-    {
-        jassertfalse;
+        return;
     }
 
-    std::reverse(bottomLine.begin(), bottomLine.end());
-    int index{0};
-    for (auto &l : topLine)
-    {
-        if (index == 0)
-        {
-            res.startNewSubPath(index, l * r.getHeight());
-        }
-        else
-        {
-            res.lineTo(index, l * r.getHeight());
-        }
-        index++;
-    }
+    // The summary makes this a couple of bucket reads per pixel however long the sample is
+    auto summary = samp->getWaveformSummary();
+    auto spans = summary->spansForPixels(*samp, 0, 0, samp->getSampleLength(), r.getWidth());
+    if (spans.empty())
+        return;
 
-    index--;
-    for (auto &l : bottomLine)
-    {
-        res.lineTo(index, l * r.getHeight());
-        index--;
-    }
-    res.closeSubPath();
+    // -1..1 maps onto the middle half of the height
+    auto yFor = [h = r.getHeight()](float val) { return (2.f - val) * 0.25f * h; };
+    auto band = [&spans](juce::Path &p, auto top, auto bottom) {
+        int n = spans.size();
+        p.startNewSubPath(0, top(spans[0]));
+        for (int i = 1; i < n; ++i)
+            p.lineTo(i, top(spans[i]));
+        for (int i = n - 1; i >= 0; --i)
+            p.lineTo(i, bottom(spans[i]));
+        p.closeSubPath();
+    };
 
-    return res;
+    band(
+        waveform, [&](auto &s) { return yFor(s.max); }, [&](auto &s) { return yFor(s.min); });
+    band(
+        rms, [&](auto &s) { return yFor(std::min(s.rms, s.max)); },
+        [&](auto &s) { return yFor(std::max(-s.rms, s.min)); });
 }
 
 void SampleWaveform::mouseDown(const juce::MouseEvent &e)
@@ -1394,10 +1374,11 @@ void SampleWaveform::paint(juce::Graphics &g)
         return;
     }
 
-    auto l = samp->getSampleLength();
+    auto l = samp->getSourceSampleLength();
     auto fac = 1.0 * r.getWidth() / l;
 
-    auto wfp = pathForSample();
+    juce::Path wfp, rmsp;
+    pathsForSample(wfp, rmsp);
     {
         juce::Graphics::ScopedSaveState gs(g);
 
@@ -1408,6 +1389,8 @@ void SampleWaveform::paint(juce::Graphics &g)
         g.fillPath(wfp);
         g.setColour(juce::Colours::white.withAlpha(0.4f));
         g.strokePath(wfp, juce::PathStrokeType(1.f));
+        g.setColour(juce::Colours::white.withAlpha(0.1f));
+        g.fillPath(rmsp);
     }
 
     {
@@ -1423,6 +1406,8 @@ void SampleWaveform::paint(juce::Graphics &g)
 
         g.setColour(juce::Colours::white);
         g.strokePath(wfp, juce::PathStrokeType(1.f));
+        g.setColour(juce::Colours::white.withAlpha(0.3f));
+        g.fillPath(rmsp);
     }
 
     if (v.loopActive)
@@ -1439,6 +1424,8 @@ void SampleWaveform::paint(juce::Graphics &g)
 
         g.setColour(juce::Colours::white);
         g.strokePath(wfp, juce::PathStrokeType(1.f));
+        g.setColour(juce::Colours::white.withAlpha(0.3f));
+        g.fillPath(rmsp);
     }
 
     g.setColour(juce::Colours::white);
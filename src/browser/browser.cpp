@@ -51,7 +51,8 @@ bool Browser::isLoadableFile(const fs::path &p) const
 {
     return extensionMatches(p, ".wav") || extensionMatches(p, ".flac") ||
            extensionMatches(p, ".aif") || extensionMatches(p, ".aiff") ||
-           extensionMatches(p, ".sf2") || extensionMatches(p, ".sfz");
+           extensionMatches(p, ".sf2") || extensionMatches(p, ".sfz") ||
+           extensionMatches(p, ".gig");
 }
 
 void Browser::addRootPathForDeviceView(const fs::path &p)
@@ -0,0 +1,186 @@
+/*
+ * Shortcircuit XT - a Surge Synth Team product
+ *
+ * A fully featured creative sampler, available as a standalone
+ * and plugin for multiple platforms.
+ *
+ * Copyright 2019 - 2023, Various authors, as described in the github
+ * transaction log.
+ *
+ * ShortcircuitXT is released under the Gnu General Public Licence
+ * V3 or later (GPL-3.0-or-later). The license is found in the file
+ * "LICENSE" in the root of this repository or at
+ * https://www.gnu.org/licenses/gpl-3.0.en.html
+ *
+ * Individual sections of code which comprises ShortcircuitXT in this
+ * repository may also be used under an MIT license. Please see the
+ * section  "Licensing" in "README.md" for details.
+ *
+ * ShortcircuitXT is inspired by, and shares code with, the
+ * commercial product Shortcircuit 1 and 2, released by VemberTech
+ * in the mid 2000s. The code for Shortcircuit 2 was opensourced in
+ * 2020 at the outset of this project.
+ *
+ * All source for ShortcircuitXT is available at
+ * https://github.com/surge-synthesizer/shortcircuit-xt
+ */
+
+
+#include "block_mix.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "infrastructure/sse_include.h"
+#include "sst/basic-blocks/mechanics/block-ops.h"
+
+namespace scxt::dsp
+{
+namespace
+{
+namespace scalar
+{
+void accumulate(const float *__restrict srcL, const float *__restrict srcR,
+                float *__restrict dstL, float *__restrict dstR)
+{
+    for (int i = 0; i < blockSize; ++i)
+    {
+        dstL[i] += srcL[i];
+        dstR[i] += srcR[i];
+    }
+}
+
+void scaleAccumulate(const float *__restrict srcL, const float *__restrict srcR, float level,
+                     float *__restrict dstL, float *__restrict dstR)
+{
+    for (int i = 0; i < blockSize; ++i)
+    {
+        dstL[i] += srcL[i] * level;
+        dstR[i] += srcR[i] * level;
+    }
+}
+
+void scale(float level, float *__restrict L, float *__restrict R)
+{
+    for (int i = 0; i < blockSize; ++i)
+    {
+        L[i] *= level;
+        R[i] *= level;
+    }
+}
+
+float absMax(const float *__restrict src)
+{
+    float res{0.f};
+    for (int i = 0; i < blockSize; ++i)
+        res = std::max(res, std::fabs(src[i]));
+    return res;
+}
+} // namespace scalar
+
+namespace sse2
+{
+namespace mech = sst::basic_blocks::mechanics;
+
+void accumulate(const float *__restrict srcL, const float *__restrict srcR,
+                float *__restrict dstL, float *__restrict dstR)
+{
+    mech::accumulate_from_to<blockSize>(srcL, dstL);
+    mech::accumulate_from_to<blockSize>(srcR, dstR);
+}
+
+void scaleAccumulate(const float *__restrict srcL, const float *__restrict srcR, float level,
+                     float *__restrict dstL, float *__restrict dstR)
+{
+    mech::scale_accumulate_from_to<blockSize>(srcL, srcR, level, dstL, dstR);
+}
+
+void scale(float level, float *__restrict L, float *__restrict R)
+{
+    mech::scale_by<blockSize>(level, L, R);
+}
+
+float absMax(const float *__restrict src) { return mech::blockAbsMax<blockSize>(src); }
+} // namespace sse2
+
+#if SCXT_ISA_X86
+namespace avx2
+{
+static_assert(blockSize % 8 == 0);
+
+SCXT_AVX2_TARGET void accumulate(const float *__restrict srcL, const float *__restrict srcR,
+                                 float *__restrict dstL, float *__restrict dstR)
+{
+    for (int i = 0; i < blockSize; i += 8)
+    {
+        _mm256_storeu_ps(dstL + i, _mm256_add_ps(_mm256_loadu_ps(dstL + i),
+                                                 _mm256_loadu_ps(srcL + i)));
+        _mm256_storeu_ps(dstR + i, _mm256_add_ps(_mm256_loadu_ps(dstR + i),
+                                                 _mm256_loadu_ps(srcR + i)));
+    }
+}
+
+SCXT_AVX2_TARGET void scaleAccumulate(const float *__restrict srcL,
+                                      const float *__restrict srcR, float level,
+                                      float *__restrict dstL, float *__restrict dstR)
+{
+    auto lv = _mm256_set1_ps(level);
+    for (int i = 0; i < blockSize; i += 8)
+    {
+        _mm256_storeu_ps(dstL + i, _mm256_add_ps(_mm256_loadu_ps(dstL + i),
+                                                 _mm256_mul_ps(_mm256_loadu_ps(srcL + i), lv)));
+        _mm256_storeu_ps(dstR + i, _mm256_add_ps(_mm256_loadu_ps(dstR + i),
+                                                 _mm256_mul_ps(_mm256_loadu_ps(srcR + i), lv)));
+    }
+}
+
+SCXT_AVX2_TARGET void scale(float level, float *__restrict L, float *__restrict R)
+{
+    auto lv = _mm256_set1_ps(level);
+    for (int i = 0; i < blockSize; i += 8)
+    {
+        _mm256_storeu_ps(L + i, _mm256_mul_ps(_mm256_loadu_ps(L + i), lv));
+        _mm256_storeu_ps(R + i, _mm256_mul_ps(_mm256_loadu_ps(R + i), lv));
+    }
+}
+
+SCXT_AVX2_TARGET float absMax(const float *__restrict src)
+{
+    auto signMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    auto mx = _mm256_setzero_ps();
+    for (int i = 0; i < blockSize; i += 8)
+        mx = _mm256_max_ps(mx, _mm256_and_ps(_mm256_loadu_ps(src + i), signMask));
+    auto m4 = _mm_max_ps(_mm256_castps256_ps128(mx), _mm256_extractf128_ps(mx, 1));
+    m4 = _mm_max_ps(m4, _mm_movehl_ps(m4, m4));
+    m4 = _mm_max_ss(m4, _mm_shuffle_ps(m4, m4, _MM_SHUFFLE(1, 1, 1, 1)));
+    return _mm_cvtss_f32(m4);
+}
+} // namespace avx2
+#endif
+
+const BlockMix scalarMix{scalar::accumulate, scalar::scaleAccumulate, scalar::scale,
+                         scalar::absMax};
+const BlockMix sse2Mix{sse2::accumulate, sse2::scaleAccumulate, sse2::scale, sse2::absMax};
+#if SCXT_ISA_X86
+const BlockMix avx2Mix{avx2::accumulate, avx2::scaleAccumulate, avx2::scale, avx2::absMax};
+#endif
+} // namespace
+
+const BlockMix &blockMix(infrastructure::Isa isa)
+{
+    switch (isa)
+    {
+    case infrastructure::Isa::SCALAR:
+        return scalarMix;
+    case infrastructure::Isa::SSE2:
+        return sse2Mix;
+    case infrastructure::Isa::AVX2:
+#if SCXT_ISA_X86
+        return avx2Mix;
+#else
+        break;
+#endif
+    }
+    return sse2Mix;
+}
+} // namespace scxt::dsp
@@ -0,0 +1,62 @@
+/*
+ * Shortcircuit XT - a Surge Synth Team product
+ *
+ * A fully featured creative sampler, available as a standalone
+ * and plugin for multiple platforms.
+ *
+ * Copyright 2019 - 2023, Various authors, as described in the github
+ * transaction log.
+ *
+ * ShortcircuitXT is released under the Gnu General Public Licence
+ * V3 or later (GPL-3.0-or-later). The license is found in the file
+ * "LICENSE" in the root of this repository or at
+ * https://www.gnu.org/licenses/gpl-3.0.en.html
+ *
+ * Individual sections of code which comprises ShortcircuitXT in this
+ * repository may also be used under an MIT license. Please see the
+ * section  "Licensing" in "README.md" for details.
+ *
+ * ShortcircuitXT is inspired by, and shares code with, the
+ * commercial product Shortcircuit 1 and 2, released by VemberTech
+ * in the mid 2000s. The code for Shortcircuit 2 was opensourced in
+ * 2020 at the outset of this project.
+ *
+ * All source for ShortcircuitXT is available at
+ * https://github.com/surge-synthesizer/shortcircuit-xt
+ */
+
+
+#ifndef SCXT_SRC_DSP_BLOCK_MIX_H
+#define SCXT_SRC_DSP_BLOCK_MIX_H
+
+#include "configuration.h"
+#include "infrastructure/cpu_isa.h"
+
+namespace scxt::dsp
+{
+/*
+ * The stereo block operations which sum voices into zones, zones into groups and
+ * so on up to the main bus, run for every active voice and bus every block. Each
+ * ISA has its own table, and all of them give the same bits: the sums are lane
+ * wise adds and multiplies, with no fused multiply add.
+ *
+ * Every pointer is to blockSize floats; a source and destination may not overlap.
+ */
+struct BlockMix
+{
+    // dst += src
+    void (*accumulate)(const float *__restrict srcL, const float *__restrict srcR,
+                       float *__restrict dstL, float *__restrict dstR);
+    // dst += level * src
+    void (*scaleAccumulate)(const float *__restrict srcL, const float *__restrict srcR,
+                            float level, float *__restrict dstL, float *__restrict dstR);
+    // L, R *= level
+    void (*scale)(float level, float *__restrict L, float *__restrict R);
+    // the largest |x| in src
+    float (*absMax)(const float *__restrict src);
+};
+
+const BlockMix &blockMix(infrastructure::Isa isa = infrastructure::activeIsa());
+} // namespace scxt::dsp
+
+#endif // SHORTCIRCUITXT_BLOCK_MIX_H
@@ -32,4 +32,26 @@ namespace scxt::dsp
 {
 SincTable sincTable;
 DbTable dbTable;
+LongSincTable longSincTable;
+
+LongSincTable::LongSincTable()
+{
+    // Just under Nyquist. The long kernel makes for a far steeper transition than sincTable
+    static constexpr double cutoff{0.95};
+    for (int j = 0; j < phases + 1; ++j)
+    {
+        for (int i = 0; i < taps; ++i)
+        {
+            double t = -double(i) + double(taps / 2) + double(j) / double(phases) - 1.0;
+            double x = cutoff * t;
+            double sinc = std::fabs(x) < 1e-9 ? 1.0 : std::sin(M_PI * x) / (M_PI * x);
+
+            // 4 term Blackman-Harris, across t's span of (-taps / 2, taps / 2)
+            double w = 2.0 * M_PI * (t + taps / 2) / taps;
+            double window = 0.35875 - 0.48829 * std::cos(w) + 0.14128 * std::cos(2 * w) -
+                            0.01168 * std::cos(3 * w);
+            table[j * taps + i] = (float)(cutoff * sinc * window);
+        }
+    }
+}
 } // namespace scxt::dsp
@@ -44,6 +44,20 @@ static_assert(dsp::FIRipol_M == SincTable::FIRipol_M);
 static_assert(dsp::FIRipol_N == SincTable::FIRipol_N);
 static_assert(dsp::FIRipolI16_N == SincTable::FIRipolI16_N);
 
+/*
+ * The long sinc behind the generator's highest interpolation quality: 64 taps (to
+ * sincTable's 16) at 256 sub-sample phases plus a closing phase, Blackman-Harris
+ * windowed. It is laid out like sincTable, with the zero phase centred on tap
+ * taps / 2 - 1, so the two line up sample for sample.
+ */
+struct LongSincTable
+{
+    static constexpr int taps{64}, phases{256};
+    alignas(16) float table[(phases + 1) * taps];
+    LongSincTable();
+};
+extern LongSincTable longSincTable;
+
 using DbTable = sst::basic_blocks::tables::DbToLinearProvider;
 extern DbTable dbTable;
 } // namespace scxt::dsp
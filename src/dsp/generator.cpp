@@ -27,6 +27,8 @@
 
 #include "generator.h"
 #include "infrastructure/sse_include.h"
+#include "infrastructure/half_float.h"
+#include "infrastructure/cpu_isa.h"
 
 #include "resampling.h"
 #include "data_tables.h"
@@ -38,496 +40,592 @@
 #include "utils.h"
 #include <array>
 #include <cassert>
+#include <cmath>
+#include <type_traits>
 
 namespace scxt::dsp
 {
 const float I16InvScale = (1.f / (16384.f * 32768.f));
 const __m128 I16InvScale_m128 = _mm_set1_ps(I16InvScale);
+const float I16UnityScale = 1.f / 32768.f;
 
-template <int compoundConfig>
-void GeneratorSample(GeneratorState *__restrict GD, GeneratorIO *__restrict IO);
+// The tap the sinc table centres on at zero sub-sample phase
+static constexpr int unityTap{FIRipol_N / 2 - 1};
 
-int toLoopValue(bool active, bool forward, bool whileGated, bool isFloat, bool isStereo)
+// The interpolation sits above the 6 bits of the rest, so it counts in 64s
+static constexpr int nLoopValues{(1 << 6) * nGeneratorInterpolations};
+
+int toLoopValue(bool active, bool forward, bool whileGated, GeneratorSampleFormat format,
+                bool isStereo, GeneratorInterpolation interpolation)
 {
-    return ((isStereo * 1) << 4) + ((isFloat * 1) << 3) + ((active * 1) << 2) +
-           ((forward * 1) << 1) + (whileGated * 1);
+    return ((int)interpolation << 6) + ((isStereo * 1) << 5) + ((int)format << 3) +
+           ((active * 1) << 2) + ((forward * 1) << 1) + (whileGated * 1);
 }
 
-constexpr std::array<bool, 5> fromLoopValue(int lv)
+constexpr std::array<bool, 4> fromLoopValue(int lv)
 {
     bool whileGated = (lv & (1 << 0));
     bool forward = (lv & (1 << 1));
     bool active = (lv & (1 << 2));
-    bool isfl = (lv & (1 << 3));
-    bool stereo = (lv & (1 << 4));
-    return {active, forward, whileGated, isfl, stereo};
+    bool stereo = (lv & (1 << 5));
+    return {active, forward, whileGated, stereo};
 }
 
-namespace detail
-{
-using genOp_t = GeneratorFPtr (*)();
-template <size_t I> GeneratorFPtr implGeneratorGetImpl() { return GeneratorSample<I>; }
-
-template <size_t... Is> auto generatorGet(size_t ft, std::index_sequence<Is...>)
+constexpr GeneratorSampleFormat formatFromLoopValue(int lv)
 {
-    constexpr genOp_t fnc[] = {detail::implGeneratorGetImpl<Is>...};
-    return fnc[ft]();
+    return (GeneratorSampleFormat)((lv >> 3) & 3);
 }
-} // namespace detail
 
-GeneratorFPtr GetFPtrGeneratorSample(bool Stereo, bool Float, bool loopActive, bool loopForward,
-                                     bool loopWhileGated)
+constexpr GeneratorInterpolation interpolationFromLoopValue(int lv)
 {
-    auto loopValue = toLoopValue(loopActive, loopForward, loopWhileGated, Float, Stereo);
-    assert(loopValue >= 0 && loopValue < (1 << 5));
-    return detail::generatorGet(loopValue, std::make_index_sequence<(1 << 5) - 1>());
+    return (GeneratorInterpolation)(lv >> 6);
 }
 
-template <int loopValue>
-void GeneratorSample(GeneratorState *__restrict GD, GeneratorIO *__restrict IO)
+inline __m128 loadSamples4(const float *p) { return _mm_loadu_ps(p); }
+inline __m128 loadSamples4(const uint16_t *p) { return infrastructure::halfToFloat4(p); }
+inline float loadSample(const float *p) { return *p; }
+inline float loadSample(const uint16_t *p) { return infrastructure::halfToFloat(*p); }
+inline float loadSample(const int16_t *p) { return *p * I16UnityScale; }
+
+/*
+ * The short kernels, reading around tap unityTap of the same 16 frame window as the
+ * sinc (and so through the loop end buffer when there is one) so that the modes line
+ * up in time. frac is the sub-sample position in [0,1).
+ */
+template <GeneratorInterpolation interpolation, typename T>
+inline float interpolateSample(const T *__restrict p, float frac)
 {
-    static constexpr auto mode = fromLoopValue(loopValue);
-    static constexpr auto loopActive = std::get<0>(mode);
-    static constexpr auto loopForward = std::get<1>(mode);
-    static constexpr auto loopWhileGated = std::get<2>(mode);
-    static constexpr auto fp = std::get<3>(mode);
-    static constexpr auto stereo = std::get<4>(mode);
-
-    int SamplePos = GD->samplePos;
-    int SampleSubPos = GD->sampleSubPos;
-    int IsFinished = GD->isFinished;
-    int WaveSize = IO->waveSize;
-    int LoopOffset = std::max(1, GD->loopUpperBound - GD->loopLowerBound);
-    int Ratio = GD->ratio;
-    int RatioSign = Ratio < 0 ? -1 : 1;
-    Ratio = std::abs(Ratio);
-    int Direction = GD->direction * RatioSign;
-    int16_t *__restrict SampleDataL;
-    int16_t *__restrict SampleDataR;
-    float *__restrict SampleDataFL;
-    float *__restrict SampleDataFR;
-    float *__restrict OutputL;
-    float *__restrict OutputR;
-
-    GD->positionWithinLoop = 0.f;
-    GD->isInLoop = false;
-
-    if (fp)
-        SampleDataFL = (float *)IO->sampleDataL;
+    auto c = p + unityTap;
+    if constexpr (interpolation == GSI_ZERO_ORDER_HOLD)
+    {
+        return loadSample(c);
+    }
+    else if constexpr (interpolation == GSI_LINEAR)
+    {
+        auto x0 = loadSample(c);
+        return x0 + frac * (loadSample(c + 1) - x0);
+    }
     else
-        SampleDataL = (short *)IO->sampleDataL;
-    OutputL = IO->outputL;
-    if (stereo)
     {
-        if (fp)
-            SampleDataFR = (float *)IO->sampleDataR;
-        SampleDataR = (short *)IO->sampleDataR;
-        OutputR = IO->outputR;
+        auto xm1 = loadSample(c - 1), x0 = loadSample(c);
+        auto x1 = loadSample(c + 1), x2 = loadSample(c + 2);
+        auto c1 = 0.5f * (x1 - xm1);
+        auto c2 = xm1 - 2.5f * x0 + 2.f * x1 - 0.5f * x2;
+        auto c3 = 0.5f * (x2 - xm1) + 1.5f * (x0 - x1);
+        return ((c3 * frac + c2) * frac + c1) * frac + x0;
     }
+}
 
-    static constexpr int resampFIRSize{16};
-    int16_t *__restrict readSampleL = nullptr;
-    int16_t *__restrict readSampleR = nullptr;
-    int16_t loopEndBufferL[resampFIRSize], loopEndBufferR[resampFIRSize];
-    float *__restrict readSampleLF32 = nullptr;
-    float *__restrict readSampleRF32 = nullptr;
-    float loopEndBufferLF32[resampFIRSize], loopEndBufferRF32[resampFIRSize];
+/*
+ * The long sinc reaches well outside the 16 frame window, so it reads around the window
+ * start p (in the sample or the loop seam) with bounds: p + lo to p + hi - 1 are there
+ * to read, and anything outside that is silence.
+ */
+template <typename T>
+inline float longSincSample(const T *__restrict p, int subPos, int lo, int hi)
+{
+    static constexpr int taps{LongSincTable::taps};
+    // which puts the kernel's zero phase tap on unityTap, as for the short sinc
+    static constexpr int firstTap{unityTap - (taps / 2 - 1)};
+
+    auto w0 = &longSincTable.table[(subPos >> 16) * taps];
+    auto w1 = w0 + taps;
+    auto frac = (subPos & 0xffff) * (1.f / 65536.f);
+
+    float res{0.f};
+    for (int k = std::max(0, lo - firstTap); k < std::min(taps, hi - firstTap); ++k)
+        res += (w0[k] + frac * (w1[k] - w0[k])) * loadSample(p + firstTap + k);
+    return res;
+}
+
+inline void storeSample(float *p, float v) { *p = v; }
+inline void storeSample(uint16_t *p, float v) { *p = infrastructure::floatToHalf(v); }
+inline void storeSample(int16_t *p, float v)
+{
+    *p = (int16_t)std::clamp(std::lrint(v * 32768.f), -32768L, 32767L);
+}
 
-    if (fp)
+template <typename T>
+void buildLoopSeamChannel(const GeneratorLoopSeam &seam, T *__restrict dest,
+                          const T *__restrict src, int last, int wrapAt, int loopLength, int fade)
+{
+    auto fadeStart = wrapAt - fade;
+    auto fadeScale = 1.f / (fade + 1);
+    auto read = [src, last](int q) { return (q < 0 || q >= last) ? 0.f : loadSample(src + q); };
+    for (int b = 0; b < seam.length; ++b)
     {
-        readSampleLF32 = SampleDataFL + SamplePos;
-        if (stereo)
-            readSampleRF32 = SampleDataFR + SamplePos;
+        auto q = seam.start - GeneratorLoopSeam::lead + b;
+        if (q >= wrapAt)
+            q -= loopLength * ((q - wrapAt) / loopLength + 1);
 
-        if constexpr (loopActive)
+        if (q >= fadeStart)
         {
-            if (SamplePos >= WaveSize - resampFIRSize && SamplePos <= GD->loopUpperBound)
-            {
-                for (int k = 0; k < resampFIRSize; ++k)
-                {
-                    auto q = k + SamplePos;
-                    if (q >= GD->loopUpperBound || q >= WaveSize)
-                        q -= LoopOffset;
-                    loopEndBufferLF32[k] = SampleDataFL[q];
-                    if (stereo)
-                        loopEndBufferRF32[k] = SampleDataFR[q];
-                }
-                readSampleLF32 = loopEndBufferLF32;
-                if (stereo)
-                    readSampleRF32 = loopEndBufferRF32;
-            }
+            auto t = (q - fadeStart + 1) * fadeScale;
+            storeSample(dest + b,
+                        std::sqrt(1.f - t) * read(q) + std::sqrt(t) * read(q - loopLength));
+        }
+        else
+        {
+            // unfaded frames are copied bit for bit
+            dest[b] = (q < 0 || q >= last) ? T{0} : src[q];
         }
     }
+}
+
+// n frames at unity ratio from src (stepping by direction) with no interpolation
+template <typename T>
+inline void unityRun(float *__restrict out, const T *__restrict src, int direction, int n)
+{
+    if (direction > 0)
+    {
+        for (int k = 0; k < n; ++k)
+            out[k] = loadSample(src + k);
+    }
     else
     {
-        readSampleL = SampleDataL + SamplePos;
-        if (stereo)
-            readSampleR = SampleDataR + SamplePos;
+        for (int k = 0; k < n; ++k)
+            out[k] = loadSample(src - k);
+    }
+}
 
-        if constexpr (loopActive)
+/*
+ * The 16 tap sinc, several outputs at a time. Each output's taps are multiplied and
+ * summed four lanes wide, exactly as a lone output would be, and then rather than
+ * reducing each output's four partial sums horizontally we transpose four outputs'
+ * worth so that one vertical add finishes all four. The adds happen in the same
+ * order as the horizontal reduction, so every batch width gives the same bits.
+ *
+ * p[j] is where output j's 16 frame window starts and subPos[j] its phase. Batches
+ * may read up to sincBatchPad entries past n, which we fill.
+ */
+static constexpr int sincBatchPad{8};
+
+inline __m128 sincCoefficients4(unsigned int m0, int k, __m128 lipol)
+{
+    return _mm_add_ps(_mm_mul_ps(*((__m128 *)&sincTable.SincOffsetF32[m0 + 4 * k]), lipol),
+                      *((__m128 *)&sincTable.SincTableF32[m0 + 4 * k]));
+}
+
+inline void transposeAndSum4(__m128 a[4], float *out)
+{
+    _MM_TRANSPOSE4_PS(a[0], a[1], a[2], a[3]);
+    _mm_storeu_ps(out, _mm_add_ps(_mm_add_ps(a[0], a[1]), _mm_add_ps(a[2], a[3])));
+}
+
+template <bool stereo, typename T>
+inline void sinc4(const T *const *pL, const T *const *pR, const int *subPos, float *outL,
+                  float *outR)
+{
+    __m128 sL[4], sR[4];
+    for (int j = 0; j < 4; ++j)
+    {
+        unsigned int m0 = (subPos[j] >> 12) & 0xff0;
+        auto lipol = _mm_set1_ps((float)(subPos[j] & 0xffff));
+        auto c = sincCoefficients4(m0, 0, lipol);
+        sL[j] = _mm_mul_ps(c, loadSamples4(pL[j]));
+        if constexpr (stereo)
+            sR[j] = _mm_mul_ps(c, loadSamples4(pR[j]));
+        for (int k = 1; k < 4; ++k)
         {
-            if (SamplePos >= WaveSize - resampFIRSize && SamplePos <= GD->loopUpperBound)
-            {
-                for (int k = 0; k < resampFIRSize; ++k)
-                {
-                    auto q = k + SamplePos;
-                    if (q >= GD->loopUpperBound || q >= WaveSize)
-                        q -= LoopOffset;
-                    loopEndBufferL[k] = SampleDataL[q];
-                    if (stereo)
-                        loopEndBufferR[k] = SampleDataR[q];
-                }
-                readSampleL = loopEndBufferL;
-                if (stereo)
-                    readSampleR = loopEndBufferR;
-            }
+            c = sincCoefficients4(m0, k, lipol);
+            sL[j] = _mm_add_ps(sL[j], _mm_mul_ps(c, loadSamples4(pL[j] + 4 * k)));
+            if constexpr (stereo)
+                sR[j] = _mm_add_ps(sR[j], _mm_mul_ps(c, loadSamples4(pR[j] + 4 * k)));
         }
     }
+    transposeAndSum4(sL, outL);
+    if constexpr (stereo)
+        transposeAndSum4(sR, outR);
+}
+
+// The int16 sinc sums in 32 bit integers, so its order doesn't matter
+inline __m128i sincCoefficients8(unsigned int m0, int k, __m128i lipol)
+{
+    return _mm_add_epi16(
+        _mm_mulhi_epi16(*((__m128i *)&sincTable.SincOffsetI16[m0 + 8 * k]), lipol),
+        *((__m128i *)&sincTable.SincTableI16[m0 + 8 * k]));
+}
+
+inline void transposeAndSum4(__m128i a[4], float *out)
+{
+    __m128 f[4];
+    for (int j = 0; j < 4; ++j)
+        f[j] = _mm_castsi128_ps(a[j]);
+    _MM_TRANSPOSE4_PS(f[0], f[1], f[2], f[3]);
+    auto s = _mm_add_epi32(_mm_add_epi32(_mm_castps_si128(f[0]), _mm_castps_si128(f[1])),
+                           _mm_add_epi32(_mm_castps_si128(f[2]), _mm_castps_si128(f[3])));
+    _mm_storeu_ps(out, _mm_mul_ps(_mm_cvtepi32_ps(s), I16InvScale_m128));
+}
 
-    int NSamples = GD->blockSize;
+template <bool stereo>
+inline void sinc4(const int16_t *const *pL, const int16_t *const *pR, const int *subPos,
+                  float *outL, float *outR)
+{
+    __m128i sL[4], sR[4];
+    for (int j = 0; j < 4; ++j)
+    {
+        auto lipol = _mm_set1_epi16(subPos[j] & 0xffff);
+        unsigned int m0 = (subPos[j] >> 12) & 0xff0;
+        auto c0 = sincCoefficients8(m0, 0, lipol), c1 = sincCoefficients8(m0, 1, lipol);
+        sL[j] = _mm_add_epi32(_mm_madd_epi16(c0, _mm_loadu_si128((__m128i *)pL[j])),
+                              _mm_madd_epi16(c1, _mm_loadu_si128((__m128i *)(pL[j] + 8))));
+        if constexpr (stereo)
+            sR[j] = _mm_add_epi32(_mm_madd_epi16(c0, _mm_loadu_si128((__m128i *)pR[j])),
+                                  _mm_madd_epi16(c1, _mm_loadu_si128((__m128i *)(pR[j] + 8))));
+    }
+    transposeAndSum4(sL, outL);
+    if constexpr (stereo)
+        transposeAndSum4(sR, outR);
+}
 
-    int i{0};
-    for (i = 0; i < NSamples && !IsFinished; i++)
+// Pad the batch entries from n up to the next multiple of width with the last one
+template <typename T> inline int padSincBatch(T **pL, T **pR, int *subPos, int n, int width)
+{
+    auto padded = (n + width - 1) / width * width;
+    for (int j = n; j < padded; ++j)
     {
-        // 2. Resample
-        unsigned int m0 = ((SampleSubPos >> 12) & 0xff0);
-        if (fp)
+        pL[j] = pL[n - 1];
+        pR[j] = pR[n - 1];
+        subPos[j] = subPos[n - 1];
+    }
+    return padded;
+}
+
+template <bool stereo, typename T>
+inline void sincBatch(T **pL, T **pR, int *subPos, int n, float *outL, float *outR)
+{
+    if (n <= 0)
+        return;
+    auto padded = padSincBatch(pL, pR, subPos, n, 4);
+    float tailL[4], tailR[4];
+    for (int j = 0; j < padded; j += 4)
+    {
+        auto last = j + 4 > n;
+        sinc4<stereo>(pL + j, pR + j, subPos + j, last ? tailL : outL + j,
+                      last ? tailR : outR + j);
+        for (int k = j; last && k < n; ++k)
         {
-            // float32 path (SSE)
-            __m128 lipol0, tmp[4], sL4, sR4;
-            lipol0 = _mm_setzero_ps();
-            lipol0 = _mm_cvtsi32_ss(lipol0, SampleSubPos & 0xffff);
-            lipol0 = _mm_shuffle_ps(lipol0, lipol0, _MM_SHUFFLE(0, 0, 0, 0));
-            tmp[0] = _mm_add_ps(_mm_mul_ps(*((__m128 *)&sincTable.SincOffsetF32[m0]), lipol0),
-                                *((__m128 *)&sincTable.SincTableF32[m0]));
-            tmp[1] = _mm_add_ps(_mm_mul_ps(*((__m128 *)&sincTable.SincOffsetF32[m0 + 4]), lipol0),
-                                *((__m128 *)&sincTable.SincTableF32[m0 + 4]));
-            tmp[2] = _mm_add_ps(_mm_mul_ps(*((__m128 *)&sincTable.SincOffsetF32[m0 + 8]), lipol0),
-                                *((__m128 *)&sincTable.SincTableF32[m0 + 8]));
-            tmp[3] = _mm_add_ps(_mm_mul_ps(*((__m128 *)&sincTable.SincOffsetF32[m0 + 12]), lipol0),
-                                *((__m128 *)&sincTable.SincTableF32[m0 + 12]));
-            sL4 = _mm_mul_ps(tmp[0], _mm_loadu_ps(readSampleLF32));
-            sL4 = _mm_add_ps(sL4, _mm_mul_ps(tmp[1], _mm_loadu_ps(readSampleLF32 + 4)));
-            sL4 = _mm_add_ps(sL4, _mm_mul_ps(tmp[2], _mm_loadu_ps(readSampleLF32 + 8)));
-            sL4 = _mm_add_ps(sL4, _mm_mul_ps(tmp[3], _mm_loadu_ps(readSampleLF32 + 12)));
-            // sL4 = sst::basic_blocks::mechanics::sum_ps_to_ss(sL4);
-            sL4 = _mm_hadd_ps(sL4, sL4);
-            sL4 = _mm_hadd_ps(sL4, sL4);
-
-            _mm_store_ss(&OutputL[i], sL4);
+            outL[k] = tailL[k - j];
             if (stereo)
-            {
-                sR4 = _mm_mul_ps(tmp[0], _mm_loadu_ps(readSampleRF32));
-                sR4 = _mm_add_ps(sR4, _mm_mul_ps(tmp[1], _mm_loadu_ps(readSampleRF32 + 4)));
-                sR4 = _mm_add_ps(sR4, _mm_mul_ps(tmp[2], _mm_loadu_ps(readSampleRF32 + 8)));
-                sR4 = _mm_add_ps(sR4, _mm_mul_ps(tmp[3], _mm_loadu_ps(readSampleRF32 + 12)));
-                // sR4 = sst::basic_blocks::mechanics::sum_ps_to_ss(sR4);
-                sR4 = _mm_hadd_ps(sR4, sR4);
-                sR4 = _mm_hadd_ps(sR4, sR4);
-
-                _mm_store_ss(&OutputR[i], sR4);
-            }
+                outR[k] = tailR[k - j];
         }
-        else
-        {
-            // int16
-            // SSE2 path
-            __m128i lipol0, tmp, sL8A, sR8A, tmp2, sL8B, sR8B;
-            __m128 fL, fR;
-            lipol0 = _mm_set1_epi16(SampleSubPos & 0xffff);
-
-            tmp = _mm_add_epi16(_mm_mulhi_epi16(*((__m128i *)&sincTable.SincOffsetI16[m0]), lipol0),
-                                *((__m128i *)&sincTable.SincTableI16[m0]));
-            sL8A = _mm_madd_epi16(tmp, _mm_loadu_si128((__m128i *)readSampleL));
-            if (stereo)
-                sR8A = _mm_madd_epi16(tmp, _mm_loadu_si128((__m128i *)readSampleR));
-            tmp2 = _mm_add_epi16(
-                _mm_mulhi_epi16(*((__m128i *)&sincTable.SincOffsetI16[m0 + 8]), lipol0),
-                *((__m128i *)&sincTable.SincTableI16[m0 + 8]));
-            sL8B = _mm_madd_epi16(tmp2, _mm_loadu_si128((__m128i *)(readSampleL + 8)));
-            if (stereo)
-                sR8B = _mm_madd_epi16(tmp2, _mm_loadu_si128((__m128i *)(readSampleR + 8)));
-            sL8A = _mm_add_epi32(sL8A, sL8B);
-            if (stereo)
-                sR8A = _mm_add_epi32(sR8A, sR8B);
+    }
+}
 
-            int l alignas(16)[4], r alignas(16)[4];
-            _mm_store_si128((__m128i *)&l, sL8A);
-            if (stereo)
-                _mm_store_si128((__m128i *)&r, sR8A);
-            l[0] = (l[0] + l[1]) + (l[2] + l[3]);
-            if (stereo)
-                r[0] = (r[0] + r[1]) + (r[2] + r[3]);
-            fL = _mm_mul_ss(_mm_cvtsi32_ss(fL, l[0]), I16InvScale_m128);
-            if (stereo)
-                fR = _mm_mul_ss(_mm_cvtsi32_ss(fR, r[0]), I16InvScale_m128);
-            _mm_store_ss(&OutputL[i], fL);
-            if (stereo)
-                _mm_store_ss(&OutputR[i], fR);
+#if SCXT_ISA_X86
+/*
+ * The AVX2 batch is eight outputs: j in the low and j + 4 in the high 128 bits of
+ * each register, running the SSE batch's lanes side by side.
+ */
+template <typename T>
+SCXT_AVX2_TARGET inline __m256 loadSamples8(const T *lo, const T *hi)
+{
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(loadSamples4(lo)), loadSamples4(hi), 1);
+}
 
-#define DEBUG_OUTPUT_MINMAX 0
-#if DEBUG_OUTPUT_MINMAX
-            {
-                // Please don't remove this in some cleanup. It is handly
-                static int printEvery{0};
-                static float mxOut = std::numeric_limits<float>::min();
-                static float mnOut = std::numeric_limits<float>::max();
-
-                mxOut = std::max(OutputL[i], mxOut);
-                mnOut = std::min(OutputL[i], mnOut);
-                if (printEvery == 1000)
-                {
-                    SCLOG("GENERATOR " << SCD(mxOut) << " " << SCD(mnOut));
-                    printEvery = 0;
-                    mxOut = std::numeric_limits<float>::min();
-                    mnOut = std::numeric_limits<float>::max();
-                }
-                printEvery++;
-            }
-#endif
-        }
+SCXT_AVX2_TARGET inline __m256 sincCoefficients4x2(unsigned int m0, unsigned int m4, int k,
+                                                   __m256 lipol)
+{
+    auto offset = _mm256_insertf128_ps(
+        _mm256_castps128_ps256(_mm_load_ps(&sincTable.SincOffsetF32[m0 + 4 * k])),
+        _mm_load_ps(&sincTable.SincOffsetF32[m4 + 4 * k]), 1);
+    auto table = _mm256_insertf128_ps(
+        _mm256_castps128_ps256(_mm_load_ps(&sincTable.SincTableF32[m0 + 4 * k])),
+        _mm_load_ps(&sincTable.SincTableF32[m4 + 4 * k]), 1);
+    return _mm256_add_ps(_mm256_mul_ps(offset, lipol), table);
+}
 
-        // 3. Forward sample position
-        SampleSubPos += Ratio * Direction;
-        int incr = SampleSubPos >> 24;
-        SamplePos += incr;
-        SampleSubPos = SampleSubPos - (incr << 24);
+SCXT_AVX2_TARGET inline void transposeAndSum4x2(__m256 a[4], float *out)
+{
+    auto t0 = _mm256_unpacklo_ps(a[0], a[1]), t1 = _mm256_unpackhi_ps(a[0], a[1]);
+    auto t2 = _mm256_unpacklo_ps(a[2], a[3]), t3 = _mm256_unpackhi_ps(a[2], a[3]);
+    auto r0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+    auto r1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+    auto r2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+    auto r3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+    _mm256_storeu_ps(out, _mm256_add_ps(_mm256_add_ps(r0, r1), _mm256_add_ps(r2, r3)));
+}
 
-        if constexpr (!loopActive) // these constexprs just remind us not to refactor to break ce
+template <bool stereo, typename T>
+SCXT_AVX2_TARGET inline void sinc8(const T *const *pL, const T *const *pR, const int *subPos,
+                                   float *outL, float *outR)
+{
+    __m256 sL[4], sR[4];
+    for (int j = 0; j < 4; ++j)
+    {
+        unsigned int m0 = (subPos[j] >> 12) & 0xff0;
+        unsigned int m4 = (subPos[j + 4] >> 12) & 0xff0;
+        auto lipol = _mm256_insertf128_ps(_mm256_set1_ps((float)(subPos[j] & 0xffff)),
+                                          _mm_set1_ps((float)(subPos[j + 4] & 0xffff)), 1);
+        auto c = sincCoefficients4x2(m0, m4, 0, lipol);
+        sL[j] = _mm256_mul_ps(c, loadSamples8(pL[j], pL[j + 4]));
+        if constexpr (stereo)
+            sR[j] = _mm256_mul_ps(c, loadSamples8(pR[j], pR[j + 4]));
+        for (int k = 1; k < 4; ++k)
         {
-            // No loop, simple case: Play the bounds then done.
-            if (SamplePos > GD->playbackUpperBound)
-            {
-                SamplePos = GD->playbackUpperBound;
-                SampleSubPos = 0;
-                if (GD->direction == 1)
-                    IsFinished = true;
-            }
-            if (SamplePos < GD->playbackLowerBound)
+            c = sincCoefficients4x2(m0, m4, k, lipol);
+            auto l = _mm256_mul_ps(c, loadSamples8(pL[j] + 4 * k, pL[j + 4] + 4 * k));
+            sL[j] = _mm256_add_ps(sL[j], l);
+            if constexpr (stereo)
             {
-                SamplePos = GD->playbackLowerBound;
-                SampleSubPos = 0;
-                if (GD->direction == -1)
-                    IsFinished = true;
-            }
-
-            if constexpr (fp)
-            {
-                readSampleLF32 = SampleDataFL + SamplePos;
-                if (stereo)
-                    readSampleRF32 = SampleDataFR + SamplePos;
-            }
-            else
-            {
-                readSampleL = SampleDataL + SamplePos;
-                if (stereo)
-                    readSampleR = SampleDataR + SamplePos;
+                auto r = _mm256_mul_ps(c, loadSamples8(pR[j] + 4 * k, pR[j + 4] + 4 * k));
+                sR[j] = _mm256_add_ps(sR[j], r);
             }
         }
-        else if constexpr (!loopWhileGated && loopForward)
-        {
-            int offset = SamplePos;
+    }
+    transposeAndSum4x2(sL, outL);
+    if constexpr (stereo)
+        transposeAndSum4x2(sR, outR);
+}
 
-            if (Direction > 0)
-            {
-                // Upper
-                if (offset > GD->loopUpperBound)
-                    offset -= LoopOffset;
-            }
-            else
-            {
-                // Lower
-                if (offset < GD->loopLowerBound)
-                    offset += LoopOffset;
-            }
+SCXT_AVX2_TARGET inline __m256i sincCoefficients8x2(unsigned int m0, unsigned int m4, int k,
+                                                    __m256i lipol)
+{
+    auto offset = _mm256_inserti128_si256(
+        _mm256_castsi128_si256(_mm_load_si128((__m128i *)&sincTable.SincOffsetI16[m0 + 8 * k])),
+        _mm_load_si128((__m128i *)&sincTable.SincOffsetI16[m4 + 8 * k]), 1);
+    auto table = _mm256_inserti128_si256(
+        _mm256_castsi128_si256(_mm_load_si128((__m128i *)&sincTable.SincTableI16[m0 + 8 * k])),
+        _mm_load_si128((__m128i *)&sincTable.SincTableI16[m4 + 8 * k]), 1);
+    return _mm256_add_epi16(_mm256_mulhi_epi16(offset, lipol), table);
+}
 
-            if (offset > WaveSize || offset < 0)
-                offset = GD->loopUpperBound;
+SCXT_AVX2_TARGET inline __m256i loadSamples16x2(const int16_t *lo, const int16_t *hi)
+{
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((__m128i *)lo)),
+                                   _mm_loadu_si128((__m128i *)hi), 1);
+}
 
-            SamplePos = offset;
-        }
-        else if constexpr (!loopWhileGated && !loopForward)
-        {
-            // bidirectional
-            if (SamplePos >= GD->loopUpperBound)
-            {
-                Direction = -1;
-            }
-            else if (SamplePos <= GD->loopLowerBound)
-            {
-                Direction = 1;
-            }
+SCXT_AVX2_TARGET inline void transposeAndSum4x2(__m256i a[4], float *out)
+{
+    auto t0 = _mm256_unpacklo_epi32(a[0], a[1]), t1 = _mm256_unpackhi_epi32(a[0], a[1]);
+    auto t2 = _mm256_unpacklo_epi32(a[2], a[3]), t3 = _mm256_unpackhi_epi32(a[2], a[3]);
+    auto s = _mm256_add_epi32(
+        _mm256_add_epi32(_mm256_unpacklo_epi64(t0, t2), _mm256_unpackhi_epi64(t0, t2)),
+        _mm256_add_epi32(_mm256_unpacklo_epi64(t1, t3), _mm256_unpackhi_epi64(t1, t3)));
+    _mm256_storeu_ps(out,
+                     _mm256_mul_ps(_mm256_cvtepi32_ps(s), _mm256_set1_ps(I16InvScale)));
+}
 
-            SamplePos = std::clamp(SamplePos, 0, WaveSize);
-        }
-        else if constexpr (loopForward)
-        {
-            // gated forward
-            if (GD->gated)
-            {
-                int offset = SamplePos;
-
-                if (Direction > 0)
-                {
-                    if (offset > GD->loopUpperBound)
-                        offset -= LoopOffset;
-                }
-                else
-                {
-                    if (offset < GD->loopLowerBound)
-                        offset += LoopOffset;
-                }
-
-                if (offset > WaveSize || offset < 0)
-                    offset = GD->loopUpperBound;
-
-                SamplePos = offset;
-            }
-            else
-            {
-                if (SamplePos > GD->playbackUpperBound)
-                {
-                    SamplePos = GD->playbackUpperBound;
-                    SampleSubPos = 0;
-                    if (GD->direction == 1)
-                        IsFinished = true;
-                }
-                if (SamplePos < GD->playbackLowerBound)
-                {
-                    SamplePos = GD->playbackLowerBound;
-                    SampleSubPos = 0;
-                    if (GD->direction == -1)
-                        IsFinished = true;
-                }
-            }
-        }
-        else if constexpr (!loopForward && loopWhileGated)
-        {
-            // gated bidirecational
-            if (GD->gated || (GD->direction != GD->directionAtOutset))
-            {
-                if (SamplePos >= GD->loopUpperBound)
-                {
-                    Direction = -1;
-                }
-                else if (SamplePos <= GD->loopLowerBound)
-                {
-                    Direction = 1;
-                }
-
-                SamplePos = std::clamp(SamplePos, 0, WaveSize);
-            }
-            else
-            {
-                // TODO : Careful with releasing a loop while going backwards
-                if (SamplePos > GD->playbackUpperBound)
-                {
-                    SamplePos = GD->playbackUpperBound;
-                    SampleSubPos = 0;
-                    if (GD->direction == 1)
-                        IsFinished = true;
-                }
-                if (SamplePos < GD->playbackLowerBound)
-                {
-                    SamplePos = GD->playbackLowerBound;
-                    SampleSubPos = 0;
-                    if (GD->direction == -1)
-                        IsFinished = true;
-                }
-            }
-        }
+template <bool stereo>
+SCXT_AVX2_TARGET inline void sinc8(const int16_t *const *pL, const int16_t *const *pR,
+                                   const int *subPos, float *outL, float *outR)
+{
+    __m256i sL[4], sR[4];
+    for (int j = 0; j < 4; ++j)
+    {
+        unsigned int m0 = (subPos[j] >> 12) & 0xff0;
+        unsigned int m4 = (subPos[j + 4] >> 12) & 0xff0;
+        auto lipol = _mm256_inserti128_si256(_mm256_set1_epi16(subPos[j] & 0xffff),
+                                             _mm_set1_epi16(subPos[j + 4] & 0xffff), 1);
+        auto c0 = sincCoefficients8x2(m0, m4, 0, lipol);
+        auto c1 = sincCoefficients8x2(m0, m4, 1, lipol);
+        sL[j] = _mm256_add_epi32(_mm256_madd_epi16(c0, loadSamples16x2(pL[j], pL[j + 4])),
+                                 _mm256_madd_epi16(c1, loadSamples16x2(pL[j] + 8, pL[j + 4] + 8)));
+        if constexpr (stereo)
+            sR[j] = _mm256_add_epi32(
+                _mm256_madd_epi16(c0, loadSamples16x2(pR[j], pR[j + 4])),
+                _mm256_madd_epi16(c1, loadSamples16x2(pR[j] + 8, pR[j + 4] + 8)));
+    }
+    transposeAndSum4x2(sL, outL);
+    if constexpr (stereo)
+        transposeAndSum4x2(sR, outR);
+}
 
-        if constexpr (loopActive)
+template <bool stereo, typename T>
+SCXT_AVX2_TARGET inline void sincBatchAVX2(T **pL, T **pR, int *subPos, int n, float *outL,
+                                           float *outR)
+{
+    if (n <= 0)
+        return;
+    auto padded = padSincBatch(pL, pR, subPos, n, 8);
+    float tailL[8], tailR[8];
+    for (int j = 0; j < padded; j += 8)
+    {
+        auto last = j + 8 > n;
+        sinc8<stereo>(pL + j, pR + j, subPos + j, last ? tailL : outL + j,
+                      last ? tailR : outR + j);
+        for (int k = j; last && k < n; ++k)
         {
-            if constexpr (fp)
-            {
-                if (SamplePos >= WaveSize - resampFIRSize && SamplePos <= GD->loopUpperBound)
-                {
-                    for (int k = 0; k < resampFIRSize; ++k)
-                    {
-                        auto q = k + SamplePos;
-                        if (q >= GD->loopUpperBound || q >= WaveSize)
-                            q -= LoopOffset;
-                        loopEndBufferLF32[k] = SampleDataFL[q];
-                        if (stereo)
-                            loopEndBufferRF32[k] = SampleDataFR[q];
-                    }
-                    readSampleLF32 = loopEndBufferLF32;
-                    if (stereo)
-                        readSampleRF32 = loopEndBufferRF32;
-                }
-                else
-                {
-                    readSampleLF32 = SampleDataFL + SamplePos;
-                    if (stereo)
-                        readSampleRF32 = SampleDataFR + SamplePos;
-                }
-            }
-            else
-            {
-                // we need both checks because if we are just doing a post-release playdown
-                // we don't want to re-pad
-                if (SamplePos >= WaveSize - resampFIRSize && SamplePos <= GD->loopUpperBound)
-                {
-                    for (int k = 0; k < resampFIRSize; ++k)
-                    {
-                        auto q = k + SamplePos;
-                        if (q >= GD->loopUpperBound || q >= WaveSize)
-                            q -= LoopOffset;
-                        loopEndBufferL[k] = SampleDataL[q];
-                        if (stereo)
-                            loopEndBufferR[k] = SampleDataR[q];
-                    }
-                    readSampleL = loopEndBufferL;
-                    if (stereo)
-                        readSampleR = loopEndBufferR;
-                }
-                else
-                {
-                    readSampleL = SampleDataL + SamplePos;
-                    if (stereo)
-                        readSampleR = SampleDataR + SamplePos;
-                }
-            }
+            outL[k] = tailL[k - j];
+            if (stereo)
+                outR[k] = tailR[k - j];
         }
     }
+}
+#endif
 
-    // Clean up any items left
-    for (; i < NSamples; ++i)
-    {
-        OutputL[i] = 0.f;
-        if (stereo)
-            OutputR[i] = 0.f;
-    }
+namespace
+{
+struct LoopSeamShape
+{
+    int wrapAt{0}, loopLength{0}, fade{0}, frames{0};
+};
+
+LoopSeamShape loopSeamShape(const GeneratorIO &io, int loopLowerBound, int loopUpperBound,
+                            int fade)
+{
+    // Reads wrap where they always have: at the loop end, or the end of the data if
+    // that comes first
+    LoopSeamShape res;
+    res.loopLength = loopUpperBound - loopLowerBound;
+    res.wrapAt = std::min(loopUpperBound, io.waveSize);
+    if (res.loopLength <= 0 || loopLowerBound < 0 || res.wrapAt <= loopLowerBound)
+        return res;
+
+    // A loop end past the data still wraps there, so positions up to it read from us too
+    // and the two together stay within maxFade, which bounds what a build costs
+    auto overhang = std::max(0, loopUpperBound - res.wrapAt);
+    if (overhang > GeneratorLoopSeam::maxFade)
+        return res;
+    res.fade = std::clamp(fade, 0,
+                          std::min({GeneratorLoopSeam::maxFade - overhang, res.loopLength,
+                                    res.wrapAt - res.loopLength}));
+    res.frames =
+        GeneratorLoopSeam::lead + res.fade + overhang + 2 * GeneratorLoopSeam::margin;
+    return res;
+}
+} // namespace
 
-    GD->direction = Direction * RatioSign;
-    GD->samplePos = SamplePos;
-    GD->sampleSubPos = SampleSubPos;
-    GD->isFinished = IsFinished;
+int GeneratorLoopSeamFrames(const GeneratorIO &io, int loopLowerBound, int loopUpperBound,
+                            int fade)
+{
+    return loopSeamShape(io, loopLowerBound, loopUpperBound, fade).frames;
+}
 
-    if constexpr (loopActive)
+void BuildGeneratorLoopSeam(GeneratorLoopSeam &seam, const GeneratorIO &io,
+                            GeneratorSampleFormat format, bool isStereo, int loopLowerBound,
+                            int loopUpperBound, int fade)
+{
+    auto shape = loopSeamShape(io, loopLowerBound, loopUpperBound, fade);
+    seam.length = 0;
+    if (shape.frames == 0 || !seam.storage[0] || (isStereo && !seam.storage[1]))
+        return;
+
+    auto wrapAt = shape.wrapAt;
+    auto loopLength = shape.loopLength;
+    fade = shape.fade;
+    seam.start = wrapAt - fade - GeneratorLoopSeam::margin;
+    seam.end = loopUpperBound;
+    seam.length = shape.frames;
+
+    auto last = io.waveSize + (int)FIRipol_N;
+    void *src[2]{io.sampleDataL, io.sampleDataR};
+    for (int c = 0; c < (isStereo ? 2 : 1); ++c)
     {
-        if (!loopWhileGated)
+        switch (format)
         {
-            GD->isInLoop = (SamplePos >= GD->loopLowerBound);
-            GD->positionWithinLoop =
-                std::clamp((SamplePos - GD->loopLowerBound) * GD->loopInvertedBounds, 0.f, 1.f);
-        }
-        else
-        {
-            if (GD->gated || (GD->directionAtOutset != GD->direction))
-            {
-                GD->isInLoop = (SamplePos >= GD->loopLowerBound);
-                GD->positionWithinLoop =
-                    std::clamp((SamplePos - GD->loopLowerBound) * GD->loopInvertedBounds, 0.f, 1.f);
-            }
-            else
-            {
-                GD->isInLoop = false;
-                GD->positionWithinLoop =
-                    std::clamp((SamplePos - GD->loopLowerBound) * GD->loopInvertedBounds, 0.f, 1.f);
-            }
+        case GSF_I16:
+            buildLoopSeamChannel(seam, (int16_t *)seam.storage[c], (const int16_t *)src[c], last,
+                                 wrapAt, loopLength, fade);
+            break;
+        case GSF_F32:
+            buildLoopSeamChannel(seam, (float *)seam.storage[c], (const float *)src[c], last,
+                                 wrapAt, loopLength, fade);
+            break;
+        case GSF_F16:
+            buildLoopSeamChannel(seam, (uint16_t *)seam.storage[c], (const uint16_t *)src[c],
+                                 last, wrapAt, loopLength, fade);
+            break;
         }
     }
 }
+
+#define SCXT_GENERATOR_IMPL GeneratorSampleImpl
+#define SCXT_GENERATOR_TARGET
+#define SCXT_GENERATOR_AVX2 0
+#include "generator_impl.h"
+#undef SCXT_GENERATOR_IMPL
+#undef SCXT_GENERATOR_TARGET
+#undef SCXT_GENERATOR_AVX2
+
+#if SCXT_ISA_X86
+#define SCXT_GENERATOR_IMPL GeneratorSampleImplAVX2
+#define SCXT_GENERATOR_TARGET SCXT_AVX2_TARGET
+#define SCXT_GENERATOR_AVX2 1
+#include "generator_impl.h"
+#undef SCXT_GENERATOR_IMPL
+#undef SCXT_GENERATOR_TARGET
+#undef SCXT_GENERATOR_AVX2
+#endif
+
+/*
+ * A voice playing at exactly the stored rate from a whole frame (a sample at the engine
+ * rate at its root key, which is most drum and one shot playback) needs no interpolation,
+ * so each block picks a kernel which just copies or converts. The ratio is fixed for the
+ * block and a unity step leaves the sub-sample position at zero, so the choice holds
+ * until pitch modulation moves the ratio, after which we interpolate again.
+ *
+ * The copy is not bit equal to the sinc at phase zero. That row of the table is a band
+ * limited kernel rather than a delta, so the copy drops its response (a gentle roll off
+ * near Nyquist) and passes the stored frames through unchanged.
+ */
+template <int loopValue>
+void GeneratorSample(GeneratorState *__restrict GD, GeneratorIO *__restrict IO)
+{
+    static constexpr int32_t unityRatio{1 << 24};
+    if (GD->sampleSubPos == 0 && (GD->ratio == unityRatio || GD->ratio == -unityRatio))
+        GeneratorSampleImpl<loopValue, true>(GD, IO);
+    else
+        GeneratorSampleImpl<loopValue, false>(GD, IO);
+}
+
+#if SCXT_ISA_X86
+// The AVX2 variant only differs in the sinc, so unity blocks take the baseline copy
+template <int loopValue>
+void GeneratorSampleAVX2(GeneratorState *__restrict GD, GeneratorIO *__restrict IO)
+{
+    static constexpr int32_t unityRatio{1 << 24};
+    if (GD->sampleSubPos == 0 && (GD->ratio == unityRatio || GD->ratio == -unityRatio))
+        GeneratorSampleImpl<loopValue, true>(GD, IO);
+    else
+        GeneratorSampleImplAVX2<loopValue, false>(GD, IO);
+}
+#endif
+
+namespace detail
+{
+using genOp_t = GeneratorFPtr (*)();
+template <size_t I> GeneratorFPtr implGeneratorGetImpl() { return GeneratorSample<I>; }
+
+template <size_t... Is> auto generatorGet(size_t ft, std::index_sequence<Is...>)
+{
+    constexpr genOp_t fnc[] = {detail::implGeneratorGetImpl<Is>...};
+    return fnc[ft]();
+}
+
+#if SCXT_ISA_X86
+// The sinc loop values are these, and their low 6 bits (stereo, format and loop) index them
+static constexpr int avx2LoopValueBase{GSI_SINC << 6};
+static constexpr int nAVX2LoopValues{1 << 6};
+
+template <size_t I> GeneratorFPtr implGeneratorGetAVX2()
+{
+    return GeneratorSampleAVX2<avx2LoopValueBase + I>;
+}
+
+template <size_t... Is> auto generatorGetAVX2(size_t ft, std::index_sequence<Is...>)
+{
+    constexpr genOp_t fnc[] = {detail::implGeneratorGetAVX2<Is>...};
+    return fnc[ft]();
+}
+#endif
+} // namespace detail
+
+GeneratorFPtr GetFPtrGeneratorSample(bool Stereo, GeneratorSampleFormat format, bool loopActive,
+                                     bool loopForward, bool loopWhileGated,
+                                     GeneratorInterpolation interpolation)
+{
+    auto loopValue =
+        toLoopValue(loopActive, loopForward, loopWhileGated, format, Stereo, interpolation);
+    assert(loopValue >= 0 && loopValue < nLoopValues);
+#if SCXT_ISA_X86
+    if (interpolation == GSI_SINC && infrastructure::activeIsa() == infrastructure::Isa::AVX2)
+    {
+        return detail::generatorGetAVX2(loopValue - detail::avx2LoopValueBase,
+                                        std::make_index_sequence<detail::nAVX2LoopValues>());
+    }
+#endif
+    return detail::generatorGet(loopValue, std::make_index_sequence<nLoopValues>());
+}
 } // namespace scxt::dsp
\ No newline at end of file
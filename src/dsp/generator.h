@@ -47,6 +47,7 @@ struct GeneratorState
     float loopInvertedBounds{1.f}; // 1 / (UB-LB)
     int32_t ratio{1 << 24};        // 1 << 24 is playback-at-tempo
     int16_t blockSize{scxt::blockSize};
+    static constexpr int16_t maxBlockSize{2 * scxt::blockSize}; // oversampled
     bool isFinished{true};
     int32_t sampleStart{0};
     int32_t sampleStop{0};
@@ -58,6 +59,8 @@ struct GeneratorState
     bool isInLoop{false};
 };
 
+struct GeneratorLoopSeam;
+
 struct GeneratorIO
 {
     float *__restrict outputL{nullptr};
@@ -65,12 +68,78 @@ struct GeneratorIO
     void *__restrict sampleDataL{nullptr};
     void *__restrict sampleDataR{nullptr};
     int waveSize{0};
+    // If set, a forward loop reads across its loop end from here
+    const GeneratorLoopSeam *loopSeam{nullptr};
 };
 
+// How the sample data in GeneratorIO is stored. Mirrors sample::Sample::BitDepth
+enum GeneratorSampleFormat
+{
+    GSF_I16,
+    GSF_F32,
+    GSF_F16 // IEEE half, converted to float as we interpolate
+};
+
+// How the generator reads between frames, cheapest first. Mirrors Zone::InterpolationType
+enum GeneratorInterpolation
+{
+    GSI_ZERO_ORDER_HOLD,
+    GSI_LINEAR,
+    GSI_CUBIC,     // 4 point, 3rd order Hermite
+    GSI_SINC,      // the 16 tap windowed sinc from sincTable
+    GSI_LONG_SINC, // the 64 tap windowed sinc from longSincTable, for offline rendering
+    nGeneratorInterpolations
+};
+
+/*
+ * The loop seam. A forward loop's signal around its loop end, wrapped (so reading on
+ * past the loop end reads from the loop start) and with the loop crossfade applied,
+ * laid out contiguously in the sample's format. Windows which start from 'start' up to
+ * the loop end read from here rather than the sample, so the generator crosses the
+ * seam with the same inner loop it uses everywhere else, and the wrap and fade cost
+ * nothing per output frame. A seam is read only once built, so one per sample, loop
+ * and mipmap level can serve every voice playing them (see Zone::LoopSeams).
+ *
+ * Without one the generator builds a bare seam, wrapped but not faded, on the stack
+ * for any block which reaches the loop end, so a loop always wraps cleanly; it can
+ * only do so for a loop end no more than margin frames past the data.
+ *
+ * The crossfade is equal power and over the fade frames before the loop end, where
+ * the frames the same distance before the loop start are faded in, so that the wrap
+ * lands the loop start exactly where the fade was heading. It is limited to the loop
+ * length, the frames in front of the loop and maxFade.
+ *
+ * The seam doesn't own its storage. Ask GeneratorLoopSeamFrames how many frames a
+ * channel needs for the loop and fade and point storage at that much of each.
+ */
+struct GeneratorLoopSeam
+{
+    static constexpr int maxFade{2048};
+    // unfaded frames either side of the fade, enough for the longest kernel's window
+    static constexpr int margin{64};
+    // frames before start, for the long sinc's taps behind its position
+    static constexpr int lead{32};
+    // the most frames a bare seam fills
+    static constexpr int maxBareFrames{lead + 3 * margin};
+
+    int start{0}, end{0}; // the positions (SamplePos) which read from here, inclusive
+    int length{0};        // frames filled, lead included; 0 for no seam
+    // in the sample's format, with position start at element lead of each channel
+    void *storage[2]{nullptr, nullptr};
+};
+
+// The frames per channel a seam for this loop and fade fills; 0 if there is no seam
+int GeneratorLoopSeamFrames(const GeneratorIO &io, int loopLowerBound, int loopUpperBound,
+                            int fade);
+void BuildGeneratorLoopSeam(GeneratorLoopSeam &seam, const GeneratorIO &io,
+                            GeneratorSampleFormat format, bool isStereo, int loopLowerBound,
+                            int loopUpperBound, int fade);
+
 typedef void (*GeneratorFPtr)(GeneratorState *__restrict, GeneratorIO *__restrict);
 // TODO Loop Mode should be an enum
-GeneratorFPtr GetFPtrGeneratorSample(bool isStereo, bool isFloat, bool loopActive, bool loopForward,
-                                     bool loopWhileGated);
+GeneratorFPtr GetFPtrGeneratorSample(bool isStereo, GeneratorSampleFormat format, bool loopActive,
+                                     bool loopForward, bool loopWhileGated,
+                                     GeneratorInterpolation interpolation);
 
 } // namespace scxt::dsp
 #endif // SCXT_SRC_DSP_GENERATOR_H
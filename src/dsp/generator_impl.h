@@ -0,0 +1,485 @@
+/*
+ * Shortcircuit XT - a Surge Synth Team product
+ *
+ * A fully featured creative sampler, available as a standalone
+ * and plugin for multiple platforms.
+ *
+ * Copyright 2019 - 2023, Various authors, as described in the github
+ * transaction log.
+ *
+ * ShortcircuitXT is released under the Gnu General Public Licence
+ * V3 or later (GPL-3.0-or-later). The license is found in the file
+ * "LICENSE" in the root of this repository or at
+ * https://www.gnu.org/licenses/gpl-3.0.en.html
+ *
+ * Individual sections of code which comprises ShortcircuitXT in this
+ * repository may also be used under an MIT license. Please see the
+ * section  "Licensing" in "README.md" for details.
+ *
+ * ShortcircuitXT is inspired by, and shares code with, the
+ * commercial product Shortcircuit 1 and 2, released by VemberTech
+ * in the mid 2000s. The code for Shortcircuit 2 was opensourced in
+ * 2020 at the outset of this project.
+ *
+ * All source for ShortcircuitXT is available at
+ * https://github.com/surge-synthesizer/shortcircuit-xt
+ */
+
+
+/*
+ * The generator's inner loop. generator.cpp includes this once for each instruction set
+ * it compiles the generator for, defining SCXT_GENERATOR_IMPL as the name to give it,
+ * SCXT_GENERATOR_TARGET as its target attribute and SCXT_GENERATOR_AVX2 as whether it
+ * may use 256 bit registers. So there is deliberately no include guard.
+ *
+ * The AVX2 variant is only instantiated for sinc playback, where it filters eight
+ * outputs at a time to the baseline's four.
+ */
+
+template <int loopValue, bool unity>
+SCXT_GENERATOR_TARGET void SCXT_GENERATOR_IMPL(GeneratorState *__restrict GD,
+                                               GeneratorIO *__restrict IO)
+{
+    static constexpr auto mode = fromLoopValue(loopValue);
+    static constexpr auto loopActive = std::get<0>(mode);
+    static constexpr auto loopForward = std::get<1>(mode);
+    static constexpr auto loopWhileGated = std::get<2>(mode);
+    static constexpr auto stereo = std::get<3>(mode);
+    static constexpr auto format = formatFromLoopValue(loopValue);
+    static constexpr auto interpolation = interpolationFromLoopValue(loopValue);
+    // Halves take the float interpolation path, widening as they load
+    static constexpr auto hp = format == GSF_F16;
+    static constexpr auto fp = format == GSF_F32 || hp;
+    using fsample_t = std::conditional_t<hp, uint16_t, float>;
+
+    int SamplePos = GD->samplePos;
+    int SampleSubPos = GD->sampleSubPos;
+    int IsFinished = GD->isFinished;
+    int WaveSize = IO->waveSize;
+    int LoopOffset = std::max(1, GD->loopUpperBound - GD->loopLowerBound);
+    int Ratio = GD->ratio;
+    int RatioSign = Ratio < 0 ? -1 : 1;
+    Ratio = std::abs(Ratio);
+    int Direction = GD->direction * RatioSign;
+    int16_t *__restrict SampleDataL;
+    int16_t *__restrict SampleDataR;
+    fsample_t *__restrict SampleDataFL;
+    fsample_t *__restrict SampleDataFR;
+    float *__restrict OutputL;
+    float *__restrict OutputR;
+
+    GD->positionWithinLoop = 0.f;
+    GD->isInLoop = false;
+
+    if (fp)
+        SampleDataFL = (fsample_t *)IO->sampleDataL;
+    else
+        SampleDataL = (short *)IO->sampleDataL;
+    OutputL = IO->outputL;
+    if (stereo)
+    {
+        if (fp)
+            SampleDataFR = (fsample_t *)IO->sampleDataR;
+        SampleDataR = (short *)IO->sampleDataR;
+        OutputR = IO->outputR;
+    }
+
+    int16_t *__restrict readSampleL = nullptr;
+    int16_t *__restrict readSampleR = nullptr;
+    fsample_t *__restrict readSampleLF = nullptr;
+    fsample_t *__restrict readSampleRF = nullptr;
+    // what of the data around readSample is there to read, for the long sinc
+    int readLo{0}, readHi{0};
+
+    /*
+     * Point readSample at SamplePos. A forward loop reads across its loop end from the
+     * loop seam, or without one from a bare seam we build the first time the block gets
+     * that far; we need the gate check because if we are just doing a post-release
+     * playdown we don't want to wrap.
+     */
+    bool wrapLoop = loopActive && loopForward && (!loopWhileGated || GD->gated);
+    const GeneratorLoopSeam *seam = IO->loopSeam;
+    bool readSeam = wrapLoop && seam && seam->length > 0;
+    bool needBare = wrapLoop && !readSeam;
+    auto bareFrom = std::min(GD->loopUpperBound, WaveSize) - GeneratorLoopSeam::margin;
+    GeneratorLoopSeam bareSeam;
+    using bare_t = std::conditional_t<fp, fsample_t, int16_t>;
+    alignas(16) bare_t bareStorage[2][GeneratorLoopSeam::maxBareFrames];
+    auto seekRead = [&]() {
+        if (needBare && SamplePos >= bareFrom && SamplePos <= GD->loopUpperBound)
+        {
+            needBare = false;
+            auto frames =
+                GeneratorLoopSeamFrames(*IO, GD->loopLowerBound, GD->loopUpperBound, 0);
+            if (frames > 0 && frames <= GeneratorLoopSeam::maxBareFrames)
+            {
+                bareSeam.storage[0] = bareStorage[0];
+                bareSeam.storage[1] = bareStorage[1];
+                BuildGeneratorLoopSeam(bareSeam, *IO, format, stereo, GD->loopLowerBound,
+                                       GD->loopUpperBound, 0);
+                seam = &bareSeam;
+                readSeam = true;
+            }
+        }
+        if (readSeam && SamplePos >= seam->start && SamplePos <= seam->end)
+        {
+            auto b = SamplePos - seam->start + GeneratorLoopSeam::lead;
+            if constexpr (fp)
+            {
+                readSampleLF = (fsample_t *)seam->storage[0] + b;
+                if (stereo)
+                    readSampleRF = (fsample_t *)seam->storage[1] + b;
+            }
+            else
+            {
+                readSampleL = (int16_t *)seam->storage[0] + b;
+                if (stereo)
+                    readSampleR = (int16_t *)seam->storage[1] + b;
+            }
+            readLo = -b;
+            readHi = seam->length - b;
+        }
+        else
+        {
+            if constexpr (fp)
+            {
+                readSampleLF = SampleDataFL + SamplePos;
+                if (stereo)
+                    readSampleRF = SampleDataFR + SamplePos;
+            }
+            else
+            {
+                readSampleL = SampleDataL + SamplePos;
+                if (stereo)
+                    readSampleR = SampleDataR + SamplePos;
+            }
+            readLo = -SamplePos;
+            readHi = WaveSize + (int)FIRipol_N - SamplePos;
+        }
+    };
+    seekRead();
+
+    int NSamples = GD->blockSize;
+    assert(NSamples <= GeneratorState::maxBlockSize);
+
+    /*
+     * The sinc reads from where each output's window starts, at its sub-sample phase,
+     * which the loop below records so that the filter can then run over several
+     * outputs at once (and pad the last batch past the outputs we make).
+     */
+    using batch_t = std::conditional_t<fp, fsample_t, int16_t>;
+    const batch_t *batchL[GeneratorState::maxBlockSize + sincBatchPad];
+    const batch_t *batchR[GeneratorState::maxBlockSize + sincBatchPad];
+    int batchSubPos[GeneratorState::maxBlockSize + sincBatchPad];
+
+    int i{0};
+    for (i = 0; i < NSamples && !IsFinished; i++)
+    {
+        if constexpr (unity && !loopActive)
+        {
+            // 1. Without a loop nothing happens until the next bound, so copy straight up
+            // to it and leave the step below to deal with the bound itself
+            int run = Direction > 0 ? GD->playbackUpperBound - SamplePos
+                                    : SamplePos - GD->playbackLowerBound;
+            run = std::clamp(run, 0, NSamples - i - 1);
+            if (run > 0)
+            {
+                if constexpr (fp)
+                {
+                    unityRun(OutputL + i, readSampleLF + unityTap, Direction, run);
+                    if (stereo)
+                        unityRun(OutputR + i, readSampleRF + unityTap, Direction, run);
+                }
+                else
+                {
+                    unityRun(OutputL + i, readSampleL + unityTap, Direction, run);
+                    if (stereo)
+                        unityRun(OutputR + i, readSampleR + unityTap, Direction, run);
+                }
+                i += run;
+                SamplePos += run * Direction;
+                seekRead();
+            }
+        }
+
+        // 2. Resample
+        auto frac = SampleSubPos * (1.f / (1 << 24));
+        if constexpr (unity)
+        {
+            // readSample points at the loop end buffer when we need it, so this wraps too
+            if constexpr (fp)
+            {
+                OutputL[i] = loadSample(readSampleLF + unityTap);
+                if (stereo)
+                    OutputR[i] = loadSample(readSampleRF + unityTap);
+            }
+            else
+            {
+                OutputL[i] = loadSample(readSampleL + unityTap);
+                if (stereo)
+                    OutputR[i] = loadSample(readSampleR + unityTap);
+            }
+        }
+        else if constexpr (interpolation == GSI_LONG_SINC)
+        {
+            if constexpr (fp)
+            {
+                OutputL[i] = longSincSample(readSampleLF, SampleSubPos, readLo, readHi);
+                if (stereo)
+                    OutputR[i] = longSincSample(readSampleRF, SampleSubPos, readLo, readHi);
+            }
+            else
+            {
+                OutputL[i] = longSincSample(readSampleL, SampleSubPos, readLo, readHi);
+                if (stereo)
+                    OutputR[i] = longSincSample(readSampleR, SampleSubPos, readLo, readHi);
+            }
+        }
+        else if constexpr (interpolation != GSI_SINC)
+        {
+            if constexpr (fp)
+            {
+                OutputL[i] = interpolateSample<interpolation>(readSampleLF, frac);
+                if (stereo)
+                    OutputR[i] = interpolateSample<interpolation>(readSampleRF, frac);
+            }
+            else
+            {
+                OutputL[i] = interpolateSample<interpolation>(readSampleL, frac);
+                if (stereo)
+                    OutputR[i] = interpolateSample<interpolation>(readSampleR, frac);
+            }
+        }
+        else
+        {
+            // The sinc filters in batches once the block's positions are known
+            if constexpr (fp)
+            {
+                batchL[i] = readSampleLF;
+                batchR[i] = stereo ? readSampleRF : readSampleLF;
+            }
+            else
+            {
+                batchL[i] = readSampleL;
+                batchR[i] = stereo ? readSampleR : readSampleL;
+            }
+            batchSubPos[i] = SampleSubPos;
+        }
+
+        // 3. Forward sample position
+        if constexpr (unity)
+        {
+            SamplePos += Direction;
+        }
+        else
+        {
+            SampleSubPos += Ratio * Direction;
+            int incr = SampleSubPos >> 24;
+            SamplePos += incr;
+            SampleSubPos = SampleSubPos - (incr << 24);
+        }
+
+        if constexpr (!loopActive) // these constexprs just remind us not to refactor to break ce
+        {
+            // No loop, simple case: Play the bounds then done.
+            if (SamplePos > GD->playbackUpperBound)
+            {
+                SamplePos = GD->playbackUpperBound;
+                SampleSubPos = 0;
+                if (GD->direction == 1)
+                    IsFinished = true;
+            }
+            if (SamplePos < GD->playbackLowerBound)
+            {
+                SamplePos = GD->playbackLowerBound;
+                SampleSubPos = 0;
+                if (GD->direction == -1)
+                    IsFinished = true;
+            }
+        }
+        else if constexpr (!loopWhileGated && loopForward)
+        {
+            int offset = SamplePos;
+
+            if (Direction > 0)
+            {
+                // Upper
+                if (offset > GD->loopUpperBound)
+                    offset -= LoopOffset;
+            }
+            else
+            {
+                // Lower
+                if (offset < GD->loopLowerBound)
+                    offset += LoopOffset;
+            }
+
+            if (offset > WaveSize || offset < 0)
+                offset = GD->loopUpperBound;
+
+            SamplePos = offset;
+        }
+        else if constexpr (!loopWhileGated && !loopForward)
+        {
+            // bidirectional
+            if (SamplePos >= GD->loopUpperBound)
+            {
+                Direction = -1;
+            }
+            else if (SamplePos <= GD->loopLowerBound)
+            {
+                Direction = 1;
+            }
+
+            SamplePos = std::clamp(SamplePos, 0, WaveSize);
+        }
+        else if constexpr (loopForward)
+        {
+            // gated forward
+            if (GD->gated)
+            {
+                int offset = SamplePos;
+
+                if (Direction > 0)
+                {
+                    if (offset > GD->loopUpperBound)
+                        offset -= LoopOffset;
+                }
+                else
+                {
+                    if (offset < GD->loopLowerBound)
+                        offset += LoopOffset;
+                }
+
+                if (offset > WaveSize || offset < 0)
+                    offset = GD->loopUpperBound;
+
+                SamplePos = offset;
+            }
+            else
+            {
+                if (SamplePos > GD->playbackUpperBound)
+                {
+                    SamplePos = GD->playbackUpperBound;
+                    SampleSubPos = 0;
+                    if (GD->direction == 1)
+                        IsFinished = true;
+                }
+                if (SamplePos < GD->playbackLowerBound)
+                {
+                    SamplePos = GD->playbackLowerBound;
+                    SampleSubPos = 0;
+                    if (GD->direction == -1)
+                        IsFinished = true;
+                }
+            }
+        }
+        else if constexpr (!loopForward && loopWhileGated)
+        {
+            // gated bidirecational
+            if (GD->gated || (GD->direction != GD->directionAtOutset))
+            {
+                if (SamplePos >= GD->loopUpperBound)
+                {
+                    Direction = -1;
+                }
+                else if (SamplePos <= GD->loopLowerBound)
+                {
+                    Direction = 1;
+                }
+
+                SamplePos = std::clamp(SamplePos, 0, WaveSize);
+            }
+            else
+            {
+                // TODO : Careful with releasing a loop while going backwards
+                if (SamplePos > GD->playbackUpperBound)
+                {
+                    SamplePos = GD->playbackUpperBound;
+                    SampleSubPos = 0;
+                    if (GD->direction == 1)
+                        IsFinished = true;
+                }
+                if (SamplePos < GD->playbackLowerBound)
+                {
+                    SamplePos = GD->playbackLowerBound;
+                    SampleSubPos = 0;
+                    if (GD->direction == -1)
+                        IsFinished = true;
+                }
+            }
+        }
+
+        seekRead();
+    }
+
+    if constexpr (interpolation == GSI_SINC && !unity)
+    {
+#if SCXT_GENERATOR_AVX2
+        sincBatchAVX2<stereo>(batchL, batchR, batchSubPos, i, OutputL,
+                              stereo ? OutputR : OutputL);
+#else
+        sincBatch<stereo>(batchL, batchR, batchSubPos, i, OutputL, stereo ? OutputR : OutputL);
+#endif
+
+#define DEBUG_OUTPUT_MINMAX 0
+#if DEBUG_OUTPUT_MINMAX
+        for (int k = 0; k < i; ++k)
+        {
+            // Please don't remove this in some cleanup. It is handly
+            static int printEvery{0};
+            static float mxOut = std::numeric_limits<float>::min();
+            static float mnOut = std::numeric_limits<float>::max();
+
+            mxOut = std::max(OutputL[k], mxOut);
+            mnOut = std::min(OutputL[k], mnOut);
+            if (printEvery == 1000)
+            {
+                SCLOG("GENERATOR " << SCD(mxOut) << " " << SCD(mnOut));
+                printEvery = 0;
+                mxOut = std::numeric_limits<float>::min();
+                mnOut = std::numeric_limits<float>::max();
+            }
+            printEvery++;
+        }
+#endif
+    }
+
+    // Clean up any items left
+    for (; i < NSamples; ++i)
+    {
+        OutputL[i] = 0.f;
+        if (stereo)
+            OutputR[i] = 0.f;
+    }
+
+    GD->direction = Direction * RatioSign;
+    GD->samplePos = SamplePos;
+    GD->sampleSubPos = SampleSubPos;
+    GD->isFinished = IsFinished;
+
+    if constexpr (loopActive)
+    {
+        if (!loopWhileGated)
+        {
+            GD->isInLoop = (SamplePos >= GD->loopLowerBound);
+            GD->positionWithinLoop =
+                std::clamp((SamplePos - GD->loopLowerBound) * GD->loopInvertedBounds, 0.f, 1.f);
+        }
+        else
+        {
+            if (GD->gated || (GD->directionAtOutset != GD->direction))
+            {
+                GD->isInLoop = (SamplePos >= GD->loopLowerBound);
+                GD->positionWithinLoop =
+                    std::clamp((SamplePos - GD->loopLowerBound) * GD->loopInvertedBounds, 0.f, 1.f);
+            }
+            else
+            {
+                GD->isInLoop = false;
+                GD->positionWithinLoop =
+                    std::clamp((SamplePos - GD->loopLowerBound) * GD->loopInvertedBounds, 0.f, 1.f);
+            }
+        }
+    }
+}
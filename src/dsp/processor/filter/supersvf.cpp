@@ -279,6 +279,242 @@ void SuperSVF::process_mono(float *datain, float *dataoutL, float *dataoutR, flo
 
 //-------------------------------------------------------------------------------------------------------
 
+/*
+ * A lone filter runs its left and right first stage in lanes 0 and 1 and, when
+ * four pole, its second stage in lanes 2 and 3. A batch turns each of those lanes
+ * into a register holding one voice per lane. The lanes a lone filter runs on zero
+ * input (the right when mono, the second stage when two pole) we skip while they
+ * are at rest, where all running them would do is settle Reg[2] at one; if they
+ * aren't we run them so they ring out just as they would have.
+ */
+namespace
+{
+// out[k] gets sample k of each of four blocks, one per lane, and back again
+inline void interleaveBlocks(const float *const *in, __m128 *out, int n)
+{
+    for (int k = 0; k < n; k += 4)
+    {
+        auto a = _mm_loadu_ps(in[0] + k), b = _mm_loadu_ps(in[1] + k);
+        auto c = _mm_loadu_ps(in[2] + k), d = _mm_loadu_ps(in[3] + k);
+        _MM_TRANSPOSE4_PS(a, b, c, d);
+        out[k] = a;
+        out[k + 1] = b;
+        out[k + 2] = c;
+        out[k + 3] = d;
+    }
+}
+
+inline void deinterleaveBlocks(const __m128 *in, float *const *out, int n)
+{
+    for (int k = 0; k < n; k += 4)
+    {
+        auto a = in[k], b = in[k + 1], c = in[k + 2], d = in[k + 3];
+        _MM_TRANSPOSE4_PS(a, b, c, d);
+        _mm_storeu_ps(out[0] + k, a);
+        _mm_storeu_ps(out[1] + k, b);
+        _mm_storeu_ps(out[2] + k, c);
+        _mm_storeu_ps(out[3] + k, d);
+    }
+}
+} // namespace
+
+template <bool Stereo, bool FourPole>
+void SuperSVF::ProcessBatchT(SuperSVF *const *f, int n, float *const *inL, float *const *inR,
+                             float *const *outL, float *const *outR)
+{
+    const int Mode = f[0]->iparam[0];
+    for (int v = 0; v < n; ++v)
+    {
+        assert(f[v]->iparam[0] == Mode);
+        assert((f[v]->iparam[1] > 0) == FourPole);
+        f[v]->calc_coeffs();
+    }
+
+    const int bs2 = BLOCK_SIZE << 1;
+    float silence alignas(16)[BLOCK_SIZE]{};
+    float PolyphaseIn alignas(16)[2][maxBatchSize][bs2];
+    const float *vInL[maxBatchSize], *vInR[maxBatchSize];
+    float *vPolyL[maxBatchSize], *vPolyR[maxBatchSize];
+    for (int v = 0; v < maxBatchSize; ++v)
+    {
+        vInL[v] = v < n ? inL[v] : silence;
+        vInR[v] = v < n && Stereo ? inR[v] : silence;
+        vPolyL[v] = PolyphaseIn[0][v];
+        vPolyR[v] = PolyphaseIn[1][v];
+    }
+    __m128 InL[BLOCK_SIZE], InR[BLOCK_SIZE];
+    interleaveBlocks(vInL, InL, BLOCK_SIZE);
+    if (Stereo)
+        interleaveBlocks(vInR, InR, BLOCK_SIZE);
+
+    // A lone filter's coefficients are the same in every lane, so take lane 0 of each
+    auto gatherCoefficient = [&](__m128 SuperSVF::*m) {
+        float r alignas(16)[maxBatchSize]{};
+        for (int v = 0; v < n; ++v)
+            r[v] = _mm_cvtss_f32(f[v]->*m);
+        return _mm_load_ps(r);
+    };
+    auto Freq = gatherCoefficient(&SuperSVF::Freq), dFreq = gatherCoefficient(&SuperSVF::dFreq);
+    auto Q = gatherCoefficient(&SuperSVF::Q), dQ = gatherCoefficient(&SuperSVF::dQ);
+    auto ClipDamp = gatherCoefficient(&SuperSVF::ClipDamp);
+    auto dClipDamp = gatherCoefficient(&SuperSVF::dClipDamp);
+    auto Gain = gatherCoefficient(&SuperSVF::Gain), dGain = gatherCoefficient(&SuperSVF::dGain);
+
+    // The state goes from a register per filter to a register per lane and back
+    auto gatherState = [&](auto member, __m128 *to) {
+        for (int v = 0; v < maxBatchSize; ++v)
+            to[v] = v < n ? member(*f[v]) : _mm_setzero_ps();
+        _MM_TRANSPOSE4_PS(to[0], to[1], to[2], to[3]);
+    };
+    auto scatterState = [&](auto member, __m128 *from) {
+        _MM_TRANSPOSE4_PS(from[0], from[1], from[2], from[3]);
+        for (int v = 0; v < n; ++v)
+            member(*f[v]) = from[v];
+    };
+    auto reg = [](int r) { return [r](SuperSVF &s) -> __m128 & { return s.Reg[r]; }; };
+    auto lastOutput = [](SuperSVF &s) -> __m128 & { return s.LastOutput; };
+
+    __m128 Reg[3][4], LastOutput[4];
+    for (int r = 0; r < 3; ++r)
+        gatherState(reg(r), Reg[r]);
+    gatherState(lastOutput, LastOutput);
+
+    bool run[4];
+    for (int l = 0; l < 4; ++l)
+    {
+        // Bitwise, since a -0 wouldn't stay put
+        auto state = _mm_castps_si128(_mm_or_ps(_mm_or_ps(Reg[0][l], Reg[1][l]), LastOutput[l]));
+        run[l] = _mm_movemask_epi8(_mm_cmpeq_epi32(state, _mm_setzero_si128())) != 0xffff;
+    }
+    run[0] = true;
+    run[1] = run[1] || Stereo;
+    run[2] = run[2] || FourPole;
+    run[3] = run[3] || (FourPole && run[1]);
+
+    const __m128 m01 = _mm_set1_ps(0.1f);
+    const __m128 m1 = _mm_set1_ps(1.0f);
+
+    // process_internal, lane by lane
+    auto step = [&](const __m128 *x, __m128 *out) {
+        Freq = _mm_add_ps(Freq, dFreq);
+        Q = _mm_add_ps(Q, dQ);
+        ClipDamp = _mm_add_ps(ClipDamp, dClipDamp);
+
+        for (int l = 0; l < 4; ++l)
+        {
+            if (!run[l])
+                continue;
+            __m128 L = _mm_add_ps(Reg[1][l], _mm_mul_ps(Freq, Reg[0][l]));
+            __m128 H = _mm_sub_ps(_mm_sub_ps(x[l], L), _mm_mul_ps(Q, Reg[0][l]));
+            __m128 B = _mm_add_ps(Reg[0][l], _mm_mul_ps(Freq, H));
+
+            __m128 L2 = _mm_add_ps(L, _mm_mul_ps(Freq, B));
+            __m128 H2 = _mm_sub_ps(_mm_sub_ps(x[l], L2), _mm_mul_ps(Q, B));
+            __m128 B2 = _mm_add_ps(B, _mm_mul_ps(Freq, H2));
+
+            Reg[0][l] = _mm_mul_ps(B2, Reg[2][l]);
+            Reg[1][l] = _mm_mul_ps(L2, Reg[2][l]);
+            Reg[2][l] = _mm_max_ps(m01, _mm_sub_ps(m1, _mm_mul_ps(ClipDamp, _mm_mul_ps(B2, B2))));
+
+            out[l] = Mode == ssvf_LP ? L2 : (Mode == ssvf_BP ? B2 : H2);
+        }
+
+        Gain = _mm_add_ps(Gain, dGain);
+        for (int l = 0; l < 4; ++l)
+            if (run[l])
+                out[l] = _mm_mul_ps(out[l], Gain);
+    };
+
+    constexpr int outLane = FourPole ? 2 : 0;
+    __m128 PolyL[bs2], PolyR[bs2];
+    __m128 Input[4], MiddleOutput[4];
+    for (int l = 0; l < 4; ++l)
+    {
+        Input[l] = _mm_setzero_ps();
+        MiddleOutput[l] = _mm_setzero_ps();
+    }
+    for (int k = 0; k < BLOCK_SIZE; k++)
+    {
+        Input[0] = InL[k];
+        if (Stereo)
+            Input[1] = InR[k];
+
+        if (FourPole)
+        {
+            Input[2] = LastOutput[0];
+            Input[3] = LastOutput[1];
+            step(Input, MiddleOutput);
+            Input[2] = MiddleOutput[0];
+            Input[3] = MiddleOutput[1];
+            step(Input, LastOutput);
+        }
+        else
+        {
+            step(Input, MiddleOutput);
+            step(Input, LastOutput);
+        }
+
+        PolyL[k << 1] = MiddleOutput[outLane];
+        PolyL[(k << 1) + 1] = LastOutput[outLane];
+        if (Stereo)
+        {
+            PolyR[k << 1] = MiddleOutput[outLane + 1];
+            PolyR[(k << 1) + 1] = LastOutput[outLane + 1];
+        }
+    }
+
+    deinterleaveBlocks(PolyL, vPolyL, bs2);
+    if (Stereo)
+        deinterleaveBlocks(PolyR, vPolyR, bs2);
+
+    for (int v = 0; v < n; ++v)
+        f[v]->mPolyphase.process_block_D2(vPolyL[v], Stereo ? vPolyR[v] : vPolyL[v], bs2,
+                                          outL[v], Stereo ? outR[v] : vPolyR[v]);
+
+    // The lanes we skipped would have settled Reg[2] at one
+    for (int l = 0; l < 4; ++l)
+        if (!run[l])
+            Reg[2][l] = m1;
+    for (int r = 0; r < 3; ++r)
+        scatterState(reg(r), Reg[r]);
+    scatterState(lastOutput, LastOutput);
+
+    float c alignas(16)[4][maxBatchSize];
+    _mm_store_ps(c[0], Freq);
+    _mm_store_ps(c[1], Q);
+    _mm_store_ps(c[2], ClipDamp);
+    _mm_store_ps(c[3], Gain);
+    for (int v = 0; v < n; ++v)
+    {
+        f[v]->Freq = _mm_set1_ps(c[0][v]);
+        f[v]->Q = _mm_set1_ps(c[1][v]);
+        f[v]->ClipDamp = _mm_set1_ps(c[2][v]);
+        f[v]->Gain = _mm_set1_ps(c[3][v]);
+    }
+}
+
+void SuperSVF::processBatch(SuperSVF *const *filters, int n, bool stereo, float *const *inL,
+                            float *const *inR, float *const *outL, float *const *outR)
+{
+    assert(n > 0 && n <= maxBatchSize);
+    if (stereo)
+    {
+        if (filters[0]->iparam[1] > 0)
+            ProcessBatchT<true, true>(filters, n, inL, inR, outL, outR);
+        else
+            ProcessBatchT<true, false>(filters, n, inL, inR, outL, outR);
+    }
+    else
+    {
+        if (filters[0]->iparam[1] > 0)
+            ProcessBatchT<false, true>(filters, n, inL, inR, outL, outR);
+        else
+            ProcessBatchT<false, false>(filters, n, inL, inR, outL, outR);
+    }
+}
+
+//-------------------------------------------------------------------------------------------------------
+
 void SuperSVF::suspend()
 {
     Reg[0] = _mm_setzero_ps();
@@ -46,6 +46,10 @@ struct alignas(16) SuperSVF : public Processor
 
     inline __m128 process_internal(__m128 x, int Mode);
 
+    template <bool Stereo, bool FourPole>
+    static void ProcessBatchT(SuperSVF *const *filters, int n, float *const *inL,
+                              float *const *inR, float *const *outL, float *const *outR);
+
   public:
     static constexpr bool isZoneProcessor{true};
     static constexpr bool isPartProcessor{true};
@@ -63,6 +67,18 @@ struct alignas(16) SuperSVF : public Processor
     template <bool Stereo, bool FourPole>
     void ProcessT(float *datainL, float *datainR, float *dataoutL, float *dataoutR, float pitch);
 
+    /*
+     * Voices playing the same filter can run it together, one voice per lane, which
+     * fills the lanes a lone two pole or mono filter leaves idle. Filters with the
+     * same batchKey can share a batch, and each gets the bits its own process_stereo
+     * or process_mono would have given it.
+     */
+    static constexpr int maxBatchSize{4};
+    static constexpr int nBatchKeys{3 * 2 * 2};
+    int batchKey(bool stereo) const { return (iparam[0] * 2 + (iparam[1] > 0)) * 2 + stereo; }
+    static void processBatch(SuperSVF *const *filters, int n, bool stereo, float *const *inL,
+                             float *const *inR, float *const *outL, float *const *outR);
+
     void init_params() override;
     void suspend() override;
     void calc_coeffs();
@@ -273,6 +273,8 @@ struct Processor : MoveableOnly<Processor>, SampleRateSupport
     // move these back to protected and friend the adapter when done
     // protected:
     engine::MemoryPool *memoryPool{nullptr};
+    // The pool had no block for us at some point. Whoever spawned us should drop us
+    bool memoryPoolFailed{false};
     float *param{nullptr};
     int *iparam{nullptr};
     float lastparam[maxProcessorFloatParams];
@@ -43,7 +43,10 @@ struct SCXTVFXConfig
 
     static uint8_t *checkoutBlock(BaseClass *b, size_t s)
     {
-        return b->memoryPool->checkoutBlock(s);
+        auto res = b->memoryPool->checkoutBlock(s);
+        if (!res)
+            b->memoryPoolFailed = true;
+        return res;
     }
 
     static void returnBlock(BaseClass *b, uint8_t *d, size_t s)
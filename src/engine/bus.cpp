@@ -34,7 +34,7 @@
 
 #include "infrastructure/sse_include.h"
 
-#include "dsp/data_tables.h"
+#include "dsp/block_mix.h"
 #include "tuning/equal.h"
 
 #include "sst/effects/EffectCore.h"
@@ -45,13 +45,10 @@
 #include "sst/effects/Bonsai.h"
 #include "sst/effects/EffectCoreDetails.h"
 
-#include "sst/basic-blocks/mechanics/block-ops.h"
 #include "sst/basic-blocks/dsp/PanLaws.h"
 
 #include "messaging/messaging.h"
 
-namespace mech = sst::basic_blocks::mechanics;
-
 namespace scxt::engine
 {
 namespace dtl
@@ -197,6 +194,8 @@ void Bus::initializeAfterUnstream(Engine &e)
 }
 void Bus::process()
 {
+    const auto &mix = dsp::blockMix();
+
     if (busSendStorage.supportsSends && busSendStorage.hasSends &&
         busSendStorage.auxLocation == BusSendStorage::PRE_FX)
         memcpy(auxoutput, output, sizeof(output));
@@ -236,7 +235,7 @@ void Bus::process()
     if (busSendStorage.level != 1.f)
     {
         auto lv = busSendStorage.level * busSendStorage.level * busSendStorage.level;
-        mech::scale_by<blockSize>(lv, output[0], output[1]);
+        mix.scale(lv, output[0], output[1]);
     }
 
     if (busSendStorage.supportsSends && busSendStorage.hasSends &&
@@ -248,7 +247,7 @@ void Bus::process()
     for (int c = 0; c < 2; ++c)
     {
         vuLevel[c] = std::min(2.f, a * vuLevel[c]);
-        vuLevel[c] = std::max((float)vuLevel[c], mech::blockAbsMax<BLOCK_SIZE>(output[c]));
+        vuLevel[c] = std::max((float)vuLevel[c], mix.absMax(output[c]));
     }
 }
 
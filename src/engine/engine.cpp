@@ -48,7 +48,10 @@
 #include "SF.h"
 
 #include <version.h>
+#include <algorithm>
+#include <cmath>
 #include <filesystem>
+#include <map>
 #include <mutex>
 namespace scxt::engine
 {
@@ -65,6 +68,7 @@ Engine::Engine()
     tuning::equalTuning.init();
 
     sampleManager = std::make_unique<sample::SampleManager>(messageController->threadingChecker);
+    sampleManager->restoreProgressCallback = makeSampleLoadProgressReporter();
     patch = std::make_unique<Patch>();
     patch->parentEngine = this;
 
@@ -83,6 +87,39 @@ Engine::Engine()
         [](auto e) { return scxt::infrastructure::defaultKeyToString(e); },
         [](auto em, auto t) { SCLOG("Defaults Parse Error :" << em << " " << t << std::endl); });
 
+    // The decoded sample cache size, off (0) by default since it writes decoded audio to disk
+    auto cacheMB = defaults->getUserDefaultValue(infrastructure::sampleCacheSizeMB, 0);
+    if (cacheMB > 0)
+    {
+        sampleManager->setSampleCache(std::make_unique<sample::SampleCache>(
+            docpath / "SampleCache", (size_t)cacheMB * 1024 * 1024));
+    }
+
+    // Half float storage for 24 bit and float material. Off by default since it is lossy
+    sampleManager->setStoreFloatAsF16(
+        defaults->getUserDefaultValue(infrastructure::storeFloatSamplesAsF16, 0) != 0);
+
+    // Off by default since the levels cost a little under the sample's own size again
+    sampleManager->setBuildMipmaps(
+        defaults->getUserDefaultValue(infrastructure::buildOctaveMipmaps, 0) != 0);
+
+    // 0 keeps every sample fully resident
+    auto budgetMB = defaults->getUserDefaultValue(infrastructure::sampleMemoryBudgetMB, 0);
+    if (budgetMB > 0)
+        sampleManager->setMemoryBudget((size_t)budgetMB * 1024 * 1024);
+
+    // Off by default; the target rate is set once we know the engine rate
+    convertSamplesToEngineRate =
+        defaults->getUserDefaultValue(infrastructure::convertSamplesToEngineRate, 0) != 0;
+
+    // Off by default; a patch only reports loaded once its samples are playable
+    if (defaults->getUserDefaultValue(infrastructure::lazySampleLoading, 0) != 0)
+    {
+        sampleManager->lazyRestoreHandler = [this](auto &&requests, auto generation) {
+            restoreSamplesLazily(std::move(requests), generation);
+        };
+    }
+
     browserDb = std::make_unique<browser::BrowserDB>(docpath);
     browser = std::make_unique<browser::Browser>(*browserDb, *defaults);
 
@@ -95,6 +132,10 @@ Engine::Engine()
     selectionManager = std::make_unique<selection::SelectionManager>(*this);
 
     memoryPool = std::make_unique<MemoryPool>();
+    // Start with room for the smaller effect states of a few voices; the patch's own
+    // processors are added for as it is set up (see reserveProcessorMemory)
+    for (size_t sc = 0; MemoryPool::sizeClassBytes(sc) <= 64 * 1024; ++sc)
+        memoryPool->reserve(MemoryPool::sizeClassBytes(sc), 8);
 
     voice::Voice::ahdsrenv_t::initializeLuts();
 
@@ -113,7 +154,14 @@ Engine::~Engine()
             v = nullptr;
         }
     }
+    // The loader calls back into the message controller so has to go first
+    sampleManager->getLoader().stop();
     messageController->stop();
+
+    // Group processors hand their blocks back to the memory pool, which is declared
+    // after the patch and so would otherwise be gone first
+    retiringPatch.reset();
+    patch.reset();
 }
 
 voice::Voice *Engine::initiateVoice(const pathToZone_t &path)
@@ -232,6 +280,8 @@ bool Engine::processAudio()
     }
 
     getPatch()->process(*this);
+    if (retiringPatch)
+        processRetiringPatch();
 
     auto &bl = sharedUIMemoryState.busVULevels;
     const auto &bs = getPatch()->busses;
@@ -266,13 +316,19 @@ bool Engine::processAudio()
         {
             auto &itm = sharedUIMemoryState.voiceDisplayItems[i];
 
-            if (v && (v->isVoiceAssigned && v->isVoicePlaying))
+            // A voice still ringing in a switched out patch has no address in this one
+            if (v && (v->isVoiceAssigned && v->isVoicePlaying) &&
+                (!retiringPatch || !isVoiceInPatch(v, retiringPatch.get())))
             {
                 itm.active = true;
                 itm.part = v->zonePath.part;
                 itm.group = v->zonePath.group;
                 itm.zone = v->zonePath.zone;
-                itm.samplePos = v->GD.samplePos;
+                // in file frames, as the zone's positions are
+                itm.samplePos = (int64_t)v->GD.samplePos * (1 << v->generatorLevel);
+                auto ps = v->playingSample;
+                if (ps && ps->isRateConverted())
+                    itm.samplePos = (int64_t)(itm.samplePos / ps->getPositionScale());
                 itm.midiNote = v->originalMidiKey;
                 itm.midiChannel = v->channel;
                 itm.gated = v->isGated;
@@ -302,9 +358,36 @@ void Engine::noteOn(int16_t channel, int16_t key, int32_t noteId, int32_t veloci
         if (!z->samplePointers[0])
         {
             // SCLOG( "Skipping voice with missing sample data" );
+            // If it is still loading, this gets it loaded sooner
+            if (z->sampleData[0].sampleID.isValid())
+            {
+                sampleManager->noteResidencyMiss();
+                if (!z->sampleWantedSent)
+                {
+                    z->sampleWantedSent = true;
+                    messaging::audio::sendSampleWanted(z->sampleData[0].sampleID,
+                                                       *messageController);
+                }
+            }
         }
         else
         {
+            // An evicted sample plays its head while the rest comes back
+            if (z->samplePointers[0]->isResidencyHead())
+            {
+                sampleManager->noteResidencyMiss();
+                if (!z->sampleWantedSent)
+                {
+                    z->sampleWantedSent = true;
+                    messaging::audio::sendSampleWanted(z->sampleData[0].sampleID,
+                                                       *messageController);
+                }
+            }
+            else
+            {
+                sampleManager->noteResidencyHit();
+            }
+
             auto v = initiateVoice(path);
             if (v)
             {
@@ -434,25 +517,58 @@ void Engine::loadSampleIntoSelectedPartAndGroup(const fs::path &p, int16_t rootK
     // If you add a type here add it to Browser::isLoadableFile also
     if (extensionMatches(p, ".sf2"))
     {
-        // TODO ok this refresh and restart is a bit unsatisfactory
-        messageController->stopAudioThreadThenRunOnSerial([this, p](const auto &) {
-            loadSf2MultiSampleIntoSelectedPart(p);
-            messageController->restartAudioThreadFromSerial();
-            serializationSendToClient(messaging::client::s2c_send_pgz_structure,
-                                      getPartGroupZoneStructure(-1), *messageController);
-        });
+        // As with sfz below, pull the sample data in on the loader first
+        loadSamplesInBackground(
+            findSf2SampleAddresses(p), [p](auto &e, const auto &, auto cancelled) {
+                if (cancelled)
+                    return;
+                // Build the instrument into a part the audio thread can't see, then
+                // hand its groups over in one step; playback carries on meanwhile
+                auto pt = e.selectedPartForImport();
+                auto detached = e.makeDetachedPart(pt);
+                int firstGroup{-1};
+                if (!e.loadSf2MultiSampleIntoPart(p, *detached, firstGroup))
+                    return;
+                e.adoptDetachedPart(pt, std::move(detached), firstGroup);
+            });
+        return;
+    }
+    else if (extensionMatches(p, ".gig"))
+    {
+        // Only the samples the instruments use are read, each on its own loader job
+        loadSamplesInBackground(
+            findGigSampleAddresses(p), [p](auto &e, const auto &, auto cancelled) {
+                if (cancelled)
+                    return;
+                auto pt = e.selectedPartForImport();
+                auto detached = e.makeDetachedPart(pt);
+                int firstGroup{-1};
+                if (!e.loadGigMultiSampleIntoPart(p, *detached, firstGroup))
+                    return;
+                e.adoptDetachedPart(pt, std::move(detached), firstGroup);
+            });
         return;
     }
     else if (extensionMatches(p, ".sfz"))
     {
-        // TODO ok this refresh and restart is a bit unsatisfactory
-        messageController->stopAudioThreadThenRunOnSerial([this, p](const auto &) {
-            auto res = sfz_support::importSFZ(p, *this);
-            if (!res)
-                messageController->reportErrorToClient("SFZ Import Failed", "Dunno why");
-            messageController->restartAudioThreadFromSerial();
-            serializationSendToClient(messaging::client::s2c_send_pgz_structure,
-                                      getPartGroupZoneStructure(-1), *messageController);
+        // Decode the samples in parallel first, so by the time we import
+        // every region finds its sample already in the sample manager
+        std::vector<sample::SampleLoader::Request> requests;
+        for (const auto &sp : sfz_support::findSFZSamplePaths(p))
+            requests.push_back({{sample::Sample::WAV_FILE, sp}});
+
+        loadSamplesInBackground(std::move(requests), [p](auto &e, const auto &, auto cancelled) {
+            if (cancelled)
+                return;
+            auto pt = e.selectedPartForImport();
+            auto detached = e.makeDetachedPart(pt);
+            int firstGroup{-1};
+            if (!sfz_support::importSFZ(p, e, *detached, firstGroup))
+            {
+                e.getMessageController()->reportErrorToClient("SFZ Import Failed", "Dunno why");
+                return;
+            }
+            e.adoptDetachedPart(pt, std::move(detached), firstGroup);
         });
         return;
     }
@@ -478,6 +594,7 @@ void Engine::loadSampleIntoSelectedPartAndGroup(const fs::path &p, int16_t rootK
     zptr->mapping.velocityRange = vrange;
     zptr->mapping.rootKey = rootKey;
     zptr->attachToSample(*sampleManager);
+    zptr->setupLoopSeams();
 
     // Drop into selected group logic goes here
     auto [sp, sg] = selectionManager->bestPartGroupForNewSample(*this);
@@ -500,6 +617,813 @@ void Engine::loadSampleIntoSelectedPartAndGroup(const fs::path &p, int16_t rootK
         });
 }
 
+void Engine::loadSamplesInBackground(std::vector<sample::SampleLoader::Request> requests,
+                                     sampleLoadCompletion_t onLoaded)
+{
+    sampleManager->getLoader().submit(
+        std::move(requests), makeSampleLoadProgressReporter(),
+        [this, onLoaded](auto, auto &&results, auto cancelled) {
+            messageController->scheduleSerializationThreadCallback(
+                [res = std::move(results), cancelled, onLoaded](auto &e) {
+                    std::vector<std::optional<SampleID>> ids;
+                    ids.reserve(res.size());
+                    for (const auto &r : res)
+                    {
+                        if (r.sample)
+                            ids.emplace_back(e.getSampleManager()->installLoadedSample(r.sample));
+                        else
+                            ids.emplace_back(std::nullopt);
+                    }
+                    if (onLoaded)
+                        onLoaded(e, ids, cancelled);
+                });
+        });
+}
+
+sample::SampleLoader::progressCallback_t Engine::makeSampleLoadProgressReporter()
+{
+    return [this](auto, auto completed, auto total, const auto &last) {
+        messageController->scheduleSerializationThreadCallback(
+            [c = (int32_t)completed, t = (int32_t)total, l = last.u8string()](auto &e) {
+                serializationSendToClient(messaging::client::s2c_sample_load_progress,
+                                          messaging::client::sampleLoadProgress_t{c, t, l},
+                                          *(e.getMessageController()));
+            },
+            false);
+    };
+}
+
+void Engine::restoreSamplesLazily(std::vector<sample::SampleLoader::Request> requests,
+                                  uint64_t generation)
+{
+    SCLOG("Restoring " << requests.size() << " samples in the background");
+    lazyRestoreInstalled = 0;
+    lazyRestoreFailed = 0;
+    sampleManager->getLoader().submit(
+        std::move(requests), makeSampleLoadProgressReporter(),
+        [this, generation](auto, auto &&results, auto) {
+            std::vector<SampleID> failed;
+            for (const auto &r : results)
+            {
+                if (!r.sample)
+                {
+                    SCLOG("Unable to restore sample " << r.request.address.path.u8string());
+                    failed.push_back(r.request.id);
+                }
+            }
+            messageController->scheduleSerializationThreadCallback(
+                [generation, f = std::move(failed)](auto &e) {
+                    if (f.empty() || generation != e.getSampleManager()->getRestoreGeneration())
+                        return;
+                    for (const auto &id : f)
+                        e.getSampleManager()->dropPendingSample(id);
+                    e.lazyRestoreFailed += (int32_t)f.size();
+                    e.sendLazyRestoreCompleteIfDone();
+                });
+        },
+        [this, generation](auto, const auto &r) {
+            messageController->scheduleSerializationThreadCallback(
+                [generation, sp = r.sample](auto &e) {
+                    e.installLazilyRestoredSample(sp, generation);
+                });
+        });
+}
+
+void Engine::installLazilyRestoredSample(const std::shared_ptr<sample::Sample> &sp,
+                                         uint64_t generation)
+{
+    assert(messageController->threadingChecker.isSerialThread());
+    if (generation != sampleManager->getRestoreGeneration())
+        return;
+
+    // If the manager already had this file the zones get that copy, under its id
+    auto installed = sampleManager->getSample(sampleManager->installLoadedSample(sp));
+    if (installed)
+        queueSampleForZones({sp->id, installed}, generation);
+    lazyRestoreInstalled++;
+    sendLazyRestoreCompleteIfDone();
+}
+
+void Engine::sendLazyRestoreCompleteIfDone()
+{
+    if (sampleManager->getPendingSampleCount() != 0)
+        return;
+    SCLOG("Lazy restore complete; " << lazyRestoreInstalled << " samples loaded and "
+                                    << lazyRestoreFailed << " failed");
+    serializationSendToClient(
+        messaging::client::s2c_patch_samples_ready,
+        messaging::client::patchSamplesReady_t{lazyRestoreInstalled, lazyRestoreFailed},
+        *messageController);
+}
+
+void Engine::queueSampleForZones(const ZoneSampleSwap &sw, uint64_t generation)
+{
+    assert(messageController->threadingChecker.isSerialThread());
+
+    // Samples tend to arrive in bursts, so collect them up and attach them in one go
+    zoneAttachQueue.push_back(sw);
+    if (zoneAttachQueue.size() == 1)
+    {
+        messageController->scheduleSerializationThreadCallback([generation](auto &e) {
+            auto q = std::move(e.zoneAttachQueue);
+            e.zoneAttachQueue.clear();
+            e.swapSamplesIntoZones(std::move(q), generation);
+        });
+    }
+}
+
+void Engine::swapSamplesIntoZones(std::vector<ZoneSampleSwap> toAttach, uint64_t generation)
+{
+    assert(messageController->threadingChecker.isSerialThread());
+    if (toAttach.empty() || generation != sampleManager->getRestoreGeneration())
+        return;
+
+    // Whatever a zone drops here is either null or held by retiredSamples, so
+    // nothing is freed on the audio thread
+    messageController->scheduleAudioThreadCallbackUnderStructureLock(
+        [generation, s = std::move(toAttach)](auto &e) {
+            // a patch which arrived since we were scheduled can reuse these ids
+            if (generation != e.getSampleManager()->getRestoreGeneration())
+                return;
+            for (const auto &part : *(e.getPatch()))
+            {
+                for (const auto &group : *part)
+                {
+                    for (const auto &zone : *group)
+                    {
+                        for (int i = 0; i < Zone::maxSamplesPerZone; ++i)
+                        {
+                            auto &zid = zone->sampleData[i].sampleID;
+                            for (const auto &[forID, sp] : s)
+                            {
+                                if (forID == zid)
+                                {
+                                    if (zone->samplePointers[i] != sp)
+                                    {
+                                        zone->samplePointers[i] = sp;
+                                        zone->sampleWantedSent = false;
+                                    }
+                                    zid = sp->id;
+                                    break;
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+            messaging::audio::sendStructureRefresh(*(e.getMessageController()));
+        },
+        [this](const auto &e) {
+            e.getSelectionManager()->sendClientDataForLeadSelectionState();
+            refreshLoopSeams();
+        });
+}
+
+void Engine::requestSampleResidency(const SampleID &id)
+{
+    assert(messageController->threadingChecker.isSerialThread());
+    auto addr = sampleManager->getPendingSampleAddress(id);
+    if (addr.has_value())
+    {
+        sampleManager->getLoader().prioritize(*addr);
+        return;
+    }
+
+    auto head = sampleManager->getSample(id);
+    if (!head || !head->isResidencyHead() || residencyReloads.count(id))
+        return;
+
+    residencyReloads.insert(id);
+    auto generation = sampleManager->getRestoreGeneration();
+    sampleManager->getLoader().submit(
+        {{head->getSampleFileAddress(), id}}, nullptr,
+        [this, id, generation](auto, auto &&results, auto) {
+            std::shared_ptr<sample::Sample> sp;
+            if (!results.empty())
+                sp = results[0].sample;
+            messageController->scheduleSerializationThreadCallback(
+                [id, generation, sp](auto &e) {
+                    e.residencyReloads.erase(id);
+                    if (!sp || generation != e.getSampleManager()->getRestoreGeneration())
+                        return;
+                    auto current = e.getSampleManager()->getSample(id);
+                    if (!current || !current->isResidencyHead())
+                        return;
+                    e.getSampleManager()->replaceResidentSample(sp);
+                    e.retiredSamples.push_back(current);
+                    e.queueSampleForZones({sp->id, sp}, generation);
+                });
+        });
+}
+
+void Engine::reconvertSamplesToEngineRate()
+{
+    assert(messageController->threadingChecker.isSerialThread());
+    auto toRate = sampleManager->getTargetSampleRate();
+    if (toRate == 0)
+        return;
+
+    // Heads are left be; they pick up the new rate if and when they are reloaded
+    std::vector<sample::SampleLoader::Request> requests;
+    for (const auto &[id, addr] : sampleManager->getSampleAddressesAndIDs())
+    {
+        auto s = sampleManager->getSample(id);
+        if (s && s->sample_rate != toRate && !s->isResidencyHead() && !residencyReloads.count(id))
+            requests.push_back({addr, id});
+    }
+    if (requests.empty())
+        return;
+
+    SCLOG("Converting " << requests.size() << " samples to " << toRate << "Hz");
+    auto generation = sampleManager->getRestoreGeneration();
+    sampleManager->getLoader().submit(
+        std::move(requests), makeSampleLoadProgressReporter(), nullptr,
+        [this, generation](auto, const auto &r) {
+            messageController->scheduleSerializationThreadCallback(
+                [generation, sp = r.sample](auto &e) {
+                    // A later rate change has its own conversion on the way
+                    auto &sm = e.getSampleManager();
+                    if (generation != sm->getRestoreGeneration() ||
+                        sp->sample_rate != sm->getTargetSampleRate())
+                        return;
+                    auto current = sm->getSample(sp->id);
+                    if (!current || current->isResidencyHead())
+                        return;
+                    sm->replaceResidentSample(sp);
+                    e.retiredSamples.push_back(current);
+                    e.queueSampleForZones({sp->id, sp}, generation);
+                });
+        });
+}
+
+void Engine::enforceSampleMemoryBudget()
+{
+    assert(messageController->threadingChecker.isSerialThread());
+
+    // Anything played since the last pass is in use, however tight the budget
+    auto usedBefore = lastHousekeepingUseClock;
+    lastHousekeepingUseClock = sample::Sample::getUseClock() + 1;
+
+    auto victims = sampleManager->chooseEvictionCandidates(usedBefore);
+    if (victims.empty())
+        return;
+
+    std::vector<ZoneSampleSwap> heads;
+    for (const auto &v : victims)
+    {
+        if (residencyReloads.count(v->id))
+            continue;
+        auto h = v->makeResidencyHead(sampleManager->getPreloadFrames());
+        if (!h)
+            continue;
+        sampleManager->replaceResidentSample(h);
+        retiredSamples.push_back(v);
+        heads.push_back({h->id, h});
+    }
+    SCLOG("Evicted " << heads.size() << " samples to preload heads to meet memory budget");
+    swapSamplesIntoZones(std::move(heads), sampleManager->getRestoreGeneration());
+}
+
+void Engine::sweepRetiredSamples()
+{
+    assert(messageController->threadingChecker.isSerialThread());
+    if (retiredSamples.empty() || retiredSweepInFlight)
+        return;
+
+    // The audio thread stamps what it finds with this sweep's id rather than searching
+    // the retired list, so its work is proportional to the voices and zones alone
+    struct Sweep
+    {
+        std::vector<std::shared_ptr<sample::Sample>> samples;
+        uint64_t id{0};
+    };
+    auto sweep = std::make_shared<Sweep>();
+    sweep->samples = retiredSamples;
+    sweep->id = ++retiredSweepId;
+    retiredSweepInFlight = true;
+
+    messageController->scheduleAudioThreadCallback(
+        [sweep](auto &e) {
+            auto id = sweep->id;
+            for (auto *v : e.voices)
+            {
+                if (!v || !v->isVoiceAssigned || !v->playingSample)
+                    continue;
+                v->playingSample->retiredSweepMark.store(id, std::memory_order_relaxed);
+            }
+
+            // A sample is retired before the swap which takes it out of its zones has run,
+            // and a voice can start on it until then. Keep it while any zone holds it, so
+            // the swap never drops the last reference on this thread.
+            for (const auto &part : *(e.getPatch()))
+                for (const auto &group : *part)
+                    for (const auto &zone : *group)
+                        for (const auto &sp : zone->samplePointers)
+                            if (sp)
+                                sp->retiredSweepMark.store(id, std::memory_order_relaxed);
+        },
+        [this, sweep](const auto &) {
+            // Only this completion removes from the list, so the swept samples are still
+            // its first entries and anything retired since we were scheduled follows them
+            std::vector<std::shared_ptr<sample::Sample>> keep;
+            for (size_t i = 0; i < retiredSamples.size(); ++i)
+            {
+                const auto &r = retiredSamples[i];
+                if (i >= sweep->samples.size() ||
+                    r->retiredSweepMark.load(std::memory_order_relaxed) == sweep->id)
+                    keep.push_back(r);
+            }
+            retiredSamples = std::move(keep);
+            retiredSweepInFlight = false;
+        });
+}
+
+std::vector<Engine::LoopSeamUpdate> Engine::staleLoopSeams(Patch &p)
+{
+    std::vector<LoopSeamUpdate> res;
+    for (int pi = 0; pi < numParts; ++pi)
+    {
+        const auto &groups = p.getPart(pi)->getGroups();
+        for (int gi = 0; gi < (int)groups.size(); ++gi)
+        {
+            const auto &zones = groups[gi]->getZones();
+            for (int zi = 0; zi < (int)zones.size(); ++zi)
+            {
+                const auto &zone = zones[zi];
+                for (int i = 0; i < Zone::maxSamplesPerZone; ++i)
+                {
+                    if (zone->loopSeamsCurrent(i))
+                        continue;
+                    // a zone which no longer wants its seams lets go of their sample
+                    res.push_back({pi, gi, zi, i, zone.get(),
+                                   zone->wantsLoopSeams(i) ? zone->buildLoopSeams(i) : nullptr});
+                }
+            }
+        }
+    }
+    return res;
+}
+
+void Engine::refreshLoopSeams()
+{
+    assert(messageController->threadingChecker.isSerialThread());
+    retiredLoopSeams.erase(std::remove_if(retiredLoopSeams.begin(), retiredLoopSeams.end(),
+                                          [](const auto &s) { return s.use_count() == 1; }),
+                           retiredLoopSeams.end());
+
+    auto updates = staleLoopSeams(*patch);
+    if (updates.empty())
+        return;
+
+    // A zone which moved since we looked is left for the next refresh
+    auto holder = std::make_shared<std::vector<LoopSeamUpdate>>(std::move(updates));
+    messageController->scheduleAudioThreadCallbackUnderStructureLock(
+        [holder](auto &e) {
+            const auto &patch = e.getPatch();
+            for (auto &u : *holder)
+            {
+                const auto &groups = patch->getPart(u.part)->getGroups();
+                if (u.group >= (int)groups.size())
+                    continue;
+                const auto &zones = groups[u.group]->getZones();
+                if (u.zone >= (int)zones.size() || zones[u.zone].get() != u.forZone)
+                    continue;
+                std::swap(zones[u.zone]->loopSeams[u.index], u.seams);
+            }
+        },
+        [this, holder](const auto &) {
+            // Each update now holds what its zone let go of, or the seams it couldn't place
+            for (auto &u : *holder)
+            {
+                if (u.seams)
+                    retiredLoopSeams.push_back(std::move(u.seams));
+            }
+        });
+}
+
+void Engine::countProcessorUse(const Part &part, processorUse_t &use) const
+{
+    for (const auto &group : part.getGroups())
+    {
+        for (const auto &ps : group->processorStorage)
+            if (ps.type != dsp::processor::proct_none)
+                use[ps.type].groups++;
+
+        for (const auto &zone : group->getZones())
+        {
+            const auto &zs = zone->processorStorage;
+            for (const auto &ps : zs)
+            {
+                if (ps.type == dsp::processor::proct_none)
+                    continue;
+                auto n = std::count_if(zs.begin(), zs.end(),
+                                       [t = ps.type](const auto &o) { return o.type == t; });
+                auto &u = use[ps.type];
+                u.perVoice = std::max(u.perVoice, (int64_t)n);
+            }
+        }
+    }
+}
+
+void Engine::countProcessorUse(const Patch &p, processorUse_t &use) const
+{
+    for (const auto &part : p.getParts())
+        countProcessorUse(*part, use);
+}
+
+void Engine::reserveProcessorInstances(const processorUse_t &use)
+{
+    // Before prepareToPlay there is no rate to size the state for, nor audio to spawn it;
+    // housekeeping catches up once there is
+    if (sampleRate <= 0)
+        return;
+
+    for (const auto &[t, u] : use)
+    {
+        auto &d = processorMemoryDemand[t];
+        if (d.sampleRate != sampleRate)
+        {
+            // Spawn one into a pool which allocates as it goes, and see what it took
+            MemoryPool probe(true);
+            uint8_t memory[dsp::processor::processorMemoryBufferSize];
+            float fp[dsp::processor::maxProcessorFloatParams]{};
+            int ip[dsp::processor::maxProcessorIntParams]{};
+            auto *proc = dsp::processor::spawnProcessorInPlace(
+                (dsp::processor::ProcessorType)t, &probe, memory,
+                dsp::processor::processorMemoryBufferSize, fp, ip);
+            if (!proc)
+                continue;
+            proc->setSampleRate(sampleRate);
+            proc->init();
+
+            d = {};
+            d.sampleRate = sampleRate;
+            for (size_t sc = 0; sc < MemoryPool::nSizeClasses; ++sc)
+                d.blocks[sc] = probe.getStats(sc).highWater;
+            dsp::processor::unspawnProcessor(proc);
+        }
+
+        auto instances = u.perVoice * maxVoices + u.groups + 1;
+        if (instances <= d.reservedInstances)
+            continue;
+        for (size_t sc = 0; sc < MemoryPool::nSizeClasses; ++sc)
+        {
+            if (d.blocks[sc] > 0)
+                memoryPool->addBlocks(MemoryPool::sizeClassBytes(sc),
+                                      d.blocks[sc] * (instances - d.reservedInstances));
+        }
+        d.reservedInstances = instances;
+    }
+}
+
+void Engine::reserveProcessorMemory()
+{
+    processorUse_t use;
+    countProcessorUse(*patch, use);
+    reserveProcessorInstances(use);
+}
+
+void Engine::reserveProcessorMemory(const Patch &incoming)
+{
+    // The live patch can ring out under it, so their groups add up
+    processorUse_t use;
+    countProcessorUse(*patch, use);
+    if (&incoming != patch.get())
+        countProcessorUse(incoming, use);
+    reserveProcessorInstances(use);
+}
+
+void Engine::reserveProcessorMemory(const Part &incoming)
+{
+    processorUse_t use;
+    countProcessorUse(*patch, use);
+    countProcessorUse(incoming, use);
+    reserveProcessorInstances(use);
+}
+
+void Engine::reserveProcessorMemory(dsp::processor::ProcessorType adding, bool forZone,
+                                    size_t slots)
+{
+    if (adding == dsp::processor::proct_none || slots == 0)
+        return;
+
+    processorUse_t use;
+    countProcessorUse(*patch, use);
+    auto &u = use[adding];
+    // A zone can't run more of a type than it has slots, however many zones take it
+    if (forZone)
+        u.perVoice = std::min(u.perVoice + 1, (int64_t)processorCount);
+    else
+        u.groups += slots;
+    reserveProcessorInstances(use);
+}
+
+void Engine::runSerialHousekeeping()
+{
+    assert(messageController->threadingChecker.isSerialThread());
+    enforceSampleMemoryBudget();
+    sweepRetiredSamples();
+    refreshLoopSeams();
+    // Picks up a sample rate change, and anything which changed processors without asking
+    reserveProcessorMemory();
+    memoryPool->refill();
+    respawnFailedGroupProcessors();
+}
+
+void Engine::respawnFailedGroupProcessors()
+{
+    auto failures = groupProcessorSpawnFailures.load();
+    if (failures == groupProcessorSpawnFailuresSeen)
+        return;
+    groupProcessorSpawnFailuresSeen = failures;
+
+    // The pool has been refilled, so the groups which went without can have another go.
+    // Any which fail again count again and come round at the next housekeeping.
+    messageController->scheduleAudioThreadCallback([](auto &e) {
+        for (const auto &part : *(e.getPatch()))
+        {
+            for (const auto &group : *part)
+            {
+                for (int w = 0; w < processorCount; ++w)
+                {
+                    auto t = group->processorStorage[w].type;
+                    if (!group->processors[w] && t != dsp::processor::proct_none)
+                        group->onProcessorTypeChanged(w, t);
+                }
+            }
+        }
+    });
+}
+
+struct Engine::ShadowPatchLoad
+{
+    std::unordered_map<SampleID, SampleID> idMap;
+    std::vector<SampleID> requestedFor; // the streamed id behind each load request
+    std::vector<fs::path> missing;
+    std::atomic<int64_t> loadedBytes{0};
+    shadowPatchBuilder_t build;
+    shadowPatchSwapped_t onSwapped;
+    PatchSwapMode mode{PatchSwapMode::CROSSFADE};
+};
+
+void Engine::prepareShadowPatch(const sample::SampleManager::sampleAddressesAndIds_t &samples,
+                                shadowPatchBuilder_t build, shadowPatchSwapped_t onSwapped,
+                                PatchSwapMode mode)
+{
+    assert(messageController->threadingChecker.isSerialThread());
+
+    auto load = std::make_shared<ShadowPatchLoad>();
+    load->build = std::move(build);
+    load->onSwapped = std::move(onSwapped);
+    load->mode = mode;
+
+    // Samples the running patch already has are shared. The rest load under fresh
+    // ids, since the streamed ones may belong to something live
+    std::vector<sample::SampleLoader::Request> requests;
+    for (const auto &[id, addr] : samples)
+    {
+        if (!fs::exists(addr.path))
+        {
+            load->missing.push_back(addr.path);
+        }
+        else if (auto existing = sampleManager->findSampleByFileAddress(addr))
+        {
+            load->idMap[id] = *existing;
+        }
+        else
+        {
+            requests.push_back({addr, SampleID::next()});
+            load->requestedFor.push_back(id);
+        }
+    }
+
+    auto total = (int32_t)requests.size();
+    serializationSendToClient(messaging::client::s2c_patch_switch_status,
+                              messaging::client::patchSwitchStatus_t{0, 0, total, 0},
+                              *messageController);
+
+    sampleManager->getLoader().submit(
+        std::move(requests),
+        [this, load](auto, auto completed, auto total, const auto &) {
+            messageController->scheduleSerializationThreadCallback(
+                [c = (int32_t)completed, t = (int32_t)total,
+                 b = (int64_t)load->loadedBytes](auto &e) {
+                    serializationSendToClient(messaging::client::s2c_patch_switch_status,
+                                              messaging::client::patchSwitchStatus_t{0, c, t, b},
+                                              *(e.getMessageController()));
+                },
+                false);
+        },
+        [this, load](auto, auto &&results, auto cancelled) {
+            messageController->scheduleSerializationThreadCallback(
+                [load, res = std::move(results), cancelled](auto &e) {
+                    e.swapInShadowPatch(load, res, cancelled);
+                });
+        },
+        [load](auto, const auto &result) { load->loadedBytes += result.sample->getDataSize(); });
+}
+
+void Engine::swapInShadowPatch(const std::shared_ptr<ShadowPatchLoad> &load,
+                               const std::vector<sample::SampleLoader::Result> &results,
+                               bool cancelled)
+{
+    assert(messageController->threadingChecker.isSerialThread());
+
+    if (cancelled)
+    {
+        // The loaded samples are unreferenced so the retire purge would take them, but
+        // nothing is retiring; leave them for the next purge and keep the current patch
+        SCLOG("Patch switch cancelled while loading samples");
+        serializationSendToClient(messaging::client::s2c_patch_switch_status,
+                                  messaging::client::patchSwitchStatus_t{2, 0, 0, 0},
+                                  *messageController);
+        return;
+    }
+
+    for (const auto &[idx, r] : sst::cpputils::enumerate(results))
+    {
+        if (r.sample)
+            load->idMap[load->requestedFor[idx]] = sampleManager->installLoadedSample(r.sample);
+        else
+            SCLOG("Unable to load sample " << r.request.address.path.u8string());
+    }
+
+    auto shadow = makeShadowPatch();
+    try
+    {
+        load->build(*this, *shadow);
+    }
+    catch (std::exception &e)
+    {
+        messageController->reportErrorToClient("Patch Load Failed", e.what());
+        return;
+    }
+    remapShadowSampleIDs(*shadow, load->idMap);
+    // Unstreaming replaced the parts, and there will be no prepareToPlay to set them up
+    if (sampleRate > 0)
+        shadow->setSampleRate(sampleRate, sampleRateInv);
+    shadow->setupBussesOnUnstream(*this);
+
+    if (!load->missing.empty())
+    {
+        std::ostringstream oss;
+        oss << "On load, sample manager could not locate the following files:\n";
+        for (const auto &p : load->missing)
+        {
+            oss << "  " << p.u8string() << "\n";
+        }
+        messageController->reportErrorToClient("Missing Samples", oss.str());
+    }
+
+    // Its group processors spawn on the audio thread as it goes live
+    reserveProcessorMemory(*shadow);
+
+    auto holder = std::make_shared<std::unique_ptr<Patch>>(std::move(shadow));
+    messageController->scheduleAudioThreadCallbackUnderStructureLock(
+        [holder, mode = load->mode](auto &e) { e.installShadowPatch(*holder, mode); },
+        [this, load, n = (int32_t)results.size()](const auto &) {
+            if (load->onSwapped)
+                load->onSwapped(*this);
+            patch->busses.sendInitialBusInfo(*this);
+            serializationSendToClient(messaging::client::s2c_send_pgz_structure,
+                                      getPartGroupZoneStructure(-1), *messageController);
+            serializationSendToClient(
+                messaging::client::s2c_patch_switch_status,
+                messaging::client::patchSwitchStatus_t{1, n, n, load->loadedBytes},
+                *messageController);
+        });
+}
+
+std::unique_ptr<Patch> Engine::makeShadowPatch()
+{
+    auto res = std::make_unique<Patch>();
+    res->parentEngine = this;
+
+    // prepareToPlay only set these up on the patch which was live at the time
+    const auto &from = patch->busses;
+    auto &to = res->busses;
+    to.mainBus.vuFalloff = from.mainBus.vuFalloff;
+    for (int i = 0; i < numParts; ++i)
+        to.partBusses[i].vuFalloff = from.partBusses[i].vuFalloff;
+    for (int i = 0; i < numAux; ++i)
+        to.auxBusses[i].vuFalloff = from.auxBusses[i].vuFalloff;
+    return res;
+}
+
+void Engine::remapShadowSampleIDs(Patch &p, const std::unordered_map<SampleID, SampleID> &idMap)
+{
+    for (const auto &part : p)
+    {
+        for (const auto &group : *part)
+        {
+            for (const auto &zone : *group)
+            {
+                for (int i = 0; i < Zone::maxSamplesPerZone; ++i)
+                {
+                    auto &sd = zone->sampleData[i];
+                    if (!sd.sampleID.isValid())
+                        continue;
+                    // An id we couldn't resolve mustn't pick up an unrelated live sample
+                    auto m = idMap.find(sd.sampleID);
+                    sd.sampleID = (m == idMap.end()) ? SampleID() : m->second;
+                    zone->attachToSample(*sampleManager, i);
+                }
+                // It isn't live yet, so it can take its loop seams directly
+                zone->setupLoopSeams();
+            }
+        }
+    }
+}
+
+void Engine::installShadowPatch(std::unique_ptr<Patch> &shadow, PatchSwapMode mode)
+{
+    // Only one patch rings out at a time, so one still going from an earlier switch ends
+    if (retiringPatch)
+        finishRetiringPatch();
+
+    retiringPatch = std::move(patch);
+    patch = std::move(shadow);
+    // It was built on the serial thread, so its group processors spawn here
+    patch->respawnGroupProcessors();
+
+    auto blocksPerSecond = sampleRate / blockSize;
+    auto fadeBlocks = 1.0;
+    if (mode != PatchSwapMode::CUT)
+        fadeBlocks = std::max(1.0, patchSwapFadeSeconds * blocksPerSecond);
+    retiringGain = 1.f;
+    retiringGainStep = 1.0 / fadeBlocks;
+    retiringRingBlocks = 0;
+    if (mode == PatchSwapMode::LET_RING)
+        retiringRingBlocks = (int32_t)(patchSwapMaxRingSeconds * blocksPerSecond);
+
+    // With no audio running nothing would ever fade it
+    if (!messageController->isAudioRunning)
+        finishRetiringPatch();
+}
+
+void Engine::processRetiringPatch()
+{
+    auto &rp = *retiringPatch;
+    rp.busses.clear();
+    rp.process(*this);
+
+    bool ringing{false};
+    if (retiringRingBlocks > 0)
+    {
+        retiringRingBlocks--;
+        for (const auto &part : rp)
+            ringing = ringing || part->isActive();
+    }
+
+    // Hold the level while voices ring, otherwise ramp down across the block
+    auto g0 = retiringGain;
+    auto g1 = ringing ? g0 : std::max(0.f, g0 - retiringGainStep);
+    auto dg = (g1 - g0) / blockSize;
+    const auto &from = rp.busses.mainBus.output;
+    auto &to = patch->busses.mainBus.output;
+    for (int i = 0; i < blockSize; ++i)
+    {
+        auto g = g0 + dg * i;
+        to[0][i] += g * from[0][i];
+        to[1][i] += g * from[1][i];
+    }
+    retiringGain = g1;
+
+    if (retiringGain <= 0.f)
+        finishRetiringPatch();
+}
+
+void Engine::finishRetiringPatch()
+{
+    for (auto &v : voices)
+    {
+        if (v && v->isVoiceAssigned && isVoiceInPatch(v, retiringPatch.get()))
+            v->cleanupVoice();
+    }
+    retiringGain = 0.f;
+    messaging::audio::sendPatchRetired(retiringPatch.release(), *messageController);
+}
+
+bool Engine::isVoiceInPatch(const voice::Voice *v, const Patch *p) const
+{
+    const auto *z = v->zone;
+    return z && z->parentGroup && z->parentGroup->parentPart &&
+           z->parentGroup->parentPart->parentPatch == p;
+}
+
+void Engine::freeRetiredPatch(Patch *p)
+{
+    assert(messageController->threadingChecker.isSerialThread());
+    std::unique_ptr<Patch> retired(p);
+    retired.reset();
+
+    // A full state load replaces the sample set, so drop what only the old patch used
+    sampleManager->purgeUnreferencedSamples();
+    serializationSendToClient(messaging::client::s2c_patch_switch_status,
+                              messaging::client::patchSwitchStatus_t{2, 0, 0, 0},
+                              *messageController);
+}
+
 void Engine::sendMetadataToClient() const
 {
     // On register send metadata
@@ -521,31 +1445,101 @@ void Engine::sendEngineStatusToClient() const
     messaging::client::serializationSendToClient(messaging::client::s2c_engine_status, ec,
                                                  *messageController);
 }
-void Engine::loadSf2MultiSampleIntoSelectedPart(const fs::path &p)
+
+namespace
 {
-    assert(messageController->threadingChecker.isSerialThread());
+// Seconds to the normalized time of our envelopes, for the importers
+double envelopeTimeFromSeconds(double s)
+{
+    using range_t = sst::basic_blocks::modulators::ThirtyTwoSecondRange;
+    auto ncs = (log2(s) - range_t::etMin) / (range_t::etMax - range_t::etMin);
+    return std::clamp(ncs, 0., 1.);
+}
+
+// libgig hands out samples as pointers; our addresses use their wave pool position
+std::unordered_map<gig::Sample *, int> gigSampleIndices(gig::File &f)
+{
+    std::unordered_map<gig::Sample *, int> res;
+    int idx{0};
+    for (auto s = f.GetFirstSample(); s; s = f.GetNextSample())
+        res[s] = idx++;
+    return res;
+}
+
+// Every dimension region of a region, with the zone each dimension is at
+template <typename F> void forEachGigDimensionRegion(gig::Region *r, F &&f)
+{
+    int combos{1};
+    for (uint32_t d = 0; d < r->Dimensions; ++d)
+        combos *= std::max(1U, (uint32_t)r->pDimensionDefinitions[d].zones);
 
+    for (int c = 0; c < combos; ++c)
+    {
+        uint8_t bits[8]{};
+        auto rem = c;
+        for (uint32_t d = 0; d < r->Dimensions; ++d)
+        {
+            auto zones = std::max(1, (int)r->pDimensionDefinitions[d].zones);
+            bits[d] = rem % zones;
+            rem /= zones;
+        }
+        auto dr = r->GetDimensionRegionByBit(bits);
+        if (dr)
+            f(dr, bits);
+    }
+}
+} // namespace
+
+std::vector<sample::SampleLoader::Request> Engine::findSf2SampleAddresses(const fs::path &p)
+{
+    // This walks the file exactly like loadSf2MultiSampleIntoPart so the
+    // addresses match what that function will ask the sample manager for
+    std::vector<sample::SampleLoader::Request> res;
     try
     {
         auto riff = std::make_unique<RIFF::File>(p.u8string());
         auto sf = std::make_unique<sf2::File>(riff.get());
 
-        auto sz = getSelectionManager()->currentLeadZone(*this);
-        auto pt = 0;
-        if (sz.has_value())
-            pt = sz->part;
-        if (pt < 0 || pt >= numParts)
-            pt = 0;
+        for (int pc = 0; pc < sf->GetPresetCount(); ++pc)
+        {
+            auto *preset = sf->GetPreset(pc);
+            for (int i = 0; i < preset->GetRegionCount(); ++i)
+            {
+                sf2::Instrument *instr = preset->GetRegion(i)->pInstrument;
+                for (int j = 0; j < instr->GetRegionCount(); ++j)
+                {
+                    if (instr->GetRegion(j)->GetSample() == nullptr)
+                        continue;
+                    sample::Sample::SampleFileAddress addr{sample::Sample::SF2_FILE, p, i, j};
+                    res.push_back({addr});
+                }
+            }
+        }
+    }
+    catch (RIFF::Exception e)
+    {
+        SCLOG("SF2 Scan Exception: " << e.Message);
+    }
+    return res;
+}
+
+bool Engine::loadSf2MultiSampleIntoPart(const fs::path &p, Part &part, int &firstGroup)
+{
+    assert(messageController->threadingChecker.isSerialThread());
+
+    firstGroup = -1;
+    try
+    {
+        auto riff = std::make_unique<RIFF::File>(p.u8string());
+        auto sf = std::make_unique<sf2::File>(riff.get());
 
-        auto &part = getPatch()->getPart(pt);
-        int firstGroup = -1;
         for (int pc = 0; pc < sf->GetPresetCount(); ++pc)
         {
             auto *preset = sf->GetPreset(pc);
             auto pnm = std::string(preset->GetName());
 
-            auto grpnum = part->addGroup() - 1;
-            auto &grp = part->getGroup(grpnum);
+            auto grpnum = part.addGroup() - 1;
+            auto &grp = part.getGroup(grpnum);
 
             grp->name = pnm;
 
@@ -599,7 +1593,7 @@ void Engine::loadSf2MultiSampleIntoSelectedPart(const fs::path &p)
                     if (!zn->attachToSample(*sampleManager))
                     {
                         SCLOG("ERROR: Can't attach to sample");
-                        return;
+                        return false;
                     }
                     auto &znSD = zn->sampleData[0];
 
@@ -621,25 +1615,16 @@ void Engine::loadSf2MultiSampleIntoSelectedPart(const fs::path &p)
                     {
                         SCLOG("ERROR: PreAttach Delay which we don't support");
                     }
-                    auto s2a = [](double s) {
-                        auto l2s = log2(s);
-                        auto scs = l2s - sst::basic_blocks::modulators::ThirtyTwoSecondRange::etMin;
-                        auto ncs =
-                            scs / (sst::basic_blocks::modulators::ThirtyTwoSecondRange::etMax -
-                                   sst::basic_blocks::modulators::ThirtyTwoSecondRange::etMin);
-                        return std::clamp(ncs, 0., 1.);
-                    };
-
                     auto sus2l = [](double s) {
                         auto db = -s / 10;
                         return pow(10.0, db * 0.05);
                     };
 
-                    zn->aegStorage.a = s2a(reg->GetEG1Attack(presetRegion));
-                    zn->aegStorage.h = s2a(reg->GetEG1Hold(presetRegion));
-                    zn->aegStorage.d = s2a(reg->GetEG1Decay(presetRegion));
+                    zn->aegStorage.a = envelopeTimeFromSeconds(reg->GetEG1Attack(presetRegion));
+                    zn->aegStorage.h = envelopeTimeFromSeconds(reg->GetEG1Hold(presetRegion));
+                    zn->aegStorage.d = envelopeTimeFromSeconds(reg->GetEG1Decay(presetRegion));
                     zn->aegStorage.s = sus2l(reg->GetEG1Sustain(presetRegion));
-                    zn->aegStorage.r = s2a(reg->GetEG1Release(presetRegion));
+                    zn->aegStorage.r = envelopeTimeFromSeconds(reg->GetEG1Release(presetRegion));
 
                     auto GetValue = [](const auto &val) {
                         if (val == sf2::NONE)
@@ -647,11 +1632,11 @@ void Engine::loadSf2MultiSampleIntoSelectedPart(const fs::path &p)
                         return ToString(val);
                     };
 
-                    zn->eg2Storage.a = s2a(reg->GetEG2Attack(presetRegion));
-                    zn->eg2Storage.h = s2a(reg->GetEG2Hold(presetRegion));
-                    zn->eg2Storage.d = s2a(reg->GetEG2Decay(presetRegion));
+                    zn->eg2Storage.a = envelopeTimeFromSeconds(reg->GetEG2Attack(presetRegion));
+                    zn->eg2Storage.h = envelopeTimeFromSeconds(reg->GetEG2Hold(presetRegion));
+                    zn->eg2Storage.d = envelopeTimeFromSeconds(reg->GetEG2Decay(presetRegion));
                     zn->eg2Storage.s = sus2l(reg->GetEG2Sustain(presetRegion));
-                    zn->eg2Storage.r = s2a(reg->GetEG2Release(presetRegion));
+                    zn->eg2Storage.r = envelopeTimeFromSeconds(reg->GetEG2Release(presetRegion));
 
                     if (reg->HasLoop)
                     {
@@ -716,29 +1701,307 @@ void Engine::loadSf2MultiSampleIntoSelectedPart(const fs::path &p)
                 }
             }
         }
-        selectionManager->selectAction(
-            {pt, firstGroup, firstGroup >= 0 ? 0 : -1, true, true, true});
     }
     catch (RIFF::Exception e)
     {
         messageController->reportErrorToClient("SF2 Load Error", e.Message);
-        return;
+        return false;
     }
     catch (const SCXTError &e)
     {
         messageController->reportErrorToClient("SF2 Load Error", e.what());
-        return;
+        return false;
     }
     catch (...)
     {
-        return;
+        return false;
+    }
+    return true;
+}
+
+std::vector<sample::SampleLoader::Request> Engine::findGigSampleAddresses(const fs::path &p)
+{
+    // The samples loadGigMultiSampleIntoPart will look for, each once
+    std::vector<sample::SampleLoader::Request> res;
+    try
+    {
+        auto riff = std::make_unique<RIFF::File>(p.u8string());
+        auto gf = std::make_unique<gig::File>(riff.get());
+        auto indices = gigSampleIndices(*gf);
+
+        std::unordered_set<int> seen;
+        for (auto ins = gf->GetFirstInstrument(); ins; ins = gf->GetNextInstrument())
+        {
+            for (auto r = ins->GetFirstRegion(); r; r = ins->GetNextRegion())
+            {
+                forEachGigDimensionRegion(r, [&](auto dr, auto) {
+                    auto si = indices.find(dr->pSample);
+                    if (!dr->pSample || si == indices.end() || !seen.insert(si->second).second)
+                        return;
+                    res.push_back({{sample::Sample::GIG_FILE, p, -1, si->second}});
+                });
+            }
+        }
+    }
+    catch (RIFF::Exception e)
+    {
+        SCLOG("GIG Scan Exception: " << e.Message);
+    }
+    return res;
+}
+
+bool Engine::loadGigMultiSampleIntoPart(const fs::path &p, Part &part, int &firstGroup)
+{
+    assert(messageController->threadingChecker.isSerialThread());
+
+    firstGroup = -1;
+    try
+    {
+        auto riff = std::make_unique<RIFF::File>(p.u8string());
+        auto gf = std::make_unique<gig::File>(riff.get());
+        auto indices = gigSampleIndices(*gf);
+
+        int insIdx{0};
+        for (auto ins = gf->GetFirstInstrument(); ins; ins = gf->GetNextInstrument(), ++insIdx)
+        {
+            auto insName = ins->pInfo ? ins->pInfo->Name : std::string();
+            if (insName.empty())
+                insName = fmt::format("Instrument {}", insIdx + 1);
+
+            // A group per keyswitch position, made as the positions turn up
+            std::map<int, size_t> groupByKeyswitch;
+            auto groupFor = [&](int ks) -> Group & {
+                auto g = groupByKeyswitch.find(ks);
+                if (g == groupByKeyswitch.end())
+                {
+                    auto gi = part.addGroup() - 1;
+                    auto &grp = part.getGroup(gi);
+                    grp->name = insName;
+                    if (ks >= 0)
+                    {
+                        grp->name = fmt::format("{} KS {}", insName, ks + 1);
+                        // Nothing switches between them yet, so the first one plays
+                        grp->outputInfo.muted = ks > 0;
+                    }
+                    g = groupByKeyswitch.emplace(ks, gi).first;
+                }
+                return *part.getGroup(g->second);
+            };
+
+            for (auto r = ins->GetFirstRegion(); r; r = ins->GetNextRegion())
+            {
+                forEachGigDimensionRegion(r, [&](gig::DimensionRegion *dr, const uint8_t *bits) {
+                    auto si = indices.find(dr->pSample);
+                    if (!dr->pSample || si == indices.end())
+                        return;
+
+                    int ks{-1};
+                    VelocityRange vel{0, 127};
+                    std::optional<float> pan;
+                    for (uint32_t d = 0; d < r->Dimensions; ++d)
+                    {
+                        const auto &def = r->pDimensionDefinitions[d];
+                        switch (def.dimension)
+                        {
+                        case gig::dimension_velocity:
+                        {
+                            auto upperFor = [&](int z) -> int {
+                                if (z + 1 >= def.zones)
+                                    return 127;
+                                if (def.split_type == gig::split_type_normal)
+                                    return (int)((z + 1) * def.zone_size) - 1;
+                                uint8_t zb[8];
+                                std::copy(bits, bits + 8, zb);
+                                zb[d] = z;
+                                auto zdr = r->GetDimensionRegionByBit(zb);
+                                auto u = zdr->DimensionUpperLimits[d];
+                                return u ? u : zdr->VelocityUpperLimit;
+                            };
+                            auto lo = bits[d] == 0 ? 0 : upperFor(bits[d] - 1) + 1;
+                            vel = {std::clamp(lo, 0, 127), std::clamp(upperFor(bits[d]), 0, 127)};
+                        }
+                        break;
+                        case gig::dimension_keyboard:
+                            ks = bits[d];
+                            break;
+                        case gig::dimension_samplechannel:
+                            pan = bits[d] == 0 ? -1.f : 1.f;
+                            break;
+                        case gig::dimension_layer:
+                            break;
+                        default:
+                            // round robin, release trigger, controllers and so on
+                            if (bits[d] != 0)
+                                return;
+                            break;
+                        }
+                    }
+
+                    auto sid = sampleManager->findSampleByFileAddress(
+                        {sample::Sample::GIG_FILE, p, -1, si->second});
+                    if (!sid.has_value())
+                        return;
+
+                    auto zn = std::make_unique<engine::Zone>(*sid);
+                    zn->mapping.keyboardRange = {r->KeyRange.low, r->KeyRange.high};
+                    zn->mapping.velocityRange = vel;
+                    zn->mapping.rootKey = dr->UnityNote;
+                    zn->mapping.pitchOffset = dr->FineTune * 0.01;
+                    // gig pan is -64 to 63
+                    zn->mapping.pan = pan.value_or(dr->Pan < 0 ? dr->Pan / 64.f : dr->Pan / 63.f);
+                    if (!zn->attachToSample(*sampleManager))
+                    {
+                        SCLOG("ERROR: Can't attach to sample");
+                        return;
+                    }
+
+                    zn->aegStorage.a = envelopeTimeFromSeconds(dr->EG1Attack);
+                    zn->aegStorage.d = envelopeTimeFromSeconds(dr->EG1Decay1);
+                    zn->aegStorage.s = dr->EG1Sustain / 1000.0;
+                    zn->aegStorage.r = envelopeTimeFromSeconds(dr->EG1Release);
+
+                    auto &znSD = zn->sampleData[0];
+                    if (dr->SampleLoops > 0 && dr->pSampleLoops)
+                    {
+                        znSD.loopActive = true;
+                        znSD.startLoop = dr->pSampleLoops[0].LoopStart;
+                        znSD.endLoop =
+                            dr->pSampleLoops[0].LoopStart + dr->pSampleLoops[0].LoopLength;
+                    }
+
+                    auto &grp = groupFor(ks);
+                    if (firstGroup < 0)
+                        firstGroup = part.getGroupIndex(grp.id);
+                    grp.addZone(zn);
+                });
+            }
+        }
     }
+    catch (RIFF::Exception e)
+    {
+        messageController->reportErrorToClient("GIG Load Error", e.Message);
+        return false;
+    }
+    catch (const SCXTError &e)
+    {
+        messageController->reportErrorToClient("GIG Load Error", e.what());
+        return false;
+    }
+    catch (...)
+    {
+        return false;
+    }
+    return true;
+}
+
+int16_t Engine::selectedPartForImport() const
+{
+    auto sz = selectionManager->currentLeadZone(*this);
+    int16_t pt = 0;
+    if (sz.has_value())
+        pt = sz->part;
+    if (pt < 0 || pt >= numParts)
+        pt = 0;
+    return pt;
+}
+
+std::unique_ptr<Part> Engine::makeDetachedPart(int16_t pt) const
+{
+    const auto &live = patch->getPart(pt);
+    auto res = std::make_unique<Part>(live->channel);
+    // Point at the real patch so zones and groups built into the detached part can
+    // find the engine, but the patch doesn't know about this part so it never plays
+    res->parentPatch = live->parentPatch;
+    res->setSampleRate(live->getSampleRate(), live->getSampleRateInv());
+    return res;
+}
+
+struct Engine::GroupAdoption
+{
+    int16_t part{0};
+    int firstGroup{-1};
+    std::unique_ptr<Part> detached;
+    Part::groupContainer_t staging;
+    int groupOffset{0};
+    bool adopted{false};
+};
+
+void Engine::adoptDetachedPart(int16_t pt, std::unique_ptr<Part> detached, int firstGroup)
+{
+    assert(messageController->threadingChecker.isSerialThread());
+
+    auto adoption = std::make_shared<GroupAdoption>();
+    adoption->part = pt;
+    adoption->firstGroup = firstGroup;
+    adoption->detached = std::move(detached);
+    stageGroupAdoption(adoption);
+}
+
+void Engine::stageGroupAdoption(const std::shared_ptr<GroupAdoption> &adoption)
+{
+    assert(messageController->threadingChecker.isSerialThread());
+
+    // Size the merged group list here so the audio thread only moves pointers. Other
+    // structure changes could slip in ahead of us in the queue, so leave a little room,
+    // and if that still isn't enough the audio thread sends us round again.
+    auto pt = adoption->part;
+    const auto &live = patch->getPart(pt);
+    adoption->staging = Part::groupContainer_t();
+    // The adopted zones aren't live yet, so they can take their loop seams here
+    for (const auto &g : adoption->detached->getGroups())
+        for (const auto &z : g->getZones())
+            z->setupLoopSeams();
+    // and the pool can take their group processors before the audio thread spawns them
+    reserveProcessorMemory(*adoption->detached);
+    adoption->staging.reserve(live->getGroups().size() + adoption->detached->getGroups().size() +
+                              16);
+
+    messageController->scheduleAudioThreadCallbackUnderStructureLock(
+        [adoption, pt](auto &e) {
+            auto &part = e.getPatch()->getPart(pt);
+            auto needed = part->getGroups().size() + adoption->detached->getGroups().size();
+            if (adoption->staging.capacity() < needed)
+                return;
+            adoption->groupOffset = part->getGroups().size();
+            part->adoptGroupsFrom(*adoption->detached, adoption->staging);
+            for (auto g = (size_t)adoption->groupOffset; g < part->getGroups().size(); ++g)
+                part->getGroup(g)->respawnProcessors();
+            adoption->adopted = true;
+        },
+        [this, adoption, pt](const auto &) {
+            if (!adoption->adopted)
+            {
+                stageGroupAdoption(adoption);
+                return;
+            }
+
+            // Drop the emptied containers here rather than on the audio thread
+            adoption->staging = Part::groupContainer_t();
+            adoption->detached.reset();
+
+            auto fg = adoption->firstGroup >= 0 ? adoption->groupOffset + adoption->firstGroup
+                                                : -1;
+            selectionManager->selectAction({pt, fg, fg >= 0 ? 0 : -1, true, true, true});
+            serializationSendToClient(messaging::client::s2c_send_pgz_structure,
+                                      getPartGroupZoneStructure(-1), *messageController);
+        });
 }
 
 void Engine::onSampleRateChanged()
 {
     patch->setSampleRate(sampleRate);
 
+    if (convertSamplesToEngineRate)
+    {
+        auto toRate = (uint32_t)std::lround(sampleRate);
+        if (toRate != sampleManager->getTargetSampleRate())
+        {
+            sampleManager->setTargetSampleRate(toRate);
+            messageController->scheduleSerializationThreadCallback(
+                [](auto &e) { e.reconvertSamplesToEngineRate(); });
+        }
+    }
+
     messageController->forceStatusUpdate = true;
 }
 } // namespace scxt::engine
\ No newline at end of file
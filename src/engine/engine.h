@@ -42,6 +42,8 @@
 #include <filesystem>
 #include <memory>
 #include <set>
+#include <unordered_map>
+#include <unordered_set>
 #include <cassert>
 #include <thread>
 
@@ -130,6 +132,8 @@ struct Engine : MoveableOnly<Engine>, SampleRateSupport
             {
                 for (const auto &[gidx, group] : sst::cpputils::enumerate(*part))
                 {
+                    if (group->outputInfo.muted)
+                        continue;
                     for (const auto &[zidx, zone] : sst::cpputils::enumerate(*group))
                     {
                         if (zone->mapping.keyboardRange.includes(key) &&
@@ -277,7 +281,106 @@ struct Engine : MoveableOnly<Engine>, SampleRateSupport
                                             KeyboardRange krange = {48, 72},
                                             VelocityRange vrange = {0, 127});
 
-    void loadSf2MultiSampleIntoSelectedPart(const fs::path &);
+    /*
+     * Imports build their groups into a detached part, which has the settings of
+     * part pt but which the audio thread never sees, and adoptDetachedPart then
+     * moves those groups onto the live part in a single audio thread step. So
+     * loading a multi-sample never has to stop playback. firstGroup is the index,
+     * within the detached part, of the group to select afterwards (or -1).
+     */
+    int16_t selectedPartForImport() const;
+    std::unique_ptr<Part> makeDetachedPart(int16_t pt) const;
+    void adoptDetachedPart(int16_t pt, std::unique_ptr<Part> detached, int firstGroup);
+
+    bool loadSf2MultiSampleIntoPart(const fs::path &, Part &into, int &firstGroup);
+    std::vector<sample::SampleLoader::Request> findSf2SampleAddresses(const fs::path &);
+
+    /*
+     * GigaStudio import. Each instrument becomes a group per keyswitch position, with
+     * all but the first muted, and each region's dimension regions become zones:
+     * velocity splits set the velocity range, layers and the two halves of a split
+     * stereo sample stack, release triggers are skipped, and other dimensions (round
+     * robin, controllers) import their first position. The samples must already be
+     * in the sample manager; findGigSampleAddresses lists the ones the file uses.
+     */
+    bool loadGigMultiSampleIntoPart(const fs::path &, Part &into, int &firstGroup);
+    std::vector<sample::SampleLoader::Request> findGigSampleAddresses(const fs::path &);
+
+    /*
+     * Background sample loading. The samples decode on the sample loader threads
+     * with progress reported to the client. Once the whole batch is in, the
+     * samples are installed in the sample manager and onLoaded is called on the
+     * serialization thread with an id per request (nullopt for failures).
+     */
+    typedef std::function<void(Engine &, const std::vector<std::optional<SampleID>> &,
+                               bool cancelled)>
+        sampleLoadCompletion_t;
+    void loadSamplesInBackground(std::vector<sample::SampleLoader::Request> requests,
+                                 sampleLoadCompletion_t onLoaded);
+    sample::SampleLoader::progressCallback_t makeSampleLoadProgressReporter();
+
+    /*
+     * Lazy patch restore. With the lazySampleLoading default set (it is off unless the
+     * user opts in), unstreaming a patch doesn't wait for its audio: the sample manager
+     * hands the pending samples here and the patch is playable straight away. Each sample
+     * is installed as it arrives and the zones using it are attached on the audio thread;
+     * until then noteOn skips those zones and asks, once, for their sample to jump the
+     * loader queue. s2c_patch_samples_ready goes out when the last one lands.
+     */
+    void restoreSamplesLazily(std::vector<sample::SampleLoader::Request> requests,
+                              uint64_t generation);
+
+    /*
+     * Sample residency under the sampleMemoryBudgetMB default. The budget is enforced
+     * from serial housekeeping by swapping cold samples for their preload heads, and a
+     * note on a head reloads the sample. Either way the version a zone drops is held
+     * in retiredSamples until no zone holds it and no voice is still reading it.
+     */
+    void requestSampleResidency(const SampleID &);
+    void enforceSampleMemoryBudget();
+
+    /*
+     * Load time rate conversion under the convertSamplesToEngineRate default. Samples
+     * are converted to the engine rate as they load, so a voice at the root key plays
+     * them without interpolating, and when the rate changes every sample at another
+     * rate is reloaded from its file and converted again in the background. Zones
+     * swap to each new version as it arrives, and play the old one until then.
+     */
+    void reconvertSamplesToEngineRate();
+
+    /*
+     * Background patch switching. A complete shadow patch is built, with all its
+     * samples loaded, on the serialization and loader threads while the current patch
+     * keeps sounding, and is then swapped in at a block boundary. The old patch keeps
+     * running into its own busses, mixed under the new one, until it has faded out
+     * (CROSSFADE, with CUT being a single block fade) or its voices have finished
+     * (LET_RING, capped at patchSwapMaxRingSeconds), and is then handed back to the
+     * serialization thread to be freed.
+     *
+     * build unstreams the new state into the shadow patch; the sample ids it uses are
+     * those of samples, and are remapped onto the running sample manager afterwards.
+     * onSwapped runs on the serialization thread once the new patch is live.
+     */
+    enum struct PatchSwapMode : int32_t
+    {
+        CUT = 0,
+        CROSSFADE = 1,
+        LET_RING = 2
+    };
+    static constexpr float patchSwapFadeSeconds{0.1f};
+    static constexpr float patchSwapMaxRingSeconds{10.f};
+    typedef std::function<void(Engine &, Patch &)> shadowPatchBuilder_t;
+    typedef std::function<void(Engine &)> shadowPatchSwapped_t;
+    void prepareShadowPatch(const sample::SampleManager::sampleAddressesAndIds_t &samples,
+                            shadowPatchBuilder_t build, shadowPatchSwapped_t onSwapped,
+                            PatchSwapMode mode);
+    // From the audio thread's a2s_patch_retired once a switched-out patch is silent
+    void freeRetiredPatch(Patch *);
+
+    /*
+     * Periodic serialization thread work, called about once a second
+     */
+    void runSerialHousekeeping();
 
     /*
      * OnRegister generate and send all the metdata the client needs
@@ -318,11 +421,111 @@ struct Engine : MoveableOnly<Engine>, SampleRateSupport
     const std::unique_ptr<MemoryPool> &getMemoryPool() { return memoryPool; }
 
     std::atomic<int32_t> stopEngineRequests{0};
+    // Bumped by the audio thread when a group processor can't get its pool memory
+    std::atomic<int32_t> groupProcessorSpawnFailures{0};
+
+    // Set by the host wrapper from the audio thread while bouncing. Voices started
+    // meanwhile swap the standard sinc for the long one (see Zone::InterpolationType)
+    bool isRenderingOffline{false};
+
+    /*
+     * Loop seams (see Zone::LoopSeams). Serial thread, under the structure lock. This
+     * rebuilds the seams any zone of the live patch lacks for its current sample and
+     * loop and swaps them in on the audio thread. What a zone drops waits in
+     * retiredLoopSeams until no voice holds it, so neither the swap nor a voice ending
+     * frees one on the audio thread.
+     */
+    void refreshLoopSeams();
+
+    /*
+     * Processor memory. Serial thread, or wherever the engine is unstreamed. Processors
+     * check their large state out of the memory pool as the audio thread spawns them, and
+     * that can't allocate, so these grow the pool first to hold every processor the patch
+     * could run at once: each zone processor on every voice, each group processor once,
+     * and one more of a type for the throwaway init in setProcessorType. The live patch
+     * always counts; pass a patch before installing it, or a type before a slot takes it.
+     */
+    void reserveProcessorMemory();
+    void reserveProcessorMemory(const Patch &incoming);
+    void reserveProcessorMemory(const Part &incoming);
+    // slots is how many groups or zones are about to take the type
+    void reserveProcessorMemory(dsp::processor::ProcessorType adding, bool forZone,
+                                size_t slots);
 
   private:
     std::unique_ptr<Patch> patch;
     std::unique_ptr<MemoryPool> memoryPool;
     std::unique_ptr<sample::SampleManager> sampleManager;
+    // A sample for every zone using forID; that is the sample's own id unless the
+    // manager already had its file under another one, which the zones then take on
+    struct ZoneSampleSwap
+    {
+        SampleID forID;
+        std::shared_ptr<sample::Sample> sample;
+    };
+    // Samples installed in the manager but not yet swapped into their zones
+    std::vector<ZoneSampleSwap> zoneAttachQueue;
+    void installLazilyRestoredSample(const std::shared_ptr<sample::Sample> &, uint64_t generation);
+    void queueSampleForZones(const ZoneSampleSwap &, uint64_t generation);
+    void swapSamplesIntoZones(std::vector<ZoneSampleSwap> samples, uint64_t generation);
+    int32_t lazyRestoreInstalled{0}, lazyRestoreFailed{0};
+    void sendLazyRestoreCompleteIfDone();
+
+    // The patch switched out by prepareShadowPatch, while it rings out
+    std::unique_ptr<Patch> retiringPatch;
+    float retiringGain{0.f}, retiringGainStep{0.f};
+    int32_t retiringRingBlocks{0};
+    struct GroupAdoption;
+    void stageGroupAdoption(const std::shared_ptr<GroupAdoption> &);
+    struct ShadowPatchLoad;
+    void swapInShadowPatch(const std::shared_ptr<ShadowPatchLoad> &,
+                           const std::vector<sample::SampleLoader::Result> &, bool cancelled);
+    std::unique_ptr<Patch> makeShadowPatch();
+    void remapShadowSampleIDs(Patch &, const std::unordered_map<SampleID, SampleID> &);
+    void installShadowPatch(std::unique_ptr<Patch> &shadow, PatchSwapMode mode);
+    void processRetiringPatch();
+    void finishRetiringPatch();
+    bool isVoiceInPatch(const voice::Voice *, const Patch *) const;
+
+    std::vector<std::shared_ptr<sample::Sample>> retiredSamples;
+    bool retiredSweepInFlight{false};
+    uint64_t retiredSweepId{0};
+    void sweepRetiredSamples();
+
+    // The zone, by position and address, and sample slot of a loop seam rebuild
+    struct LoopSeamUpdate
+    {
+        int part, group, zone, index;
+        const Zone *forZone;
+        std::shared_ptr<const Zone::LoopSeams> seams;
+    };
+    std::vector<LoopSeamUpdate> staleLoopSeams(Patch &);
+    std::vector<std::shared_ptr<const Zone::LoopSeams>> retiredLoopSeams;
+
+    // What one processor of a type checks out at a sample rate, by size class, and how
+    // many of them the pool has had blocks added for
+    struct ProcessorMemoryDemand
+    {
+        double sampleRate{0};
+        std::array<int64_t, MemoryPool::nSizeClasses> blocks{};
+        int64_t reservedInstances{0};
+    };
+    std::unordered_map<int32_t, ProcessorMemoryDemand> processorMemoryDemand;
+    // The most of a type any one zone runs, and how many group slots run it
+    struct ProcessorUse
+    {
+        int64_t perVoice{0}, groups{0};
+    };
+    typedef std::unordered_map<int32_t, ProcessorUse> processorUse_t;
+    void countProcessorUse(const Part &, processorUse_t &) const;
+    void countProcessorUse(const Patch &, processorUse_t &) const;
+    void reserveProcessorInstances(const processorUse_t &);
+    int32_t groupProcessorSpawnFailuresSeen{0};
+    void respawnFailedGroupProcessors();
+
+    std::unordered_set<SampleID> residencyReloads;
+    bool convertSamplesToEngineRate{false};
+    uint64_t lastHousekeepingUseClock{0};
     std::unique_ptr<browser::BrowserDB> browserDb;
     std::unique_ptr<browser::Browser> browser;
     std::array<voice::Voice *, maxVoices> voices;
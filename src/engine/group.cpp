@@ -31,14 +31,16 @@
 
 #include "infrastructure/sse_include.h"
 
-#include "sst/basic-blocks/mechanics/block-ops.h"
 #include "sst/basic-blocks/dsp/PanLaws.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 
 #include "messaging/messaging.h"
 #include "patch.h"
 #include "engine.h"
+#include "dsp/block_mix.h"
 #include "group_and_zone_impl.h"
 
 namespace scxt::engine
@@ -55,11 +57,21 @@ Group::Group() : id(GroupID::next()), name(id.to_string()), routingTable(modMatr
         lfos[i].assign(&lfoStorage[i], modMatrix.getValuePtr(modulation::gmd_LFO_Rate, i), nullptr,
                        getEngine()->rngGen);
     }
+
+    memset(processorIntParams, 0, sizeof(processorIntParams));
+}
+
+Group::~Group()
+{
+    for (auto i = 0; i < processorCount; ++i)
+    {
+        dsp::processor::unspawnProcessor(processors[i]);
+    }
 }
 
 void Group::process(Engine &e)
 {
-    namespace blk = sst::basic_blocks::mechanics;
+    const auto &mix = dsp::blockMix();
 
     // TODO these memsets are probably gratuitous
     memset(output, 0, sizeof(output));
@@ -110,12 +122,27 @@ void Group::process(Engine &e)
         if (z->isActive())
         {
             z->process(e);
-            blk::accumulate_from_to<blockSize>(z->output[0], lOut);
-            blk::accumulate_from_to<blockSize>(z->output[1], rOut);
+            mix.accumulate(z->output[0], z->output[1], lOut, rOut);
         }
     }
 
-    // for processor do the necessary
+    for (int i = 0; i < processorCount; ++i)
+    {
+        if (!processors[i] || !processorStorage[i].isActive)
+            continue;
+
+        // int params aren't modulated so pick up edits to the storage directly
+        memcpy(&processorIntParams[i][0], processorStorage[i].intParams.data(),
+               sizeof(processorIntParams[i]));
+        processorMix[i].set_target(modMatrix.getValue(modulation::gmd_Processor_Mix, i));
+
+        processors[i]->process_stereo(lOut, rOut, processorOutput[0], processorOutput[1], 0.f);
+        processorMix[i].fade_blocks(lOut, processorOutput[0], lOut);
+        processorMix[i].fade_blocks(rOut, processorOutput[1], rOut);
+    }
+
+    if (ringingOut)
+        updateRingOut(lOut, rOut);
 
     // Pan
     auto pvo = modMatrix.getValue(modulation::gmd_pan, 0);
@@ -145,7 +172,11 @@ void Group::addActiveZone()
 {
     if (activeZones == 0)
     {
-        parentPart->addActiveGroup();
+        // A group ringing out is still counted by the part
+        if (ringingOut)
+            ringingOut = false;
+        else
+            parentPart->addActiveGroup();
     }
     activeZones++;
 }
@@ -156,7 +187,98 @@ void Group::removeActiveZone()
     activeZones--;
     if (activeZones == 0)
     {
+        if (anyProcessorActive())
+        {
+            ringingOut = true;
+            silentBlocks = 0;
+        }
+        else
+        {
+            parentPart->removeActiveGroup();
+        }
+    }
+}
+
+bool Group::anyProcessorActive() const
+{
+    for (int i = 0; i < processorCount; ++i)
+    {
+        if (processors[i] && processorStorage[i].isActive)
+            return true;
+    }
+    return false;
+}
+
+void Group::updateRingOut(const float *l, const float *r)
+{
+    float peak{0.f};
+    for (int i = 0; i < blockSize; ++i)
+        peak = std::max({peak, std::fabs(l[i]), std::fabs(r[i])});
+    silentBlocks = peak < ringOutSilence ? silentBlocks + 1 : 0;
+
+    if (!anyProcessorActive() || silentBlocks * blockSize >= ringOutSilentSeconds * sampleRate)
+        stopRingingOut();
+}
+
+void Group::stopRingingOut()
+{
+    if (!ringingOut)
+        return;
+
+    ringingOut = false;
+    for (auto *p : processors)
+    {
+        if (p)
+            p->suspend();
+    }
+    if (parentPart)
         parentPart->removeActiveGroup();
+}
+
+void Group::onProcessorTypeChanged(int w, dsp::processor::ProcessorType t)
+{
+    dsp::processor::unspawnProcessor(processors[w]);
+    processors[w] = nullptr;
+
+    if (t != dsp::processor::proct_none)
+    {
+        assert(getEngine());
+
+        // Spawn against current values so init sees the params it will run with
+        modMatrix.copyBaseValuesFromGroup(*this);
+        modMatrix.initializeModulationValues();
+        memcpy(&processorIntParams[w][0], processorStorage[w].intParams.data(),
+               sizeof(processorIntParams[w]));
+
+        processors[w] = dsp::processor::spawnProcessorInPlace(
+            t, getEngine()->getMemoryPool().get(), processorPlacementStorage[w],
+            dsp::processor::processorMemoryBufferSize,
+            modMatrix.getValuePtr(modulation::gmd_Processor_FP1, w), processorIntParams[w]);
+
+        if (processors[w])
+        {
+            processors[w]->setSampleRate(getEngine()->getSampleRate());
+            processors[w]->init();
+            if (processors[w]->memoryPoolFailed)
+            {
+                // Housekeeping refills the pool and spawns it again
+                dsp::processor::unspawnProcessor(processors[w]);
+                processors[w] = nullptr;
+                getEngine()->groupProcessorSpawnFailures++;
+            }
+        }
+        processorMix[w].set_target_instant(processorStorage[w].mix);
+    }
+
+    modMatrix.snapDepthScalesFromGroup(*this);
+}
+
+void Group::respawnProcessors()
+{
+    for (int p = 0; p < processorCount; ++p)
+    {
+        setupProcessorControlDescriptions(p, processorStorage[p].type);
+        onProcessorTypeChanged(p, processorStorage[p].type);
     }
 }
 
@@ -169,10 +291,10 @@ engine::Engine *Group::getEngine()
 
 void Group::setupOnUnstream(const engine::Engine &e)
 {
+    // The processors themselves wait for respawnProcessors
     for (int p = 0; p < processorCount; ++p)
     {
         setupProcessorControlDescriptions(p, processorStorage[p].type);
-        onProcessorTypeChanged(p, processorStorage[p].type);
     }
 
     modMatrix.copyBaseValuesFromGroup(*this);
@@ -192,6 +314,12 @@ void Group::onSampleRateChanged()
         lfos[i].assign(&lfoStorage[i], modMatrix.getValuePtr(modulation::gmd_LFO_Rate, i), nullptr,
                        getEngine()->rngGen);
     }
+
+    for (auto *p : processors)
+    {
+        if (p)
+            p->setSampleRate(sampleRate);
+    }
 }
 
 template struct HasGroupZoneProcessors<Group>;
@@ -56,6 +56,7 @@ constexpr int lfosPerGroup{3};
 struct Group : MoveableOnly<Group>, HasGroupZoneProcessors<Group>, SampleRateSupport
 {
     Group();
+    ~Group();
     GroupID id;
 
     std::string name{};
@@ -130,10 +131,20 @@ struct Group : MoveableOnly<Group>, HasGroupZoneProcessors<Group>, SampleRateSup
         return res;
     }
 
-    bool isActive() { return activeZones != 0; }
+    bool isActive() { return activeZones != 0 || ringingOut; }
     void addActiveZone();
     void removeActiveZone();
 
+    /*
+     * When its last zone stops, a group with active processors keeps running so their
+     * tails play out, until its output has stayed under ringOutSilence for
+     * ringOutSilentSeconds. Then the processors are suspended and the group goes idle.
+     */
+    static constexpr float ringOutSilence{1e-5f};
+    static constexpr double ringOutSilentSeconds{1.0};
+    bool isRingingOut() const { return ringingOut; }
+    void stopRingingOut();
+
     void onSampleRateChanged() override;
 
     /*
@@ -170,15 +181,33 @@ struct Group : MoveableOnly<Group>, HasGroupZoneProcessors<Group>, SampleRateSup
 
     bool anyModulatorUsed{false};
 
-    void onProcessorTypeChanged(int w, dsp::processor::ProcessorType t)
-    {
-        if (t != dsp::processor::ProcessorType::proct_none)
-        {
-            SCLOG("Group Processor Changed: " << w << " " << t);
-        }
-    }
+    /*
+     * Group processors run once per block on the summed output of the group's
+     * zones, so an effect applied identically to every voice can live here rather
+     * than in each voice. Their float params are the group mod matrix values, so
+     * they follow the group EGs and LFOs.
+     */
+    dsp::processor::Processor *processors[processorCount]{nullptr, nullptr, nullptr, nullptr};
+    uint8_t processorPlacementStorage alignas(
+        16)[processorCount][dsp::processor::processorMemoryBufferSize];
+    int32_t processorIntParams alignas(16)[processorCount][dsp::processor::maxProcessorIntParams];
+    float processorOutput alignas(16)[2][blockSize];
+    lipol processorMix[processorCount];
+
+    void onProcessorTypeChanged(int w, dsp::processor::ProcessorType t);
+    /*
+     * Spawn each slot's processor from processorStorage, refreshing its description
+     * and the matrix depth scales. Unstreaming only restores the storage, since
+     * spawning checks blocks out of the engine's memory pool, so this runs on the
+     * audio thread once an unstreamed group is installed where it can play.
+     */
+    void respawnProcessors();
 
     uint32_t activeZones{0};
+    bool ringingOut{false};
+    int32_t silentBlocks{0};
+    bool anyProcessorActive() const;
+    void updateRingOut(const float *l, const float *r);
 
     typedef std::vector<std::unique_ptr<Zone>> zoneContainer_t;
 
@@ -92,8 +92,13 @@ void HasGroupZoneProcessors<T>::setupProcessorControlDescriptions(
 
     auto *tmpProcessor = tmpProcessorFromAfar;
 
-    assert(asT()->getEngine() &&
-           asT()->getEngine()->getMessageController()->threadingChecker.isAudioThread());
+    /*
+     * No thread check here. Unstreaming calls this on the serialization thread while
+     * audio runs, and that is safe: a processor we spawn ourselves lives on the stack
+     * and is never init()ed, so it takes nothing from the memory pool, and the
+     * description we fill in is never read by the audio thread.
+     */
+    assert(asT()->getEngine());
 
     uint8_t memory[dsp::processor::processorMemoryBufferSize];
     float pfp[dsp::processor::maxProcessorFloatParams];
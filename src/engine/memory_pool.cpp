@@ -30,40 +30,141 @@
 
 namespace scxt::engine
 {
+void MemoryPool::SizeClass::push(data_t *block)
+{
+    auto fb = reinterpret_cast<FreeBlock *>(block);
+    fb->next = head.load(std::memory_order_relaxed);
+    while (!head.compare_exchange_weak(fb->next, fb, std::memory_order_release,
+                                       std::memory_order_relaxed))
+        ;
+    free++;
+}
+
 /*
- * A massive TODO here. Right now this allocates on the audio thread but we
- * can instead have this have a message contrller refecence at construction time
- * and instead try to ask the audio thread to allocate.
+ * Only one thread pops, so the head we read can't be popped and pushed back
+ * between our load and the exchange; pushes just make us go around again.
  */
+MemoryPool::data_t *MemoryPool::SizeClass::pop()
+{
+    auto fb = head.load(std::memory_order_acquire);
+    while (fb &&
+           !head.compare_exchange_weak(fb, fb->next, std::memory_order_acquire,
+                                       std::memory_order_acquire))
+        ;
+    if (!fb)
+        return nullptr;
+    free--;
+    return reinterpret_cast<data_t *>(fb);
+}
 
 MemoryPool::~MemoryPool()
 {
-    for (auto &[sz, s] : cache)
+    for (auto &c : classes)
     {
-        for (auto &p : s)
-        {
-            delete p;
-        }
+        assert(c.checkedOut == 0);
+        while (auto b = c.pop())
+            delete[] b;
     }
+}
 
-    assert(debugCheckouts == debugReturns);
+void MemoryPool::preReservePool(size_t blockSize)
+{
+    auto sc = sizeClassFor(blockSize);
+    if (sc == nSizeClasses)
+        return;
+    auto &c = classes[sc];
+    auto sp = c.spare.load();
+    while (sp < defaultSpareBlocks && !c.spare.compare_exchange_weak(sp, defaultSpareBlocks))
+        ;
 }
 
-#define ALLOCATE_IMPLEMENTATION 1
-#if ALLOCATE_IMPLEMENTATION
-void MemoryPool::preReservePool(size_t blockSize) {}
 MemoryPool::data_t *MemoryPool::checkoutBlock(size_t blockSize)
 {
-    // Technically don't need this in the naive impl but lets avoid some bugs
-    debugCheckouts++;
-    auto ubs = nearestBlock(blockSize);
-    return new data_t[ubs];
+    auto sc = sizeClassFor(blockSize);
+    if (sc == nSizeClasses)
+    {
+        oversizedRequests++;
+        return nullptr;
+    }
+
+    auto &c = classes[sc];
+    auto res = c.pop();
+    if (!res && allocateWhenDry)
+        res = new data_t[sizeClassBytes(sc)];
+    if (!res)
+    {
+        c.failures++;
+        return nullptr;
+    }
+    auto out = ++c.checkedOut;
+    if (out > c.highWater)
+        c.highWater = out;
+    return res;
 }
+
 void MemoryPool::returnBlock(data_t *block, size_t blockSize)
 {
-    debugReturns++;
-    delete[] block;
+    auto sc = sizeClassFor(blockSize);
+    if (!block || sc == nSizeClasses)
+        return;
+
+    auto &c = classes[sc];
+    c.checkedOut--;
+    c.push(block);
 }
-#endif
 
-} // namespace scxt::engine
\ No newline at end of file
+void MemoryPool::reserve(size_t blockSize, int64_t count)
+{
+    auto sc = sizeClassFor(blockSize);
+    if (sc == nSizeClasses)
+        return;
+    auto &c = classes[sc];
+    if (c.spare < count)
+        c.spare = count;
+    while (c.free < count)
+        c.push(new data_t[sizeClassBytes(sc)]);
+}
+
+void MemoryPool::addBlocks(size_t blockSize, int64_t count)
+{
+    auto sc = sizeClassFor(blockSize);
+    if (sc == nSizeClasses)
+        return;
+    auto &c = classes[sc];
+    for (int64_t i = 0; i < count; ++i)
+        c.push(new data_t[sizeClassBytes(sc)]);
+}
+
+void MemoryPool::refill()
+{
+    for (size_t sc = 0; sc < nSizeClasses; ++sc)
+    {
+        auto &c = classes[sc];
+        auto failures = c.failures.load();
+        if (failures != c.failuresAtLastRefill)
+        {
+            auto missed = failures - c.failuresAtLastRefill;
+            SCLOG("Memory pool ran out of " << sizeClassBytes(sc) << " byte blocks " << missed
+                                            << " times; high water " << c.highWater);
+            c.failuresAtLastRefill = failures;
+            // Keep enough spare that the same burst would have fit
+            c.spare += missed;
+        }
+        while (c.free < c.spare)
+            c.push(new data_t[sizeClassBytes(sc)]);
+    }
+}
+
+MemoryPool::Stats MemoryPool::getStats(size_t sizeClass) const
+{
+    assert(sizeClass < nSizeClasses);
+    const auto &c = classes[sizeClass];
+    Stats res;
+    res.blockSize = sizeClassBytes(sizeClass);
+    res.free = c.free;
+    res.checkedOut = c.checkedOut;
+    res.highWater = c.highWater;
+    res.failures = c.failures;
+    return res;
+}
+} // namespace scxt::engine
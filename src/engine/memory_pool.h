@@ -28,35 +28,99 @@
 #ifndef SCXT_SRC_ENGINE_MEMORY_POOL_H
 #define SCXT_SRC_ENGINE_MEMORY_POOL_H
 
+#include <array>
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
-#include <cctype>
-#include <unordered_map>
-#include <unordered_set>
 
 #include "utils.h"
 
 namespace scxt::engine
 {
+/*
+ * The pool processors and effects take their delay lines and other large state
+ * from. Blocks come in power of two size classes, each with a lock-free free list
+ * which the audio thread checks out of and returns to without touching the system
+ * allocator.
+ *
+ * Free lists are single consumer: checkoutBlock belongs to the audio thread (or
+ * whoever stands in for it when audio isn't running). Blocks may be returned and
+ * the pool refilled from any thread. When a class runs dry, or a request is bigger
+ * than the largest class, checkoutBlock returns nullptr and counts a failure; the
+ * caller does without. Refill, which the engine runs with its serial housekeeping,
+ * then tops the class up so it doesn't happen again.
+ *
+ * That is a last resort. The engine works out what each processor type checks out by
+ * spawning one into a pool built to allocate when dry, off the audio thread, and adds
+ * blocks for every instance a patch could run before the audio thread spawns them.
+ */
 struct MemoryPool : MoveableOnly<MemoryPool>
 {
     typedef uint8_t data_t;
 
+    static constexpr size_t minBlockBits{10}, maxBlockBits{22}; // 1k to 4M
+    static constexpr size_t nSizeClasses{maxBlockBits - minBlockBits + 1};
+    // Spare blocks refill keeps in a class once something has asked for it
+    static constexpr int64_t defaultSpareBlocks{4};
+
+    MemoryPool() = default;
+    // A pool which allocates rather than fail when a class is dry. Never the audio thread's
+    explicit MemoryPool(bool allocateWhenDry) : allocateWhenDry(allocateWhenDry) {}
     ~MemoryPool();
 
+    // Audio thread. Notes that blocks of this size will be wanted; never allocates
     void preReservePool(size_t blockSize);
-
+    // Audio thread. Never allocates, so nullptr if there is no free block to hand
     data_t *checkoutBlock(size_t blockSize);
     void returnBlock(data_t *block, size_t blockSize);
 
-  private:
-    template <size_t N = 10> static inline size_t nearestBlock(size_t x)
+    // Not on the audio thread. Keep at least count blocks of this size free
+    void reserve(size_t blockSize, int64_t count);
+    // Not on the audio thread. Allocate count more free blocks of this size
+    void addBlocks(size_t blockSize, int64_t count);
+    // Not on the audio thread. Top every class back up to its spare count
+    void refill();
+
+    struct Stats
     {
-        return ((x >> N) + 1) * (1 << N);
+        size_t blockSize{0};
+        int64_t free{0}, checkedOut{0}, highWater{0}, failures{0};
+    };
+    Stats getStats(size_t sizeClass) const;
+    // Requests bigger than the largest class, which always fail
+    int64_t getOversizedRequests() const { return oversizedRequests; }
+
+    static constexpr size_t sizeClassBytes(size_t sizeClass)
+    {
+        return (size_t)1 << (sizeClass + minBlockBits);
+    }
+    static size_t sizeClassFor(size_t blockSize)
+    {
+        size_t res{0};
+        while (res < nSizeClasses && sizeClassBytes(res) < blockSize)
+            res++;
+        return res; // nSizeClasses if it's too big for any
     }
-    void growBlock(size_t blockSize);
-    std::unordered_map<size_t, std::unordered_set<data_t *>> cache;
 
-    int64_t debugCheckouts{0}, debugReturns{0};
+  private:
+    // A free block holds the link to the next one in its first bytes
+    struct FreeBlock
+    {
+        FreeBlock *next;
+    };
+    struct SizeClass
+    {
+        std::atomic<FreeBlock *> head{nullptr};
+        std::atomic<int64_t> free{0}, checkedOut{0}, highWater{0}, failures{0};
+        std::atomic<int64_t> spare{0};
+        int64_t failuresAtLastRefill{0};
+
+        void push(data_t *);
+        data_t *pop();
+    };
+    std::array<SizeClass, nSizeClasses> classes;
+    std::atomic<int64_t> oversizedRequests{0};
+    bool allocateWhenDry{false};
 };
 } // namespace scxt::engine
 
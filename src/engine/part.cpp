@@ -32,14 +32,13 @@
 
 #include "selection/selection_manager.h"
 
-#include "infrastructure/sse_include.h"
-#include "sst/basic-blocks/mechanics/block-ops.h"
+#include "dsp/block_mix.h"
 
 namespace scxt::engine
 {
 void Part::process(Engine &e)
 {
-    namespace blk = sst::basic_blocks::mechanics;
+    const auto &mix = dsp::blockMix();
 
     for (auto &sm : midiCCSmoothers)
         if (sm.active)
@@ -57,10 +56,10 @@ void Part::process(Engine &e)
             {
                 bi = (BusAddress)(MAIN_0 + partNumber);
             }
-            blk::accumulate_from_to<blockSize>(g->output[0],
-                                               e.getPatch()->busses.partBusses[bi].output[0]);
-            blk::accumulate_from_to<blockSize>(g->output[1],
-                                               e.getPatch()->busses.partBusses[bi].output[1]);
+            // Our own patch's busses, not the engine's, so a patch which is being
+            // switched out can keep ringing into its own outputs
+            auto &bus = parentPatch->busses.partBusses[bi];
+            mix.accumulate(g->output[0], g->output[1], bus.output[0], bus.output[1]);
         }
     }
 }
@@ -132,7 +132,12 @@ struct Part : MoveableOnly<Part>, SampleRateSupport
     typedef std::vector<std::unique_ptr<Group>> groupContainer_t;
 
     const groupContainer_t &getGroups() const { return groups; }
-    void clearGroups() { groups.clear(); }
+    void clearGroups()
+    {
+        for (auto &g : groups)
+            g->stopRingingOut();
+        groups.clear();
+    }
     int getGroupIndex(const GroupID &zid) const
     {
         for (const auto &[idx, r] : sst::cpputils::enumerate(groups))
@@ -148,9 +153,32 @@ struct Part : MoveableOnly<Part>, SampleRateSupport
 
         auto res = std::move(groups[idx]);
         groups.erase(groups.begin() + idx);
+        res->stopRingingOut();
         res->parentPart = nullptr;
         return res;
     }
+
+    /*
+     * Move every group of another (detached) part onto the end of this one. The
+     * merged list is built in staging, which must be empty, and swapped in, so if
+     * staging already has room for both sets of groups this doesn't allocate and is
+     * safe to call from the audio thread. On return staging holds our old, emptied
+     * container; free it back on the serialization thread.
+     */
+    void adoptGroupsFrom(Part &other, groupContainer_t &staging)
+    {
+        assert(staging.empty());
+        for (auto &g : groups)
+            staging.push_back(std::move(g));
+        for (auto &g : other.groups)
+        {
+            g->parentPart = this;
+            staging.push_back(std::move(g));
+        }
+        other.groups.clear();
+        groups.swap(staging);
+        staging.clear();
+    }
     groupContainer_t::iterator begin() noexcept { return groups.begin(); }
     groupContainer_t::const_iterator cbegin() const noexcept { return groups.cbegin(); }
 
@@ -26,13 +26,13 @@
  */
 
 #include "patch.h"
-#include "sst/basic-blocks/mechanics/block-ops.h"
+#include "dsp/block_mix.h"
 
 namespace scxt::engine
 {
 void Patch::process(Engine &e)
 {
-    namespace mech = sst::basic_blocks::mechanics;
+    const auto &mix = dsp::blockMix();
     // Run each of the parts, accumulating onto the engine busses
     for (const auto &part : parts)
     {
@@ -55,9 +55,10 @@ void Patch::process(Engine &e)
             {
                 if (b.busSendStorage.sendLevels[i] != 0.f)
                 {
-                    mech::scale_accumulate_from_to<blockSize>(
-                        b.auxoutput[0], b.auxoutput[1], b.busSendStorage.sendLevels[i],
-                        busses.auxBusses[i].output[0], busses.auxBusses[i].output[1]);
+                    mix.scaleAccumulate(b.auxoutput[0], b.auxoutput[1],
+                                        b.busSendStorage.sendLevels[i],
+                                        busses.auxBusses[i].output[0],
+                                        busses.auxBusses[i].output[1]);
                 }
             }
         }
@@ -73,10 +74,8 @@ void Patch::process(Engine &e)
         if (br == 0)
         {
             // accumulate onto main
-            mech::accumulate_from_to<blockSize>(busses.partBusses[bi].output[0],
-                                                busses.mainBus.output[0]);
-            mech::accumulate_from_to<blockSize>(busses.partBusses[bi].output[1],
-                                                busses.mainBus.output[1]);
+            mix.accumulate(busses.partBusses[bi].output[0], busses.partBusses[bi].output[1],
+                           busses.mainBus.output[0], busses.mainBus.output[1]);
         }
     }
 
@@ -85,10 +84,8 @@ void Patch::process(Engine &e)
         if (br == 0)
         {
             // accumulate onto main
-            mech::accumulate_from_to<blockSize>(busses.auxBusses[bi].output[0],
-                                                busses.mainBus.output[0]);
-            mech::accumulate_from_to<blockSize>(busses.auxBusses[bi].output[1],
-                                                busses.mainBus.output[1]);
+            mix.accumulate(busses.auxBusses[bi].output[0], busses.auxBusses[bi].output[1],
+                           busses.mainBus.output[0], busses.mainBus.output[1]);
         }
     }
 
@@ -112,6 +109,13 @@ void Patch::setupBussesOnUnstream(Engine &e)
         a.initializeAfterUnstream(e);
     }
 }
+void Patch::respawnGroupProcessors()
+{
+    for (const auto &part : parts)
+        for (const auto &group : *part)
+            group->respawnProcessors();
+}
+
 void Patch::onSampleRateChanged()
 {
     for (const auto &part : parts)
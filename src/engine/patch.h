@@ -128,6 +128,8 @@ struct Patch : MoveableOnly<Patch>, SampleRateSupport
     }
 
     void setupBussesOnUnstream(Engine &e);
+    // Audio thread, once an unstreamed patch is live (see Group::respawnProcessors)
+    void respawnGroupProcessors();
     PatchID id;
     uint64_t streamingVersion{0}; // we use hex dates for these
 
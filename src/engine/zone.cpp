@@ -34,17 +34,36 @@
 #include "messaging/messaging.h"
 #include "voice/voice.h"
 
-#include "sst/basic-blocks/mechanics/block-ops.h"
+#include "dsp/block_mix.h"
 #include "group_and_zone_impl.h"
 
 namespace scxt::engine
 {
 void Zone::process(Engine &e)
 {
-    namespace blk = sst::basic_blocks::mechanics;
+    const auto &mix = dsp::blockMix();
     // TODO these memsets are probably gratuitous
     memset(output, 0, sizeof(output));
 
+    // Run the voices a step at a time, so each processor slot runs across them all
+    std::array<voice::Voice *, maxVoices> running;
+    size_t runningCount{0};
+    for (auto &v : voiceWeakPointers)
+    {
+        if (v && v->isVoiceAssigned && v->processUpToProcessors())
+        {
+            running[runningCount++] = v;
+        }
+    }
+    for (auto i = 0; i < processorCount; ++i)
+    {
+        voice::Voice::processProcessorAcrossVoices(running.data(), runningCount, i);
+    }
+    for (size_t i = 0; i < runningCount; ++i)
+    {
+        running[i]->processAfterProcessors();
+    }
+
     std::array<voice::Voice *, maxVoices> toCleanUp;
     size_t cleanupIdx{0};
     gatedVoiceCount = 0;
@@ -52,21 +71,15 @@ void Zone::process(Engine &e)
     {
         if (v && v->isVoiceAssigned)
         {
-            if (v->process())
+            if (outputInfo.routeTo == DEFAULT_BUS)
+            {
+                mix.accumulate(v->output[0], v->output[1], output[0], output[1]);
+            }
+            else if (outputInfo.routeTo >= 0)
             {
-                if (outputInfo.routeTo == DEFAULT_BUS)
-                {
-                    blk::accumulate_from_to<blockSize>(v->output[0], output[0]);
-                    blk::accumulate_from_to<blockSize>(v->output[1], output[1]);
-                }
-                else if (outputInfo.routeTo >= 0)
-                {
-                    auto &bs = getEngine()->getPatch()->busses;
-                    blk::accumulate_from_to<blockSize>(
-                        v->output[0], bs.busByAddress(outputInfo.routeTo).output[0]);
-                    blk::accumulate_from_to<blockSize>(
-                        v->output[1], bs.busByAddress(outputInfo.routeTo).output[1]);
-                }
+                auto &bs = parentGroup->parentPart->parentPatch->busses;
+                auto &bus = bs.busByAddress(outputInfo.routeTo);
+                mix.accumulate(v->output[0], v->output[1], bus.output[0], bus.output[1]);
             }
             if (!v->isVoicePlaying)
             {
@@ -186,7 +199,7 @@ bool Zone::attachToSample(const sample::SampleManager &manager, int index)
         {
             const auto &m = samplePointers[index]->meta;
             s.startSample = 0;
-            s.endSample = samplePointers[index]->getSampleLength();
+            s.endSample = samplePointers[index]->getSourceSampleLength();
             if (m.loop_present)
             {
                 s.startLoop = m.loop_start;
@@ -203,6 +216,81 @@ bool Zone::attachToSample(const sample::SampleManager &manager, int index)
     return samplePointers[index] != nullptr;
 }
 
+bool Zone::wantsLoopSeams(int index) const
+{
+    const auto &s = samplePointers[index];
+    const auto &sd = sampleData[index];
+    // A residency head reloads as soon as it plays, so it isn't worth a seam
+    return s && !s->isResidencyHead() && sd.loopActive && sd.loopDirection == FORWARD_ONLY;
+}
+
+bool Zone::loopSeamsCurrent(int index) const
+{
+    const auto &current = loopSeams[index];
+    if (!wantsLoopSeams(index))
+        return !current;
+    return current && current->builtFor(samplePointers[index].get(), sampleData[index]);
+}
+
+void Zone::setupLoopSeams()
+{
+    for (int i = 0; i < maxSamplesPerZone; ++i)
+    {
+        if (!loopSeamsCurrent(i))
+            loopSeams[i] = wantsLoopSeams(i) ? buildLoopSeams(i) : nullptr;
+    }
+}
+
+std::shared_ptr<const Zone::LoopSeams> Zone::buildLoopSeams(int index) const
+{
+    const auto &s = samplePointers[index];
+    const auto &sd = sampleData[index];
+    assert(s);
+
+    auto res = std::make_shared<LoopSeams>();
+    res->sample = s;
+    res->startLoop = sd.startLoop;
+    res->endLoop = sd.endLoop;
+    res->loopFade = sd.loopFade;
+
+    auto format = dsp::GSF_I16;
+    if (s->bitDepth == sample::Sample::BD_F32)
+        format = dsp::GSF_F32;
+    else if (s->bitDepth == sample::Sample::BD_F16)
+        format = dsp::GSF_F16;
+    auto frameBytes = format == dsp::GSF_F32 ? 4 : 2;
+    auto stereo = s->channels != 1;
+
+    // The bounds each level's voices loop over, found as Voice::initializeGenerator and
+    // moveToGeneratorLevel find them. The fade is in file frames, as the zone's positions are
+    auto lower = s->toStoredPosition((int32_t)sd.startLoop);
+    auto upper = s->toStoredPosition((int32_t)sd.endLoop);
+    auto fade = sd.loopFade * s->getPositionScale();
+    for (int level = 0; level < s->getMipmapLevelCount(); ++level)
+    {
+        auto data = s->getMipmapLevel(level);
+        dsp::GeneratorIO io;
+        io.sampleDataL = data.sampleData[0];
+        io.sampleDataR = data.sampleData[1];
+        io.waveSize = data.sample_length;
+        auto lo = s->toMipmapPosition(lower, level);
+        auto hi = s->toMipmapPosition(upper, level);
+        auto fadeFrames = (int)std::lround(fade / (1 << level));
+        auto frames = dsp::GeneratorLoopSeamFrames(io, lo, hi, fadeFrames);
+        if (frames == 0)
+            continue;
+
+        auto &seam = res->levels[level];
+        for (int c = 0; c < (stereo ? 2 : 1); ++c)
+        {
+            res->storage[level][c].resize(frames * frameBytes);
+            seam.storage[c] = res->storage[level][c].data();
+        }
+        dsp::BuildGeneratorLoopSeam(seam, io, format, stereo, lo, hi, fadeFrames);
+    }
+    return res;
+}
+
 std::string Zone::toStringPlayMode(const PlayMode &p)
 {
     switch (p)
@@ -273,5 +361,33 @@ Zone::LoopDirection Zone::fromStringLoopDirection(const std::string &s)
     return p->second;
 }
 
+std::string Zone::toStringInterpolationType(const InterpolationType &p)
+{
+    switch (p)
+    {
+    case ZERO_ORDER_HOLD:
+        return "zoh";
+    case LINEAR:
+        return "linear";
+    case HERMITE_CUBIC:
+        return "hermite";
+    case SINC:
+        return "sinc";
+    case LONG_SINC:
+        return "long_sinc";
+    }
+    return "sinc";
+}
+
+Zone::InterpolationType Zone::fromStringInterpolationType(const std::string &s)
+{
+    static auto inverse = makeEnumInverse<Zone::InterpolationType, Zone::toStringInterpolationType>(
+        Zone::InterpolationType::ZERO_ORDER_HOLD, Zone::InterpolationType::LONG_SINC);
+    auto p = inverse.find(s);
+    if (p == inverse.end())
+        return SINC;
+    return p->second;
+}
+
 template struct HasGroupZoneProcessors<Zone>;
 } // namespace scxt::engine
\ No newline at end of file
@@ -95,6 +95,19 @@ struct Zone : MoveableOnly<Zone>, HasGroupZoneProcessors<Zone>
     };
     DECLARE_ENUM_STRING(LoopDirection);
 
+    // Cheapest first. SINC is the generator's long standing 16 tap sinc; LONG_SINC is
+    // for offline rendering, and sounding zones use it in place of SINC when the
+    // engine is rendering offline
+    enum InterpolationType
+    {
+        ZERO_ORDER_HOLD,
+        LINEAR,
+        HERMITE_CUBIC,
+        SINC,
+        LONG_SINC
+    };
+    DECLARE_ENUM_STRING(InterpolationType);
+
     struct AssociatedSample
     {
         bool active{false};
@@ -106,6 +119,7 @@ struct Zone : MoveableOnly<Zone>, HasGroupZoneProcessors<Zone>
         bool playReverse{false};
         LoopMode loopMode{LOOP_DURING_VOICE};
         LoopDirection loopDirection{FORWARD_ONLY};
+        InterpolationType interpolationType{SINC};
         int loopCountWhenCounted{0};
 
         int64_t loopFade{0};
@@ -120,6 +134,38 @@ struct Zone : MoveableOnly<Zone>, HasGroupZoneProcessors<Zone>
     typedef std::array<AssociatedSample, maxSamplesPerZone> AssociatedSampleArray;
     AssociatedSampleArray sampleData;
     std::array<std::shared_ptr<sample::Sample>, maxSamplesPerZone> samplePointers;
+    // Audio thread only. Set once noteOn has asked for sample 0 to be loaded, and cleared
+    // when its pointer is swapped, so a note on a missing sample asks just the once
+    bool sampleWantedSent{false};
+
+    /*
+     * The loop seams (see dsp::GeneratorLoopSeam) for a sample's forward loop, one per
+     * mipmap level, which every voice playing it reads. Engine::refreshLoopSeams builds
+     * them on the serial thread when the sample or its loop changes. A voice only takes
+     * them if they were built for the sample and loop it plays, and until they are it
+     * wraps at the loop end without the crossfade.
+     */
+    struct LoopSeams
+    {
+        std::shared_ptr<sample::Sample> sample;
+        int64_t startLoop{-1}, endLoop{-1}, loopFade{0};
+        static constexpr int nLevels{sample::Sample::maxMipmapLevels + 1};
+        std::array<dsp::GeneratorLoopSeam, nLevels> levels;
+        std::array<std::array<std::vector<uint8_t>, 2>, nLevels> storage;
+
+        bool builtFor(const sample::Sample *s, const AssociatedSample &sd) const
+        {
+            return s && s == sample.get() && sd.startLoop == startLoop &&
+                   sd.endLoop == endLoop && sd.loopFade == loopFade;
+        }
+    };
+    std::array<std::shared_ptr<const LoopSeams>, maxSamplesPerZone> loopSeams;
+    // Serial thread, under the structure lock
+    bool wantsLoopSeams(int index) const;
+    bool loopSeamsCurrent(int index) const;
+    std::shared_ptr<const LoopSeams> buildLoopSeams(int index) const;
+    // Bring every sample's seams up to date, for a zone which isn't live yet
+    void setupLoopSeams();
 
     struct ZoneOutputInfo
     {
@@ -0,0 +1,177 @@
+/*
+ * Shortcircuit XT - a Surge Synth Team product
+ *
+ * A fully featured creative sampler, available as a standalone
+ * and plugin for multiple platforms.
+ *
+ * Copyright 2019 - 2023, Various authors, as described in the github
+ * transaction log.
+ *
+ * ShortcircuitXT is released under the Gnu General Public Licence
+ * V3 or later (GPL-3.0-or-later). The license is found in the file
+ * "LICENSE" in the root of this repository or at
+ * https://www.gnu.org/licenses/gpl-3.0.en.html
+ *
+ * Individual sections of code which comprises ShortcircuitXT in this
+ * repository may also be used under an MIT license. Please see the
+ * section  "Licensing" in "README.md" for details.
+ *
+ * ShortcircuitXT is inspired by, and shares code with, the
+ * commercial product Shortcircuit 1 and 2, released by VemberTech
+ * in the mid 2000s. The code for Shortcircuit 2 was opensourced in
+ * 2020 at the outset of this project.
+ *
+ * All source for ShortcircuitXT is available at
+ * https://github.com/surge-synthesizer/shortcircuit-xt
+ */
+
+
+#ifndef SCXT_SRC_INFRASTRUCTURE_CONTENT_HASH_H
+#define SCXT_SRC_INFRASTRUCTURE_CONTENT_HASH_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+namespace scxt::infrastructure
+{
+/**
+ * A streaming 64 bit content hash. This is the XXH64 algorithm (so results match
+ * the reference implementation with the same seed) written out so we don't need
+ * another dependency. It is fast enough to run over every decoded sample at load.
+ */
+struct ContentHasher
+{
+    explicit ContentHasher(uint64_t seed = 0) : seed(seed)
+    {
+        acc[0] = seed + prime1 + prime2;
+        acc[1] = seed + prime2;
+        acc[2] = seed;
+        acc[3] = seed - prime1;
+    }
+
+    void update(const void *data, size_t len)
+    {
+        auto p = static_cast<const uint8_t *>(data);
+        totalLen += len;
+
+        if (bufferUsed + len < 32)
+        {
+            std::memcpy(buffer + bufferUsed, p, len);
+            bufferUsed += len;
+            return;
+        }
+
+        if (bufferUsed)
+        {
+            auto fill = 32 - bufferUsed;
+            std::memcpy(buffer + bufferUsed, p, fill);
+            consumeStripe(buffer);
+            p += fill;
+            len -= fill;
+            bufferUsed = 0;
+        }
+
+        while (len >= 32)
+        {
+            consumeStripe(p);
+            p += 32;
+            len -= 32;
+        }
+
+        std::memcpy(buffer, p, len);
+        bufferUsed = len;
+    }
+
+    template <typename T> void updateValue(const T &v) { update(&v, sizeof(T)); }
+
+    uint64_t digest() const
+    {
+        uint64_t h;
+        if (totalLen >= 32)
+        {
+            h = rotl(acc[0], 1) + rotl(acc[1], 7) + rotl(acc[2], 12) + rotl(acc[3], 18);
+            for (int i = 0; i < 4; ++i)
+                h = mergeRound(h, acc[i]);
+        }
+        else
+        {
+            h = seed + prime5;
+        }
+        h += totalLen;
+
+        const uint8_t *p = buffer;
+        auto len = bufferUsed;
+        while (len >= 8)
+        {
+            h ^= round(0, read64(p));
+            h = rotl(h, 27) * prime1 + prime4;
+            p += 8;
+            len -= 8;
+        }
+        if (len >= 4)
+        {
+            h ^= (uint64_t)read32(p) * prime1;
+            h = rotl(h, 23) * prime2 + prime3;
+            p += 4;
+            len -= 4;
+        }
+        while (len > 0)
+        {
+            h ^= (*p) * prime5;
+            h = rotl(h, 11) * prime1;
+            p++;
+            len--;
+        }
+
+        h ^= h >> 33;
+        h *= prime2;
+        h ^= h >> 29;
+        h *= prime3;
+        h ^= h >> 32;
+        return h;
+    }
+
+  private:
+    static constexpr uint64_t prime1{0x9E3779B185EBCA87ULL}, prime2{0xC2B2AE3D27D4EB4FULL},
+        prime3{0x165667B19E3779F9ULL}, prime4{0x85EBCA77C2B2AE63ULL}, prime5{0x27D4EB2F165667C5ULL};
+
+    static inline uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+    static inline uint64_t read64(const uint8_t *p)
+    {
+        uint64_t v;
+        std::memcpy(&v, p, 8);
+        return v;
+    }
+    static inline uint32_t read32(const uint8_t *p)
+    {
+        uint32_t v;
+        std::memcpy(&v, p, 4);
+        return v;
+    }
+    static inline uint64_t round(uint64_t a, uint64_t input)
+    {
+        a += input * prime2;
+        a = rotl(a, 31);
+        return a * prime1;
+    }
+    static inline uint64_t mergeRound(uint64_t a, uint64_t v)
+    {
+        a ^= round(0, v);
+        return a * prime1 + prime4;
+    }
+    inline void consumeStripe(const uint8_t *p)
+    {
+        for (int i = 0; i < 4; ++i)
+            acc[i] = round(acc[i], read64(p + i * 8));
+    }
+
+    uint64_t seed{0};
+    uint64_t acc[4]{};
+    uint8_t buffer[32]{};
+    size_t bufferUsed{0};
+    uint64_t totalLen{0};
+};
+} // namespace scxt::infrastructure
+
+#endif // SHORTCIRCUITXT_CONTENT_HASH_H
@@ -0,0 +1,142 @@
+/*
+ * Shortcircuit XT - a Surge Synth Team product
+ *
+ * A fully featured creative sampler, available as a standalone
+ * and plugin for multiple platforms.
+ *
+ * Copyright 2019 - 2023, Various authors, as described in the github
+ * transaction log.
+ *
+ * ShortcircuitXT is released under the Gnu General Public Licence
+ * V3 or later (GPL-3.0-or-later). The license is found in the file
+ * "LICENSE" in the root of this repository or at
+ * https://www.gnu.org/licenses/gpl-3.0.en.html
+ *
+ * Individual sections of code which comprises ShortcircuitXT in this
+ * repository may also be used under an MIT license. Please see the
+ * section  "Licensing" in "README.md" for details.
+ *
+ * ShortcircuitXT is inspired by, and shares code with, the
+ * commercial product Shortcircuit 1 and 2, released by VemberTech
+ * in the mid 2000s. The code for Shortcircuit 2 was opensourced in
+ * 2020 at the outset of this project.
+ *
+ * All source for ShortcircuitXT is available at
+ * https://github.com/surge-synthesizer/shortcircuit-xt
+ */
+
+
+#include "cpu_isa.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+#if SCXT_ISA_X86 && defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+#include "utils.h"
+
+namespace scxt::infrastructure
+{
+namespace
+{
+bool detectAVX2()
+{
+#if SCXT_ISA_X86
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+    __cpuid(info, 1);
+    bool osxsave = info[2] & (1 << 27);
+    bool avx = info[2] & (1 << 28);
+    bool f16c = info[2] & (1 << 29);
+    if (!osxsave || !avx || !f16c || (_xgetbv(0) & 0x6) != 0x6)
+        return false;
+    __cpuidex(info, 7, 0);
+    return info[1] & (1 << 5);
+#else
+    __builtin_cpu_init();
+    // Our AVX2 level also uses F16C
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("f16c");
+#endif
+#else
+    return false;
+#endif
+}
+
+Isa initialIsa()
+{
+    auto res = bestAvailableIsa();
+    if (auto f = getenv("SCXT_FORCE_ISA"))
+    {
+        for (auto isa : {Isa::SCALAR, Isa::SSE2, Isa::AVX2})
+        {
+            if (strcmp(f, isaName(isa)) == 0 && isIsaAvailable(isa))
+                res = isa;
+        }
+    }
+    SCLOG("Running DSP kernels with " << isaName(res));
+    return res;
+}
+
+std::atomic<Isa> &activeIsaStorage()
+{
+    static std::atomic<Isa> res{initialIsa()};
+    return res;
+}
+} // namespace
+
+bool isIsaAvailable(Isa isa)
+{
+    switch (isa)
+    {
+    case Isa::SCALAR:
+    case Isa::SSE2:
+        return true;
+    case Isa::AVX2:
+    {
+        static const bool hasAVX2 = detectAVX2();
+        return hasAVX2;
+    }
+    }
+    return false;
+}
+
+Isa bestAvailableIsa()
+{
+    if (isIsaAvailable(Isa::AVX2))
+        return Isa::AVX2;
+    return Isa::SSE2;
+}
+
+const char *isaName(Isa isa)
+{
+    switch (isa)
+    {
+    case Isa::SCALAR:
+        return "scalar";
+    case Isa::SSE2:
+        return "sse2";
+    case Isa::AVX2:
+        return "avx2";
+    }
+    return "unknown";
+}
+
+Isa activeIsa() { return activeIsaStorage().load(std::memory_order_relaxed); }
+
+bool forceIsa(Isa isa)
+{
+    if (!isIsaAvailable(isa))
+        return false;
+    activeIsaStorage().store(isa, std::memory_order_relaxed);
+    return true;
+}
+
+void clearForcedIsa() { activeIsaStorage().store(bestAvailableIsa(), std::memory_order_relaxed); }
+} // namespace scxt::infrastructure
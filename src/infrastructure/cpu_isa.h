@@ -0,0 +1,79 @@
+/*
+ * Shortcircuit XT - a Surge Synth Team product
+ *
+ * A fully featured creative sampler, available as a standalone
+ * and plugin for multiple platforms.
+ *
+ * Copyright 2019 - 2023, Various authors, as described in the github
+ * transaction log.
+ *
+ * ShortcircuitXT is released under the Gnu General Public Licence
+ * V3 or later (GPL-3.0-or-later). The license is found in the file
+ * "LICENSE" in the root of this repository or at
+ * https://www.gnu.org/licenses/gpl-3.0.en.html
+ *
+ * Individual sections of code which comprises ShortcircuitXT in this
+ * repository may also be used under an MIT license. Please see the
+ * section  "Licensing" in "README.md" for details.
+ *
+ * ShortcircuitXT is inspired by, and shares code with, the
+ * commercial product Shortcircuit 1 and 2, released by VemberTech
+ * in the mid 2000s. The code for Shortcircuit 2 was opensourced in
+ * 2020 at the outset of this project.
+ *
+ * All source for ShortcircuitXT is available at
+ * https://github.com/surge-synthesizer/shortcircuit-xt
+ */
+
+
+#ifndef SCXT_SRC_INFRASTRUCTURE_CPU_ISA_H
+#define SCXT_SRC_INFRASTRUCTURE_CPU_ISA_H
+
+#include <cstdint>
+
+/*
+ * Which vector instruction set our hot kernels run with. Everything is compiled
+ * for the SSE2 baseline (simde maps it onto NEON on ARM); the kernels which have
+ * something to gain also carry variants marked SCXT_AVX2_TARGET, compiled for
+ * AVX2 in the same translation unit, and pick one at run time from activeIsa().
+ * Every variant of a kernel gives the same bits, so a mixed fleet renders the same.
+ *
+ * activeIsa() starts as the best the CPU has. The SCXT_FORCE_ISA environment
+ * variable (scalar, sse2 or avx2) or forceIsa() pins a lower one, which is how
+ * the tests run each variant on one machine.
+ */
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SCXT_ISA_X86 1
+#if defined(_MSC_VER) && !defined(__clang__)
+#define SCXT_AVX2_TARGET
+#else
+#define SCXT_AVX2_TARGET __attribute__((target("avx2,f16c")))
+#endif
+#else
+#define SCXT_ISA_X86 0
+#endif
+
+namespace scxt::infrastructure
+{
+enum class Isa : uint8_t
+{
+    SCALAR,
+    SSE2,
+    AVX2
+};
+
+bool isIsaAvailable(Isa isa);
+Isa bestAvailableIsa();
+const char *isaName(Isa isa);
+
+Isa activeIsa();
+/*
+ * Run the dispatched kernels with isa from here on; false (and no change) if this
+ * CPU lacks it. Kernels are picked per block or per voice start, so change this
+ * before audio runs, not during.
+ */
+bool forceIsa(Isa isa);
+void clearForcedIsa();
+} // namespace scxt::infrastructure
+
+#endif // SHORTCIRCUITXT_CPU_ISA_H
@@ -0,0 +1,134 @@
+/*
+ * Shortcircuit XT - a Surge Synth Team product
+ *
+ * A fully featured creative sampler, available as a standalone
+ * and plugin for multiple platforms.
+ *
+ * Copyright 2019 - 2023, Various authors, as described in the github
+ * transaction log.
+ *
+ * ShortcircuitXT is released under the Gnu General Public Licence
+ * V3 or later (GPL-3.0-or-later). The license is found in the file
+ * "LICENSE" in the root of this repository or at
+ * https://www.gnu.org/licenses/gpl-3.0.en.html
+ *
+ * Individual sections of code which comprises ShortcircuitXT in this
+ * repository may also be used under an MIT license. Please see the
+ * section  "Licensing" in "README.md" for details.
+ *
+ * ShortcircuitXT is inspired by, and shares code with, the
+ * commercial product Shortcircuit 1 and 2, released by VemberTech
+ * in the mid 2000s. The code for Shortcircuit 2 was opensourced in
+ * 2020 at the outset of this project.
+ *
+ * All source for ShortcircuitXT is available at
+ * https://github.com/surge-synthesizer/shortcircuit-xt
+ */
+
+
+#ifndef SCXT_SRC_INFRASTRUCTURE_HALF_FLOAT_H
+#define SCXT_SRC_INFRASTRUCTURE_HALF_FLOAT_H
+
+#include <cstdint>
+#include <cstring>
+
+#include "sse_include.h"
+
+/*
+ * IEEE 754 binary16 <-> float. Half to float is exact for every input, so the
+ * scalar, SSE2 and F16C versions here agree bit for bit. Float to half rounds to
+ * nearest even, which is what F16C does with _MM_FROUND_TO_NEAREST_INT.
+ *
+ * The half to float direction is what the sample generators use while they
+ * interpolate, so it avoids the float multiply trick that most portable versions
+ * use for subnormals; that gives zeros under DAZ, which the audio thread runs with.
+ */
+namespace scxt::infrastructure
+{
+inline float halfToFloat(uint16_t h)
+{
+    uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+    uint32_t em = h & 0x7fff;
+    uint32_t bits;
+    if (em >= 0x7c00)
+    {
+        // like F16C, NaNs come out quiet
+        bits = 0x7f800000 | ((em & 0x3ff) << 13) | (em > 0x7c00 ? 0x400000 : 0);
+    }
+    else if (em >= 0x400)
+    {
+        bits = (em << 13) + (112 << 23);
+    }
+    else
+    {
+        // subnormal; em * 2^-24 is exact and always a normal float
+        float f = (float)em * (1.f / 16777216.f);
+        memcpy(&bits, &f, sizeof(bits));
+    }
+    bits |= sign;
+    float res;
+    memcpy(&res, &bits, sizeof(res));
+    return res;
+}
+
+inline uint16_t floatToHalf(float f)
+{
+    uint32_t x;
+    memcpy(&x, &f, sizeof(x));
+    uint32_t sign = x & 0x80000000;
+    x ^= sign;
+
+    uint16_t res;
+    if (x >= 0x47800000)
+    {
+        // too big becomes infinity; NaN stays a (quiet) NaN
+        res = (x > 0x7f800000) ? 0x7e00 : 0x7c00;
+    }
+    else if (x < 0x38800000)
+    {
+        // Subnormal or zero. Adding 0.5 lines the half mantissa up with the bottom of
+        // the float mantissa and lets the FPU do the round to nearest even for us
+        float ff;
+        memcpy(&ff, &x, sizeof(ff));
+        ff += 0.5f;
+        uint32_t fb;
+        memcpy(&fb, &ff, sizeof(fb));
+        res = (uint16_t)(fb - 0x3f000000);
+    }
+    else
+    {
+        uint32_t mantOdd = (x >> 13) & 1;
+        x += ((uint32_t)(15 - 127) << 23) + 0xfff;
+        x += mantOdd;
+        res = (uint16_t)(x >> 13);
+    }
+    return res | (uint16_t)(sign >> 16);
+}
+
+// Four halves from h (no alignment needed) to four floats
+inline __m128 halfToFloat4(const uint16_t *h)
+{
+    auto hv = _mm_loadl_epi64((const __m128i *)h);
+#if defined(__F16C__)
+    return _mm_cvtph_ps(hv);
+#else
+    auto h32 = _mm_unpacklo_epi16(hv, _mm_setzero_si128());
+    auto em = _mm_and_si128(h32, _mm_set1_epi32(0x7fff));
+    auto sign = _mm_slli_epi32(_mm_xor_si128(h32, em), 16);
+
+    const auto expAdjust = _mm_set1_epi32(112 << 23);
+    auto normal = _mm_add_epi32(_mm_slli_epi32(em, 13), expAdjust);
+    auto infNan = _mm_cmpgt_epi32(em, _mm_set1_epi32(0x7bff));
+    normal = _mm_add_epi32(normal, _mm_and_si128(infNan, expAdjust));
+    auto isNan = _mm_cmpgt_epi32(em, _mm_set1_epi32(0x7c00));
+    normal = _mm_or_si128(normal, _mm_and_si128(isNan, _mm_set1_epi32(0x400000)));
+
+    auto sub = _mm_castps_si128(_mm_mul_ps(_mm_cvtepi32_ps(em), _mm_set1_ps(1.f / 16777216.f)));
+    auto isSub = _mm_cmplt_epi32(em, _mm_set1_epi32(0x400));
+    auto res = _mm_or_si128(_mm_and_si128(isSub, sub), _mm_andnot_si128(isSub, normal));
+    return _mm_castsi128_ps(_mm_or_si128(res, sign));
+#endif
+}
+} // namespace scxt::infrastructure
+
+#endif // SHORTCIRCUITXT_HALF_FLOAT_H
@@ -37,6 +37,13 @@ enum DefaultKeys
     zoomLevel,
     skinName,
     octave0,
+    sampleCacheSizeMB,
+    storeFloatSamplesAsF16,
+    lazySampleLoading,
+    sampleMemoryBudgetMB,
+    patchSwitchMode,
+    convertSamplesToEngineRate,
+    buildOctaveMipmaps,
     nKeys
 };
 inline std::string defaultKeyToString(DefaultKeys k)
@@ -49,6 +56,20 @@ inline std::string defaultKeyToString(DefaultKeys k)
         return "skinName";
     case octave0:
         return "octave0";
+    case sampleCacheSizeMB:
+        return "sampleCacheSizeMB";
+    case storeFloatSamplesAsF16:
+        return "storeFloatSamplesAsF16";
+    case lazySampleLoading:
+        return "lazySampleLoading";
+    case sampleMemoryBudgetMB:
+        return "sampleMemoryBudgetMB";
+    case patchSwitchMode:
+        return "patchSwitchMode";
+    case convertSamplesToEngineRate:
+        return "convertSamplesToEngineRate";
+    case buildOctaveMipmaps:
+        return "buildOctaveMipmaps";
     case nKeys:
         return "nKeys";
     default:
@@ -76,8 +76,10 @@ template <> struct scxt_traits<scxt::engine::Engine>
         findIf(v, "patch", *(engine.getPatch()));
         findIf(v, "selectionManager", *(engine.getSelectionManager()));
 
-        // Now we need to restore the bus effects
+        // Now we need to restore the bus effects and group processors
         engine.getPatch()->setupBussesOnUnstream(engine);
+        engine.reserveProcessorMemory();
+        engine.getPatch()->respawnGroupProcessors();
     }
 };
 
@@ -270,6 +272,8 @@ STREAM_ENUM(engine::Zone::LoopMode, engine::Zone::toStringLoopMode,
             engine::Zone::fromStringLoopMode);
 STREAM_ENUM(engine::Zone::LoopDirection, engine::Zone::toStringLoopDirection,
             engine::Zone::fromStringLoopDirection);
+STREAM_ENUM(engine::Zone::InterpolationType, engine::Zone::toStringInterpolationType,
+            engine::Zone::fromStringInterpolationType);
 STREAM_ENUM(engine::Zone::ProcRoutingPath, engine::Zone::toStringProcRoutingPath,
             engine::Zone::fromStringProcRoutingPath);
 STREAM_ENUM(engine::Group::ProcRoutingPath, engine::Group::toStringProcRoutingPath,
@@ -293,6 +297,7 @@ template <> struct scxt_traits<scxt::engine::Zone::AssociatedSample>
              {"playReverse", s.playReverse},
              {"loopMode", s.loopMode},
              {"loopDirection", s.loopDirection},
+             {"interpolationType", s.interpolationType},
              {"loopCountWhenCounted", s.loopCountWhenCounted},
              {"loopFade", s.loopFade}};
     }
@@ -311,6 +316,8 @@ template <> struct scxt_traits<scxt::engine::Zone::AssociatedSample>
         findOrSet(v, "playReverse", false, s.playReverse);
         findOrSet(v, "loopMode", engine::Zone::LoopMode::LOOP_DURING_VOICE, s.loopMode);
         findOrSet(v, "loopDirection", engine::Zone::LoopDirection::FORWARD_ONLY, s.loopDirection);
+        findOrSet(v, "interpolationType", engine::Zone::InterpolationType::SINC,
+                  s.interpolationType);
         findOrSet(v, "loopFade", 0, s.loopFade);
         findOrSet(v, "loopCountWhenCounted", 0, s.loopCountWhenCounted);
     }
@@ -59,6 +59,12 @@ template <> struct scxt_traits<scxt::sample::Sample::SourceType>
         case sample::Sample::AIFF_FILE:
             v = {{key, "aiff_file"}};
             break;
+        case sample::Sample::MONOLITH_FILE:
+            v = {{key, "monolith_file"}};
+            break;
+        case sample::Sample::GIG_FILE:
+            v = {{key, "gig_file"}};
+            break;
         }
     }
 
@@ -76,6 +82,10 @@ template <> struct scxt_traits<scxt::sample::Sample::SourceType>
             r = sample::Sample::FLAC_FILE;
         if (k == "aiff_file")
             r = sample::Sample::AIFF_FILE;
+        if (k == "monolith_file")
+            r = sample::Sample::MONOLITH_FILE;
+        if (k == "gig_file")
+            r = sample::Sample::GIG_FILE;
 
         return;
     }
@@ -27,6 +27,9 @@
 
 #include "stream.h"
 
+#include <algorithm>
+#include <unordered_set>
+
 #include <tao/json/to_string.hpp>
 #include <tao/json/from_string.hpp>
 #include <tao/json/contrib/traits.hpp>
@@ -34,6 +37,7 @@
 #include "scxt_traits.h"
 #include "engine_traits.h"
 #include "messaging/messaging.h"
+#include "sample/monolith.h"
 
 namespace scxt::json
 {
@@ -70,11 +74,36 @@ std::string streamEngineState(const engine::Engine &e, bool pretty)
     return streamValue(json::scxt_value(e), pretty);
 }
 
-void unstreamEngineState(engine::Engine &e, const std::string &xml)
+namespace
+{
+scxt_value parseState(const std::string &jsonData)
 {
     tao::json::events::transformer<tao::json::events::to_basic_value<scxt_traits>> consumer;
-    tao::json::events::from_string(consumer, xml);
-    auto jv = std::move(consumer.value);
+    tao::json::events::from_string(consumer, jsonData);
+    return std::move(consumer.value);
+}
+
+void restoreInBackground(engine::Engine &e, const std::shared_ptr<scxt_value> &jv,
+                         engine::Engine::PatchSwapMode mode)
+{
+    e.getMessageController()->scheduleSerializationThreadCallback([jv, mode](auto &e) {
+        sample::SampleManager::sampleAddressesAndIds_t samples;
+        auto sm = jv->find("sampleManager");
+        if (sm)
+            findIf(*sm, "sampleAddresses", samples);
+
+        // Order matters as in the Engine traits: the selection goes on once the patch is live
+        e.prepareShadowPatch(
+            samples, [jv](auto &, auto &patch) { findIf(*jv, "patch", patch); },
+            [jv](auto &e) { findIf(*jv, "selectionManager", *(e.getSelectionManager())); },
+            mode);
+    });
+}
+} // namespace
+
+void unstreamEngineState(engine::Engine &e, const std::string &xml)
+{
+    auto jv = parseState(xml);
     jv.to(e);
 
     if (!e.getSampleManager()->missingList.empty())
@@ -88,4 +117,111 @@ void unstreamEngineState(engine::Engine &e, const std::string &xml)
         e.getMessageController()->reportErrorToClient("Missing Samples", oss.str());
     }
 }
+
+void unstreamEngineStateInBackground(engine::Engine &e, const std::string &jsonData,
+                                     engine::Engine::PatchSwapMode mode)
+{
+    restoreInBackground(e, std::make_shared<scxt_value>(parseState(jsonData)), mode);
+}
+
+bool streamEngineStateToMonolith(engine::Engine &e, const fs::path &to)
+{
+    auto sm = e.getSampleManager();
+
+    // Bundle only what the patch's zones use. Saving mustn't purge the manager, which
+    // may hold samples that undo or a shadow patch still expect to find.
+    std::unordered_set<SampleID> referenced;
+    for (const auto &part : *(e.getPatch()))
+        for (const auto &group : *part)
+            for (const auto &zone : *group)
+                for (const auto &sd : zone->sampleData)
+                    if (sd.sampleID.isValid())
+                        referenced.insert(sd.sampleID);
+
+    auto addresses = sm->getSampleAddressesAndIDs();
+    addresses.erase(std::remove_if(addresses.begin(), addresses.end(),
+                                   [&](const auto &a) { return !referenced.count(a.first); }),
+                    addresses.end());
+
+    // Samples still loading or evicted down to a head are loaded in full for the bundle
+    std::vector<std::shared_ptr<sample::Sample>> samples(addresses.size());
+    std::vector<sample::SampleLoader::Request> reloads;
+    std::vector<size_t> reloadIndex;
+    for (size_t i = 0; i < addresses.size(); ++i)
+    {
+        auto s = sm->getSample(addresses[i].first);
+        if (s && !s->isResidencyHead())
+        {
+            samples[i] = s;
+        }
+        else
+        {
+            reloads.push_back({addresses[i].second, addresses[i].first});
+            reloadIndex.push_back(i);
+        }
+    }
+    if (!reloads.empty())
+    {
+        auto res = sm->getLoader().loadAndWait(std::move(reloads));
+        for (size_t i = 0; i < res.size() && i < reloadIndex.size(); ++i)
+            samples[reloadIndex[i]] = res[i].sample;
+    }
+
+    sample::SampleManager::sampleAddressesAndIds_t bundled;
+    for (size_t i = 0; i < addresses.size(); ++i)
+    {
+        if (!samples[i])
+        {
+            e.getMessageController()->reportErrorToClient(
+                "Unable to Save Monolith",
+                "Could not load " + addresses[i].second.path.u8string() + " to bundle it");
+            return false;
+        }
+        bundled.emplace_back(addresses[i].first,
+                             sample::Sample::SampleFileAddress{sample::Sample::MONOLITH_FILE, to,
+                                                               -1, (int)i});
+    }
+
+    auto v = scxt_value(e);
+    v.at("sampleManager").at("sampleAddresses") = scxt_value(bundled);
+    if (!sample::MonolithBundle::write(to, tao::json::to_string(v), samples))
+    {
+        e.getMessageController()->reportErrorToClient("Unable to Save Monolith",
+                                                      "Could not write " + to.u8string());
+        return false;
+    }
+    SCLOG("Saved monolith " << to.u8string() << " with " << samples.size() << " samples");
+    return true;
+}
+
+bool unstreamMonolithInBackground(engine::Engine &e, const fs::path &from,
+                                  engine::Engine::PatchSwapMode mode)
+{
+    auto bundle = sample::MonolithBundle::forFile(from);
+    if (!bundle)
+    {
+        e.getMessageController()->reportErrorToClient(
+            "Unable to Load Monolith", from.u8string() + " is not a readable monolith");
+        return false;
+    }
+
+    auto jv = std::make_shared<scxt_value>(parseState(bundle->getStateJson()));
+
+    // The bundle may have been moved since it was written, so point its samples at it here
+    auto sm = jv->find("sampleManager");
+    if (sm && sm->find("sampleAddresses"))
+    {
+        sample::SampleManager::sampleAddressesAndIds_t samples;
+        findIf(*sm, "sampleAddresses", samples);
+        for (auto &[id, addr] : samples)
+        {
+            if (addr.type == sample::Sample::MONOLITH_FILE)
+                addr.path = from;
+        }
+        sm->at("sampleAddresses") = scxt_value(samples);
+    }
+
+    restoreInBackground(e, jv, mode);
+    return true;
+}
 } // namespace scxt::json
\ No newline at end of file
@@ -39,6 +39,25 @@ static constexpr uint64_t currentStreamingVersion{0x20230201};
 std::string streamPatch(const engine::Patch &p, bool pretty = false);
 std::string streamEngineState(const engine::Engine &e, bool pretty = false);
 void unstreamEngineState(engine::Engine &e, const std::string &jsonData);
+
+/*
+ * Restore a state without stopping the engine. The json is parsed on the calling
+ * thread, then the new patch is built and its samples loaded in the background while
+ * the current one keeps playing; see Engine::prepareShadowPatch.
+ */
+void unstreamEngineStateInBackground(engine::Engine &e, const std::string &jsonData,
+                                     engine::Engine::PatchSwapMode mode);
+
+/*
+ * Monolith bundles; see sample::MonolithBundle. Saving writes the state and all its
+ * sample data to one file, loading in full any sample which is still loading or has
+ * been evicted, so it blocks the serialization thread it must be called on. Loading
+ * restores a bundle as unstreamEngineStateInBackground does, with every sample mapped
+ * straight from the bundle. Both report failures to the client.
+ */
+bool streamEngineStateToMonolith(engine::Engine &e, const fs::path &to);
+bool unstreamMonolithInBackground(engine::Engine &e, const fs::path &from,
+                                  engine::Engine::PatchSwapMode mode);
 } // namespace scxt::json
 
 #endif // SHORTCIRCUIT_STREAM_H
@@ -40,4 +40,24 @@ void sendStructureRefresh(MessageController &mc)
     a2s.payloadType = AudioToSerialization::NONE;
     mc.sendAudioToSerialization(a2s);
 }
+
+void sendSampleWanted(const SampleID &id, MessageController &mc)
+{
+    assert(mc.threadingChecker.isAudioThread());
+    AudioToSerialization a2s;
+    a2s.id = a2s_sample_wanted;
+    a2s.payloadType = AudioToSerialization::INT;
+    a2s.payload.i[0] = id.id;
+    mc.sendAudioToSerialization(a2s);
+}
+
+void sendPatchRetired(engine::Patch *patch, MessageController &mc)
+{
+    assert(mc.threadingChecker.isAudioThread());
+    AudioToSerialization a2s;
+    a2s.id = a2s_patch_retired;
+    a2s.payloadType = AudioToSerialization::VOID_STAR;
+    a2s.payload.p = (void *)patch;
+    mc.sendAudioToSerialization(a2s);
+}
 } // namespace scxt::messaging::audio
\ No newline at end of file
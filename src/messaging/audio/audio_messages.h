@@ -36,6 +36,8 @@ namespace scxt::messaging::audio
 // Audio thread
 void sendVoiceState(uint32_t voiceCount, MessageController &mc);
 void sendStructureRefresh(MessageController &mc);
+void sendSampleWanted(const SampleID &id, MessageController &mc);
+void sendPatchRetired(engine::Patch *patch, MessageController &mc);
 
 } // namespace scxt::messaging::audio
 #endif // SHORTCIRCUIT_AUDIO_MESSAGES_H
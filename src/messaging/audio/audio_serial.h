@@ -50,7 +50,9 @@ enum AudioToSerializationMessageId
     a2s_pointer_complete,
     a2s_note_on,
     a2s_note_off,
-    a2s_structure_refresh
+    a2s_structure_refresh,
+    a2s_sample_wanted, // a note hit a zone whose sample is still loading. i[0] is the id
+    a2s_patch_retired  // a switched out patch has gone silent. p is the Patch to free
 };
 
 /**
@@ -83,6 +83,13 @@ enum ClientToSerializationMessagesIds
 
     c2s_browser_add_device_location,
 
+    c2s_cancel_sample_loads,
+    c2s_clear_sample_cache,
+    c2s_request_sample_residency_stats,
+
+    c2s_save_monolith,
+    c2s_load_monolith,
+
     num_clientToSerializationMessages
 };
 
@@ -115,6 +122,11 @@ enum SerializationToClientMessageIds
 
     s2c_refresh_browser,
 
+    s2c_sample_load_progress,
+    s2c_send_sample_residency_stats,
+    s2c_patch_switch_status,
+    s2c_patch_samples_ready,
+
     num_serializationToClientMessages
 };
 
@@ -51,18 +51,18 @@ SERIAL_TO_CLIENT(ProcessorsMismatched, s2c_notify_mismatched_processors_for_zone
 // C2S set processor type (sends back data and metadata)
 // tuple is forzone, whichprocessor, type
 typedef std::tuple<bool, int32_t, int32_t> setProcessorPayload_t;
-inline void setProcessorType(const setProcessorPayload_t &whichToType, const engine::Engine &engine,
+inline void setProcessorType(const setProcessorPayload_t &whichToType, engine::Engine &engine,
                              messaging::MessageController &cont)
 {
     const auto &[forZone, w, id] = whichToType;
     if (!forZone)
     {
-        SCLOG_UNIMPL("GROUP Set " << w << " to " << id);
         auto sg = engine.getSelectionManager()->currentlySelectedGroups();
         auto lg = engine.getSelectionManager()->currentLeadGroup(engine);
         assert(sg.empty() || lg.has_value());
         if (!sg.empty())
         {
+            engine.reserveProcessorMemory((dsp::processor::ProcessorType)id, false, sg.size());
             cont.scheduleAudioThreadCallback(
                 [gs = sg, which = w, type = id](auto &e) {
                     for (const auto &a : gs)
@@ -79,11 +79,9 @@ inline void setProcessorType(const setProcessorPayload_t &whichToType, const eng
                             false, which, true, g->processorDescription[which],
                             g->processorStorage[which]},
                         *(engine.getMessageController()));
-                    /*
-                    serializationSendToClient(
-                        messaging::client::s2c_update_zone_matrix_metadata,
-                        modulation::getVoiceModMatrixMetadata(*z),
-                        *(engine.getMessageController()));*/
+                    serializationSendToClient(messaging::client::s2c_update_group_matrix_metadata,
+                                              modulation::getGroupModMatrixMetadata(*g),
+                                              *(engine.getMessageController()));
                 });
         }
         return;
@@ -97,6 +95,7 @@ inline void setProcessorType(const setProcessorPayload_t &whichToType, const eng
 
         if (!sz.empty() && lz.has_value())
         {
+            engine.reserveProcessorMemory((dsp::processor::ProcessorType)id, true, sz.size());
             cont.scheduleAudioThreadCallback(
                 [zs = sz, which = w, type = id](auto &e) {
                     for (const auto &a : zs)
@@ -0,0 +1,103 @@
+/*
+ * Shortcircuit XT - a Surge Synth Team product
+ *
+ * A fully featured creative sampler, available as a standalone
+ * and plugin for multiple platforms.
+ *
+ * Copyright 2019 - 2023, Various authors, as described in the github
+ * transaction log.
+ *
+ * ShortcircuitXT is released under the Gnu General Public Licence
+ * V3 or later (GPL-3.0-or-later). The license is found in the file
+ * "LICENSE" in the root of this repository or at
+ * https://www.gnu.org/licenses/gpl-3.0.en.html
+ *
+ * Individual sections of code which comprises ShortcircuitXT in this
+ * repository may also be used under an MIT license. Please see the
+ * section  "Licensing" in "README.md" for details.
+ *
+ * ShortcircuitXT is inspired by, and shares code with, the
+ * commercial product Shortcircuit 1 and 2, released by VemberTech
+ * in the mid 2000s. The code for Shortcircuit 2 was opensourced in
+ * 2020 at the outset of this project.
+ *
+ * All source for ShortcircuitXT is available at
+ * https://github.com/surge-synthesizer/shortcircuit-xt
+ */
+
+
+#ifndef SCXT_SRC_MESSAGING_CLIENT_SAMPLE_MESSAGES_H
+#define SCXT_SRC_MESSAGING_CLIENT_SAMPLE_MESSAGES_H
+
+#include "messaging/client/detail/client_json_details.h"
+#include "engine/engine.h"
+#include "json/stream.h"
+#include "infrastructure/user_defaults.h"
+#include "client_macros.h"
+
+namespace scxt::messaging::client
+{
+// completed, total, last file loaded. completed == total means the batch is done
+typedef std::tuple<int32_t, int32_t, std::string> sampleLoadProgress_t;
+SERIAL_TO_CLIENT(SampleLoadProgress, s2c_sample_load_progress, sampleLoadProgress_t,
+                 onSampleLoadProgress);
+
+// stage, samples loaded, samples to load, bytes of sample data loaded for the new patch.
+// stage is 0 while a background patch switch loads, 1 once the new patch is playing and
+// 2 when the old one has been freed along with any samples only it used
+typedef std::tuple<int32_t, int32_t, int32_t, int64_t> patchSwitchStatus_t;
+SERIAL_TO_CLIENT(PatchSwitchStatus, s2c_patch_switch_status, patchSwitchStatus_t,
+                 onPatchSwitchStatus);
+
+// samples loaded, samples which failed. Sent when a lazy restore has no samples left pending
+typedef std::tuple<int32_t, int32_t> patchSamplesReady_t;
+SERIAL_TO_CLIENT(PatchSamplesReady, s2c_patch_samples_ready, patchSamplesReady_t,
+                 onPatchSamplesReady);
+
+CLIENT_TO_SERIAL(CancelSampleLoads, c2s_cancel_sample_loads, bool,
+                 engine.getSampleManager()->cancelPendingLoads());
+
+inline void clearSampleCache(const engine::Engine &engine)
+{
+    auto c = engine.getSampleManager()->getSampleCache();
+    if (c)
+        c->clear();
+}
+CLIENT_TO_SERIAL(ClearSampleCache, c2s_clear_sample_cache, bool, clearSampleCache(engine));
+
+// budget bytes, resident bytes, complete samples, head only samples, hits, misses,
+// evictions, reloads. See SampleManager::ResidencyStats
+typedef std::tuple<int64_t, int64_t, int32_t, int32_t, int64_t, int64_t, int64_t, int64_t>
+    sampleResidencyStats_t;
+inline void sampleResidencyStatsSerialSide(const engine::Engine &engine, MessageController &cont)
+{
+    auto s = engine.getSampleManager()->getResidencyStats();
+    serializationSendToClient(
+        s2c_send_sample_residency_stats,
+        sampleResidencyStats_t{(int64_t)s.budgetBytes, (int64_t)s.residentBytes,
+                               (int32_t)s.completeSamples, (int32_t)s.headSamples,
+                               (int64_t)s.hits, (int64_t)s.misses, (int64_t)s.evictions,
+                               (int64_t)s.reloads},
+        cont);
+}
+CLIENT_SERIAL_REQUEST_RESPONSE(SampleResidencyStats, c2s_request_sample_residency_stats, bool,
+                               s2c_send_sample_residency_stats, sampleResidencyStats_t,
+                               sampleResidencyStatsSerialSide(engine, cont),
+                               onSampleResidencyStats);
+
+// Monolith bundles (see sample::MonolithBundle). The payload is the bundle path
+CLIENT_TO_SERIAL(SaveMonolith, c2s_save_monolith, std::string,
+                 json::streamEngineStateToMonolith(engine, fs::path{payload}));
+
+inline void loadMonolith(engine::Engine &engine, const std::string &path)
+{
+    auto mode = engine.defaults->getUserDefaultValue(
+        infrastructure::DefaultKeys::patchSwitchMode,
+        (int)engine::Engine::PatchSwapMode::CROSSFADE);
+    json::unstreamMonolithInBackground(engine, fs::path{path},
+                                       (engine::Engine::PatchSwapMode)std::clamp(mode, 0, 2));
+}
+CLIENT_TO_SERIAL(LoadMonolith, c2s_load_monolith, std::string, loadMonolith(engine, payload));
+
+} // namespace scxt::messaging::client
+#endif // SHORTCIRCUITXT_SAMPLE_MESSAGES_H
@@ -77,9 +77,15 @@ inline void samplesSelectedZoneUpdate(const engine::Zone::AssociatedSampleArray
     if (sz.has_value())
     {
         auto [ps, gs, zs] = *sz;
-        cont.scheduleAudioThreadCallback([p = ps, g = gs, z = zs, sampv = samples](auto &eng) {
-            eng.getPatch()->getPart(p)->getGroup(g)->getZone(z)->sampleData = sampv;
-        });
+        cont.scheduleAudioThreadCallback(
+            [p = ps, g = gs, z = zs, sampv = samples](auto &eng) {
+                eng.getPatch()->getPart(p)->getGroup(g)->getZone(z)->sampleData = sampv;
+            },
+            [](const auto &eng) {
+                // a new loop wants new seams
+                eng.getMessageController()->scheduleSerializationThreadCallback(
+                    [](auto &e) { e.refreshLoopSeams(); });
+            });
     }
 }
 CLIENT_TO_SERIAL(SamplesSelectedZoneUpdateRequest, c2s_update_zone_samples,
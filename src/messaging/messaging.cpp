@@ -53,6 +53,16 @@ void MessageController::parseAudioMessageOnSerializationThread(
         serializationSendToClient(client::s2c_send_pgz_structure,
                                   engine.getPartGroupZoneStructure(-1), *this);
         break;
+    case audio::a2s_sample_wanted:
+    {
+        SampleID sid;
+        sid.id = as.payload.i[0];
+        engine.requestSampleResidency(sid);
+    }
+    break;
+    case audio::a2s_patch_retired:
+        engine.freeRetiredPatch(static_cast<engine::Patch *>(as.payload.p));
+        break;
     case audio::a2s_none:
         break;
     }
@@ -101,6 +111,7 @@ void MessageController::returnAudioThreadCallback(AudioThreadCallback *r)
 {
     assert(threadingChecker.isSerialThread());
     r->execCompleteOnSer(engine);
+    r->clearFunctions();
     cbStore.push(r);
 }
 
@@ -139,6 +150,16 @@ void MessageController::scheduleAudioThreadFunctionCallback(
     }
 }
 
+void MessageController::scheduleSerializationThreadCallback(
+    std::function<void(engine::Engine &)> f, bool underStructureLock)
+{
+    {
+        std::lock_guard<std::mutex> g(clientToSerializationMutex);
+        serializationCallbacks.emplace_back(std::move(f), underStructureLock);
+    }
+    clientToSerializationConditionVar.notify_one();
+}
+
 void MessageController::stopAudioThreadThenRunOnSerial(
     std::function<void(const engine::Engine &)> f)
 {
@@ -163,13 +184,17 @@ void MessageController::runSerialization()
         clientToSerializationMessage_t inbound;
         bool audioStateChanged{false};
         bool receivedMessageFromClient{false};
+        bool housekeepingDue{std::chrono::steady_clock::now() - lastHousekeeping > 1s};
+        std::vector<std::pair<std::function<void(engine::Engine &)>, bool>> callbacks;
         {
             std::unique_lock<std::mutex> lock(clientToSerializationMutex);
             while (shouldRun && clientToSerializationQueue.empty() &&
-                   (audioToSerializationQueue.empty()) && !audioStateChanged)
+                   (audioToSerializationQueue.empty()) && serializationCallbacks.empty() &&
+                   !audioStateChanged && !housekeepingDue)
             {
                 clientToSerializationConditionVar.wait_for(lock, 50ms);
                 audioStateChanged = updateAudioRunning();
+                housekeepingDue = std::chrono::steady_clock::now() - lastHousekeeping > 1s;
             }
             if (!clientToSerializationQueue.empty())
             {
@@ -177,6 +202,7 @@ void MessageController::runSerialization()
                 clientToSerializationQueue.pop();
                 receivedMessageFromClient = true;
             }
+            callbacks.swap(serializationCallbacks);
         }
         if (shouldRun)
         {
@@ -191,11 +217,31 @@ void MessageController::runSerialization()
                 }
             }
 
+            for (auto &[f, underLock] : callbacks)
+            {
+                if (underLock)
+                {
+                    std::lock_guard<std::mutex> g(engine.modifyStructureMutex);
+                    f(engine);
+                }
+                else
+                {
+                    f(engine);
+                }
+            }
+
             if (audioStateChanged && isClientConnected)
             {
                 engine.sendEngineStatusToClient();
             }
 
+            if (housekeepingDue)
+            {
+                lastHousekeeping = std::chrono::steady_clock::now();
+                std::lock_guard<std::mutex> g(engine.modifyStructureMutex);
+                engine.runSerialHousekeeping();
+            }
+
             // TODO: Drain SerToAudioQ if there's no audio thread
             bool tryToDrain{true};
             while (tryToDrain && !audioToSerializationQueue.empty())
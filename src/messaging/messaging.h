@@ -36,6 +36,7 @@
 
 #include <queue>
 #include <stack>
+#include <vector>
 #include <chrono>
 
 #include "client/client_serial.h"
@@ -264,6 +265,16 @@ struct MessageController : MoveableOnly<MessageController>
                                              std::function<void(engine::Engine &)> f,
                                              std::function<void(const engine::Engine &)> cb);
 
+    /**
+     * Schedule a function to run on the serialization thread. This can be called
+     * from any thread other than audio, and is how background workers like the
+     * sample loader hand their results back. The function runs under the engine
+     * structure lock unless you ask it not to, which is handy for things like
+     * progress reports which touch no structure.
+     */
+    void scheduleSerializationThreadCallback(std::function<void(engine::Engine &)> f,
+                                             bool underStructureLock = true);
+
     void stopAudioThreadThenRunOnSerial(std::function<void(const engine::Engine &)> f);
     void restartAudioThreadFromSerial();
     struct AudioThreadCallback
@@ -275,6 +286,12 @@ struct MessageController : MoveableOnly<MessageController>
             serialOnComplete = std::move(q);
         }
         void nullSerialCompleteFunction() { serialOnComplete = nullptr; }
+        // Drop the functions (and anything they captured) before this goes back in the pool
+        void clearFunctions()
+        {
+            f = nullptr;
+            serialOnComplete = nullptr;
+        }
         inline void exec(engine::Engine &e)
         {
             assert(e.getMessageController()->threadingChecker.isAudioThread());
@@ -308,6 +325,7 @@ struct MessageController : MoveableOnly<MessageController>
   private:
     uint64_t inboundClientMessageCount{0};
     void runSerialization();
+    std::chrono::steady_clock::time_point lastHousekeeping{};
     void parseAudioMessageOnSerializationThread(const audio::AudioToSerialization &as);
 
     // serialization thread only please
@@ -319,6 +337,7 @@ struct MessageController : MoveableOnly<MessageController>
     sst::cpputils::SimpleRingBuffer<audioToSerializationMessage_t, 1024> audioToSerializationQueue;
 
     std::queue<clientToSerializationMessage_t> clientToSerializationQueue;
+    std::vector<std::pair<std::function<void(engine::Engine &)>, bool>> serializationCallbacks;
     std::mutex clientToSerializationMutex;
     std::condition_variable clientToSerializationConditionVar;
 
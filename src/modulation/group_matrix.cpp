@@ -25,6 +25,7 @@
  * https://github.com/surge-synthesizer/shortcircuit-xt
  */
 
+#include "datamodel/parameter.h"
 #include "group_matrix.h"
 #include "engine/group.h"
 #include <stdexcept>
@@ -48,6 +49,27 @@ std::string getGroupModMatrixDestStreamingName(const GroupModMatrixDestinationTy
     case gmd_LFO_Rate:
         return "gmd_lforate";
 
+    case gmd_Processor_Mix:
+        return "gmd_processor_mix";
+    case gmd_Processor_FP1:
+        return "gmd_processor_fp1";
+    case gmd_Processor_FP2:
+        return "gmd_processor_fp2";
+    case gmd_Processor_FP3:
+        return "gmd_processor_fp3";
+    case gmd_Processor_FP4:
+        return "gmd_processor_fp4";
+    case gmd_Processor_FP5:
+        return "gmd_processor_fp5";
+    case gmd_Processor_FP6:
+        return "gmd_processor_fp6";
+    case gmd_Processor_FP7:
+        return "gmd_processor_fp7";
+    case gmd_Processor_FP8:
+        return "gmd_processor_fp8";
+    case gmd_Processor_FP9:
+        return "gmd_processor_fp9";
+
     case numGroupMatrixDestinations:
         throw std::logic_error("Can't convert numGroupMatrixDestinations to string");
     }
@@ -110,6 +132,28 @@ void GroupModMatrix::copyBaseValuesFromGroup(engine::Group &g)
     {
         baseValues[destIndex(gmd_LFO_Rate, i)] = g.lfoStorage[i].rate;
     }
+    for (int i = 0; i < engine::processorCount; ++i)
+    {
+        baseValues[destIndex(gmd_Processor_Mix, i)] = g.processorStorage[i].mix;
+        memcpy(&baseValues[destIndex(gmd_Processor_FP1, i)],
+               g.processorStorage[i].floatParams.data(),
+               sizeof(float) * dsp::processor::maxProcessorFloatParams);
+    }
+}
+
+void GroupModMatrix::snapDepthScalesFromGroup(const engine::Group &g)
+{
+    // As with the voice matrix, processor depth is scaled by each parameter's range
+    for (int idx = 0; idx < engine::processorCount; ++idx)
+    {
+        for (int q = gmd_Processor_FP1; q <= gmd_Processor_FP9; ++q)
+        {
+            auto di = destIndex((GroupModMatrixDestinationType)q, idx);
+            const auto &cd =
+                g.processorDescription[idx].floatControlDescriptions[q - gmd_Processor_FP1];
+            depthScales[di] = cd.maxVal - cd.minVal;
+        }
+    }
 }
 
 void GroupModMatrix::updateModulatorUsed(engine::Group &g) const
@@ -186,6 +230,18 @@ int getGroupModMatrixDestIndexCount(const GroupModMatrixDestinationType &t)
     case gmd_LFO_Rate:
         return engine::lfosPerGroup;
 
+    case gmd_Processor_Mix:
+    case gmd_Processor_FP1:
+    case gmd_Processor_FP2:
+    case gmd_Processor_FP3:
+    case gmd_Processor_FP4:
+    case gmd_Processor_FP5:
+    case gmd_Processor_FP6:
+    case gmd_Processor_FP7:
+    case gmd_Processor_FP8:
+    case gmd_Processor_FP9:
+        return engine::processorCount;
+
     case gmd_none:
         return 1;
     case numGroupMatrixDestinations:
@@ -224,6 +280,21 @@ getGroupModMatrixDestDisplayName(const GroupModMatrixDestinationAddress &dest,
     {
         return fmt::format("GLFO {}/Rate", idx + 1);
     }
+
+    if (gmd >= gmd_Processor_Mix && gmd <= gmd_Processor_FP9)
+    {
+        const auto &pd = g.processorDescription[idx];
+        if (g.processorStorage[idx].type == dsp::processor::proct_none)
+            return std::nullopt;
+
+        if (gmd == gmd_Processor_Mix)
+            return fmt::format("P{} {}/Mix", idx + 1, pd.typeDisplayName);
+
+        const auto &cd = pd.floatControlDescriptions[gmd - gmd_Processor_FP1];
+        if (cd.type == datamodel::pmd::NONE)
+            return std::nullopt;
+        return fmt::format("P{} {}/{}", idx + 1, pd.typeDisplayName, cd.name);
+    }
     assert(false);
     return fmt::format("ERR {} {}", gmd, idx);
 }
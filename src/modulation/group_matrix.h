@@ -60,6 +60,17 @@ enum GroupModMatrixDestinationType
     gmd_pan,
     gmd_LFO_Rate,
 
+    gmd_Processor_Mix,
+    gmd_Processor_FP1,
+    gmd_Processor_FP2,
+    gmd_Processor_FP3,
+    gmd_Processor_FP4,
+    gmd_Processor_FP5,
+    gmd_Processor_FP6,
+    gmd_Processor_FP7,
+    gmd_Processor_FP8,
+    gmd_Processor_FP9, // These should be contiguous and match maxProcessorFloatParams
+
     numGroupMatrixDestinations
 };
 
@@ -72,7 +83,7 @@ std::optional<GroupModMatrixSource> fromGroupModMatrixSourceStreamingName(const
 
 struct GroupModMatrixDestinationAddress
 {
-    static constexpr int maxIndex{4}; // 4 processors per zone
+    static constexpr int maxIndex{4}; // 4 processors per group
     static constexpr int maxDestinations{maxIndex * numGroupMatrixDestinations};
     GroupModMatrixDestinationType type{gmd_none};
     size_t index{0};
@@ -122,6 +133,7 @@ struct GroupModMatrix : public MoveableOnly<GroupModMatrix>, ModMatrix<GroupModM
     void assignSourcesFromGroup(engine::Group &g);
 
     void copyBaseValuesFromGroup(engine::Group &);
+    void snapDepthScalesFromGroup(const engine::Group &);
     void updateModulatorUsed(engine::Group &) const;
 };
 } // namespace scxt::modulation
@@ -141,45 +141,23 @@ bool Sample::parse_aiff(void *data, size_t filesize)
 
     unsigned char *loaddata = (unsigned char *)mf.ReadPtr(datasize - 8);
 
+    pcm::Format format;
     if (bitdepth == 32)
-    {
-        if (channels == 2)
-        {
-            load_data_i32BE(0, loaddata, nsamples, 8);
-            load_data_i32BE(1, loaddata + 4, nsamples, 8);
-        }
-        else
-            load_data_i32BE(0, loaddata, nsamples, 4);
-    }
+        format = pcm::Format::I32BE;
     else if (bitdepth == 24)
-    {
-        if (channels == 2)
-        {
-            load_data_i24BE(0, loaddata, nsamples, 6);
-            load_data_i24BE(1, loaddata + 3, nsamples, 6);
-        }
-        else
-            load_data_i24BE(0, loaddata, nsamples, 3);
-    }
+        format = pcm::Format::I24BE;
     else if (bitdepth == 16)
-    {
-        if (channels == 2)
-        {
-            load_data_i16BE(0, loaddata, nsamples, 4);
-            load_data_i16BE(1, loaddata + 2, nsamples, 4);
-        }
-        else
-            load_data_i16BE(0, loaddata, nsamples, 2);
-    }
+        format = pcm::Format::I16BE;
     else if (bitdepth == 8)
+        format = pcm::Format::I8;
+    else
+        return false;
+
+    if (!load_data_interleaved(format, loaddata, nsamples, channels))
     {
-        if (channels == 2)
-        {
-            load_data_i8(0, loaddata, nsamples, 2);
-            load_data_i8(1, loaddata + 1, nsamples, 2);
-        }
-        else
-            load_data_i8(0, loaddata, nsamples, 1);
+        SCLOG("Failed to load aiff: unable to convert sample data");
+        clear_data();
+        return false;
     }
 
     this->sample_loaded = (sampleData[0] != 0);
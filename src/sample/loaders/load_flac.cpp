@@ -25,71 +25,102 @@
  * https://github.com/surge-synthesizer/shortcircuit-xt
  */
 #include "sample/sample.h"
+#include "sample/sample_loader.h"
 
 #if SCXT_USE_FLAC
 #include "FLAC++/decoder.h"
+#include "infrastructure/sse_include.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
 namespace scxt::sample
 {
 namespace detail
 {
+/*
+ * Files with at least this many frames get split across threads at frame
+ * boundaries (via seek_absolute, which uses the seek table when there is one).
+ * We only do this when no other load is outstanding, since a busy SampleLoader
+ * already has every core decoding a file of its own.
+ */
+static constexpr uint64_t flacParallelDecodeMinFrames{1 << 20};
+static constexpr uint64_t flacParallelDecodeMinChunk{1 << 18};
+static constexpr size_t flacParallelDecodeMaxThreads{8};
+
+// FLAC hands us right justified ints; bring them up to our I16 format
+inline void flacToI16(const FLAC__int32 *src, int16_t *dst, size_t n, uint32_t bps)
+{
+    auto shift = 16 - bps;
+    for (size_t i = 0; i < n; ++i)
+        dst[i] = (int16_t)(src[i] << shift);
+}
+
+// And for deeper files, scale to float four at a time
+inline void flacToF32(const FLAC__int32 *src, float *dst, size_t n, uint32_t bps)
+{
+    const float scale = (float)(1.0 / (double)(1ULL << (bps - 1)));
+    const auto scale4 = _mm_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        auto iv = _mm_loadu_si128((const __m128i *)(src + i));
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(iv), scale4));
+    }
+    for (; i < n; ++i)
+        dst[i] = scale * (float)src[i];
+}
+
 class SampleFLACDecoder : public FLAC::Decoder::File
 {
   public:
     Sample *sample{nullptr};
     SampleFLACDecoder(Sample *s) : FLAC::Decoder::File(), sample(s) {}
 
-    bool isValid{false};
-
-  protected:
-    FILE *f;
+    // Stream info, filled in by the metadata callback
+    bool hasStreamInfo{false};
+    uint64_t totalSamples{0};
+    uint32_t sampleRate{0}, channels{0}, bps{0};
 
-    int64_t streamPos{0};
+    // The frame range this decoder writes. Frames outside it are decoded but dropped.
+    uint64_t startSample{0}, endSample{0};
+    uint64_t decodedUpTo{0};
 
+  protected:
     virtual ::FLAC__StreamDecoderWriteStatus write_callback(const ::FLAC__Frame *frame,
                                                             const FLAC__int32 *const buffer[])
     {
-        if (sample->bitDepth == Sample::BD_I16)
+        // libFLAC converts frame numbers to sample numbers before calling us
+        uint64_t pos = frame->header.number.sample_number;
+
+        auto blockEnd = pos + frame->header.blocksize;
+        auto from = std::max(pos, startSample);
+        auto to = std::min({blockEnd, endSample, (uint64_t)sample->sample_length});
+
+        if (from < to && frame->header.channels == sample->channels)
         {
             for (int c = 0; c < sample->channels; ++c)
             {
-                auto sdata = sample->GetSamplePtrI16(c);
-                for (int i = 0; i < frame->header.blocksize; i++)
-                {
-                    sdata[i + streamPos] = (FLAC__int16)buffer[c][i];
-                }
+                auto src = buffer[c] + (from - pos);
+                if (sample->bitDepth == Sample::BD_I16)
+                    flacToI16(src, sample->GetSamplePtrI16(c) + from, to - from, bps);
+                else
+                    flacToF32(src, sample->GetSamplePtrF32(c) + from, to - from, bps);
             }
-            streamPos += frame->header.blocksize;
         }
+        decodedUpTo = blockEnd;
         return FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
     }
     virtual void metadata_callback(const ::FLAC__StreamMetadata *metadata)
     {
         if (metadata->type == FLAC__METADATA_TYPE_STREAMINFO)
         {
-            /* save for later */
-            auto total_samples = metadata->data.stream_info.total_samples;
-            auto sample_rate = metadata->data.stream_info.sample_rate;
-            auto channels = metadata->data.stream_info.channels;
-            auto bps = metadata->data.stream_info.bits_per_sample;
-
-            sample->sample_rate = sample_rate;
-            sample->channels = channels;
-            sample->bitDepth = (bps <= 16 ? Sample::BD_I16 : Sample::BD_F32);
-            sample->sample_length = total_samples;
-
-            if (bps == 16)
-            {
-                if (channels == 1)
-                {
-                    sample->allocateI16(0, total_samples);
-                }
-                else if (channels == 2)
-                {
-                    sample->allocateI16(0, total_samples);
-                    sample->allocateI16(1, total_samples);
-                }
-                isValid = true;
-            }
+            totalSamples = metadata->data.stream_info.total_samples;
+            sampleRate = metadata->data.stream_info.sample_rate;
+            channels = metadata->data.stream_info.channels;
+            bps = metadata->data.stream_info.bits_per_sample;
+            hasStreamInfo = true;
         }
     }
     virtual void error_callback(::FLAC__StreamDecoderErrorStatus status) {}
@@ -98,22 +129,94 @@ class SampleFLACDecoder : public FLAC::Decoder::File
     SampleFLACDecoder(const SampleFLACDecoder &);
     SampleFLACDecoder &operator=(const SampleFLACDecoder &);
 };
+
+/*
+ * Decode [start, end) of the file into the sample's (already allocated) buffers
+ */
+bool decodeFlacRange(const fs::path &p, Sample *s, uint32_t bps, uint64_t start, uint64_t end)
+{
+    SampleFLACDecoder dec(s);
+    dec.bps = bps;
+    dec.startSample = start;
+    dec.endSample = end;
+    if (dec.init(p.u8string()) != FLAC__STREAM_DECODER_INIT_STATUS_OK)
+        return false;
+
+    // seek_absolute delivers the (trimmed) frame containing start to the write callback
+    if (start > 0 && !dec.seek_absolute(start))
+        return false;
+
+    while (dec.decodedUpTo < end)
+    {
+        if (dec.get_state() == FLAC__STREAM_DECODER_END_OF_STREAM)
+            break;
+        if (!dec.process_single())
+            return false;
+    }
+    return dec.decodedUpTo >= end;
+}
 } // namespace detail
+
 bool Sample::parseFlac(const fs::path &p)
 {
-    auto dec = detail::SampleFLACDecoder(this);
-    auto status = dec.init(p.u8string());
-    if (status != FLAC__STREAM_DECODER_INIT_STATUS_OK)
-        return false;
+    uint64_t total{0};
+    uint32_t bps{0};
+    {
+        auto probe = detail::SampleFLACDecoder(this);
+        if (probe.init(p.u8string()) != FLAC__STREAM_DECODER_INIT_STATUS_OK)
+            return false;
+        if (!probe.process_until_end_of_metadata() || !probe.hasStreamInfo)
+            return false;
+
+        total = probe.totalSamples;
+        bps = probe.bps;
+        // We need the length up front to allocate and we only do mono and stereo
+        if (total == 0 || total > 0xFFFFFFFF || bps < 4 || bps > 32 ||
+            !SetMeta(probe.channels, probe.sampleRate, (uint32_t)total))
+            return false;
+    }
+
+    for (int c = 0; c < channels; ++c)
+    {
+        bool ok = (bps <= 16) ? allocateI16(c, sample_length) : allocateF32(c, sample_length);
+        if (!ok)
+            return false;
+    }
+
+    bool res{false};
+    auto hwThreads = (size_t)std::max(std::thread::hardware_concurrency(), 1U);
+    auto nThreads = std::min({hwThreads, detail::flacParallelDecodeMaxThreads,
+                              (size_t)(total / detail::flacParallelDecodeMinChunk)});
+    if (total >= detail::flacParallelDecodeMinFrames && nThreads > 1 &&
+        SampleLoader::getOutstandingJobCount() <= 1)
+    {
+        std::vector<std::thread> workers;
+        std::vector<char> ok(nThreads, 0);
+        auto chunk = (total + nThreads - 1) / nThreads;
+        for (size_t t = 0; t < nThreads; ++t)
+        {
+            auto start = t * chunk;
+            auto end = std::min(total, start + chunk);
+            workers.emplace_back([&, t, start, end]() {
+                ok[t] = detail::decodeFlacRange(p, this, bps, start, end);
+            });
+        }
+        for (auto &w : workers)
+            w.join();
+        res = std::all_of(ok.begin(), ok.end(), [](auto b) { return b; });
+        if (!res)
+            SCLOG("Parallel FLAC decode failed; retrying serially " << p.u8string());
+    }
 
-    auto res = dec.process_until_end_of_stream();
+    if (!res)
+        res = detail::decodeFlacRange(p, this, bps, 0, total);
 
     mFileName = p;
     type = Sample::FLAC_FILE;
     instrument = 0;
     region = 0;
 
-    return res && dec.isValid;
+    return res;
 }
 } // namespace scxt::sample
 #else
@@ -190,48 +190,17 @@ bool Sample::parse_riff_wave(void *data, size_t filesize, bool skip_riffchunk)
         return false;
     }
 
+    pcm::Format format;
     if (wh.wFormatTag == WAVE_FORMAT_PCM)
     {
         if (wh.wBitsPerSample == 8)
-        {
-            if (channels == 2)
-            {
-                load_data_ui8(0, loaddata, WaveDataSamples, 2);
-                load_data_ui8(1, loaddata + 1, WaveDataSamples, 2);
-            }
-            else
-                load_data_ui8(0, loaddata, WaveDataSamples, 1);
-        }
+            format = pcm::Format::UI8;
         else if (wh.wBitsPerSample == 16)
-        {
-            if (channels == 2)
-            {
-                load_data_i16(0, loaddata, WaveDataSamples, 4);
-                load_data_i16(1, loaddata + 2, WaveDataSamples, 4);
-            }
-            else
-                load_data_i16(0, loaddata, WaveDataSamples, 2);
-        }
+            format = pcm::Format::I16LE;
         else if (wh.wBitsPerSample == 24)
-        {
-            if (channels == 2)
-            {
-                load_data_i24(0, loaddata, WaveDataSamples, 6);
-                load_data_i24(1, loaddata + 3, WaveDataSamples, 6);
-            }
-            else
-                load_data_i24(0, loaddata, WaveDataSamples, 3);
-        }
+            format = pcm::Format::I24LE;
         else if (wh.wBitsPerSample == 32)
-        {
-            if (channels == 2)
-            {
-                load_data_i32(0, loaddata, WaveDataSamples, 8);
-                load_data_i32(1, loaddata + 4, WaveDataSamples, 8);
-            }
-            else
-                load_data_i32(0, loaddata, WaveDataSamples, 4);
-        }
+            format = pcm::Format::I32LE;
         else
         {
             SCLOG("Failed to load: " << SCD(wh.wBitsPerSample)
@@ -242,25 +211,9 @@ bool Sample::parse_riff_wave(void *data, size_t filesize, bool skip_riffchunk)
     else if (wh.wFormatTag == WAVE_FORMAT_IEEE_FLOAT)
     {
         if (wh.wBitsPerSample == 32)
-        {
-            if (channels == 2)
-            {
-                load_data_f32(0, loaddata, WaveDataSamples, 8);
-                load_data_f32(1, loaddata + 4, WaveDataSamples, 8);
-            }
-            else
-                load_data_f32(0, loaddata, WaveDataSamples, 4);
-        }
+            format = pcm::Format::F32LE;
         else if (wh.wBitsPerSample == 64)
-        {
-            if (channels == 2)
-            {
-                load_data_f64(0, loaddata, WaveDataSamples, 16);
-                load_data_f64(1, loaddata + 8, WaveDataSamples, 16);
-            }
-            else
-                load_data_f64(0, loaddata, WaveDataSamples, 8);
-        }
+            format = pcm::Format::F64LE;
         else
         {
             SCLOG("Failed to load wav: " << SCD(wh.wBitsPerSample)
@@ -277,6 +230,11 @@ bool Sample::parse_riff_wave(void *data, size_t filesize, bool skip_riffchunk)
               << std::setfill('0') << WAVE_FORMAT_PCM << ")");
         return false;
     }
+    if (!load_data_interleaved(format, loaddata, WaveDataSamples, channels))
+    {
+        SCLOG("Failed to load wav: unable to allocate sample data");
+        return false;
+    }
     this->sample_loaded = true;
 
     // read smpl chunk
@@ -0,0 +1,370 @@
+/*
+ * Shortcircuit XT - a Surge Synth Team product
+ *
+ * A fully featured creative sampler, available as a standalone
+ * and plugin for multiple platforms.
+ *
+ * Copyright 2019 - 2023, Various authors, as described in the github
+ * transaction log.
+ *
+ * ShortcircuitXT is released under the Gnu General Public Licence
+ * V3 or later (GPL-3.0-or-later). The license is found in the file
+ * "LICENSE" in the root of this repository or at
+ * https://www.gnu.org/licenses/gpl-3.0.en.html
+ *
+ * Individual sections of code which comprises ShortcircuitXT in this
+ * repository may also be used under an MIT license. Please see the
+ * section  "Licensing" in "README.md" for details.
+ *
+ * ShortcircuitXT is inspired by, and shares code with, the
+ * commercial product Shortcircuit 1 and 2, released by VemberTech
+ * in the mid 2000s. The code for Shortcircuit 2 was opensourced in
+ * 2020 at the outset of this project.
+ *
+ * All source for ShortcircuitXT is available at
+ * https://github.com/surge-synthesizer/shortcircuit-xt
+ */
+
+
+#include "monolith.h"
+#include "sample.h"
+#include "sample_record.h"
+#include "dsp/resampling.h"
+
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+
+namespace scxt::sample
+{
+using detail::HeaderReader;
+using detail::HeaderWriter;
+
+namespace
+{
+static constexpr char monolithMagic[8]{'S', 'C', 'X', 'T', 'M', 'O', 'N', '1'};
+static constexpr uint32_t monolithVersion{2};
+
+inline uint64_t alignToPage(uint64_t s)
+{
+    return (s + MonolithBundle::pageSize - 1) / MonolithBundle::pageSize * MonolithBundle::pageSize;
+}
+
+uint64_t channelBytes(const Sample &s)
+{
+    return ((uint64_t)s.sample_length + dsp::FIRipol_N) * Sample::bitDepthByteSize(s.bitDepth);
+}
+
+void writeSummary(HeaderWriter &w, const std::shared_ptr<const WaveformSummary> &ws)
+{
+    if (!ws)
+    {
+        w.value((uint32_t)0);
+        return;
+    }
+    w.value((uint32_t)ws->levels.size());
+    w.value((uint64_t)ws->sampleLength);
+    w.value((int32_t)ws->channels);
+    for (const auto &l : ws->levels)
+    {
+        for (const auto &c : l)
+        {
+            w.value((uint64_t)c.size());
+            w.bytes(c.data(), c.size() * sizeof(WaveformSummary::Bucket));
+        }
+    }
+}
+} // namespace
+
+bool MonolithBundle::write(const fs::path &to, const std::string &stateJson,
+                           const std::vector<std::shared_ptr<Sample>> &samples)
+{
+    HeaderWriter index;
+    index.string(stateJson);
+    index.value((uint32_t)samples.size());
+
+    // Sample data starts after the header page and each channel starts on a page
+    uint64_t pos{pageSize};
+    for (const auto &s : samples)
+    {
+        if (!s || s->isResidencyHead() || s->channels < 1 || s->channels > 2)
+        {
+            SCLOG("Monolith: can't bundle a missing or partially resident sample");
+            return false;
+        }
+        for (int c = 0; c < s->channels; ++c)
+        {
+            if (!s->sampleData[c])
+            {
+                SCLOG("Monolith: sample " << s->getDisplayName() << " has no data");
+                return false;
+            }
+        }
+
+        HeaderWriter desc;
+        detail::writeSampleDescription(desc, *s);
+        index.value((uint32_t)desc.data.size());
+        index.bytes(desc.data.data(), desc.data.size());
+
+        auto cb = channelBytes(*s);
+        index.value(cb);
+        for (int c = 0; c < 2; ++c)
+        {
+            if (c < s->channels)
+            {
+                index.value(pos);
+                pos += alignToPage(cb);
+            }
+            else
+            {
+                index.value((uint64_t)0);
+            }
+        }
+
+        HeaderWriter summary;
+        writeSummary(summary, s->getWaveformSummary());
+        index.value((uint32_t)summary.data.size());
+        index.bytes(summary.data.data(), summary.data.size());
+    }
+
+    HeaderWriter header;
+    header.bytes(monolithMagic, 8);
+    header.value(monolithVersion);
+    header.value(pos);
+    header.value((uint64_t)index.data.size());
+    header.data.resize(pageSize, 0);
+
+    std::ostringstream tmpn;
+    tmpn << to.filename().u8string() << "." << std::this_thread::get_id() << ".tmp";
+    auto tmpFile = to.parent_path() / tmpn.str();
+
+    {
+        std::ofstream ofs(tmpFile, std::ios::binary | std::ios::trunc);
+        if (!ofs)
+        {
+            SCLOG("Monolith: unable to open " << tmpFile.u8string());
+            return false;
+        }
+        ofs.write((const char *)header.data.data(), header.data.size());
+        std::vector<char> pad;
+        for (const auto &s : samples)
+        {
+            auto cb = channelBytes(*s);
+            pad.assign(alignToPage(cb) - cb, 0);
+            for (int c = 0; c < s->channels; ++c)
+            {
+                ofs.write((const char *)s->sampleData[c], cb);
+                ofs.write(pad.data(), pad.size());
+            }
+        }
+        ofs.write((const char *)index.data.data(), index.data.size());
+        if (!ofs)
+        {
+            ofs.close();
+            std::error_code ec;
+            fs::remove(tmpFile, ec);
+            SCLOG("Monolith: unable to write " << tmpFile.u8string());
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    fs::rename(tmpFile, to, ec);
+    if (ec)
+    {
+        fs::remove(tmpFile, ec);
+        SCLOG("Monolith: unable to move bundle into place at " << to.u8string());
+        return false;
+    }
+    return true;
+}
+
+std::shared_ptr<const MonolithBundle> MonolithBundle::forFile(const fs::path &p)
+{
+    static std::mutex registryMutex;
+    static std::unordered_map<std::string, std::weak_ptr<const MonolithBundle>> registry;
+
+    std::error_code ec;
+    auto key = fs::weakly_canonical(p, ec).u8string();
+    if (ec)
+        key = p.lexically_normal().u8string();
+
+    // A bundle rewritten in place gets a fresh map; samples on the old one keep theirs
+    auto size = fs::file_size(p, ec);
+    if (ec)
+        return nullptr;
+    auto time = fs::last_write_time(p, ec).time_since_epoch().count();
+    if (ec)
+        return nullptr;
+
+    std::lock_guard<std::mutex> g(registryMutex);
+    auto r = registry.find(key);
+    if (r != registry.end())
+    {
+        auto res = r->second.lock();
+        if (res && res->fileSize == size && res->fileTime == (int64_t)time)
+            return res;
+    }
+
+    for (auto it = registry.begin(); it != registry.end();)
+    {
+        if (it->second.expired())
+            it = registry.erase(it);
+        else
+            ++it;
+    }
+
+    auto res = std::make_shared<MonolithBundle>(p);
+    res->fileSize = size;
+    res->fileTime = (int64_t)time;
+    if (!res->parse())
+        return nullptr;
+    registry[key] = res;
+    return res;
+}
+
+MonolithBundle::MonolithBundle(const fs::path &p)
+    : view(std::make_unique<infrastructure::FileMapView>(p))
+{
+}
+
+bool MonolithBundle::parse()
+{
+    if (!view->isMapped() || view->dataSize() < pageSize)
+        return false;
+
+    data = (const uint8_t *)view->data();
+    dataSize = view->dataSize();
+
+    HeaderReader h(data, pageSize);
+    char magic[8];
+    h.bytes(magic, 8);
+    auto version = h.value<uint32_t>();
+    auto indexOffset = h.value<uint64_t>();
+    auto indexBytes = h.value<uint64_t>();
+    if (!h.ok || memcmp(magic, monolithMagic, 8) != 0 || version != monolithVersion ||
+        indexOffset > dataSize || indexBytes > dataSize - indexOffset)
+        return false;
+
+    HeaderReader r(data + indexOffset, indexBytes);
+    stateJson = r.string();
+    auto n = r.value<uint32_t>();
+    if (!r.ok)
+        return false;
+
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        Record rec;
+        rec.descriptionBytes = r.value<uint32_t>();
+        rec.description = r.span(rec.descriptionBytes);
+        rec.channelBytes = r.value<uint64_t>();
+        rec.dataOffset[0] = r.value<uint64_t>();
+        rec.dataOffset[1] = r.value<uint64_t>();
+        rec.summaryBytes = r.value<uint32_t>();
+        rec.summary = r.span(rec.summaryBytes);
+        if (!r.ok)
+            return false;
+
+        // Data lives between the header page and the index, page aligned
+        for (auto off : rec.dataOffset)
+        {
+            if (off == 0)
+                continue;
+            if (off < pageSize || off % pageSize != 0 || off > indexOffset ||
+                rec.channelBytes > indexOffset - off)
+                return false;
+        }
+        records.push_back(rec);
+    }
+    return true;
+}
+
+std::array<const void *, 2> MonolithBundle::describeSample(size_t idx, Sample &s) const
+{
+    std::array<const void *, 2> res{nullptr, nullptr};
+    if (idx >= records.size())
+        return res;
+
+    const auto &rec = records[idx];
+    HeaderReader r(rec.description, rec.descriptionBytes);
+    auto d = detail::readSampleDescription(r);
+    if (!d.has_value())
+        return res;
+    if (d->bitDepth != Sample::BD_I16 && d->bitDepth != Sample::BD_F32 &&
+        d->bitDepth != Sample::BD_F16)
+        return res;
+    if (rec.channelBytes !=
+        ((uint64_t)d->sampleLength + dsp::FIRipol_N) * Sample::bitDepthByteSize(d->bitDepth))
+        return res;
+    for (int c = 0; c < d->channels; ++c)
+    {
+        if (rec.dataOffset[c] == 0)
+            return res;
+    }
+
+    // The record checks out, so now the sample can take it on
+    detail::applySampleDescription(*d, s);
+    s.SetMeta(d->channels, d->sampleRate, d->sampleLength);
+    s.bitDepth = d->bitDepth;
+    s.contentHash = d->contentHash;
+    for (int c = 0; c < d->channels; ++c)
+        res[c] = data + rec.dataOffset[c];
+    return res;
+}
+
+std::shared_ptr<const WaveformSummary> MonolithBundle::getWaveformSummary(size_t idx) const
+{
+    if (idx >= records.size() || !records[idx].summary)
+        return nullptr;
+
+    // Nothing here is trusted: a summary which doesn't fit its record is dropped, and
+    // the sample builds a fresh one when it is first asked for
+    HeaderReader dr(records[idx].description, records[idx].descriptionBytes);
+    auto d = detail::readSampleDescription(dr);
+    if (!d.has_value())
+        return nullptr;
+
+    HeaderReader r(records[idx].summary, records[idx].summaryBytes);
+    auto nLevels = r.value<uint32_t>();
+    if (!r.ok || nLevels == 0)
+        return nullptr;
+
+    auto res = std::make_shared<WaveformSummary>();
+    res->sampleLength = r.value<uint64_t>();
+    res->channels = r.value<int32_t>();
+    if (!r.ok || nLevels > r.left)
+        return nullptr;
+    if (res->channels < 1 || res->channels > 2 || res->sampleLength != d->sampleLength)
+        return nullptr;
+    // WaveformSummary::build halves the base buckets until one is left
+    uint32_t wantLevels{1};
+    for (auto n = (res->sampleLength + WaveformSummary::baseBlock - 1) / WaveformSummary::baseBlock;
+         n > 1; n = (n + 1) / 2)
+        wantLevels++;
+    if (nLevels != wantLevels)
+        return nullptr;
+    res->levels.resize(nLevels);
+    for (size_t k = 0; k < nLevels; ++k)
+    {
+        auto bucketSize = WaveformSummary::baseBlock << k;
+        auto expected = (res->sampleLength + bucketSize - 1) / bucketSize;
+        for (int ch = 0; ch < 2; ++ch)
+        {
+            auto &c = res->levels[k][ch];
+            auto nb = r.value<uint64_t>();
+            if (!r.ok || nb > r.left / sizeof(WaveformSummary::Bucket))
+                return nullptr;
+            if (ch < res->channels && nb != expected)
+                return nullptr;
+            c.resize(nb);
+            r.bytes(c.data(), nb * sizeof(WaveformSummary::Bucket));
+        }
+    }
+    if (!r.ok)
+        return nullptr;
+    return res;
+}
+} // namespace scxt::sample
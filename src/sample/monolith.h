@@ -0,0 +1,123 @@
+/*
+ * Shortcircuit XT - a Surge Synth Team product
+ *
+ * A fully featured creative sampler, available as a standalone
+ * and plugin for multiple platforms.
+ *
+ * Copyright 2019 - 2023, Various authors, as described in the github
+ * transaction log.
+ *
+ * ShortcircuitXT is released under the Gnu General Public Licence
+ * V3 or later (GPL-3.0-or-later). The license is found in the file
+ * "LICENSE" in the root of this repository or at
+ * https://www.gnu.org/licenses/gpl-3.0.en.html
+ *
+ * Individual sections of code which comprises ShortcircuitXT in this
+ * repository may also be used under an MIT license. Please see the
+ * section  "Licensing" in "README.md" for details.
+ *
+ * ShortcircuitXT is inspired by, and shares code with, the
+ * commercial product Shortcircuit 1 and 2, released by VemberTech
+ * in the mid 2000s. The code for Shortcircuit 2 was opensourced in
+ * 2020 at the outset of this project.
+ *
+ * All source for ShortcircuitXT is available at
+ * https://github.com/surge-synthesizer/shortcircuit-xt
+ */
+
+
+#ifndef SCXT_SRC_SAMPLE_MONOLITH_H
+#define SCXT_SRC_SAMPLE_MONOLITH_H
+
+#include "utils.h"
+#include "infrastructure/filesystem_import.h"
+#include "infrastructure/file_map_view.h"
+#include "waveform_summary.h"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace scxt::sample
+{
+struct Sample;
+
+/**
+ * A monolith is a single file holding a saved engine state together with every
+ * sample it uses, so an instrument can be moved to another machine and loaded
+ * without its original sample files.
+ *
+ * Each sample's channels are stored exactly as Sample holds them in memory (bit
+ * depth, FIR padding and all) at page aligned offsets. A bundle is memory mapped
+ * and its samples point straight into the map, with no decode, conversion or copy,
+ * so a cold load costs little more than paging the data in. The waveform
+ * summaries are stored as well so drawing doesn't have to scan the data.
+ *
+ * The file is a fixed header (magic, version, index offset and size) in the first
+ * page, the sample data, then the index: the state json followed by one record per
+ * sample with its description, channel offsets and summary. In the state the
+ * samples have MONOLITH_FILE addresses whose region is their record in the index.
+ * The address path is whatever the bundle was called when written; the loader
+ * replaces it with the bundle's real location.
+ *
+ * Like the sample cache, a monolith is written in native byte order.
+ */
+struct MonolithBundle : MoveableOnly<MonolithBundle>
+{
+    static constexpr size_t pageSize{4096};
+    static constexpr const char *extension{".scxtmono"};
+
+    /**
+     * Write a bundle. samples[i] is stored as record i, and stateJson must already
+     * refer to it that way. Returns false (having written nothing) if any sample
+     * has no data or the file can't be written.
+     */
+    static bool write(const fs::path &to, const std::string &stateJson,
+                      const std::vector<std::shared_ptr<Sample>> &samples);
+
+    /**
+     * Get the bundle for a file, sharing a map already open if the file hasn't
+     * changed since. Returns null if the file can't be mapped or isn't a valid
+     * bundle. Safe from any thread.
+     */
+    static std::shared_ptr<const MonolithBundle> forFile(const fs::path &);
+
+    const std::string &getStateJson() const { return stateJson; }
+    size_t getSampleCount() const { return records.size(); }
+
+    /**
+     * Fill in the layout, name and metadata of record idx on s and return each
+     * channel's data, padded like Sample::sampleData and pointing into the map.
+     * Returns nulls if idx is out of range or its record is bad.
+     */
+    std::array<const void *, 2> describeSample(size_t idx, Sample &s) const;
+    std::shared_ptr<const WaveformSummary> getWaveformSummary(size_t idx) const;
+
+    explicit MonolithBundle(const fs::path &);
+
+  private:
+    bool parse();
+
+    struct Record
+    {
+        const uint8_t *description{nullptr};
+        size_t descriptionBytes{0};
+        std::array<uint64_t, 2> dataOffset{0, 0};
+        uint64_t channelBytes{0};
+        const uint8_t *summary{nullptr};
+        size_t summaryBytes{0};
+    };
+
+    std::unique_ptr<infrastructure::FileMapView> view;
+    const uint8_t *data{nullptr};
+    size_t dataSize{0};
+    std::string stateJson;
+    std::vector<Record> records;
+    uint64_t fileSize{0};
+    int64_t fileTime{0};
+};
+} // namespace scxt::sample
+
+#endif // SHORTCIRCUITXT_MONOLITH_H
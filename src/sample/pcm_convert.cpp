@@ -0,0 +1,762 @@
+/*
+ * Shortcircuit XT - a Surge Synth Team product
+ *
+ * A fully featured creative sampler, available as a standalone
+ * and plugin for multiple platforms.
+ *
+ * Copyright 2019 - 2023, Various authors, as described in the github
+ * transaction log.
+ *
+ * ShortcircuitXT is released under the Gnu General Public Licence
+ * V3 or later (GPL-3.0-or-later). The license is found in the file
+ * "LICENSE" in the root of this repository or at
+ * https://www.gnu.org/licenses/gpl-3.0.en.html
+ *
+ * Individual sections of code which comprises ShortcircuitXT in this
+ * repository may also be used under an MIT license. Please see the
+ * section  "Licensing" in "README.md" for details.
+ *
+ * ShortcircuitXT is inspired by, and shares code with, the
+ * commercial product Shortcircuit 1 and 2, released by VemberTech
+ * in the mid 2000s. The code for Shortcircuit 2 was opensourced in
+ * 2020 at the outset of this project.
+ *
+ * All source for ShortcircuitXT is available at
+ * https://github.com/surge-synthesizer/shortcircuit-xt
+ */
+
+
+#include "pcm_convert.h"
+
+#include <cassert>
+#include <cstring>
+
+#include "infrastructure/sse_include.h"
+#include "infrastructure/half_float.h"
+#include "infrastructure/cpu_isa.h"
+
+// The vector paths read samples as little endian lanes
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define SCXT_PCM_SIMD 0
+#else
+#define SCXT_PCM_SIMD 1
+#endif
+
+namespace scxt::sample::pcm
+{
+namespace
+{
+// These are the constants the scalar Sample::load_data_xxx functions use. They are
+// both exact powers of two, which is what makes the vector paths bit exact.
+static constexpr float i24Scale{0.00000011920928955078f};
+static constexpr float i32Scale{4.6566128730772E-10f};
+
+template <Format F> struct FormatTraits;
+template <> struct FormatTraits<Format::UI8>
+{
+    static constexpr size_t bytes{1};
+    using out_t = int16_t;
+};
+template <> struct FormatTraits<Format::I8>
+{
+    static constexpr size_t bytes{1};
+    using out_t = int16_t;
+};
+template <> struct FormatTraits<Format::I16LE>
+{
+    static constexpr size_t bytes{2};
+    using out_t = int16_t;
+};
+template <> struct FormatTraits<Format::I16BE>
+{
+    static constexpr size_t bytes{2};
+    using out_t = int16_t;
+};
+template <> struct FormatTraits<Format::I24LE>
+{
+    static constexpr size_t bytes{3};
+    using out_t = float;
+};
+template <> struct FormatTraits<Format::I24BE>
+{
+    static constexpr size_t bytes{3};
+    using out_t = float;
+};
+template <> struct FormatTraits<Format::I32LE>
+{
+    static constexpr size_t bytes{4};
+    using out_t = float;
+};
+template <> struct FormatTraits<Format::I32BE>
+{
+    static constexpr size_t bytes{4};
+    using out_t = float;
+};
+template <> struct FormatTraits<Format::F32LE>
+{
+    static constexpr size_t bytes{4};
+    using out_t = float;
+};
+template <> struct FormatTraits<Format::F64LE>
+{
+    static constexpr size_t bytes{8};
+    using out_t = float;
+};
+
+template <Format F> using out_t = typename FormatTraits<F>::out_t;
+
+/*
+ * The scalar reference. Byte assembly rather than a cast load so this is right
+ * on any host and for any alignment.
+ */
+template <Format F> inline out_t<F> convertOne(const uint8_t *p)
+{
+    if constexpr (F == Format::UI8)
+    {
+        return (int16_t)((int(p[0]) - 128) * 256);
+    }
+    else if constexpr (F == Format::I8)
+    {
+        return (int16_t)(int((int8_t)p[0]) * 256);
+    }
+    else if constexpr (F == Format::I16LE)
+    {
+        return (int16_t)(uint16_t)(p[0] | (p[1] << 8));
+    }
+    else if constexpr (F == Format::I16BE)
+    {
+        return (int16_t)(uint16_t)(p[1] | (p[0] << 8));
+    }
+    else if constexpr (F == Format::I24LE || F == Format::I24BE)
+    {
+        int value = (F == Format::I24LE) ? ((p[2] << 16) | (p[1] << 8) | p[0])
+                                         : ((p[0] << 16) | (p[1] << 8) | p[2]);
+        value -= (value & 0x800000) << 1;
+        return i24Scale * float(value);
+    }
+    else if constexpr (F == Format::I32LE || F == Format::I32BE)
+    {
+        uint32_t u = (F == Format::I32LE)
+                         ? (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+                               ((uint32_t)p[3] << 24)
+                         : (uint32_t)p[3] | ((uint32_t)p[2] << 8) | ((uint32_t)p[1] << 16) |
+                               ((uint32_t)p[0] << 24);
+        return i32Scale * (float)(int32_t)u;
+    }
+    else if constexpr (F == Format::F32LE)
+    {
+        uint32_t u = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+                     ((uint32_t)p[3] << 24);
+        float f;
+        memcpy(&f, &u, sizeof(f));
+        return f;
+    }
+    else
+    {
+        uint64_t u{0};
+        for (int b = 7; b >= 0; --b)
+            u = (u << 8) | p[b];
+        double d;
+        memcpy(&d, &u, sizeof(d));
+        return (float)d;
+    }
+}
+
+template <Format F>
+void convertScalar(const uint8_t *src, size_t from, size_t frames, int channels,
+                   out_t<F> *const *dest)
+{
+    constexpr size_t bps = FormatTraits<F>::bytes;
+    if (channels == 1)
+    {
+        for (size_t i = from; i < frames; ++i)
+            dest[0][i] = convertOne<F>(src + i * bps);
+    }
+    else
+    {
+        for (size_t i = from; i < frames; ++i)
+        {
+            dest[0][i] = convertOne<F>(src + i * 2 * bps);
+            dest[1][i] = convertOne<F>(src + i * 2 * bps + bps);
+        }
+    }
+}
+
+#if SCXT_PCM_SIMD
+/*
+ * SSE2. Every kernel converts as many whole blocks as it can without reading past
+ * the end of the source and returns the number of frames done; the scalar
+ * path finishes the tail.
+ */
+namespace sse2
+{
+inline __m128i swap16(__m128i v)
+{
+    return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+}
+inline __m128i swap32(__m128i v)
+{
+    v = swap16(v);
+    return _mm_or_si128(_mm_slli_epi32(v, 16), _mm_srli_epi32(v, 16));
+}
+
+inline __m128i load(const uint8_t *p) { return _mm_loadu_si128((const __m128i *)p); }
+
+template <bool isUnsigned>
+size_t int8(const uint8_t *src, size_t frames, int channels, int16_t *const *dest)
+{
+    const auto zero = _mm_setzero_si128();
+    const auto flip = _mm_set1_epi8((char)0x80);
+    const auto hiByte = _mm_set1_epi16((short)0xFF00);
+    size_t i{0};
+    if (channels == 1)
+    {
+        for (; i + 16 <= frames; i += 16)
+        {
+            auto v = load(src + i);
+            if constexpr (isUnsigned)
+                v = _mm_xor_si128(v, flip);
+            // A byte in the high half of a zeroed word is value << 8
+            _mm_storeu_si128((__m128i *)(dest[0] + i), _mm_unpacklo_epi8(zero, v));
+            _mm_storeu_si128((__m128i *)(dest[0] + i + 8), _mm_unpackhi_epi8(zero, v));
+        }
+    }
+    else
+    {
+        // Each 16 bit word is one frame: left in the low byte, right in the high one
+        for (; i + 8 <= frames; i += 8)
+        {
+            auto v = load(src + i * 2);
+            if constexpr (isUnsigned)
+                v = _mm_xor_si128(v, flip);
+            _mm_storeu_si128((__m128i *)(dest[0] + i), _mm_slli_epi16(v, 8));
+            _mm_storeu_si128((__m128i *)(dest[1] + i), _mm_and_si128(v, hiByte));
+        }
+    }
+    return i;
+}
+
+template <bool bigEndian>
+size_t int16(const uint8_t *src, size_t frames, int channels, int16_t *const *dest)
+{
+    size_t i{0};
+    if (channels == 1)
+    {
+        if constexpr (!bigEndian)
+        {
+            memcpy(dest[0], src, frames * sizeof(int16_t));
+            return frames;
+        }
+        for (; i + 8 <= frames; i += 8)
+            _mm_storeu_si128((__m128i *)(dest[0] + i), swap16(load(src + i * 2)));
+    }
+    else
+    {
+        for (; i + 8 <= frames; i += 8)
+        {
+            auto a = load(src + i * 4);
+            auto b = load(src + i * 4 + 16);
+            if constexpr (bigEndian)
+            {
+                a = swap16(a);
+                b = swap16(b);
+            }
+            // Sign extend each half of the 32 bit frames then pack; the pack can't
+            // saturate since everything is already in int16 range
+            auto la = _mm_srai_epi32(_mm_slli_epi32(a, 16), 16);
+            auto lb = _mm_srai_epi32(_mm_slli_epi32(b, 16), 16);
+            auto ra = _mm_srai_epi32(a, 16);
+            auto rb = _mm_srai_epi32(b, 16);
+            _mm_storeu_si128((__m128i *)(dest[0] + i), _mm_packs_epi32(la, lb));
+            _mm_storeu_si128((__m128i *)(dest[1] + i), _mm_packs_epi32(ra, rb));
+        }
+    }
+    return i;
+}
+
+// Four packed 24 bit samples from the 16 bytes at p, as 24.8 fixed point.
+template <bool bigEndian> inline __m128i gather24(const uint8_t *p)
+{
+    auto v = load(p);
+    auto s01 = _mm_unpacklo_epi32(v, _mm_srli_si128(v, 3));
+    auto s23 = _mm_unpacklo_epi32(_mm_srli_si128(v, 6), _mm_srli_si128(v, 9));
+    auto s = _mm_unpacklo_epi64(s01, s23);
+    if constexpr (bigEndian)
+        return swap32(s);
+    else
+        return _mm_slli_epi32(s, 8);
+}
+
+template <bool bigEndian>
+size_t int24(const uint8_t *src, size_t frames, int channels, float *const *dest)
+{
+    const auto scale = _mm_set1_ps(i24Scale);
+    const size_t total = frames * channels * 3;
+    size_t i{0};
+    if (channels == 1)
+    {
+        for (; (i + 4) * 3 + 4 <= total; i += 4)
+        {
+            auto s = _mm_srai_epi32(gather24<bigEndian>(src + i * 3), 8);
+            _mm_storeu_ps(dest[0] + i, _mm_mul_ps(_mm_cvtepi32_ps(s), scale));
+        }
+    }
+    else
+    {
+        for (; (i + 4) * 6 + 4 <= total; i += 4)
+        {
+            auto a = _mm_srai_epi32(gather24<bigEndian>(src + i * 6), 8);
+            auto b = _mm_srai_epi32(gather24<bigEndian>(src + i * 6 + 12), 8);
+            auto fa = _mm_mul_ps(_mm_cvtepi32_ps(a), scale);
+            auto fb = _mm_mul_ps(_mm_cvtepi32_ps(b), scale);
+            _mm_storeu_ps(dest[0] + i, _mm_shuffle_ps(fa, fb, _MM_SHUFFLE(2, 0, 2, 0)));
+            _mm_storeu_ps(dest[1] + i, _mm_shuffle_ps(fa, fb, _MM_SHUFFLE(3, 1, 3, 1)));
+        }
+    }
+    return i;
+}
+
+template <bool bigEndian, bool isFloat>
+inline __m128 load32(const uint8_t *p, __m128 scale)
+{
+    if constexpr (isFloat)
+    {
+        return _mm_loadu_ps((const float *)p);
+    }
+    else
+    {
+        auto v = load(p);
+        if constexpr (bigEndian)
+            v = swap32(v);
+        return _mm_mul_ps(_mm_cvtepi32_ps(v), scale);
+    }
+}
+
+template <bool bigEndian, bool isFloat>
+size_t int32(const uint8_t *src, size_t frames, int channels, float *const *dest)
+{
+    const auto scale = _mm_set1_ps(i32Scale);
+    size_t i{0};
+    if (channels == 1)
+    {
+        if constexpr (isFloat)
+        {
+            memcpy(dest[0], src, frames * sizeof(float));
+            return frames;
+        }
+        for (; i + 4 <= frames; i += 4)
+            _mm_storeu_ps(dest[0] + i, load32<bigEndian, isFloat>(src + i * 4, scale));
+    }
+    else
+    {
+        for (; i + 4 <= frames; i += 4)
+        {
+            auto fa = load32<bigEndian, isFloat>(src + i * 8, scale);
+            auto fb = load32<bigEndian, isFloat>(src + i * 8 + 16, scale);
+            _mm_storeu_ps(dest[0] + i, _mm_shuffle_ps(fa, fb, _MM_SHUFFLE(2, 0, 2, 0)));
+            _mm_storeu_ps(dest[1] + i, _mm_shuffle_ps(fa, fb, _MM_SHUFFLE(3, 1, 3, 1)));
+        }
+    }
+    return i;
+}
+
+inline __m128 load4f64(const uint8_t *p)
+{
+    auto lo = _mm_cvtpd_ps(_mm_loadu_pd((const double *)p));
+    auto hi = _mm_cvtpd_ps(_mm_loadu_pd((const double *)(p + 16)));
+    return _mm_movelh_ps(lo, hi);
+}
+
+inline size_t float64(const uint8_t *src, size_t frames, int channels, float *const *dest)
+{
+    size_t i{0};
+    if (channels == 1)
+    {
+        for (; i + 4 <= frames; i += 4)
+            _mm_storeu_ps(dest[0] + i, load4f64(src + i * 8));
+    }
+    else
+    {
+        for (; i + 4 <= frames; i += 4)
+        {
+            auto fa = load4f64(src + i * 16);
+            auto fb = load4f64(src + i * 16 + 32);
+            _mm_storeu_ps(dest[0] + i, _mm_shuffle_ps(fa, fb, _MM_SHUFFLE(2, 0, 2, 0)));
+            _mm_storeu_ps(dest[1] + i, _mm_shuffle_ps(fa, fb, _MM_SHUFFLE(3, 1, 3, 1)));
+        }
+    }
+    return i;
+}
+
+template <Format F>
+size_t kernel(const uint8_t *src, size_t frames, int channels, out_t<F> *const *dest)
+{
+    if constexpr (F == Format::UI8 || F == Format::I8)
+        return int8<F == Format::UI8>(src, frames, channels, dest);
+    else if constexpr (F == Format::I16LE || F == Format::I16BE)
+        return int16<F == Format::I16BE>(src, frames, channels, dest);
+    else if constexpr (F == Format::I24LE || F == Format::I24BE)
+        return int24<F == Format::I24BE>(src, frames, channels, dest);
+    else if constexpr (F == Format::I32LE || F == Format::I32BE)
+        return int32<F == Format::I32BE, false>(src, frames, channels, dest);
+    else if constexpr (F == Format::F32LE)
+        return int32<false, true>(src, frames, channels, dest);
+    else
+        return float64(src, frames, channels, dest);
+}
+} // namespace sse2
+#endif
+
+#if SCXT_PCM_SIMD && SCXT_ISA_X86
+/*
+ * AVX2. Same structure as the SSE2 kernels, twice the width. The 256 bit pack and
+ * shuffle instructions work within 128 bit lanes, hence the cross lane permutes.
+ */
+namespace avx2
+{
+SCXT_AVX2_TARGET inline __m256i load(const uint8_t *p)
+{
+    return _mm256_loadu_si256((const __m256i *)p);
+}
+
+SCXT_AVX2_TARGET inline __m256i swap16(__m256i v)
+{
+    return _mm256_or_si256(_mm256_slli_epi16(v, 8), _mm256_srli_epi16(v, 8));
+}
+
+SCXT_AVX2_TARGET inline __m256i swap32(__m256i v)
+{
+    const auto mask = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12, 3,
+                                       2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    return _mm256_shuffle_epi8(v, mask);
+}
+
+// Undo the in-lane interleave of a 64 bit granular shuffle or pack
+SCXT_AVX2_TARGET inline __m256 fixLanes(__m256 v)
+{
+    return _mm256_castpd_ps(
+        _mm256_permute4x64_pd(_mm256_castps_pd(v), _MM_SHUFFLE(3, 1, 2, 0)));
+}
+
+template <bool isUnsigned>
+SCXT_AVX2_TARGET size_t int8(const uint8_t *src, size_t frames, int channels,
+                                 int16_t *const *dest)
+{
+    const auto flip = _mm256_set1_epi8((char)0x80);
+    const auto hiByte = _mm256_set1_epi16((short)0xFF00);
+    size_t i{0};
+    if (channels == 1)
+    {
+        for (; i + 16 <= frames; i += 16)
+        {
+            auto v = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)(src + i)));
+            if constexpr (isUnsigned)
+                v = _mm256_xor_si256(v, _mm256_set1_epi16(0x80));
+            // the sign extension fills the high byte, which the shift then drops
+            _mm256_storeu_si256((__m256i *)(dest[0] + i), _mm256_slli_epi16(v, 8));
+        }
+    }
+    else
+    {
+        for (; i + 16 <= frames; i += 16)
+        {
+            auto v = load(src + i * 2);
+            if constexpr (isUnsigned)
+                v = _mm256_xor_si256(v, flip);
+            _mm256_storeu_si256((__m256i *)(dest[0] + i), _mm256_slli_epi16(v, 8));
+            _mm256_storeu_si256((__m256i *)(dest[1] + i), _mm256_and_si256(v, hiByte));
+        }
+    }
+    return i;
+}
+
+template <bool bigEndian>
+SCXT_AVX2_TARGET size_t int16(const uint8_t *src, size_t frames, int channels,
+                                  int16_t *const *dest)
+{
+    size_t i{0};
+    if (channels == 1)
+    {
+        if constexpr (!bigEndian)
+        {
+            memcpy(dest[0], src, frames * sizeof(int16_t));
+            return frames;
+        }
+        for (; i + 16 <= frames; i += 16)
+            _mm256_storeu_si256((__m256i *)(dest[0] + i), swap16(load(src + i * 2)));
+    }
+    else
+    {
+        for (; i + 16 <= frames; i += 16)
+        {
+            auto a = load(src + i * 4);
+            auto b = load(src + i * 4 + 32);
+            if constexpr (bigEndian)
+            {
+                a = swap16(a);
+                b = swap16(b);
+            }
+            auto la = _mm256_srai_epi32(_mm256_slli_epi32(a, 16), 16);
+            auto lb = _mm256_srai_epi32(_mm256_slli_epi32(b, 16), 16);
+            auto ra = _mm256_srai_epi32(a, 16);
+            auto rb = _mm256_srai_epi32(b, 16);
+            auto l = _mm256_packs_epi32(la, lb);
+            auto r = _mm256_packs_epi32(ra, rb);
+            l = _mm256_permute4x64_epi64(l, _MM_SHUFFLE(3, 1, 2, 0));
+            r = _mm256_permute4x64_epi64(r, _MM_SHUFFLE(3, 1, 2, 0));
+            _mm256_storeu_si256((__m256i *)(dest[0] + i), l);
+            _mm256_storeu_si256((__m256i *)(dest[1] + i), r);
+        }
+    }
+    return i;
+}
+
+// Eight packed 24 bit samples from the 28 bytes at p, as sign extended int32
+template <bool bigEndian> SCXT_AVX2_TARGET inline __m256i gather24(const uint8_t *p)
+{
+    const auto lo = _mm_loadu_si128((const __m128i *)p);
+    const auto hi = _mm_loadu_si128((const __m128i *)(p + 12));
+    auto v = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+    // Move each 3 byte sample into the top of a 32 bit lane, then shift it back down
+    __m256i mask;
+    if constexpr (bigEndian)
+        mask = _mm256_setr_epi8(-1, 2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1, 2, 1,
+                                0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9);
+    else
+        mask = _mm256_setr_epi8(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1, 0, 1,
+                                2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+    return _mm256_srai_epi32(_mm256_shuffle_epi8(v, mask), 8);
+}
+
+template <bool bigEndian>
+SCXT_AVX2_TARGET size_t int24(const uint8_t *src, size_t frames, int channels,
+                                  float *const *dest)
+{
+    const auto scale = _mm256_set1_ps(i24Scale);
+    const size_t total = frames * channels * 3;
+    size_t i{0};
+    if (channels == 1)
+    {
+        for (; (i + 8) * 3 + 4 <= total; i += 8)
+        {
+            auto s = gather24<bigEndian>(src + i * 3);
+            _mm256_storeu_ps(dest[0] + i, _mm256_mul_ps(_mm256_cvtepi32_ps(s), scale));
+        }
+    }
+    else
+    {
+        for (; (i + 8) * 6 + 4 <= total; i += 8)
+        {
+            auto fa = _mm256_mul_ps(_mm256_cvtepi32_ps(gather24<bigEndian>(src + i * 6)), scale);
+            auto fb =
+                _mm256_mul_ps(_mm256_cvtepi32_ps(gather24<bigEndian>(src + i * 6 + 24)), scale);
+            auto l = _mm256_shuffle_ps(fa, fb, _MM_SHUFFLE(2, 0, 2, 0));
+            auto r = _mm256_shuffle_ps(fa, fb, _MM_SHUFFLE(3, 1, 3, 1));
+            _mm256_storeu_ps(dest[0] + i, fixLanes(l));
+            _mm256_storeu_ps(dest[1] + i, fixLanes(r));
+        }
+    }
+    return i;
+}
+
+template <bool bigEndian, bool isFloat>
+SCXT_AVX2_TARGET inline __m256 load32(const uint8_t *p, __m256 scale)
+{
+    if constexpr (isFloat)
+    {
+        return _mm256_loadu_ps((const float *)p);
+    }
+    else
+    {
+        auto v = load(p);
+        if constexpr (bigEndian)
+            v = swap32(v);
+        return _mm256_mul_ps(_mm256_cvtepi32_ps(v), scale);
+    }
+}
+
+template <bool bigEndian, bool isFloat>
+SCXT_AVX2_TARGET size_t int32(const uint8_t *src, size_t frames, int channels,
+                                  float *const *dest)
+{
+    const auto scale = _mm256_set1_ps(i32Scale);
+    size_t i{0};
+    if (channels == 1)
+    {
+        if constexpr (isFloat)
+        {
+            memcpy(dest[0], src, frames * sizeof(float));
+            return frames;
+        }
+        for (; i + 8 <= frames; i += 8)
+            _mm256_storeu_ps(dest[0] + i, load32<bigEndian, isFloat>(src + i * 4, scale));
+    }
+    else
+    {
+        for (; i + 8 <= frames; i += 8)
+        {
+            auto fa = load32<bigEndian, isFloat>(src + i * 8, scale);
+            auto fb = load32<bigEndian, isFloat>(src + i * 8 + 32, scale);
+            auto l = _mm256_shuffle_ps(fa, fb, _MM_SHUFFLE(2, 0, 2, 0));
+            auto r = _mm256_shuffle_ps(fa, fb, _MM_SHUFFLE(3, 1, 3, 1));
+            _mm256_storeu_ps(dest[0] + i, fixLanes(l));
+            _mm256_storeu_ps(dest[1] + i, fixLanes(r));
+        }
+    }
+    return i;
+}
+
+SCXT_AVX2_TARGET inline size_t float64(const uint8_t *src, size_t frames, int channels,
+                                           float *const *dest)
+{
+    size_t i{0};
+    if (channels == 1)
+    {
+        for (; i + 8 <= frames; i += 8)
+        {
+            auto lo = _mm256_cvtpd_ps(_mm256_loadu_pd((const double *)(src + i * 8)));
+            auto hi = _mm256_cvtpd_ps(_mm256_loadu_pd((const double *)(src + i * 8 + 32)));
+            _mm_storeu_ps(dest[0] + i, lo);
+            _mm_storeu_ps(dest[0] + i + 4, hi);
+        }
+    }
+    else
+    {
+        for (; i + 4 <= frames; i += 4)
+        {
+            auto fa = _mm256_cvtpd_ps(_mm256_loadu_pd((const double *)(src + i * 16)));
+            auto fb = _mm256_cvtpd_ps(_mm256_loadu_pd((const double *)(src + i * 16 + 32)));
+            _mm_storeu_ps(dest[0] + i, _mm_shuffle_ps(fa, fb, _MM_SHUFFLE(2, 0, 2, 0)));
+            _mm_storeu_ps(dest[1] + i, _mm_shuffle_ps(fa, fb, _MM_SHUFFLE(3, 1, 3, 1)));
+        }
+    }
+    return i;
+}
+
+template <Format F>
+SCXT_AVX2_TARGET size_t kernel(const uint8_t *src, size_t frames, int channels,
+                                   out_t<F> *const *dest)
+{
+    if constexpr (F == Format::UI8 || F == Format::I8)
+        return int8<F == Format::UI8>(src, frames, channels, dest);
+    else if constexpr (F == Format::I16LE || F == Format::I16BE)
+        return int16<F == Format::I16BE>(src, frames, channels, dest);
+    else if constexpr (F == Format::I24LE || F == Format::I24BE)
+        return int24<F == Format::I24BE>(src, frames, channels, dest);
+    else if constexpr (F == Format::I32LE || F == Format::I32BE)
+        return int32<F == Format::I32BE, false>(src, frames, channels, dest);
+    else if constexpr (F == Format::F32LE)
+        return int32<false, true>(src, frames, channels, dest);
+    else
+        return float64(src, frames, channels, dest);
+}
+SCXT_AVX2_TARGET size_t floatToHalf(const float *src, uint16_t *dest, size_t n)
+{
+    size_t i{0};
+    for (; i + 8 <= n; i += 8)
+    {
+        auto h = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128((__m128i *)(dest + i), h);
+    }
+    return i;
+}
+} // namespace avx2
+#endif
+
+template <Format F>
+void convertFormat(const uint8_t *src, size_t frames, int channels, void *const *dest, Isa isa)
+{
+    out_t<F> *d[2]{(out_t<F> *)dest[0], channels == 2 ? (out_t<F> *)dest[1] : nullptr};
+
+    size_t done{0};
+#if SCXT_PCM_SIMD && SCXT_ISA_X86
+    if (isa == Isa::AVX2)
+        done = avx2::kernel<F>(src, frames, channels, d);
+#endif
+#if SCXT_PCM_SIMD
+    if (isa == Isa::SSE2)
+        done = sse2::kernel<F>(src, frames, channels, d);
+#endif
+    convertScalar<F>(src, done, frames, channels, d);
+}
+} // namespace
+
+size_t bytesPerSample(Format f)
+{
+    switch (f)
+    {
+    case Format::UI8:
+    case Format::I8:
+        return 1;
+    case Format::I16LE:
+    case Format::I16BE:
+        return 2;
+    case Format::I24LE:
+    case Format::I24BE:
+        return 3;
+    case Format::I32LE:
+    case Format::I32BE:
+    case Format::F32LE:
+        return 4;
+    case Format::F64LE:
+        return 8;
+    }
+    return 0;
+}
+
+bool convertsToFloat(Format f) { return bytesPerSample(f) > 2; }
+
+void convert(Format f, const void *src, size_t frames, int channels, void *const *dest, Isa isa)
+{
+    assert(channels == 1 || channels == 2);
+    assert(isIsaAvailable(isa));
+    if (frames == 0)
+        return;
+    auto s = (const uint8_t *)src;
+    switch (f)
+    {
+    case Format::UI8:
+        convertFormat<Format::UI8>(s, frames, channels, dest, isa);
+        break;
+    case Format::I8:
+        convertFormat<Format::I8>(s, frames, channels, dest, isa);
+        break;
+    case Format::I16LE:
+        convertFormat<Format::I16LE>(s, frames, channels, dest, isa);
+        break;
+    case Format::I16BE:
+        convertFormat<Format::I16BE>(s, frames, channels, dest, isa);
+        break;
+    case Format::I24LE:
+        convertFormat<Format::I24LE>(s, frames, channels, dest, isa);
+        break;
+    case Format::I24BE:
+        convertFormat<Format::I24BE>(s, frames, channels, dest, isa);
+        break;
+    case Format::I32LE:
+        convertFormat<Format::I32LE>(s, frames, channels, dest, isa);
+        break;
+    case Format::I32BE:
+        convertFormat<Format::I32BE>(s, frames, channels, dest, isa);
+        break;
+    case Format::F32LE:
+        convertFormat<Format::F32LE>(s, frames, channels, dest, isa);
+        break;
+    case Format::F64LE:
+        convertFormat<Format::F64LE>(s, frames, channels, dest, isa);
+        break;
+    }
+}
+
+void floatToHalf(const float *src, uint16_t *dest, size_t n, Isa isa)
+{
+    assert(isIsaAvailable(isa));
+    size_t i{0};
+#if SCXT_PCM_SIMD && SCXT_ISA_X86
+    if (isa == Isa::AVX2)
+        i = avx2::floatToHalf(src, dest, n);
+#endif
+    for (; i < n; ++i)
+        dest[i] = infrastructure::floatToHalf(src[i]);
+}
+} // namespace scxt::sample::pcm
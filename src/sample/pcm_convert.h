@@ -0,0 +1,91 @@
+/*
+ * Shortcircuit XT - a Surge Synth Team product
+ *
+ * A fully featured creative sampler, available as a standalone
+ * and plugin for multiple platforms.
+ *
+ * Copyright 2019 - 2023, Various authors, as described in the github
+ * transaction log.
+ *
+ * ShortcircuitXT is released under the Gnu General Public Licence
+ * V3 or later (GPL-3.0-or-later). The license is found in the file
+ * "LICENSE" in the root of this repository or at
+ * https://www.gnu.org/licenses/gpl-3.0.en.html
+ *
+ * Individual sections of code which comprises ShortcircuitXT in this
+ * repository may also be used under an MIT license. Please see the
+ * section  "Licensing" in "README.md" for details.
+ *
+ * ShortcircuitXT is inspired by, and shares code with, the
+ * commercial product Shortcircuit 1 and 2, released by VemberTech
+ * in the mid 2000s. The code for Shortcircuit 2 was opensourced in
+ * 2020 at the outset of this project.
+ *
+ * All source for ShortcircuitXT is available at
+ * https://github.com/surge-synthesizer/shortcircuit-xt
+ */
+
+
+#ifndef SCXT_SRC_SAMPLE_PCM_CONVERT_H
+#define SCXT_SRC_SAMPLE_PCM_CONVERT_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "infrastructure/cpu_isa.h"
+
+/*
+ * Deinterleave-and-convert kernels for the PCM layouts our file loaders
+ * understand. Each call converts a block of interleaved frames into one
+ * destination buffer per channel: 8 and 16 bit sources land in int16_t,
+ * everything else in float, with exactly the scaling of the scalar
+ * Sample::load_data_xxx helpers.
+ *
+ * The scalar path is the reference. The SSE2 and AVX2 paths must produce
+ * bit identical output (tests/pcm_convert.cpp checks this), so if you add
+ * a format add it to all three.
+ */
+namespace scxt::sample::pcm
+{
+enum class Format : uint8_t
+{
+    UI8,
+    I8,
+    I16LE,
+    I16BE,
+    I24LE,
+    I24BE,
+    I32LE,
+    I32BE,
+    F32LE,
+    F64LE
+};
+
+using infrastructure::Isa;
+
+size_t bytesPerSample(Format f);
+// True if the format converts to float, false if it converts to int16_t
+bool convertsToFloat(Format f);
+
+using infrastructure::bestAvailableIsa;
+using infrastructure::isIsaAvailable;
+
+/*
+ * Convert 'frames' frames of 'channels' (1 or 2) interleaved channels from
+ * src into dest[0..channels). dest[c] is an int16_t* or float* according
+ * to convertsToFloat(f). src needs no alignment and is never read past
+ * frames * channels * bytesPerSample(f) bytes.
+ */
+void convert(Format f, const void *src, size_t frames, int channels, void *const *dest,
+             Isa isa = infrastructure::activeIsa());
+
+/*
+ * Convert n floats to IEEE halves, rounding to nearest even, for BD_F16 storage.
+ * The AVX2 path uses F16C (which every AVX2 part has); below that we use the
+ * portable scalar conversion, and all paths give the same bits.
+ */
+void floatToHalf(const float *src, uint16_t *dest, size_t n,
+                 Isa isa = infrastructure::activeIsa());
+} // namespace scxt::sample::pcm
+
+#endif // SHORTCIRCUITXT_PCM_CONVERT_H
@@ -26,10 +26,20 @@
  */
 
 #include "sample.h"
+#include "sf2_mapped_data.h"
+#include "monolith.h"
+#include "sample_rate_convert.h"
+#include "infrastructure/content_hash.h"
+#include "infrastructure/half_float.h"
 #include "infrastructure/file_map_view.h"
 #include "dsp/resampling.h"
 #include "sst/basic-blocks/mechanics/endian-ops.h"
 #include <sstream>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <vector>
 
 namespace scxt::sample
 {
@@ -59,6 +69,7 @@ bool Sample::load(const fs::path &path)
         mFileName = path;
         displayName = fmt::format("{}", path.filename().u8string());
         type = WAV_FILE;
+        computeContentHash();
         return true;
     }
     else if (extensionMatches(path, ".flac"))
@@ -69,6 +80,7 @@ bool Sample::load(const fs::path &path)
             type = FLAC_FILE;
             mFileName = path;
             displayName = fmt::format("{}", path.filename().u8string());
+            computeContentHash();
             return true;
         }
     }
@@ -86,6 +98,7 @@ bool Sample::load(const fs::path &path)
         sample_loaded = true;
         mFileName = path;
         displayName = fmt::format("{}", path.filename().u8string());
+        computeContentHash();
         return true;
     }
 
@@ -114,10 +127,14 @@ bool Sample::loadFromSF2(const fs::path &p, sf2::File *f, int inst, int reg)
     if (frameSize == 2 && channels == 1 && sfsample->SampleType == sf2::Sample::MONO_SAMPLE)
     {
         bitDepth = BD_I16;
+        if (referenceMappedSF2Data(p, f, sfsample))
+            return true;
+
         auto buf = sfsample->LoadSampleData();
         // >> 1 here because void* -> int16_t is byte to two bytes
         load_data_i16(0, buf.pStart, buf.Size >> 1, sfsample->GetFrameSize());
         sfsample->ReleaseSampleData();
+        computeContentHash();
         return true;
     }
     else if (frameSize == 4 && sfsample->GetChannelCount() == 2 &&
@@ -138,6 +155,7 @@ bool Sample::loadFromSF2(const fs::path &p, sf2::File *f, int inst, int reg)
             load_data_i16(0, (int16_t *)(buf.pStart) + 1, buf.Size >> 2, sfsample->GetFrameSize());
         }
         sfsample->ReleaseSampleData();
+        computeContentHash();
         return true;
     }
     else if (sfsample->GetFrameSize() == 3 && sfsample->GetChannelCount() == 1)
@@ -146,6 +164,7 @@ bool Sample::loadFromSF2(const fs::path &p, sf2::File *f, int inst, int reg)
         channels = 1;
         auto buf = sfsample->LoadSampleData();
         load_data_i24(0, (void *)(buf.pStart), buf.Size, sfsample->GetFrameSize());
+        computeContentHash();
         return true;
     }
 
@@ -156,6 +175,319 @@ bool Sample::loadFromSF2(const fs::path &p, sf2::File *f, int inst, int reg)
     return false;
 }
 
+bool Sample::loadFromGIG(const fs::path &p, gig::File *f, int idx)
+{
+    auto gs = idx >= 0 ? f->GetSample(idx) : nullptr;
+    if (!gs)
+        return false;
+    if (gs->Channels < 1 || gs->Channels > 2 || (gs->BitDepth != 16 && gs->BitDepth != 24))
+    {
+        std::ostringstream oss;
+        oss << "Unable to load sample from GIG. " << SCD(gs->Channels) << SCD(gs->BitDepth);
+        throw SCXTError(oss.str());
+    }
+
+    mFileName = p;
+    instrument = -1;
+    region = idx;
+    type = GIG_FILE;
+    auto nm = gs->pInfo ? gs->pInfo->Name : std::string();
+    displayName = fmt::format("{} ({} @ {})", nm.empty() ? "Sample" : nm,
+                              p.filename().u8string(), idx);
+
+    // libgig reads interleaved little endian frames, with 24 bit packed in three bytes
+    auto format = gs->BitDepth == 24 ? pcm::Format::I24LE : pcm::Format::I16LE;
+    auto frames = (size_t)gs->SamplesTotal;
+    if (!SetMeta(gs->Channels, gs->SamplesPerSecond, frames))
+        return false;
+
+    void *dest[2]{nullptr, nullptr};
+    size_t destBytes{0};
+    for (int c = 0; c < channels; ++c)
+    {
+        if (pcm::convertsToFloat(format))
+        {
+            if (!allocateF32(c, frames))
+                return false;
+            dest[c] = GetSamplePtrF32(c);
+            destBytes = sizeof(float);
+        }
+        else
+        {
+            if (!allocateI16(c, frames))
+                return false;
+            dest[c] = GetSamplePtrI16(c);
+            destBytes = sizeof(int16_t);
+        }
+    }
+
+    // Compressed samples decode through a buffer of our own since libgig's is shared
+    static constexpr size_t chunkFrames{65536};
+    struct Decompression
+    {
+        gig::buffer_t buffer{};
+        bool used{false};
+        ~Decompression()
+        {
+            if (used)
+                gig::Sample::DestroyDecompressionBuffer(buffer);
+        }
+    } decompression;
+    if (gs->Compressed)
+    {
+        decompression.buffer = gig::Sample::CreateDecompressionBuffer(chunkFrames);
+        decompression.used = true;
+    }
+
+    std::vector<uint8_t> chunk(chunkFrames * gs->FrameSize);
+    gs->SetPos(0);
+    size_t done{0};
+    while (done < frames)
+    {
+        auto want = std::min(chunkFrames, frames - done);
+        auto got = (size_t)gs->Read(chunk.data(), want,
+                                    decompression.used ? &decompression.buffer : nullptr);
+        if (got == 0)
+            break;
+        void *to[2]{nullptr, nullptr};
+        for (int c = 0; c < channels; ++c)
+            to[c] = (uint8_t *)dest[c] + done * destBytes;
+        pcm::convert(format, chunk.data(), got, channels, to);
+        done += got;
+    }
+    if (done != frames)
+    {
+        SCLOG("GIG sample " << idx << " in " << p.u8string() << " ended after " << done << " of "
+                            << frames << " frames");
+        return false;
+    }
+
+    if (gs->Loops)
+    {
+        meta.loop_present = true;
+        meta.loop_start = gs->LoopStart;
+        meta.loop_end = gs->LoopEnd;
+    }
+    sample_loaded = true;
+    computeContentHash();
+    return true;
+}
+
+bool Sample::referenceMappedSF2Data(const fs::path &p, sf2::File *f, sf2::Sample *sfsample)
+{
+    auto m = SF2MappedData::forFile(p);
+    if (!m)
+        return false;
+
+    int idx{-1};
+    for (int i = 0; i < f->GetSampleCount(); ++i)
+    {
+        if (f->GetSample(i) == sfsample)
+        {
+            idx = i;
+            break;
+        }
+    }
+    if (idx < 0 || idx >= (int)m->getSampleHeaders().size())
+        return false;
+
+    // If we don't agree with libgig about where this sample is, copy it the usual way
+    const auto &h = m->getSampleHeaders()[idx];
+    if (h.end - h.start != sample_length)
+        return false;
+    auto d = m->paddedSampleData(idx);
+    if (!d)
+        return false;
+
+    freeData();
+    mappedDataSource = m;
+    sampleData[0] = const_cast<int16_t *>(d);
+    // Don't page in the whole sample just to hash it; the page cache is our dedupe here
+    contentHash = 0;
+    return true;
+}
+
+bool Sample::loadFromMonolith(const fs::path &p, int idx)
+{
+    auto m = MonolithBundle::forFile(p);
+    if (!m || idx < 0)
+        return false;
+
+    auto d = m->describeSample(idx, *this);
+    if (!d[0])
+        return false;
+
+    freeData();
+    mappedDataSource = m;
+    sampleData[0] = const_cast<void *>(d[0]);
+    sampleData[1] = const_cast<void *>(d[1]);
+    std::atomic_store(&waveformSummary, m->getWaveformSummary(idx));
+
+    mFileName = p;
+    type = MONOLITH_FILE;
+    instrument = -1;
+    region = idx;
+    return true;
+}
+
+Sample::~Sample() { freeData(); }
+
+void Sample::freeData()
+{
+    if (sharedDataSource || mappedDataSource)
+    {
+        sampleData[0] = nullptr;
+        sampleData[1] = nullptr;
+        // a shared sample's mipmaps are its source's
+        for (auto &m : mipmaps)
+            m = {};
+        mipmapLevels = 0;
+        sharedDataSource.reset();
+        mappedDataSource.reset();
+        return;
+    }
+    for (auto &d : sampleData)
+    {
+        if (d)
+            free(d);
+        d = nullptr;
+    }
+    freeMipmaps();
+}
+
+void Sample::freeMipmaps()
+{
+    if (sharedDataSource)
+        return;
+    for (auto &m : mipmaps)
+    {
+        for (auto &d : m.sampleData)
+        {
+            if (d)
+                free(d);
+            d = nullptr;
+        }
+        m.sample_length = 0;
+    }
+    mipmapLevels = 0;
+}
+
+void Sample::computeContentHash()
+{
+    infrastructure::ContentHasher h;
+    h.updateValue((int32_t)bitDepth);
+    h.updateValue((int32_t)channels);
+    h.updateValue((uint32_t)sample_length);
+    auto chanBytes = (size_t)sample_length * bitDepthByteSize(bitDepth);
+    for (int c = 0; c < channels; ++c)
+    {
+        if (!sampleData[c])
+        {
+            contentHash = 0;
+            return;
+        }
+        h.update((const uint8_t *)sampleData[c] + scxt::dsp::FIRoffset * bitDepthByteSize(bitDepth),
+                 chanBytes);
+    }
+    contentHash = h.digest();
+}
+
+bool Sample::hasSameContentAs(const Sample &other) const
+{
+    if (contentHash != other.contentHash || bitDepth != other.bitDepth ||
+        channels != other.channels || sample_length != other.sample_length)
+        return false;
+
+    // The hash is a filter; we still check the data so a collision can't swap audio
+    auto chanBytes = (size_t)sample_length * bitDepthByteSize(bitDepth);
+    auto off = scxt::dsp::FIRoffset * bitDepthByteSize(bitDepth);
+    for (int c = 0; c < channels; ++c)
+    {
+        if (!sampleData[c] || !other.sampleData[c])
+            return false;
+        if (memcmp((const uint8_t *)sampleData[c] + off, (const uint8_t *)other.sampleData[c] + off,
+                   chanBytes) != 0)
+            return false;
+    }
+    return true;
+}
+
+void Sample::shareDataFrom(const std::shared_ptr<Sample> &other)
+{
+    assert(other && other.get() != this);
+    freeData();
+    sharedDataSource = other;
+    sampleData[0] = other->sampleData[0];
+    sampleData[1] = other->sampleData[1];
+    for (int i = 0; i < maxMipmapLevels; ++i)
+        mipmaps[i] = other->mipmaps[i];
+    mipmapLevels = other->mipmapLevels;
+    std::atomic_store(&waveformSummary, std::atomic_load(&other->waveformSummary));
+}
+
+std::atomic<uint64_t> Sample::useClock{0};
+
+std::shared_ptr<Sample> Sample::makeResidencyHead(uint32_t frames) const
+{
+    assert(!isResidencyHead());
+    auto res = std::make_shared<Sample>(id);
+    res->type = type;
+    res->displayName = displayName;
+    res->mFileName = mFileName;
+    res->instrument = instrument;
+    res->region = region;
+    res->meta = meta;
+    // slices are owned by the complete sample
+    res->meta.n_slices = 0;
+    res->meta.slice_start = nullptr;
+    res->meta.slice_end = nullptr;
+    memcpy(res->name, name, sizeof(name));
+    res->bitDepth = bitDepth;
+    res->channels = channels;
+    res->sample_rate = sample_rate;
+    res->InvSampleRate = InvSampleRate;
+    res->sourceSampleRate = sourceSampleRate;
+    res->sourceSampleLength = sourceSampleLength;
+    res->sample_loaded = sample_loaded;
+    res->sample_length = std::min(frames, sample_length);
+    res->fullSampleLength = std::max(sample_length, 1U);
+    res->lastUsed.store(getLastUsed());
+
+    // Copy the zero lead and the head frames then give it a fresh zero tail
+    auto bytes = bitDepthByteSize(bitDepth);
+    auto copyBytes = ((size_t)res->sample_length + scxt::dsp::FIRoffset) * bytes;
+    for (int c = 0; c < channels; ++c)
+    {
+        res->sampleData[c] = malloc(((size_t)res->sample_length + scxt::dsp::FIRipol_N) * bytes);
+        if (!res->sampleData[c])
+            return nullptr;
+        memcpy(res->sampleData[c], sampleData[c], copyBytes);
+        memset((char *)res->sampleData[c] + copyBytes, 0, scxt::dsp::FIRoffset * bytes);
+    }
+
+    // The editor still draws the whole sample
+    std::atomic_store(&res->waveformSummary, std::atomic_load(&waveformSummary));
+    return res;
+}
+
+std::shared_ptr<const WaveformSummary> Sample::getWaveformSummary()
+{
+    auto res = std::atomic_load(&waveformSummary);
+    if (!res)
+    {
+        // two threads racing here both build, which is harmless
+        buildWaveformSummary();
+        res = std::atomic_load(&waveformSummary);
+    }
+    return res;
+}
+
+void Sample::buildWaveformSummary()
+{
+    std::shared_ptr<const WaveformSummary> s = WaveformSummary::build(*this);
+    std::atomic_store(&waveformSummary, s);
+}
+
 // TODO: Rename these
 short *Sample::GetSamplePtrI16(int Channel)
 {
@@ -169,6 +501,12 @@ float *Sample::GetSamplePtrF32(int Channel)
         return 0;
     return &((float *)sampleData[Channel])[scxt::dsp::FIRoffset];
 }
+uint16_t *Sample::GetSamplePtrF16(int Channel)
+{
+    if (bitDepth != BD_F16)
+        return 0;
+    return &((uint16_t *)sampleData[Channel])[scxt::dsp::FIRoffset];
+}
 
 // TODO: What the heck is this doing?
 bool Sample::allocateI16(int Channel, int Samples)
@@ -208,6 +546,207 @@ bool Sample::allocateF32(int Channel, int Samples)
     return true;
 }
 
+bool Sample::allocateF16(int Channel, int Samples)
+{
+    int samplesizewithmargin = Samples + scxt::dsp::FIRipol_N;
+    if (sampleData[Channel])
+        free(sampleData[Channel]);
+    sampleData[Channel] = malloc(sizeof(uint16_t) * samplesizewithmargin);
+    if (!sampleData[Channel])
+        return false;
+    bitDepth = BD_F16;
+
+    // clear pre/post zero area. +0.0 is all zero bits in a half too
+    memset(sampleData[Channel], 0, scxt::dsp::FIRoffset * sizeof(uint16_t));
+    memset((char *)sampleData[Channel] + (Samples + scxt::dsp::FIRoffset) * sizeof(uint16_t), 0,
+           scxt::dsp::FIRoffset * sizeof(uint16_t));
+
+    return true;
+}
+
+bool Sample::convertToF16()
+{
+    if (bitDepth != BD_F32 || isDataShared() || isDataMapped())
+        return false;
+
+    // Convert the whole padded buffer, so the zero lead and tail come along for free
+    size_t withMargin = (size_t)sample_length + scxt::dsp::FIRipol_N;
+    void *converted[2]{nullptr, nullptr};
+    for (int c = 0; c < channels; ++c)
+    {
+        converted[c] = malloc(sizeof(uint16_t) * withMargin);
+        if (!converted[c])
+        {
+            free(converted[0]);
+            return false;
+        }
+        pcm::floatToHalf((const float *)sampleData[c], (uint16_t *)converted[c], withMargin);
+    }
+    for (int c = 0; c < channels; ++c)
+    {
+        free(sampleData[c]);
+        sampleData[c] = converted[c];
+    }
+    // Mipmaps are kept in our bit depth, so any we had are now the wrong format
+    freeMipmaps();
+    bitDepth = BD_F16;
+    computeContentHash();
+    return true;
+}
+
+bool Sample::convertSampleRate(uint32_t toRate)
+{
+    if (toRate == 0 || toRate == sample_rate || sample_length == 0 || isResidencyHead())
+        return false;
+    if (bitDepth != BD_I16 && bitDepth != BD_F32)
+        return false;
+
+    auto outFrames = rate::outputLength(sample_length, sample_rate, toRate);
+    if (outFrames == 0 || outFrames > std::numeric_limits<uint32_t>::max())
+        return false;
+
+    std::vector<float> in, out[2];
+    for (int c = 0; c < channels; ++c)
+    {
+        const float *src = GetSamplePtrF32(c);
+        if (bitDepth == BD_I16)
+        {
+            auto i16 = GetSamplePtrI16(c);
+            in.resize(sample_length);
+            for (size_t i = 0; i < sample_length; ++i)
+                in[i] = i16[i] * (1.f / 32768.f);
+            src = in.data();
+        }
+        out[c].resize(outFrames);
+        rate::resample(src, sample_length, sample_rate, out[c].data(), outFrames, toRate);
+    }
+
+    // Build the new padded buffers, in the bit depth we already have, before letting go
+    auto bytes = bitDepthByteSize(bitDepth);
+    void *converted[2]{nullptr, nullptr};
+    for (int c = 0; c < channels; ++c)
+    {
+        converted[c] = calloc(outFrames + scxt::dsp::FIRipol_N, bytes);
+        if (!converted[c])
+        {
+            free(converted[0]);
+            return false;
+        }
+        if (bitDepth == BD_I16)
+        {
+            auto d = (short *)converted[c] + scxt::dsp::FIRoffset;
+            for (size_t i = 0; i < outFrames; ++i)
+                d[i] = (short)std::clamp(std::lrint(out[c][i] * 32768.f), -32768L, 32767L);
+        }
+        else
+        {
+            memcpy((float *)converted[c] + scxt::dsp::FIRoffset, out[c].data(),
+                   outFrames * sizeof(float));
+        }
+    }
+
+    // This also drops any data we shared or mapped; from here on the data is our own
+    freeData();
+    for (int c = 0; c < channels; ++c)
+        sampleData[c] = converted[c];
+
+    if (!isRateConverted())
+    {
+        sourceSampleRate = sample_rate;
+        sourceSampleLength = sample_length;
+    }
+    sample_rate = toRate;
+    InvSampleRate = 1.f / (float)toRate;
+    sample_length = (uint32_t)outFrames;
+    computeContentHash();
+    std::atomic_store(&waveformSummary, std::shared_ptr<const WaveformSummary>());
+    return true;
+}
+
+bool Sample::buildMipmaps()
+{
+    if (isResidencyHead() || isDataShared() || isDataMapped() || !sampleData[0])
+        return false;
+    freeMipmaps();
+
+    // Each level is decimated from the float copy of the one above, so the rounding
+    // to our bit depth happens once per level rather than accumulating
+    std::vector<float> above[2], below[2];
+    auto bytes = bitDepthByteSize(bitDepth);
+    for (int c = 0; c < channels; ++c)
+    {
+        above[c].resize(sample_length);
+        auto d = above[c].data();
+        switch (bitDepth)
+        {
+        case BD_I16:
+        {
+            auto i16 = GetSamplePtrI16(c);
+            for (size_t i = 0; i < sample_length; ++i)
+                d[i] = i16[i] * (1.f / 32768.f);
+        }
+        break;
+        case BD_F16:
+        {
+            auto f16 = GetSamplePtrF16(c);
+            for (size_t i = 0; i < sample_length; ++i)
+                d[i] = infrastructure::halfToFloat(f16[i]);
+        }
+        break;
+        case BD_F32:
+            memcpy(d, GetSamplePtrF32(c), sample_length * sizeof(float));
+            break;
+        }
+    }
+
+    // Stop once a level would be too short to be worth playing from
+    static constexpr size_t shortestLevel{64};
+    size_t aboveLength = sample_length;
+    while (mipmapLevels < maxMipmapLevels && aboveLength / 2 >= shortestLevel)
+    {
+        auto length = rate::outputLength(aboveLength, 2, 1);
+        auto &level = mipmaps[mipmapLevels];
+        for (int c = 0; c < channels; ++c)
+        {
+            below[c].resize(length);
+            rate::resample(above[c].data(), aboveLength, 2, below[c].data(), length, 1);
+
+            level.sampleData[c] = calloc(length + scxt::dsp::FIRipol_N, bytes);
+            if (!level.sampleData[c])
+            {
+                // keep the levels we managed; the voice simply won't go this high
+                free(level.sampleData[0]);
+                level.sampleData[0] = nullptr;
+                return mipmapLevels > 0;
+            }
+            const auto *src = below[c].data();
+            switch (bitDepth)
+            {
+            case BD_I16:
+            {
+                auto d = (short *)level.sampleData[c] + scxt::dsp::FIRoffset;
+                for (size_t i = 0; i < length; ++i)
+                    d[i] = (short)std::clamp(std::lrint(src[i] * 32768.f), -32768L, 32767L);
+            }
+            break;
+            case BD_F16:
+                pcm::floatToHalf(src, (uint16_t *)level.sampleData[c] + scxt::dsp::FIRoffset,
+                                 length);
+                break;
+            case BD_F32:
+                memcpy((float *)level.sampleData[c] + scxt::dsp::FIRoffset, src,
+                       length * sizeof(float));
+                break;
+            }
+            std::swap(above[c], below[c]);
+        }
+        level.sample_length = (uint32_t)length;
+        aboveLength = length;
+        mipmapLevels++;
+    }
+    return mipmapLevels > 0;
+}
+
 bool Sample::load_data_ui8(int channel, void *data, unsigned int samplesize, unsigned int stride)
 {
     allocateI16(channel, samplesize);
@@ -337,6 +876,32 @@ bool Sample::load_data_f64(int channel, void *data, unsigned int samplesize, uns
     return true;
 }
 
+bool Sample::load_data_interleaved(pcm::Format format, const void *data, unsigned int frames,
+                                   int nChannels)
+{
+    if (nChannels < 1 || nChannels > 2)
+        return false;
+
+    void *dest[2]{nullptr, nullptr};
+    for (int c = 0; c < nChannels; ++c)
+    {
+        if (pcm::convertsToFloat(format))
+        {
+            if (!allocateF32(c, frames))
+                return false;
+            dest[c] = GetSamplePtrF32(c);
+        }
+        else
+        {
+            if (!allocateI16(c, frames))
+                return false;
+            dest[c] = GetSamplePtrI16(c);
+        }
+    }
+    pcm::convert(format, data, frames, nChannels, dest);
+    return true;
+}
+
 bool Sample::SetMeta(unsigned int Channels, unsigned int SampleRate, unsigned int SampleLength)
 {
     if (Channels > 2)
@@ -368,6 +933,12 @@ void Sample::dumpInformationToLog()
         SCLOG("SF2 File : " << getPath().u8string() << " Instrument=" << getCompoundInstrument()
                             << " Region=" << getCompoundRegion());
         break;
+    case MONOLITH_FILE:
+        SCLOG("Monolith File : " << getPath().u8string() << " Record=" << getCompoundRegion());
+        break;
+    case GIG_FILE:
+        SCLOG("GIG File : " << getPath().u8string() << " Sample=" << getCompoundRegion());
+        break;
     }
 
     SCLOG("BitDepth=" << bitDepthByteSize(bitDepth) * 8 << " Channels=" << (int)channels);
@@ -396,6 +967,7 @@ void Sample::dumpInformationToLog()
     }
     break;
     case BD_F32:
+    case BD_F16:
     {
         SCLOG("TODO: Implement Sapmle Scan for F32");
     }
@@ -30,10 +30,16 @@
 #include "utils.h"
 #include "infrastructure/filesystem_import.h"
 #include "SF.h"
+#include "gig.h"
+#include "pcm_convert.h"
+#include "waveform_summary.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 
 namespace scxt::sample
 {
-
 struct alignas(16) Sample : MoveableOnly<Sample>
 {
     enum SourceType
@@ -42,11 +48,19 @@ struct alignas(16) Sample : MoveableOnly<Sample>
         SF2_FILE,
         FLAC_FILE,
         AIFF_FILE,
+        MONOLITH_FILE,
+        GIG_FILE,
     } type{WAV_FILE};
 
+    // Files with many samples, addressed by instrument and region, rather than one per file
+    static bool isMultiSampleFile(SourceType t)
+    {
+        return t == SF2_FILE || t == MONOLITH_FILE || t == GIG_FILE;
+    }
+
     Sample() : id(SampleID::next()) {}
     Sample(const SampleID &sid) : id(sid), displayName(sid.to_string()) {}
-    virtual ~Sample() = default;
+    virtual ~Sample();
 
     void dumpInformationToLog();
 
@@ -54,6 +68,14 @@ struct alignas(16) Sample : MoveableOnly<Sample>
     std::string getDisplayName() const { return displayName; }
     bool load(const fs::path &path);
     bool loadFromSF2(const fs::path &path, sf2::File *f, int inst, int region);
+    // Point at record idx of a monolith bundle (see MonolithBundle), which we then hold
+    bool loadFromMonolith(const fs::path &path, int idx);
+    /*
+     * Decode sample idx of the file's wave pool (libgig's GetSample order; our address
+     * is instrument -1, region idx). Only this sample's PCM is read, a chunk at a time,
+     * decompressing if need be, so an import never pulls the whole library into memory.
+     */
+    bool loadFromGIG(const fs::path &path, gig::File *f, int idx);
 
     const fs::path &getPath() const { return mFileName; }
 
@@ -74,21 +96,138 @@ struct alignas(16) Sample : MoveableOnly<Sample>
         return {type, getPath(), getCompoundInstrument(), getCompoundRegion()};
     }
 
-    size_t getDataSize() const { return sample_length * bitDepthByteSize(bitDepth) * channels; }
+    // Includes the octave mipmaps, if we have them
+    size_t getDataSize() const
+    {
+        size_t frames = sample_length;
+        for (int i = 0; i < mipmapLevels; ++i)
+            frames += mipmaps[i].sample_length;
+        return frames * bitDepthByteSize(bitDepth) * channels;
+    }
     size_t getSampleLength() const { return sample_length; }
 
+    /*
+     * Load time rate conversion. A sample converted to the engine rate keeps the rate
+     * and length of its file here (both are 0 if it hasn't been converted), and the
+     * positions in its meta and in the zones which play it stay in file frames so they
+     * survive a re-conversion. getPositionScale takes a file frame to a stored one.
+     * Only I16 and F32 data converts (keeping its depth), so convert before F16.
+     */
+    uint32_t sourceSampleRate{0}, sourceSampleLength{0};
+    bool convertSampleRate(uint32_t toRate);
+    bool isRateConverted() const { return sourceSampleRate > 0; }
+    size_t getSourceSampleLength() const
+    {
+        if (isRateConverted())
+            return sourceSampleLength;
+        return isResidencyHead() ? fullSampleLength : sample_length;
+    }
+    double getPositionScale() const
+    {
+        return isRateConverted() ? 1.0 * sample_rate / sourceSampleRate : 1.0;
+    }
+    // A zone position, counted in frames of the file, as a frame of our data
+    int32_t toStoredPosition(int32_t p) const
+    {
+        if (!isRateConverted() || p < 0)
+            return p;
+        return (int32_t)std::min((int64_t)std::llround(p * getPositionScale()),
+                                 (int64_t)sample_length);
+    }
+
+    /*
+     * Octave mipmaps. Level n (from 1) is the sample low passed and decimated to
+     * 1/2^n of its rate, stored in our bit depth with the same padding as sampleData,
+     * so frame j of level n lines up with frame j << n of the sample. Voices transposing
+     * up an octave or more read the level which brings their ratio back near unity
+     * rather than oversampling. Built once the data is final (after rate conversion
+     * and any F16 store) and never for residency heads or mapped data.
+     */
+    struct MipmapLevel
+    {
+        void *__restrict sampleData[2]{nullptr, nullptr};
+        uint32_t sample_length{0};
+    };
+    static constexpr int maxMipmapLevels{4};
+    MipmapLevel mipmaps[maxMipmapLevels]{};
+    int mipmapLevels{0};
+    bool buildMipmaps();
+    // Level 0 is the sample itself
+    int getMipmapLevelCount() const { return mipmapLevels + 1; }
+    MipmapLevel getMipmapLevel(int level) const
+    {
+        if (level <= 0 || level > mipmapLevels)
+            return {{sampleData[0], sampleData[1]}, sample_length};
+        return mipmaps[level - 1];
+    }
+    // A frame of our data as the nearest frame of a level
+    int32_t toMipmapPosition(int32_t p, int level) const
+    {
+        if (level == 0 || p < 0)
+            return p;
+        auto len = (int32_t)getMipmapLevel(level).sample_length;
+        return std::min((p + (1 << (level - 1))) >> level, len);
+    }
+
     bool parseFlac(const fs::path &p);
 
     void *__restrict sampleData[2]{nullptr, nullptr};
 
+    /*
+     * A hash of the decoded data and its layout (bit depth, channels, length),
+     * computed at load. The sample manager uses it to let samples with identical
+     * content share one buffer while keeping their own ids, addresses and metadata.
+     */
+    uint64_t contentHash{0};
+    void computeContentHash();
+    bool hasSameContentAs(const Sample &other) const;
+
+    /*
+     * Point this sample at another sample's data, releasing our own. We hold
+     * the other sample so the data lives as long as we do.
+     */
+    void shareDataFrom(const std::shared_ptr<Sample> &other);
+    bool isDataShared() const { return sharedDataSource != nullptr; }
+
+    // True if our data points into a memory mapped file (see SF2MappedData, MonolithBundle)
+    bool isDataMapped() const { return mappedDataSource != nullptr; }
+
+    /*
+     * The min/max/RMS pyramid the editor draws from. The loader builds it off
+     * thread; if it hasn't, the first call here does. Safe from any thread.
+     */
+    std::shared_ptr<const WaveformSummary> getWaveformSummary();
+    void buildWaveformSummary();
+
+    /*
+     * Residency. Under a memory budget the sample manager swaps a sample which hasn't
+     * been played in a while for a copy holding only its first frames, reloading the
+     * whole thing when it is next played. fullSampleLength is the length of the
+     * sample a head was made from, and 0 for a complete sample.
+     */
+    std::shared_ptr<Sample> makeResidencyHead(uint32_t frames) const;
+    bool isResidencyHead() const { return fullSampleLength > 0; }
+    uint32_t fullSampleLength{0};
+
+    // Eviction order. Stamped from the audio thread as voices start on this sample
+    void markUsed() { lastUsed.store(++useClock, std::memory_order_relaxed); }
+    uint64_t getLastUsed() const { return lastUsed.load(std::memory_order_relaxed); }
+    static uint64_t getUseClock() { return useClock.load(std::memory_order_relaxed); }
+
+    // Set on the audio thread by the retired sample sweep to the id of a sweep which
+    // found this sample in a voice or zone; read back once that sweep completes
+    mutable std::atomic<uint64_t> retiredSweepMark{0};
+
     // TODO: Review evertyhing from here down before moving it above this comment
     bool parse_riff_wave(void *data, size_t filesize, bool skip_riffchunk = false);
     bool parse_aiff(void *data, size_t filesize);
     short *GetSamplePtrI16(int Channel);
     float *GetSamplePtrF32(int Channel);
+    uint16_t *GetSamplePtrF16(int Channel);
     char *GetName();
 
   private:
+    bool referenceMappedSF2Data(const fs::path &path, sf2::File *f, sf2::Sample *s);
     bool parse_sf2_sample(void *data, size_t filesize, unsigned int sampleid);
     bool parse_dls_sample(void *data, size_t filesize, unsigned int sampleid);
 
@@ -105,7 +244,8 @@ struct alignas(16) Sample : MoveableOnly<Sample>
         // BD_I12,
         BD_I16,
         // BD_I24,
-        BD_F32
+        BD_F32,
+        BD_F16 // IEEE half; an optional compact store for what would otherwise be F32
     } bitDepth{BD_F32};
 
     static constexpr int bitDepthByteSize(BitDepth bd)
@@ -113,6 +253,7 @@ struct alignas(16) Sample : MoveableOnly<Sample>
         switch (bd)
         {
         case BD_I16:
+        case BD_F16:
             return 2;
         case BD_F32:
             return 4;
@@ -173,6 +314,15 @@ struct alignas(16) Sample : MoveableOnly<Sample>
     } meta;
 
   private:
+    std::shared_ptr<Sample> sharedDataSource{nullptr};
+    // The SF2MappedData or MonolithBundle our data points into
+    std::shared_ptr<const void> mappedDataSource{nullptr};
+    std::shared_ptr<const WaveformSummary> waveformSummary{nullptr};
+    std::atomic<uint64_t> lastUsed{0};
+    static std::atomic<uint64_t> useClock;
+    void freeData();
+    void freeMipmaps();
+
     void clear_data()
     {
         // TODO: Figure Out and Implement clear_data
@@ -182,6 +332,13 @@ struct alignas(16) Sample : MoveableOnly<Sample>
   public:
     bool allocateI16(int Channel, int Samples);
     bool allocateF32(int Channel, int Samples);
+    bool allocateF16(int Channel, int Samples);
+
+    /*
+     * Re-store F32 data as BD_F16, halving its footprint. Does nothing (and returns
+     * false) for other bit depths or data shared with another sample.
+     */
+    bool convertToF16();
 
     bool load_data_ui8(int channel, void *data, unsigned int samplesize, unsigned int stride);
     bool load_data_i8(int channel, void *data, unsigned int samplesize, unsigned int stride);
@@ -193,6 +350,9 @@ struct alignas(16) Sample : MoveableOnly<Sample>
     bool load_data_i32BE(int channel, void *data, unsigned int samplesize, unsigned int stride);
     bool load_data_f32(int channel, void *data, unsigned int samplesize, unsigned int stride);
     bool load_data_f64(int channel, void *data, unsigned int samplesize, unsigned int stride);
+    // Allocate and fill every channel from an interleaved block of frames in one pass
+    bool load_data_interleaved(pcm::Format format, const void *data, unsigned int frames,
+                               int nChannels);
     bool sample_loaded{false};
 
     bool SetMeta(unsigned int channels, unsigned int SampleRate, unsigned int SampleLength);
@@ -0,0 +1,421 @@
+/*
+ * Shortcircuit XT - a Surge Synth Team product
+ *
+ * A fully featured creative sampler, available as a standalone
+ * and plugin for multiple platforms.
+ *
+ * Copyright 2019 - 2023, Various authors, as described in the github
+ * transaction log.
+ *
+ * ShortcircuitXT is released under the Gnu General Public Licence
+ * V3 or later (GPL-3.0-or-later). The license is found in the file
+ * "LICENSE" in the root of this repository or at
+ * https://www.gnu.org/licenses/gpl-3.0.en.html
+ *
+ * Individual sections of code which comprises ShortcircuitXT in this
+ * repository may also be used under an MIT license. Please see the
+ * section  "Licensing" in "README.md" for details.
+ *
+ * ShortcircuitXT is inspired by, and shares code with, the
+ * commercial product Shortcircuit 1 and 2, released by VemberTech
+ * in the mid 2000s. The code for Shortcircuit 2 was opensourced in
+ * 2020 at the outset of this project.
+ *
+ * All source for ShortcircuitXT is available at
+ * https://github.com/surge-synthesizer/shortcircuit-xt
+ */
+
+
+#include "sample_cache.h"
+#include "sample_record.h"
+#include "dsp/resampling.h"
+#include "infrastructure/content_hash.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace scxt::sample
+{
+using detail::HeaderReader;
+using detail::HeaderWriter;
+
+namespace
+{
+static constexpr char cacheMagic[8]{'S', 'C', 'X', 'T', 'S', 'C', 'C', '1'};
+static constexpr uint32_t cacheVersion{2};
+static constexpr const char *cacheExtension{".scxtsc"};
+
+inline size_t alignToPage(size_t s)
+{
+    return (s + SampleCache::pageSize - 1) / SampleCache::pageSize * SampleCache::pageSize;
+}
+
+size_t channelBytes(const Sample &s)
+{
+    return ((size_t)s.sample_length + dsp::FIRipol_N) * Sample::bitDepthByteSize(s.bitDepth);
+}
+} // namespace
+
+SampleCache::SampleCache(const fs::path &dir, size_t bytes) : directory(dir), maxBytes(bytes)
+{
+    std::lock_guard<std::mutex> g(mutex);
+    scanLocked();
+}
+
+bool SampleCache::shouldCache(const Sample &s)
+{
+    if (Sample::isMultiSampleFile(s.type) || s.sample_length == 0 || !s.sampleData[0])
+        return false;
+    // FLAC needs a real decode; anything else only if we converted it to float
+    return s.type == Sample::FLAC_FILE || s.bitDepth == Sample::BD_F32;
+}
+
+std::optional<SampleCache::SourceStamp>
+SampleCache::stampFor(const Sample::SampleFileAddress &addr)
+{
+    std::error_code ec;
+    SourceStamp res;
+    auto cp = fs::weakly_canonical(addr.path, ec);
+    if (ec)
+        return std::nullopt;
+    res.path = cp.u8string();
+    res.size = fs::file_size(cp, ec);
+    if (ec)
+        return std::nullopt;
+    auto mt = fs::last_write_time(cp, ec);
+    if (ec)
+        return std::nullopt;
+    res.mtime = (int64_t)mt.time_since_epoch().count();
+    res.instrument = addr.instrument;
+    res.region = addr.region;
+    return res;
+}
+
+std::string SampleCache::pathPrefix(const std::string &canonicalPath)
+{
+    infrastructure::ContentHasher h;
+    h.update(canonicalPath.data(), canonicalPath.size());
+    return fmt::format("{:016x}", h.digest());
+}
+
+std::string SampleCache::entryName(const SourceStamp &st) const
+{
+    return fmt::format("{}_{}_{}{}", pathPrefix(st.path), st.instrument + 1, st.region + 1,
+                       cacheExtension);
+}
+
+void SampleCache::scanLocked()
+{
+    entries.clear();
+    totalBytes = 0;
+
+    std::error_code ec;
+    if (!fs::is_directory(directory, ec))
+    {
+        fs::create_directories(directory, ec);
+        if (ec)
+        {
+            SCLOG("Unable to create sample cache directory " << directory.u8string());
+        }
+        return;
+    }
+
+    for (const auto &de : fs::directory_iterator(directory, ec))
+    {
+        if (!de.is_regular_file())
+            continue;
+        auto p = de.path();
+        if (p.extension() == cacheExtension)
+        {
+            Entry e;
+            e.file = p;
+            e.bytes = de.file_size(ec);
+            e.lastUse = de.last_write_time(ec);
+            totalBytes += e.bytes;
+            entries[p.filename().u8string()] = e;
+        }
+        else if (p.extension() == ".tmp")
+        {
+            // left over from an interrupted write
+            fs::remove(p, ec);
+        }
+    }
+    SCLOG("Sample cache at " << directory.u8string() << " has " << entries.size()
+                             << " entries using " << totalBytes << " bytes");
+}
+
+bool SampleCache::restore(const Sample::SampleFileAddress &addr, Sample &s)
+{
+    if (maxBytes == 0)
+        return false;
+
+    auto st = stampFor(addr);
+    if (!st.has_value())
+        return false;
+
+    auto nm = entryName(*st);
+    fs::path file;
+    {
+        std::lock_guard<std::mutex> g(mutex);
+        auto e = entries.find(nm);
+        if (e == entries.end())
+            return false;
+        file = e->second.file;
+    }
+
+    std::ifstream ifs(file, std::ios::binary);
+
+    // Any bad entry leaves the index, and the sample data we allocated into s goes with it
+    auto invalid = [&]() {
+        for (auto &d : s.sampleData)
+        {
+            free(d);
+            d = nullptr;
+        }
+        ifs.close();
+        std::lock_guard<std::mutex> g(mutex);
+        removeLocked(nm);
+        return false;
+    };
+
+    if (!ifs)
+        return invalid();
+
+    char magic[8];
+    uint32_t version{0};
+    uint64_t headerBytes{0};
+    ifs.read(magic, 8);
+    ifs.read((char *)&version, sizeof(version));
+    ifs.read((char *)&headerBytes, sizeof(headerBytes));
+    if (!ifs || memcmp(magic, cacheMagic, 8) != 0 || version != cacheVersion ||
+        headerBytes > 1024 * 1024)
+        return invalid();
+
+    std::vector<uint8_t> header(headerBytes);
+    ifs.seekg(0);
+    ifs.read((char *)header.data(), headerBytes);
+    if (!ifs)
+        return invalid();
+
+    HeaderReader r(header);
+    r.bytes(magic, 8);
+    r.value<uint32_t>();
+    r.value<uint64_t>();
+
+    auto path = r.string();
+    auto size = r.value<uint64_t>();
+    auto mtime = r.value<int64_t>();
+    auto inst = r.value<int32_t>();
+    auto reg = r.value<int32_t>();
+    if (!r.ok || path != st->path || size != st->size || mtime != st->mtime ||
+        inst != st->instrument || reg != st->region)
+    {
+        // The source has changed under us so this entry is stale
+        return invalid();
+    }
+
+    auto desc = detail::readSampleDescription(r);
+    if (!desc.has_value() ||
+        (desc->bitDepth != Sample::BD_I16 && desc->bitDepth != Sample::BD_F32))
+        return invalid();
+    const auto &d = *desc;
+
+    s.SetMeta(d.channels, d.sampleRate, d.sampleLength);
+    for (int c = 0; c < d.channels; ++c)
+    {
+        bool ok = (d.bitDepth == Sample::BD_I16) ? s.allocateI16(c, d.sampleLength)
+                                                 : s.allocateF32(c, d.sampleLength);
+        if (!ok)
+            return invalid();
+        auto cb = channelBytes(s);
+        ifs.seekg(headerBytes + c * alignToPage(cb));
+        ifs.read((char *)s.sampleData[c], cb);
+        if (!ifs)
+            return invalid();
+    }
+
+    s.computeContentHash();
+    if (s.contentHash != d.contentHash)
+    {
+        SCLOG("Sample cache entry " << file.u8string() << " is corrupt; removing");
+        return invalid();
+    }
+
+    // Only now does the entry's meta go in, so a bad entry leaves no slices behind
+    detail::applySampleDescription(d, s);
+    s.type = d.type;
+    s.mFileName = addr.path;
+    s.instrument = addr.instrument;
+    s.region = addr.region;
+    s.sample_loaded = true;
+
+    {
+        std::lock_guard<std::mutex> g(mutex);
+        auto e = entries.find(nm);
+        if (e != entries.end())
+        {
+            std::error_code ec;
+            e->second.lastUse = fs::file_time_type::clock::now();
+            fs::last_write_time(e->second.file, e->second.lastUse, ec);
+        }
+    }
+    return true;
+}
+
+void SampleCache::store(const Sample::SampleFileAddress &addr, const Sample &s)
+{
+    if (maxBytes == 0 || !shouldCache(s))
+        return;
+
+    auto st = stampFor(addr);
+    if (!st.has_value())
+        return;
+
+    HeaderWriter w;
+    w.bytes(cacheMagic, 8);
+    w.value(cacheVersion);
+    w.value((uint64_t)0); // header size, filled in below
+    w.string(st->path);
+    w.value(st->size);
+    w.value(st->mtime);
+    w.value(st->instrument);
+    w.value(st->region);
+
+    detail::writeSampleDescription(w, s);
+
+    auto headerBytes = (uint64_t)alignToPage(w.data.size());
+    memcpy(w.data.data() + 8 + sizeof(uint32_t), &headerBytes, sizeof(headerBytes));
+    w.data.resize(headerBytes, 0);
+
+    auto cb = channelBytes(s);
+    auto paddedCB = alignToPage(cb);
+    auto nm = entryName(*st);
+    std::ostringstream tmpn;
+    tmpn << nm << "." << std::this_thread::get_id() << ".tmp";
+    auto tmpFile = directory / tmpn.str();
+    auto file = directory / nm;
+
+    {
+        std::ofstream ofs(tmpFile, std::ios::binary | std::ios::trunc);
+        if (!ofs)
+            return;
+        ofs.write((const char *)w.data.data(), w.data.size());
+        std::vector<char> pad(paddedCB - cb, 0);
+        for (int c = 0; c < s.channels; ++c)
+        {
+            ofs.write((const char *)s.sampleData[c], cb);
+            ofs.write(pad.data(), pad.size());
+        }
+        if (!ofs)
+        {
+            ofs.close();
+            std::error_code ec;
+            fs::remove(tmpFile, ec);
+            return;
+        }
+    }
+
+    std::lock_guard<std::mutex> g(mutex);
+    std::error_code ec;
+    removeLocked(nm);
+    fs::rename(tmpFile, file, ec);
+    if (ec)
+    {
+        fs::remove(tmpFile, ec);
+        return;
+    }
+    Entry e;
+    e.file = file;
+    e.bytes = headerBytes + paddedCB * s.channels;
+    e.lastUse = fs::file_time_type::clock::now();
+    totalBytes += e.bytes;
+    entries[nm] = e;
+    evictLocked();
+}
+
+bool SampleCache::loadThroughCache(SampleCache *cache, const Sample::SampleFileAddress &addr,
+                                   Sample &s)
+{
+    if (cache && cache->restore(addr, s))
+        return true;
+    if (!s.load(addr.path))
+        return false;
+    if (cache)
+        cache->store(addr, s);
+    return true;
+}
+
+void SampleCache::removeLocked(const std::string &nm)
+{
+    auto e = entries.find(nm);
+    if (e == entries.end())
+        return;
+    std::error_code ec;
+    fs::remove(e->second.file, ec);
+    totalBytes -= std::min((size_t)e->second.bytes, totalBytes);
+    entries.erase(e);
+}
+
+void SampleCache::evictLocked()
+{
+    if (totalBytes <= maxBytes)
+        return;
+
+    // Drop the least recently used entries until we are comfortably under the limit
+    std::vector<std::pair<fs::file_time_type, std::string>> byAge;
+    byAge.reserve(entries.size());
+    for (const auto &[k, e] : entries)
+        byAge.emplace_back(e.lastUse, k);
+    std::sort(byAge.begin(), byAge.end());
+
+    auto target = maxBytes - maxBytes / 10;
+    for (const auto &[t, k] : byAge)
+    {
+        if (totalBytes <= target)
+            break;
+        removeLocked(k);
+    }
+}
+
+void SampleCache::invalidate(const fs::path &source)
+{
+    std::error_code ec;
+    auto cp = fs::weakly_canonical(source, ec);
+    auto prefix = pathPrefix((ec ? source.lexically_normal() : cp).u8string()) + "_";
+
+    std::lock_guard<std::mutex> g(mutex);
+    std::vector<std::string> toGo;
+    for (const auto &[k, e] : entries)
+        if (k.rfind(prefix, 0) == 0)
+            toGo.push_back(k);
+    for (const auto &k : toGo)
+        removeLocked(k);
+}
+
+void SampleCache::clear()
+{
+    std::lock_guard<std::mutex> g(mutex);
+    std::vector<std::string> toGo;
+    for (const auto &[k, e] : entries)
+        toGo.push_back(k);
+    for (const auto &k : toGo)
+        removeLocked(k);
+    SCLOG("Cleared sample cache at " << directory.u8string());
+}
+
+void SampleCache::setMaxBytes(size_t bytes)
+{
+    std::lock_guard<std::mutex> g(mutex);
+    maxBytes = bytes;
+    evictLocked();
+}
+
+size_t SampleCache::getTotalBytes() const
+{
+    std::lock_guard<std::mutex> g(mutex);
+    return totalBytes;
+}
+} // namespace scxt::sample
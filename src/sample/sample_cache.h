@@ -0,0 +1,118 @@
+/*
+ * Shortcircuit XT - a Surge Synth Team product
+ *
+ * A fully featured creative sampler, available as a standalone
+ * and plugin for multiple platforms.
+ *
+ * Copyright 2019 - 2023, Various authors, as described in the github
+ * transaction log.
+ *
+ * ShortcircuitXT is released under the Gnu General Public Licence
+ * V3 or later (GPL-3.0-or-later). The license is found in the file
+ * "LICENSE" in the root of this repository or at
+ * https://www.gnu.org/licenses/gpl-3.0.en.html
+ *
+ * Individual sections of code which comprises ShortcircuitXT in this
+ * repository may also be used under an MIT license. Please see the
+ * section  "Licensing" in "README.md" for details.
+ *
+ * ShortcircuitXT is inspired by, and shares code with, the
+ * commercial product Shortcircuit 1 and 2, released by VemberTech
+ * in the mid 2000s. The code for Shortcircuit 2 was opensourced in
+ * 2020 at the outset of this project.
+ *
+ * All source for ShortcircuitXT is available at
+ * https://github.com/surge-synthesizer/shortcircuit-xt
+ */
+
+
+#ifndef SCXT_SRC_SAMPLE_SAMPLE_CACHE_H
+#define SCXT_SRC_SAMPLE_SAMPLE_CACHE_H
+
+#include "utils.h"
+#include "sample.h"
+
+#include <atomic>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+namespace scxt::sample
+{
+/**
+ * An on-disk cache of decoded samples. Decoding a FLAC or converting 24 bit
+ * integer data to float is most of our load time, so once we have done it we
+ * write the result out in exactly our in-memory format (with the FIR padding,
+ * each channel page aligned) and next time just read it back.
+ *
+ * An entry is keyed by the source path (plus sf2 instrument and region) and
+ * records the source size and mtime; if either changes the entry is stale and
+ * gets replaced. The decoded content hash is stored and checked on restore.
+ * Total size is bounded with least-recently-used eviction, and the cache can
+ * be invalidated per source or cleared entirely.
+ *
+ * restore and store are safe to call from the loader threads.
+ */
+struct SampleCache : MoveableOnly<SampleCache>
+{
+    SampleCache(const fs::path &cacheDirectory, size_t maxBytes);
+
+    // Only samples where we did real decode or conversion work are worth the disk
+    static bool shouldCache(const Sample &s);
+
+    /**
+     * Fill the sample from the cache. Returns false if there is no valid entry for
+     * the address, in which case load the sample as usual (which overwrites anything
+     * a failed restore may have partially filled in).
+     */
+    bool restore(const Sample::SampleFileAddress &addr, Sample &s);
+    void store(const Sample::SampleFileAddress &addr, const Sample &s);
+
+    void invalidate(const fs::path &source);
+    void clear();
+
+    void setMaxBytes(size_t bytes);
+    size_t getMaxBytes() const { return maxBytes; }
+    size_t getTotalBytes() const;
+
+    static constexpr size_t pageSize{4096};
+
+    /**
+     * Load a file based (non sf2) sample, restoring from the cache if we can and
+     * storing the result if we had to decode it. The cache can be null.
+     */
+    static bool loadThroughCache(SampleCache *cache, const Sample::SampleFileAddress &addr,
+                                 Sample &s);
+
+  private:
+    struct SourceStamp
+    {
+        std::string path;
+        uint64_t size{0};
+        int64_t mtime{0};
+        int32_t instrument{-1}, region{-1};
+    };
+    static std::optional<SourceStamp> stampFor(const Sample::SampleFileAddress &addr);
+    static std::string pathPrefix(const std::string &canonicalPath);
+    std::string entryName(const SourceStamp &) const;
+
+    struct Entry
+    {
+        fs::path file;
+        uint64_t bytes{0};
+        fs::file_time_type lastUse{};
+    };
+
+    // Call these with the mutex held
+    void scanLocked();
+    void removeLocked(const std::string &name);
+    void evictLocked();
+
+    fs::path directory;
+    std::atomic<size_t> maxBytes{0};
+    size_t totalBytes{0};
+    std::unordered_map<std::string, Entry> entries;
+    mutable std::mutex mutex;
+};
+} // namespace scxt::sample
+#endif // SHORTCIRCUITXT_SAMPLE_CACHE_H
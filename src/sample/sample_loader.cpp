@@ -0,0 +1,326 @@
+/*
+ * Shortcircuit XT - a Surge Synth Team product
+ *
+ * A fully featured creative sampler, available as a standalone
+ * and plugin for multiple platforms.
+ *
+ * Copyright 2019 - 2023, Various authors, as described in the github
+ * transaction log.
+ *
+ * ShortcircuitXT is released under the Gnu General Public Licence
+ * V3 or later (GPL-3.0-or-later). The license is found in the file
+ * "LICENSE" in the root of this repository or at
+ * https://www.gnu.org/licenses/gpl-3.0.en.html
+ *
+ * Individual sections of code which comprises ShortcircuitXT in this
+ * repository may also be used under an MIT license. Please see the
+ * section  "Licensing" in "README.md" for details.
+ *
+ * ShortcircuitXT is inspired by, and shares code with, the
+ * commercial product Shortcircuit 1 and 2, released by VemberTech
+ * in the mid 2000s. The code for Shortcircuit 2 was opensourced in
+ * 2020 at the outset of this project.
+ *
+ * All source for ShortcircuitXT is available at
+ * https://github.com/surge-synthesizer/shortcircuit-xt
+ */
+
+
+#include "sample_loader.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace scxt::sample
+{
+std::atomic<size_t> SampleLoader::outstandingJobs{0};
+
+SampleLoader::SampleLoader(size_t nt) : numThreads(nt)
+{
+    if (numThreads == 0)
+    {
+        auto hc = std::thread::hardware_concurrency();
+        numThreads = hc > 1 ? hc - 1 : 1;
+    }
+}
+
+SampleLoader::~SampleLoader() { stop(); }
+
+void SampleLoader::stop()
+{
+    cancelAll();
+    {
+        std::lock_guard<std::mutex> g(jobMutex);
+        shouldRun = false;
+    }
+    jobCondition.notify_all();
+    for (auto &w : workers)
+        w.join();
+    workers.clear();
+}
+
+void SampleLoader::startWorkersIfNeeded()
+{
+    // call with jobMutex held
+    if (!workers.empty())
+        return;
+
+    SCLOG("Starting sample loader with " << numThreads << " worker threads");
+    for (size_t i = 0; i < numThreads; ++i)
+        workers.emplace_back([this]() { workerLoop(); });
+}
+
+SampleLoader::batchID_t SampleLoader::submit(std::vector<Request> requests,
+                                             progressCallback_t onProgress,
+                                             completionCallback_t onComplete,
+                                             resultCallback_t onEachResult)
+{
+    auto batch = std::make_shared<Batch>();
+    batch->requests = std::move(requests);
+    batch->results.resize(batch->requests.size());
+    batch->onProgress = std::move(onProgress);
+    batch->onComplete = std::move(onComplete);
+    batch->onEachResult = std::move(onEachResult);
+
+    for (size_t i = 0; i < batch->requests.size(); ++i)
+        batch->results[i].request = batch->requests[i];
+
+    bool accepted{false};
+    {
+        std::lock_guard<std::mutex> g(jobMutex);
+        batch->id = nextBatchID++;
+        if (shouldRun && !batch->requests.empty())
+        {
+            activeBatches[batch->id] = batch;
+            for (size_t i = 0; i < batch->requests.size(); ++i)
+                jobs.push_back({batch, i});
+            outstandingJobs += batch->requests.size();
+            startWorkersIfNeeded();
+            accepted = true;
+        }
+    }
+
+    if (!accepted)
+    {
+        // Empty, or we are shutting down. Either way we are done right now.
+        if (batch->onComplete)
+            batch->onComplete(batch->id, std::move(batch->results), !batch->requests.empty());
+        return batch->id;
+    }
+
+    jobCondition.notify_all();
+    return batch->id;
+}
+
+std::vector<SampleLoader::Result> SampleLoader::loadAndWait(std::vector<Request> requests,
+                                                            progressCallback_t onProgress)
+{
+    std::mutex doneMutex;
+    std::condition_variable doneCondition;
+    bool done{false};
+    std::vector<Result> res;
+
+    submit(std::move(requests), std::move(onProgress),
+           [&](auto, auto &&results, auto) {
+               std::lock_guard<std::mutex> g(doneMutex);
+               res = std::move(results);
+               done = true;
+               doneCondition.notify_all();
+           });
+
+    std::unique_lock<std::mutex> lock(doneMutex);
+    doneCondition.wait(lock, [&done]() { return done; });
+    return res;
+}
+
+void SampleLoader::cancel(batchID_t b)
+{
+    std::lock_guard<std::mutex> g(jobMutex);
+    auto p = activeBatches.find(b);
+    if (p != activeBatches.end())
+        p->second->cancelled = true;
+}
+
+void SampleLoader::cancelAll()
+{
+    std::lock_guard<std::mutex> g(jobMutex);
+    for (auto &[id, b] : activeBatches)
+        b->cancelled = true;
+}
+
+bool SampleLoader::prioritize(const Sample::SampleFileAddress &a)
+{
+    std::lock_guard<std::mutex> g(jobMutex);
+    auto p = std::find_if(jobs.begin(), jobs.end(), [&a](const auto &j) {
+        const auto &b = j.batch->requests[j.index].address;
+        return b.type == a.type && b.instrument == a.instrument && b.region == a.region &&
+               b.path == a.path;
+    });
+    if (p == jobs.end())
+        return false;
+
+    auto job = std::move(*p);
+    jobs.erase(p);
+    jobs.push_front(std::move(job));
+    return true;
+}
+
+size_t SampleLoader::getPendingJobCount() const
+{
+    std::lock_guard<std::mutex> g(jobMutex);
+    return jobs.size();
+}
+
+void SampleLoader::workerLoop()
+{
+    // libgig objects are not thread safe so each worker keeps its own handles,
+    // dropped whenever the worker runs out of work
+    std::unordered_map<std::string,
+                       std::pair<std::unique_ptr<RIFF::File>, std::unique_ptr<sf2::File>>>
+        sf2Files;
+    std::unordered_map<std::string,
+                       std::pair<std::unique_ptr<RIFF::File>, std::unique_ptr<gig::File>>>
+        gigFiles;
+
+    while (true)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(jobMutex);
+            if (jobs.empty())
+            {
+                sf2Files.clear();
+                gigFiles.clear();
+                jobCondition.wait(lock, [this]() { return !shouldRun || !jobs.empty(); });
+            }
+            if (!shouldRun && jobs.empty())
+                return;
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+
+        auto &batch = *job.batch;
+        if (!batch.cancelled)
+        {
+            const auto &req = batch.requests[job.index];
+            const auto &addr = req.address;
+            auto sp = std::make_shared<Sample>(req.id);
+            bool ok{false};
+
+            try
+            {
+                switch (addr.type)
+                {
+                case Sample::WAV_FILE:
+                case Sample::FLAC_FILE:
+                case Sample::AIFF_FILE:
+                    ok = SampleCache::loadThroughCache(cache, addr, *sp);
+                    break;
+                case Sample::SF2_FILE:
+                {
+                    auto key = addr.path.u8string();
+                    auto sfp = sf2Files.find(key);
+                    if (sfp == sf2Files.end())
+                    {
+                        auto riff = std::make_unique<RIFF::File>(key);
+                        auto sf = std::make_unique<sf2::File>(riff.get());
+                        sfp = sf2Files.emplace(key, std::make_pair(std::move(riff), std::move(sf)))
+                                  .first;
+                    }
+                    ok = sp->loadFromSF2(addr.path, sfp->second.second.get(), addr.instrument,
+                                         addr.region);
+                }
+                break;
+                case Sample::MONOLITH_FILE:
+                    ok = sp->loadFromMonolith(addr.path, addr.region);
+                    break;
+                case Sample::GIG_FILE:
+                {
+                    auto key = addr.path.u8string();
+                    auto gfp = gigFiles.find(key);
+                    if (gfp == gigFiles.end())
+                    {
+                        auto riff = std::make_unique<RIFF::File>(key);
+                        auto gf = std::make_unique<gig::File>(riff.get());
+                        gfp = gigFiles.emplace(key, std::make_pair(std::move(riff), std::move(gf)))
+                                  .first;
+                    }
+                    ok = sp->loadFromGIG(addr.path, gfp->second.second.get(), addr.region);
+                }
+                break;
+                }
+            }
+            catch (RIFF::Exception &e)
+            {
+                SCLOG("Unable to read " << addr.path.u8string() << " : " << e.Message);
+                ok = false;
+            }
+            catch (const std::exception &e)
+            {
+                SCLOG("Unable to load " << addr.path.u8string() << " : " << e.what());
+                ok = false;
+            }
+
+            // Convert before the F16 store, which the converter can't read
+            auto toRate = targetSampleRate.load();
+            if (ok && toRate > 0)
+                sp->convertSampleRate(toRate);
+            if (ok && storeFloatAsF16)
+                sp->convertToF16();
+            if (ok && buildMipmaps)
+                sp->buildMipmaps();
+            // A mapped sample's summary waits until it is drawn, rather than paging it all in
+            if (ok && !sp->isDataMapped())
+                sp->buildWaveformSummary();
+
+            if (ok)
+                batch.results[job.index].sample = sp;
+            else
+                SCLOG("Background load failed for " << addr.path.u8string());
+        }
+
+        outstandingJobs--;
+        finishJob(job);
+    }
+}
+
+void SampleLoader::finishJob(const Job &job)
+{
+    auto &batch = *job.batch;
+    auto total = batch.requests.size();
+
+    if (batch.onEachResult && !batch.cancelled && batch.results[job.index].sample)
+        batch.onEachResult(batch.id, batch.results[job.index]);
+
+    auto done = ++batch.completed;
+
+    if (batch.onProgress)
+    {
+        // Always report the final job; otherwise only the first job to cross each percent
+        bool report = (done == total);
+        if (!report)
+        {
+            auto pct = (int)(done * 100 / total);
+            auto last = batch.lastReportedPercent.load();
+            report = pct > last && batch.lastReportedPercent.compare_exchange_strong(last, pct);
+        }
+        if (report)
+            batch.onProgress(batch.id, done, total, batch.requests[job.index].address.path);
+    }
+
+    if (done == total)
+    {
+        {
+            std::lock_guard<std::mutex> g(jobMutex);
+            activeBatches.erase(batch.id);
+        }
+        if (batch.cancelled)
+        {
+            for (auto &r : batch.results)
+                r.sample.reset();
+        }
+        if (batch.onComplete)
+            batch.onComplete(batch.id, std::move(batch.results), batch.cancelled);
+    }
+}
+} // namespace scxt::sample
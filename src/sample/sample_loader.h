@@ -0,0 +1,182 @@
+/*
+ * Shortcircuit XT - a Surge Synth Team product
+ *
+ * A fully featured creative sampler, available as a standalone
+ * and plugin for multiple platforms.
+ *
+ * Copyright 2019 - 2023, Various authors, as described in the github
+ * transaction log.
+ *
+ * ShortcircuitXT is released under the Gnu General Public Licence
+ * V3 or later (GPL-3.0-or-later). The license is found in the file
+ * "LICENSE" in the root of this repository or at
+ * https://www.gnu.org/licenses/gpl-3.0.en.html
+ *
+ * Individual sections of code which comprises ShortcircuitXT in this
+ * repository may also be used under an MIT license. Please see the
+ * section  "Licensing" in "README.md" for details.
+ *
+ * ShortcircuitXT is inspired by, and shares code with, the
+ * commercial product Shortcircuit 1 and 2, released by VemberTech
+ * in the mid 2000s. The code for Shortcircuit 2 was opensourced in
+ * 2020 at the outset of this project.
+ *
+ * All source for ShortcircuitXT is available at
+ * https://github.com/surge-synthesizer/shortcircuit-xt
+ */
+
+
+#ifndef SCXT_SRC_SAMPLE_SAMPLE_LOADER_H
+#define SCXT_SRC_SAMPLE_SAMPLE_LOADER_H
+
+#include "utils.h"
+#include "sample.h"
+#include "sample_cache.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace scxt::sample
+{
+/**
+ * The SampleLoader is a small pool of worker threads which decode samples
+ * off the serialization thread. It knows nothing about the sample manager
+ * or messaging; it takes a batch of file addresses, loads each one into a
+ * free standing Sample object in parallel, and calls you back when they are
+ * all done. Installing those samples in a SampleManager (which has to happen
+ * on the serialization thread) is the caller's job.
+ *
+ * Callbacks are made on whichever worker thread finished the relevant job,
+ * so if you want to touch engine state from them you need to bounce to the
+ * serialization thread with MessageController::scheduleSerializationThreadCallback.
+ *
+ * SF2 files are opened once per worker per batch since libgig isn't safe
+ * to share across threads.
+ */
+struct SampleLoader : MoveableOnly<SampleLoader>
+{
+    struct Request
+    {
+        Sample::SampleFileAddress address;
+        SampleID id{}; // the id the sample will be constructed with. Can be unset.
+    };
+
+    struct Result
+    {
+        Request request;
+        std::shared_ptr<Sample> sample; // null if the load failed or was cancelled
+    };
+
+    typedef uint64_t batchID_t;
+    typedef std::function<void(batchID_t, size_t completed, size_t total, const fs::path &last)>
+        progressCallback_t;
+    typedef std::function<void(batchID_t, std::vector<Result> &&, bool cancelled)>
+        completionCallback_t;
+    typedef std::function<void(batchID_t, const Result &)> resultCallback_t;
+
+    /**
+     * @param numThreads worker count. 0 means hardware_concurrency - 1 (at least 1).
+     * The workers are started lazily on the first submit.
+     */
+    explicit SampleLoader(size_t numThreads = 0);
+    ~SampleLoader();
+
+    /**
+     * Submit a batch for background loading. Progress is reported at most once
+     * per percent of the batch and once at the end. The completion callback
+     * is always called exactly once, even if the batch is cancelled, with the
+     * results in the order of the requests. If onEachResult is set it is called
+     * as each sample in the batch loads successfully, before the batch completes.
+     */
+    batchID_t submit(std::vector<Request> requests, progressCallback_t onProgress,
+                     completionCallback_t onComplete, resultCallback_t onEachResult = nullptr);
+
+    /**
+     * Submit a batch and block the calling thread until it is loaded. Useful for
+     * the synchronous unstream path, which still gets the parallel decode.
+     */
+    std::vector<Result> loadAndWait(std::vector<Request> requests,
+                                    progressCallback_t onProgress = nullptr);
+
+    void cancel(batchID_t batch);
+    void cancelAll();
+
+    /**
+     * Move any queued (not yet started) job for this address to the front of the
+     * queue. Returns false if there was no such job.
+     */
+    bool prioritize(const Sample::SampleFileAddress &address);
+
+    /**
+     * Cancel everything and join the workers. Every outstanding completion
+     * callback has been made by the time this returns.
+     */
+    void stop();
+
+    // Non owning. Workers restore from and populate this decoded sample cache if set.
+    void setSampleCache(SampleCache *c) { cache = c; }
+    // If set, F32 samples are re-stored as BD_F16 once loaded (see Sample::convertToF16)
+    void setStoreFloatAsF16(bool b) { storeFloatAsF16 = b; }
+    // If non zero, samples at another rate are converted to this one once loaded
+    void setTargetSampleRate(uint32_t r) { targetSampleRate = r; }
+    uint32_t getTargetSampleRate() const { return targetSampleRate; }
+    // If set, each sample gets its octave mipmaps once loaded (see Sample::buildMipmaps)
+    void setBuildMipmaps(bool b) { buildMipmaps = b; }
+
+    size_t getNumThreads() const { return numThreads; }
+    size_t getPendingJobCount() const;
+
+    /**
+     * Jobs queued or running but not yet finished, across every loader. Decoders
+     * which could split one file over several threads check this so they don't
+     * oversubscribe a busy pool.
+     */
+    static size_t getOutstandingJobCount() { return outstandingJobs; }
+
+  private:
+    struct Batch
+    {
+        batchID_t id{0};
+        std::vector<Request> requests;
+        std::vector<Result> results;
+        std::atomic<size_t> completed{0};
+        std::atomic<int> lastReportedPercent{-1};
+        std::atomic<bool> cancelled{false};
+        progressCallback_t onProgress{nullptr};
+        completionCallback_t onComplete{nullptr};
+        resultCallback_t onEachResult{nullptr};
+    };
+    struct Job
+    {
+        std::shared_ptr<Batch> batch;
+        size_t index{0};
+    };
+
+    void startWorkersIfNeeded();
+    void workerLoop();
+    void finishJob(const Job &job);
+
+    static std::atomic<size_t> outstandingJobs;
+
+    std::atomic<SampleCache *> cache{nullptr};
+    std::atomic<bool> storeFloatAsF16{false};
+    std::atomic<uint32_t> targetSampleRate{0};
+    std::atomic<bool> buildMipmaps{false};
+    size_t numThreads{1};
+    std::vector<std::thread> workers;
+    std::deque<Job> jobs;
+    std::unordered_map<batchID_t, std::shared_ptr<Batch>> activeBatches;
+    mutable std::mutex jobMutex;
+    std::condition_variable jobCondition;
+    bool shouldRun{true};
+    batchID_t nextBatchID{1};
+};
+} // namespace scxt::sample
+#endif // SHORTCIRCUITXT_SAMPLE_LOADER_H
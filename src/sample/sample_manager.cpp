@@ -26,39 +26,280 @@
  */
 
 #include <cassert>
+#include <unordered_set>
 #include "sample_manager.h"
 
 namespace scxt::sample
 {
 void SampleManager::restoreFromSampleAddressesAndIDs(const sampleAddressesAndIds_t &r)
 {
+    // Decode everything in parallel on the loader and then install on this thread
+    std::vector<SampleLoader::Request> requests;
     for (const auto &[id, addr] : r)
     {
         if (!fs::exists(addr.path))
         {
             missingList.push_back(addr.path);
         }
-        else
+        else if (!findSampleByFileAddress(addr).has_value())
         {
-            switch (addr.type)
-            {
-            case Sample::WAV_FILE:
-            case Sample::FLAC_FILE:
-            case Sample::AIFF_FILE:
+            requests.push_back({addr, id});
+        }
+    }
+
+    if (lazyRestoreHandler)
+    {
+        if (requests.empty())
+            return;
+
+        {
+            std::unique_lock<std::shared_mutex> g(sampleMutex);
+            for (const auto &req : requests)
             {
-                loadSampleByPathToID(addr.path, id);
+                SampleID::guaranteeNextAbove(req.id);
+                pendingSamples[req.id] = req.address;
             }
-            break;
-            case Sample::SF2_FILE:
+        }
+        lazyRestoreHandler(std::move(requests), restoreGeneration);
+        return;
+    }
+
+    auto results = loader->loadAndWait(std::move(requests), restoreProgressCallback);
+    for (const auto &res : results)
+    {
+        if (res.sample)
+        {
+            installLoadedSample(res.sample);
+        }
+        else
+        {
+            SCLOG("Unable to restore sample " << res.request.address.path.u8string());
+        }
+    }
+}
+
+std::string SampleManager::pathKey(const fs::path &p)
+{
+    std::error_code ec;
+    auto c = fs::weakly_canonical(p, ec);
+    if (ec)
+        return p.lexically_normal().u8string();
+    return c.u8string();
+}
+
+std::optional<SampleID>
+SampleManager::findSampleByFileAddress(const Sample::SampleFileAddress &addr) const
+{
+    auto key = pathKey(addr.path);
+    std::shared_lock<std::shared_mutex> g(sampleMutex);
+    return findSampleByFileAddressLocked(addr, key);
+}
+
+std::optional<SampleID>
+SampleManager::findSampleByFileAddressLocked(const Sample::SampleFileAddress &addr,
+                                             const std::string &key) const
+{
+    if (Sample::isMultiSampleFile(addr.type))
+    {
+        auto p = idBySF2Address.find({key, addr.instrument, addr.region});
+        if (p != idBySF2Address.end())
+            return p->second;
+    }
+    else
+    {
+        auto p = idByPath.find(key);
+        if (p != idByPath.end())
+            return p->second;
+    }
+    return std::nullopt;
+}
+
+void SampleManager::addSampleLocked(const std::shared_ptr<Sample> &sp, const std::string &key)
+{
+    dedupeContentLocked(sp);
+
+    samples[sp->id] = sp;
+    const auto &addr = sp->getSampleFileAddress();
+    if (Sample::isMultiSampleFile(addr.type))
+        idBySF2Address[{key, addr.instrument, addr.region}] = sp->id;
+    else
+        idByPath[key] = sp->id;
+    pathKeyById[sp->id] = key;
+}
+
+void SampleManager::dedupeContentLocked(const std::shared_ptr<Sample> &sp)
+{
+    // Mapped data costs no heap, and comparing it would page the whole file in
+    if (sp->contentHash != 0 && !sp->isDataShared() && !sp->isDataMapped())
+    {
+        auto h = idByContentHash.find(sp->contentHash);
+        if (h == idByContentHash.end())
+        {
+            idByContentHash[sp->contentHash] = sp->id;
+        }
+        else
+        {
+            auto owner = samples.find(h->second);
+            if (owner != samples.end() && sp->hasSameContentAs(*owner->second))
             {
-                loadSampleFromSF2ToID(addr.path, nullptr, addr.instrument, addr.region, id);
-            }
-            break;
+                sp->shareDataFrom(owner->second);
+                contentDedupeBytesSaved += sp->getDataSize();
+                SCLOG("Sample " << sp->getDisplayName() << " shares content with "
+                                << owner->second->getDisplayName() << "; "
+                                << contentDedupeBytesSaved << " bytes saved by content dedupe");
             }
         }
     }
 }
 
+SampleID SampleManager::installLoadedSample(const std::shared_ptr<Sample> &sp)
+{
+    assert(threadingChecker.isSerialThread());
+    assert(sp);
+
+    auto key = pathKey(sp->getSampleFileAddress().path);
+    std::unique_lock<std::shared_mutex> g(sampleMutex);
+    auto existing = findSampleByFileAddressLocked(sp->getSampleFileAddress(), key);
+    if (existing.has_value())
+    {
+        pendingSamples.erase(sp->id);
+        return *existing;
+    }
+
+    if (sp->id.isValid())
+        SampleID::guaranteeNextAbove(sp->id);
+    else
+        sp->id = SampleID::next();
+
+    pendingSamples.erase(sp->id);
+    addSampleLocked(sp, key);
+    return sp->id;
+}
+
+std::optional<Sample::SampleFileAddress>
+SampleManager::getPendingSampleAddress(const SampleID &id) const
+{
+    std::shared_lock<std::shared_mutex> g(sampleMutex);
+    auto p = pendingSamples.find(id);
+    if (p == pendingSamples.end())
+        return std::nullopt;
+    return p->second;
+}
+
+size_t SampleManager::residentBytesLocked() const
+{
+    size_t res{0};
+    for (const auto &[id, sp] : samples)
+    {
+        if (!sp->isDataShared() && !sp->isDataMapped())
+            res += sp->getDataSize();
+    }
+    return res;
+}
+
+std::vector<std::shared_ptr<Sample>>
+SampleManager::chooseEvictionCandidates(uint64_t usedBefore) const
+{
+    assert(threadingChecker.isSerialThread());
+    std::vector<std::shared_ptr<Sample>> res;
+    if (memoryBudget == 0)
+        return res;
+
+    std::shared_lock<std::shared_mutex> g(sampleMutex);
+    auto resident = residentBytesLocked();
+    if (resident <= memoryBudget)
+        return res;
+
+    // Data which is shared by content dedupe stays resident, since dropping
+    // one of the samples using it frees nothing. Mapped data is the OS's to page.
+    std::unordered_set<uint64_t> sharedContent;
+    for (const auto &[id, sp] : samples)
+    {
+        if (sp->isDataShared())
+            sharedContent.insert(sp->contentHash);
+    }
+
+    std::vector<std::shared_ptr<Sample>> candidates;
+    for (const auto &[id, sp] : samples)
+    {
+        if (sp->isResidencyHead() || sp->isDataShared() || sp->isDataMapped() ||
+            sharedContent.count(sp->contentHash))
+            continue;
+        if (sp->getSampleLength() <= preloadFrames || sp->getLastUsed() >= usedBefore)
+            continue;
+        candidates.push_back(sp);
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const auto &a, const auto &b) {
+        return a->getLastUsed() < b->getLastUsed();
+    });
+
+    for (const auto &c : candidates)
+    {
+        if (resident <= memoryBudget)
+            break;
+        auto headBytes =
+            (size_t)preloadFrames * Sample::bitDepthByteSize(c->bitDepth) * c->channels;
+        resident -= c->getDataSize() - headBytes;
+        res.push_back(c);
+    }
+    return res;
+}
+
+void SampleManager::replaceResidentSample(const std::shared_ptr<Sample> &sp)
+{
+    assert(threadingChecker.isSerialThread());
+    assert(sp);
+
+    std::unique_lock<std::shared_mutex> g(sampleMutex);
+    auto p = samples.find(sp->id);
+    if (p == samples.end())
+        return;
+
+    auto h = idByContentHash.find(p->second->contentHash);
+    if (h != idByContentHash.end() && h->second == sp->id)
+        idByContentHash.erase(h);
+
+    if (sp->isResidencyHead())
+    {
+        residencyEvictions++;
+    }
+    else
+    {
+        // a rate conversion also swaps in a complete sample, but isn't a reload
+        if (p->second->isResidencyHead())
+            residencyReloads++;
+        dedupeContentLocked(sp);
+    }
+    p->second = sp;
+}
+
+SampleManager::ResidencyStats SampleManager::getResidencyStats() const
+{
+    std::shared_lock<std::shared_mutex> g(sampleMutex);
+    ResidencyStats res;
+    res.budgetBytes = memoryBudget;
+    res.residentBytes = residentBytesLocked();
+    for (const auto &[id, sp] : samples)
+    {
+        if (sp->isResidencyHead())
+            res.headSamples++;
+        else
+            res.completeSamples++;
+    }
+    res.hits = residencyHits.load(std::memory_order_relaxed);
+    res.misses = residencyMisses.load(std::memory_order_relaxed);
+    res.evictions = residencyEvictions;
+    res.reloads = residencyReloads;
+    return res;
+}
+
+void SampleManager::dropPendingSample(const SampleID &id)
+{
+    assert(threadingChecker.isSerialThread());
+    std::unique_lock<std::shared_mutex> g(sampleMutex);
+    pendingSamples.erase(id);
+}
+
 std::optional<SampleID> SampleManager::loadSampleByPath(const fs::path &p)
 {
     return loadSampleByPathToID(p, SampleID::next());
@@ -70,22 +311,26 @@ std::optional<SampleID> SampleManager::loadSampleByPathToID(const fs::path &p, c
     assert(threadingChecker.isSerialThread());
     SampleID::guaranteeNextAbove(id);
 
-    for (const auto &[id, sm] : samples)
-    {
-        if (sm->getPath() == p)
-        {
-            return id;
-        }
-    }
+    auto existing = findSampleByFileAddress({Sample::WAV_FILE, p});
+    if (existing.has_value())
+        return existing;
 
     auto sp = std::make_shared<Sample>(id);
 
-    if (!sp->load(p))
+    if (!SampleCache::loadThroughCache(sampleCache.get(), {Sample::WAV_FILE, p}, *sp))
     {
         return std::nullopt;
     }
+    if (targetSampleRate > 0)
+        sp->convertSampleRate(targetSampleRate);
+    if (storeFloatAsF16)
+        sp->convertToF16();
+    if (buildMipmaps)
+        sp->buildMipmaps();
 
-    samples[sp->id] = sp;
+    auto key = pathKey(sp->getSampleFileAddress().path);
+    std::unique_lock<std::shared_mutex> g(sampleMutex);
+    addSampleLocked(sp, key);
     return sp->id;
 }
 
@@ -99,6 +344,10 @@ std::optional<SampleID> SampleManager::loadSampleFromSF2ToID(const fs::path &p,
                                                              int instrument, int region,
                                                              const SampleID &sid)
 {
+    auto existing = findSampleByFileAddress({Sample::SF2_FILE, p, instrument, region});
+    if (existing.has_value())
+        return existing;
+
     if (!f)
     {
         if (sf2FilesByPath.find(p.u8string()) == sf2FilesByPath.end())
@@ -120,28 +369,29 @@ std::optional<SampleID> SampleManager::loadSampleFromSF2ToID(const fs::path &p,
     }
 
     assert(f);
-    for (const auto &[id, sm] : samples)
-    {
-        if (sm->type == Sample::SF2_FILE)
-        {
-            const auto &[type, path, inst, reg] = sm->getSampleFileAddress();
-            if (path == p && instrument == inst && region == reg)
-                return id;
-        }
-    }
-
     auto sp = std::make_shared<Sample>(sid);
 
     SCLOG("Loading individual sf2 sample " << SCD(instrument) << SCD(region) << SCD(p.u8string()));
     if (!sp->loadFromSF2(p, f, instrument, region))
         return {};
+    if (targetSampleRate > 0)
+        sp->convertSampleRate(targetSampleRate);
+    if (storeFloatAsF16)
+        sp->convertToF16();
+    if (buildMipmaps)
+        sp->buildMipmaps();
 
-    samples[sp->id] = sp;
+    auto key = pathKey(sp->getSampleFileAddress().path);
+    std::unique_lock<std::shared_mutex> g(sampleMutex);
+    addSampleLocked(sp, key);
     return sp->id;
 }
 
 void SampleManager::purgeUnreferencedSamples()
 {
+    assert(threadingChecker.isSerialThread());
+    std::unique_lock<std::shared_mutex> g(sampleMutex);
+
     SCLOG_WFUNC("PrePurge Sample Count is " << samples.size());
     auto b = samples.begin();
     while (b != samples.end())
@@ -151,6 +401,23 @@ void SampleManager::purgeUnreferencedSamples()
         {
             SCLOG("Purging sample " << b->first.to_string() << " from "
                                     << b->second->mFileName.u8string())
+            const auto &addr = b->second->getSampleFileAddress();
+            auto k = pathKeyById.find(b->first);
+            if (k != pathKeyById.end())
+            {
+                if (Sample::isMultiSampleFile(addr.type))
+                    idBySF2Address.erase({k->second, addr.instrument, addr.region});
+                else
+                    idByPath.erase(k->second);
+                pathKeyById.erase(k);
+            }
+
+            // an owner is only purged once nothing shares its data (the sharers hold it)
+            auto h = idByContentHash.find(b->second->contentHash);
+            if (h != idByContentHash.end() && h->second == b->first)
+                idByContentHash.erase(h);
+            if (b->second->isDataShared())
+                contentDedupeBytesSaved -= b->second->getDataSize();
             b = samples.erase(b);
         }
         else
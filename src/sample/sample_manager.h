@@ -30,12 +30,19 @@
 
 #include "utils.h"
 #include "sample.h"
+#include "sample_loader.h"
+#include "sample_cache.h"
 
 #include "infrastructure/filesystem_import.h"
 
+#include <atomic>
 #include <filesystem>
+#include <functional>
 #include <unordered_map>
 #include <optional>
+#include <algorithm>
+#include <shared_mutex>
+#include <mutex>
 #include <vector>
 #include <utility>
 #include "SF.h"
@@ -45,7 +52,10 @@ namespace scxt::sample
 struct SampleManager : MoveableOnly<SampleManager>
 {
     const ThreadingChecker &threadingChecker;
-    SampleManager(const ThreadingChecker &t) : threadingChecker(t) {}
+    SampleManager(const ThreadingChecker &t)
+        : threadingChecker(t), loader(std::make_unique<SampleLoader>())
+    {
+    }
 
     std::optional<SampleID> loadSampleByFileAddress(const Sample::SampleFileAddress &);
     std::optional<SampleID> loadSampleByFileAddressToID(const Sample::SampleFileAddress &,
@@ -61,31 +71,160 @@ struct SampleManager : MoveableOnly<SampleManager>
                                                   sf2::File *f, // if this is null I will re-open it
                                                   int instrument, int region, const SampleID &id);
 
+    /*
+     * Lookups are safe from any thread. Mutation of the sample set only happens
+     * on the serialization thread, under an exclusive lock, so readers
+     * (the ui, the loader threads) only ever take a shared lock.
+     */
     std::shared_ptr<Sample> getSample(const SampleID &id) const
     {
+        std::shared_lock<std::shared_mutex> g(sampleMutex);
         auto p = samples.find(id);
         if (p != samples.end())
             return p->second;
         return {};
     }
+    size_t getSampleCount() const
+    {
+        std::shared_lock<std::shared_mutex> g(sampleMutex);
+        return samples.size();
+    }
 
     typedef std::vector<std::pair<SampleID, Sample::SampleFileAddress>> sampleAddressesAndIds_t;
     sampleAddressesAndIds_t getSampleAddressesAndIDs() const
     {
+        std::shared_lock<std::shared_mutex> g(sampleMutex);
         sampleAddressesAndIds_t res;
         for (const auto &[k, v] : samples)
         {
             res.emplace_back(k, v->getSampleFileAddress());
         }
+        // a sample still loading from a lazy restore is still part of the patch
+        for (const auto &[k, a] : pendingSamples)
+        {
+            res.emplace_back(k, a);
+        }
         return res;
     }
     void restoreFromSampleAddressesAndIDs(const sampleAddressesAndIds_t &);
 
+    /*
+     * Lazy restore. If a handler is set, restoreFromSampleAddressesAndIDs doesn't wait
+     * for any audio. Each sample it needs is recorded as pending, which reserves the id
+     * and keeps the address in the patch, and the requests go to the handler to load in
+     * the background and install with installLoadedSample. Zones which unstream before
+     * their sample arrives just have no sample pointer until someone attaches them.
+     *
+     * The generation is bumped by every reset so a handler can tell that its results
+     * belong to a patch which has since been replaced.
+     */
+    typedef std::function<void(std::vector<SampleLoader::Request> &&, uint64_t generation)>
+        lazyRestoreHandler_t;
+    lazyRestoreHandler_t lazyRestoreHandler{nullptr};
+    uint64_t getRestoreGeneration() const { return restoreGeneration; }
+    std::optional<Sample::SampleFileAddress> getPendingSampleAddress(const SampleID &) const;
+    size_t getPendingSampleCount() const
+    {
+        std::shared_lock<std::shared_mutex> g(sampleMutex);
+        return pendingSamples.size();
+    }
+    // Give up on a pending sample whose load failed
+    void dropPendingSample(const SampleID &);
+
+    /*
+     * Residency under a memory budget. With a budget set (0, the default, is no limit)
+     * the engine periodically swaps the least recently played samples for a preload
+     * head (see Sample::makeResidencyHead) until the resident sample data fits. A note
+     * on an evicted sample plays the head and brings the rest back in the background.
+     * The manager keeps the books; the engine does the swapping since that has to be
+     * coordinated with the voices.
+     */
+    void setMemoryBudget(size_t bytes) { memoryBudget = bytes; }
+    size_t getMemoryBudget() const { return memoryBudget; }
+    void setPreloadFrames(uint32_t f) { preloadFrames = std::max(f, 1U); }
+    uint32_t getPreloadFrames() const { return preloadFrames; }
+
+    // Complete samples last used before usedBefore, oldest first, enough to fit the budget
+    std::vector<std::shared_ptr<Sample>> chooseEvictionCandidates(uint64_t usedBefore) const;
+    // Swap in a head or a reloaded complete sample for the sample with its id
+    void replaceResidentSample(const std::shared_ptr<Sample> &);
+
+    struct ResidencyStats
+    {
+        size_t budgetBytes{0}, residentBytes{0};
+        uint32_t completeSamples{0}, headSamples{0};
+        uint64_t hits{0}, misses{0}, evictions{0}, reloads{0};
+    };
+    ResidencyStats getResidencyStats() const;
+    // Counted from the audio thread as notes start
+    void noteResidencyHit() { residencyHits.fetch_add(1, std::memory_order_relaxed); }
+    void noteResidencyMiss() { residencyMisses.fetch_add(1, std::memory_order_relaxed); }
+
+    /*
+     * Background loading. The loader decodes into free standing samples on
+     * its own threads; installLoadedSample brings one of those into the manager
+     * on the serialization thread, returning the id of an existing sample with
+     * the same address if there is one.
+     */
+    SampleLoader &getLoader() { return *loader; }
+
+    // The on disk decoded sample cache. Can be null, in which case we always decode.
+    // Set this up before any loading starts.
+    void setSampleCache(std::unique_ptr<SampleCache> c)
+    {
+        loader->setSampleCache(c.get());
+        sampleCache = std::move(c);
+    }
+    SampleCache *getSampleCache() const { return sampleCache.get(); }
+
+    // Store what would be F32 sample data as half floats. Applies to subsequent loads.
+    void setStoreFloatAsF16(bool b)
+    {
+        storeFloatAsF16 = b;
+        loader->setStoreFloatAsF16(b);
+    }
+    // Convert samples to this rate as they load (see Sample::convertSampleRate); 0 for off
+    void setTargetSampleRate(uint32_t r)
+    {
+        targetSampleRate = r;
+        loader->setTargetSampleRate(r);
+    }
+    uint32_t getTargetSampleRate() const { return targetSampleRate; }
+    // Build octave mipmaps for each sample as it loads (see Sample::buildMipmaps)
+    void setBuildMipmaps(bool b)
+    {
+        buildMipmaps = b;
+        loader->setBuildMipmaps(b);
+    }
+    std::optional<SampleID> findSampleByFileAddress(const Sample::SampleFileAddress &) const;
+    SampleID installLoadedSample(const std::shared_ptr<Sample> &);
+    void cancelPendingLoads() { loader->cancelAll(); }
+
+    // If set, restoreFromSampleAddressesAndIDs reports progress here (from loader threads)
+    SampleLoader::progressCallback_t restoreProgressCallback{nullptr};
+
     void purgeUnreferencedSamples();
 
+    // Bytes of sample data not held in memory because of content dedupe
+    size_t getContentDedupeBytesSaved() const
+    {
+        std::shared_lock<std::shared_mutex> g(sampleMutex);
+        return contentDedupeBytesSaved;
+    }
+
     void reset()
     {
-        samples.clear();
+        {
+            std::unique_lock<std::shared_mutex> g(sampleMutex);
+            samples.clear();
+            idByPath.clear();
+            idBySF2Address.clear();
+            pathKeyById.clear();
+            idByContentHash.clear();
+            pendingSamples.clear();
+            contentDedupeBytesSaved = 0;
+        }
+        restoreGeneration++;
         sf2FilesByPath.clear();
         streamingVersion = 0x21120101;
     }
@@ -94,9 +233,65 @@ struct SampleManager : MoveableOnly<SampleManager>
     void resetMissingList() { missingList.clear(); }
 
     uint64_t streamingVersion{0x21120101}; // see comment in patch.h
-    std::unordered_map<SampleID, std::shared_ptr<Sample>> samples;
 
   private:
+    /*
+     * The sample set and its indices. The path index covers everything which isn't
+     * an sf2 and the sf2 index is keyed by (path, instrument, region). Paths are
+     * canonicalized so two spellings of a file are one sample. Canonicalizing touches
+     * the disk, so callers make the key before taking sampleMutex.
+     */
+    static std::string pathKey(const fs::path &);
+    struct SF2AddressKey
+    {
+        std::string path;
+        int instrument{-1}, region{-1};
+        bool operator==(const SF2AddressKey &o) const
+        {
+            return instrument == o.instrument && region == o.region && path == o.path;
+        }
+    };
+    struct SF2AddressKeyHash
+    {
+        size_t operator()(const SF2AddressKey &k) const
+        {
+            auto h = std::hash<std::string>()(k.path);
+            h ^= std::hash<int>()(k.instrument) + 0x9e3779b9 + (h << 6) + (h >> 2);
+            h ^= std::hash<int>()(k.region) + 0x9e3779b9 + (h << 6) + (h >> 2);
+            return h;
+        }
+    };
+    // Call these with sampleMutex held; key is pathKey of the address's path
+    std::optional<SampleID> findSampleByFileAddressLocked(const Sample::SampleFileAddress &,
+                                                          const std::string &key) const;
+    void addSampleLocked(const std::shared_ptr<Sample> &, const std::string &key);
+    void dedupeContentLocked(const std::shared_ptr<Sample> &);
+    size_t residentBytesLocked() const;
+
+    mutable std::shared_mutex sampleMutex;
+    std::unordered_map<SampleID, std::shared_ptr<Sample>> samples;
+    std::unordered_map<std::string, SampleID> idByPath;
+    std::unordered_map<SF2AddressKey, SampleID, SF2AddressKeyHash> idBySF2Address;
+    // the key each sample is indexed under, so purging needn't canonicalize again
+    std::unordered_map<SampleID, std::string> pathKeyById;
+    // content hash to the sample which owns that content's buffer
+    std::unordered_map<uint64_t, SampleID> idByContentHash;
+    size_t contentDedupeBytesSaved{0};
+    bool storeFloatAsF16{false};
+    std::atomic<uint32_t> targetSampleRate{0};
+    bool buildMipmaps{false};
+    // samples a lazy restore has asked for but not yet installed
+    std::unordered_map<SampleID, Sample::SampleFileAddress> pendingSamples;
+    std::atomic<uint64_t> restoreGeneration{0};
+
+    size_t memoryBudget{0};
+    uint32_t preloadFrames{32768};
+    uint64_t residencyEvictions{0}, residencyReloads{0};
+    std::atomic<uint64_t> residencyHits{0}, residencyMisses{0};
+
+    // the cache is declared first so it outlives the loader threads which use it
+    std::unique_ptr<SampleCache> sampleCache;
+    std::unique_ptr<SampleLoader> loader;
     std::unordered_map<std::string,
                        std::pair<std::unique_ptr<RIFF::File>, std::unique_ptr<sf2::File>>>
         sf2FilesByPath;
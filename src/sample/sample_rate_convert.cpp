@@ -0,0 +1,131 @@
+/*
+ * Shortcircuit XT - a Surge Synth Team product
+ *
+ * A fully featured creative sampler, available as a standalone
+ * and plugin for multiple platforms.
+ *
+ * Copyright 2019 - 2023, Various authors, as described in the github
+ * transaction log.
+ *
+ * ShortcircuitXT is released under the Gnu General Public Licence
+ * V3 or later (GPL-3.0-or-later). The license is found in the file
+ * "LICENSE" in the root of this repository or at
+ * https://www.gnu.org/licenses/gpl-3.0.en.html
+ *
+ * Individual sections of code which comprises ShortcircuitXT in this
+ * repository may also be used under an MIT license. Please see the
+ * section  "Licensing" in "README.md" for details.
+ *
+ * ShortcircuitXT is inspired by, and shares code with, the
+ * commercial product Shortcircuit 1 and 2, released by VemberTech
+ * in the mid 2000s. The code for Shortcircuit 2 was opensourced in
+ * 2020 at the outset of this project.
+ *
+ * All source for ShortcircuitXT is available at
+ * https://github.com/surge-synthesizer/shortcircuit-xt
+ */
+
+
+#include "sample_rate_convert.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace scxt::sample::rate
+{
+namespace
+{
+static constexpr int zeroCrossings{32};
+static constexpr int tablePointsPerCrossing{256};
+static constexpr int tableSize{zeroCrossings * tablePointsPerCrossing + 2};
+static constexpr double kaiserBeta{9.0};
+// Of the Nyquist frequency of the lower rate
+static constexpr double passband{0.95};
+
+double besselI0(double x)
+{
+    double sum{1.0}, term{1.0};
+    for (int k = 1; k < 64; ++k)
+    {
+        auto f = x / (2.0 * k);
+        term *= f * f;
+        sum += term;
+        if (term < sum * 1e-17)
+            break;
+    }
+    return sum;
+}
+
+/*
+ * One side of the windowed sinc, tablePointsPerCrossing points per zero crossing and
+ * read with linear interpolation. The last two points are zero so a read at the very
+ * edge of the window needs no check.
+ */
+struct KernelTable
+{
+    std::array<float, tableSize> h{};
+    KernelTable()
+    {
+        auto norm = 1.0 / besselI0(kaiserBeta);
+        auto n = zeroCrossings * tablePointsPerCrossing;
+        for (int k = 0; k < n; ++k)
+        {
+            auto x = 1.0 * k / tablePointsPerCrossing;
+            auto sinc = k == 0 ? 1.0 : std::sin(M_PI * x) / (M_PI * x);
+            auto r = x / zeroCrossings;
+            h[k] = (float)(sinc * besselI0(kaiserBeta * std::sqrt(1.0 - r * r)) * norm);
+        }
+        h[n] = 0.f;
+        h[n + 1] = 0.f;
+    }
+};
+
+const KernelTable &kernel()
+{
+    static KernelTable table;
+    return table;
+}
+} // namespace
+
+size_t outputLength(size_t inFrames, uint32_t fromRate, uint32_t toRate)
+{
+    if (fromRate == 0 || toRate == 0)
+        return 0;
+    return (size_t)(((uint64_t)inFrames * toRate + fromRate - 1) / fromRate);
+}
+
+void resample(const float *src, size_t inFrames, uint32_t fromRate, float *dest,
+              size_t outFrames, uint32_t toRate)
+{
+    const auto &h = kernel().h;
+
+    // Scaling the kernel by cutoff lowers it to the passband edge of the lower rate
+    auto cutoff = passband * std::min(1.0, 1.0 * toRate / fromRate);
+    auto halfWidth = zeroCrossings / cutoff;
+    auto tableScale = cutoff * tablePointsPerCrossing;
+    auto last = (int64_t)inFrames - 1;
+
+    for (size_t j = 0; j < outFrames; ++j)
+    {
+        // Keep the position exact however long the sample is
+        auto num = (uint64_t)j * fromRate;
+        auto t = (double)(num / toRate) + (double)(num % toRate) / toRate;
+
+        auto lo = std::max((int64_t)std::ceil(t - halfWidth), (int64_t)0);
+        auto hi = std::min((int64_t)std::floor(t + halfWidth), last);
+
+        double acc{0.0};
+        for (auto i = lo; i <= hi; ++i)
+        {
+            auto pos = std::fabs(t - i) * tableScale;
+            auto k = (int)pos;
+            if (k >= tableSize - 1)
+                continue;
+            auto f = (float)(pos - k);
+            acc += src[i] * (h[k] + f * (h[k + 1] - h[k]));
+        }
+        dest[j] = (float)(acc * cutoff);
+    }
+}
+} // namespace scxt::sample::rate
@@ -0,0 +1,54 @@
+/*
+ * Shortcircuit XT - a Surge Synth Team product
+ *
+ * A fully featured creative sampler, available as a standalone
+ * and plugin for multiple platforms.
+ *
+ * Copyright 2019 - 2023, Various authors, as described in the github
+ * transaction log.
+ *
+ * ShortcircuitXT is released under the Gnu General Public Licence
+ * V3 or later (GPL-3.0-or-later). The license is found in the file
+ * "LICENSE" in the root of this repository or at
+ * https://www.gnu.org/licenses/gpl-3.0.en.html
+ *
+ * Individual sections of code which comprises ShortcircuitXT in this
+ * repository may also be used under an MIT license. Please see the
+ * section  "Licensing" in "README.md" for details.
+ *
+ * ShortcircuitXT is inspired by, and shares code with, the
+ * commercial product Shortcircuit 1 and 2, released by VemberTech
+ * in the mid 2000s. The code for Shortcircuit 2 was opensourced in
+ * 2020 at the outset of this project.
+ *
+ * All source for ShortcircuitXT is available at
+ * https://github.com/surge-synthesizer/shortcircuit-xt
+ */
+
+
+#ifndef SCXT_SRC_SAMPLE_SAMPLE_RATE_CONVERT_H
+#define SCXT_SRC_SAMPLE_SAMPLE_RATE_CONVERT_H
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Offline sample rate conversion, for storing a sample at the engine rate rather
+ * than resampling it in every voice. This is a windowed sinc (a Kaiser window over
+ * 32 zero crossings each side of the lower of the two rates) evaluated at each
+ * output frame, so it costs far more per frame than the voice interpolator but
+ * leaves nothing audible behind: the passband runs to 95% of the lower Nyquist and
+ * the stopband is about 90dB down. Frames before the start and past the end of the
+ * source are taken as silence.
+ */
+namespace scxt::sample::rate
+{
+// The number of frames inFrames at fromRate becomes at toRate
+size_t outputLength(size_t inFrames, uint32_t fromRate, uint32_t toRate);
+
+// Output frame j lands on source frame j * fromRate / toRate
+void resample(const float *src, size_t inFrames, uint32_t fromRate, float *dest,
+              size_t outFrames, uint32_t toRate);
+} // namespace scxt::sample::rate
+
+#endif // SHORTCIRCUITXT_SAMPLE_RATE_CONVERT_H
@@ -0,0 +1,247 @@
+/*
+ * Shortcircuit XT - a Surge Synth Team product
+ *
+ * A fully featured creative sampler, available as a standalone
+ * and plugin for multiple platforms.
+ *
+ * Copyright 2019 - 2023, Various authors, as described in the github
+ * transaction log.
+ *
+ * ShortcircuitXT is released under the Gnu General Public Licence
+ * V3 or later (GPL-3.0-or-later). The license is found in the file
+ * "LICENSE" in the root of this repository or at
+ * https://www.gnu.org/licenses/gpl-3.0.en.html
+ *
+ * Individual sections of code which comprises ShortcircuitXT in this
+ * repository may also be used under an MIT license. Please see the
+ * section  "Licensing" in "README.md" for details.
+ *
+ * ShortcircuitXT is inspired by, and shares code with, the
+ * commercial product Shortcircuit 1 and 2, released by VemberTech
+ * in the mid 2000s. The code for Shortcircuit 2 was opensourced in
+ * 2020 at the outset of this project.
+ *
+ * All source for ShortcircuitXT is available at
+ * https://github.com/surge-synthesizer/shortcircuit-xt
+ */
+
+#ifndef SCXT_SRC_SAMPLE_SAMPLE_RECORD_H
+#define SCXT_SRC_SAMPLE_SAMPLE_RECORD_H
+
+#include "sample.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace scxt::sample::detail
+{
+/*
+ * The little binary records our on-disk sample formats (the decoded sample cache
+ * and monolith bundles) are made of. Values are written in native byte order;
+ * both formats are for the machine, or at least the architecture, that wrote them.
+ */
+struct HeaderWriter
+{
+    std::vector<uint8_t> data;
+    template <typename T> void value(const T &v)
+    {
+        auto p = reinterpret_cast<const uint8_t *>(&v);
+        data.insert(data.end(), p, p + sizeof(T));
+    }
+    void bytes(const void *v, size_t n)
+    {
+        auto p = static_cast<const uint8_t *>(v);
+        data.insert(data.end(), p, p + n);
+    }
+    void string(const std::string &s)
+    {
+        value((uint32_t)s.size());
+        bytes(s.data(), s.size());
+    }
+};
+
+struct HeaderReader
+{
+    const uint8_t *p{nullptr};
+    size_t left{0};
+    bool ok{true};
+
+    HeaderReader(const std::vector<uint8_t> &d) : p(d.data()), left(d.size()) {}
+    HeaderReader(const uint8_t *d, size_t n) : p(d), left(n) {}
+    template <typename T> T value()
+    {
+        T res{};
+        bytes(&res, sizeof(T));
+        return res;
+    }
+    void bytes(void *to, size_t n)
+    {
+        if (!ok || n > left)
+        {
+            ok = false;
+            return;
+        }
+        memcpy(to, p, n);
+        p += n;
+        left -= n;
+    }
+    // Step over n bytes, returning where they start (or null if there aren't n left)
+    const uint8_t *span(size_t n)
+    {
+        if (!ok || n > left)
+        {
+            ok = false;
+            return nullptr;
+        }
+        auto res = p;
+        p += n;
+        left -= n;
+        return res;
+    }
+    std::string string()
+    {
+        auto n = value<uint32_t>();
+        if (!ok || n > left)
+        {
+            ok = false;
+            return {};
+        }
+        std::string res((const char *)p, n);
+        p += n;
+        left -= n;
+        return res;
+    }
+};
+
+/*
+ * The layout of a sample's data and its descriptive metadata. Reading one touches
+ * no sample, so the caller can check the layout (and allocate and verify against
+ * it) first, then applySampleDescription fills in the source rate and length,
+ * name, display name and meta.
+ */
+struct SampleDescription
+{
+    Sample::SourceType type{Sample::WAV_FILE};
+    Sample::BitDepth bitDepth{Sample::BD_F32};
+    int32_t channels{0};
+    uint32_t sampleLength{0};
+    uint32_t sampleRate{0};
+    uint64_t contentHash{0};
+
+    uint32_t sourceSampleRate{0}, sourceSampleLength{0};
+    char name[sizeof(Sample::name)]{};
+    std::string displayName;
+    decltype(Sample::meta) meta{}; // with the slices held below rather than in its pointers
+    std::vector<int32_t> sliceStart, sliceEnd;
+};
+
+inline void writeSampleDescription(HeaderWriter &w, const Sample &s)
+{
+    w.value((int32_t)s.type);
+    w.value((int32_t)s.bitDepth);
+    w.value((int32_t)s.channels);
+    w.value((uint32_t)s.sample_length);
+    w.value((uint32_t)s.sample_rate);
+    w.value((uint64_t)s.contentHash);
+    w.value((uint32_t)s.sourceSampleRate);
+    w.value((uint32_t)s.sourceSampleLength);
+    w.bytes(s.name, sizeof(s.name));
+    w.string(s.displayName);
+    const auto &m = s.meta;
+    w.value(m.key_low);
+    w.value(m.key_high);
+    w.value(m.key_root);
+    w.value(m.vel_low);
+    w.value(m.vel_high);
+    w.value((uint8_t)m.playmode);
+    w.value(m.detune);
+    w.value((uint32_t)m.loop_start);
+    w.value((uint32_t)m.loop_end);
+    w.value((uint8_t)m.rootkey_present);
+    w.value((uint8_t)m.key_present);
+    w.value((uint8_t)m.vel_present);
+    w.value((uint8_t)m.loop_present);
+    w.value((uint8_t)m.playmode_present);
+    w.value((int32_t)m.n_beats);
+    auto nSlices = (m.slice_start && m.slice_end) ? m.n_slices : 0;
+    w.value((int32_t)nSlices);
+    for (int i = 0; i < nSlices; ++i)
+        w.value((int32_t)m.slice_start[i]);
+    for (int i = 0; i < nSlices; ++i)
+        w.value((int32_t)m.slice_end[i]);
+}
+
+inline std::optional<SampleDescription> readSampleDescription(HeaderReader &r)
+{
+    SampleDescription d;
+    d.type = (Sample::SourceType)r.value<int32_t>();
+    d.bitDepth = (Sample::BitDepth)r.value<int32_t>();
+    d.channels = r.value<int32_t>();
+    d.sampleLength = r.value<uint32_t>();
+    d.sampleRate = r.value<uint32_t>();
+    d.contentHash = r.value<uint64_t>();
+    if (!r.ok || d.channels < 1 || d.channels > 2)
+        return std::nullopt;
+
+    d.sourceSampleRate = r.value<uint32_t>();
+    d.sourceSampleLength = r.value<uint32_t>();
+    r.bytes(d.name, sizeof(d.name));
+    d.displayName = r.string();
+    auto &m = d.meta;
+    m.key_low = r.value<char>();
+    m.key_high = r.value<char>();
+    m.key_root = r.value<char>();
+    m.vel_low = r.value<char>();
+    m.vel_high = r.value<char>();
+    m.playmode = (Sample::PlayMode)r.value<uint8_t>();
+    m.detune = r.value<float>();
+    m.loop_start = r.value<uint32_t>();
+    m.loop_end = r.value<uint32_t>();
+    m.rootkey_present = r.value<uint8_t>();
+    m.key_present = r.value<uint8_t>();
+    m.vel_present = r.value<uint8_t>();
+    m.loop_present = r.value<uint8_t>();
+    m.playmode_present = r.value<uint8_t>();
+    m.n_beats = r.value<int32_t>();
+    auto nSlices = r.value<int32_t>();
+    if (!r.ok || nSlices < 0 || (size_t)nSlices * 8 > r.left)
+        return std::nullopt;
+    d.sliceStart.resize(nSlices);
+    d.sliceEnd.resize(nSlices);
+    for (auto &v : d.sliceStart)
+        v = r.value<int32_t>();
+    for (auto &v : d.sliceEnd)
+        v = r.value<int32_t>();
+    if (!r.ok)
+        return std::nullopt;
+    return d;
+}
+
+inline void applySampleDescription(const SampleDescription &d, Sample &s)
+{
+    s.sourceSampleRate = d.sourceSampleRate;
+    s.sourceSampleLength = d.sourceSampleLength;
+    memcpy(s.name, d.name, sizeof(s.name));
+    s.displayName = d.displayName;
+
+    delete[] s.meta.slice_start;
+    delete[] s.meta.slice_end;
+    s.meta = d.meta;
+    s.meta.n_slices = (int)d.sliceStart.size();
+    s.meta.slice_start = nullptr;
+    s.meta.slice_end = nullptr;
+    if (!d.sliceStart.empty())
+    {
+        s.meta.slice_start = new int[d.sliceStart.size()];
+        s.meta.slice_end = new int[d.sliceEnd.size()];
+        std::copy(d.sliceStart.begin(), d.sliceStart.end(), s.meta.slice_start);
+        std::copy(d.sliceEnd.begin(), d.sliceEnd.end(), s.meta.slice_end);
+    }
+}
+} // namespace scxt::sample::detail
+
+#endif // SHORTCIRCUITXT_SAMPLE_RECORD_H
@@ -0,0 +1,205 @@
+/*
+ * Shortcircuit XT - a Surge Synth Team product
+ *
+ * A fully featured creative sampler, available as a standalone
+ * and plugin for multiple platforms.
+ *
+ * Copyright 2019 - 2023, Various authors, as described in the github
+ * transaction log.
+ *
+ * ShortcircuitXT is released under the Gnu General Public Licence
+ * V3 or later (GPL-3.0-or-later). The license is found in the file
+ * "LICENSE" in the root of this repository or at
+ * https://www.gnu.org/licenses/gpl-3.0.en.html
+ *
+ * Individual sections of code which comprises ShortcircuitXT in this
+ * repository may also be used under an MIT license. Please see the
+ * section  "Licensing" in "README.md" for details.
+ *
+ * ShortcircuitXT is inspired by, and shares code with, the
+ * commercial product Shortcircuit 1 and 2, released by VemberTech
+ * in the mid 2000s. The code for Shortcircuit 2 was opensourced in
+ * 2020 at the outset of this project.
+ *
+ * All source for ShortcircuitXT is available at
+ * https://github.com/surge-synthesizer/shortcircuit-xt
+ */
+
+
+#include "sf2_mapped_data.h"
+#include "dsp/resampling.h"
+
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace scxt::sample
+{
+namespace
+{
+bool hostIsLittleEndian()
+{
+    uint16_t x{1};
+    uint8_t b;
+    memcpy(&b, &x, 1);
+    return b == 1;
+}
+
+uint32_t readU32(const uint8_t *p)
+{
+    uint32_t res;
+    memcpy(&res, p, sizeof(res));
+    return res;
+}
+
+uint16_t readU16(const uint8_t *p)
+{
+    uint16_t res;
+    memcpy(&res, p, sizeof(res));
+    return res;
+}
+
+/*
+ * Call f(id, body, size) for each chunk in [p, end), stopping early if f returns true.
+ * Chunks are word aligned so odd sizes have a pad byte.
+ */
+template <typename F> void forEachChunk(const uint8_t *p, const uint8_t *end, F f)
+{
+    while (end - p >= 8)
+    {
+        auto sz = (size_t)readU32(p + 4);
+        auto body = p + 8;
+        if ((size_t)(end - body) < sz)
+            return;
+        if (f(p, body, sz))
+            return;
+        p = body + sz + (sz & 1);
+    }
+}
+
+bool isID(const uint8_t *p, const char *id) { return memcmp(p, id, 4) == 0; }
+} // namespace
+
+std::shared_ptr<const SF2MappedData> SF2MappedData::forFile(const fs::path &p)
+{
+    static std::mutex registryMutex;
+    static std::unordered_map<std::string, std::weak_ptr<const SF2MappedData>> registry;
+
+    if (!hostIsLittleEndian())
+        return nullptr;
+
+    std::error_code ec;
+    auto key = fs::weakly_canonical(p, ec).u8string();
+    if (ec)
+        key = p.lexically_normal().u8string();
+
+    std::lock_guard<std::mutex> g(registryMutex);
+    auto r = registry.find(key);
+    if (r != registry.end())
+    {
+        auto res = r->second.lock();
+        if (res)
+            return res;
+    }
+
+    for (auto it = registry.begin(); it != registry.end();)
+    {
+        if (it->second.expired())
+            it = registry.erase(it);
+        else
+            ++it;
+    }
+
+    auto res = std::make_shared<SF2MappedData>(p);
+    if (!res->parse())
+        return nullptr;
+    registry[key] = res;
+    return res;
+}
+
+SF2MappedData::SF2MappedData(const fs::path &p)
+    : view(std::make_unique<infrastructure::FileMapView>(p))
+{
+}
+
+bool SF2MappedData::parse()
+{
+    if (!view->isMapped() || view->dataSize() < 12)
+        return false;
+
+    auto base = (const uint8_t *)view->data();
+    if (!isID(base, "RIFF") || !isID(base + 8, "sfbk"))
+        return false;
+
+    auto riffEnd = base + std::min((size_t)readU32(base + 4) + 8, view->dataSize());
+    const uint8_t *shdr{nullptr};
+    size_t shdrSize{0};
+    forEachChunk(base + 12, riffEnd, [&](auto ck, auto body, auto sz) {
+        if (!isID(ck, "LIST") || sz < 4)
+            return false;
+        forEachChunk(body + 4, body + sz, [&](auto sck, auto sbody, auto ssz) {
+            if (isID(body, "sdta") && isID(sck, "smpl"))
+            {
+                smpl = (const int16_t *)sbody;
+                smplFrames = ssz / 2;
+            }
+            else if (isID(body, "sdta") && isID(sck, "sm24"))
+            {
+                hasSm24 = true;
+            }
+            else if (isID(body, "pdta") && isID(sck, "shdr"))
+            {
+                shdr = sbody;
+                shdrSize = ssz;
+            }
+            return false;
+        });
+        return false;
+    });
+
+    if (!smpl || !shdr || hasSm24 || ((uintptr_t)smpl & 1))
+        return false;
+
+    // 46 byte records, the last of which is the terminal EOS record
+    static constexpr size_t recordSize{46};
+    auto n = shdrSize / recordSize;
+    for (size_t i = 0; i + 1 < n; ++i)
+    {
+        auto r = shdr + i * recordSize;
+        SampleHeader h;
+        h.start = readU32(r + 20);
+        h.end = readU32(r + 24);
+        h.startLoop = readU32(r + 28);
+        h.endLoop = readU32(r + 32);
+        h.sampleRate = readU32(r + 36);
+        h.sampleType = readU16(r + 44);
+        headers.push_back(h);
+    }
+    return true;
+}
+
+const int16_t *SF2MappedData::paddedSampleData(size_t idx) const
+{
+    if (idx >= headers.size())
+        return nullptr;
+
+    const auto &h = headers[idx];
+    static constexpr size_t lead{scxt::dsp::FIRoffset};
+    static constexpr size_t tail{scxt::dsp::FIRipol_N - scxt::dsp::FIRoffset};
+    if (h.end <= h.start || h.start < lead || (size_t)h.end + tail > smplFrames)
+        return nullptr;
+
+    for (size_t i = 0; i < lead; ++i)
+    {
+        if (smpl[h.start - lead + i] != 0)
+            return nullptr;
+    }
+    for (size_t i = 0; i < tail; ++i)
+    {
+        if (smpl[h.end + i] != 0)
+            return nullptr;
+    }
+    return smpl + h.start - lead;
+}
+} // namespace scxt::sample
@@ -0,0 +1,93 @@
+/*
+ * Shortcircuit XT - a Surge Synth Team product
+ *
+ * A fully featured creative sampler, available as a standalone
+ * and plugin for multiple platforms.
+ *
+ * Copyright 2019 - 2023, Various authors, as described in the github
+ * transaction log.
+ *
+ * ShortcircuitXT is released under the Gnu General Public Licence
+ * V3 or later (GPL-3.0-or-later). The license is found in the file
+ * "LICENSE" in the root of this repository or at
+ * https://www.gnu.org/licenses/gpl-3.0.en.html
+ *
+ * Individual sections of code which comprises ShortcircuitXT in this
+ * repository may also be used under an MIT license. Please see the
+ * section  "Licensing" in "README.md" for details.
+ *
+ * ShortcircuitXT is inspired by, and shares code with, the
+ * commercial product Shortcircuit 1 and 2, released by VemberTech
+ * in the mid 2000s. The code for Shortcircuit 2 was opensourced in
+ * 2020 at the outset of this project.
+ *
+ * All source for ShortcircuitXT is available at
+ * https://github.com/surge-synthesizer/shortcircuit-xt
+ */
+
+
+#ifndef SCXT_SRC_SAMPLE_SF2_MAPPED_DATA_H
+#define SCXT_SRC_SAMPLE_SF2_MAPPED_DATA_H
+
+#include "utils.h"
+#include "infrastructure/filesystem_import.h"
+#include "infrastructure/file_map_view.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace scxt::sample
+{
+/**
+ * A read only memory map of an SF2 file's sample data. Every sample in an SF2
+ * is 16 bit little endian PCM in the one `smpl` chunk, with the spec requiring
+ * 46 zero points after each, so a mono sample can point straight at its slice
+ * of the map (see Sample::loadFromSF2) instead of copying it into its own buffer.
+ * The map then lives as long as any sample using it, and the OS shares its
+ * pages between every instance which has the file open.
+ *
+ * We walk the RIFF structure ourselves for the `smpl` chunk and the `shdr`
+ * sample headers; libgig's sample n is our header n.
+ */
+struct SF2MappedData : MoveableOnly<SF2MappedData>
+{
+    struct SampleHeader
+    {
+        uint32_t start{0}, end{0}; // frames from the start of smpl; end is exclusive
+        uint32_t startLoop{0}, endLoop{0};
+        uint32_t sampleRate{0};
+        uint16_t sampleType{0};
+    };
+
+    /**
+     * Get the map for a file, sharing one already open if there is one. Returns
+     * null if the file can't be mapped or isn't an SF2 we can reference directly
+     * (for instance it has 24 bit sm24 data). Safe from any thread.
+     */
+    static std::shared_ptr<const SF2MappedData> forFile(const fs::path &);
+
+    /**
+     * The data for header idx with the generator's padding around it (FIRoffset
+     * frames before, FIRipol_N - FIRoffset after, all of which must be zero) or
+     * null if the file doesn't have that padding for this sample and it needs a copy.
+     */
+    const int16_t *paddedSampleData(size_t idx) const;
+
+    const std::vector<SampleHeader> &getSampleHeaders() const { return headers; }
+    size_t getSampleFrameCount() const { return smplFrames; }
+
+    explicit SF2MappedData(const fs::path &);
+
+  private:
+    bool parse();
+
+    std::unique_ptr<infrastructure::FileMapView> view;
+    const int16_t *smpl{nullptr};
+    size_t smplFrames{0};
+    bool hasSm24{false};
+    std::vector<SampleHeader> headers;
+};
+} // namespace scxt::sample
+
+#endif // SHORTCIRCUITXT_SF2_MAPPED_DATA_H
@@ -0,0 +1,210 @@
+/*
+ * Shortcircuit XT - a Surge Synth Team product
+ *
+ * A fully featured creative sampler, available as a standalone
+ * and plugin for multiple platforms.
+ *
+ * Copyright 2019 - 2023, Various authors, as described in the github
+ * transaction log.
+ *
+ * ShortcircuitXT is released under the Gnu General Public Licence
+ * V3 or later (GPL-3.0-or-later). The license is found in the file
+ * "LICENSE" in the root of this repository or at
+ * https://www.gnu.org/licenses/gpl-3.0.en.html
+ *
+ * Individual sections of code which comprises ShortcircuitXT in this
+ * repository may also be used under an MIT license. Please see the
+ * section  "Licensing" in "README.md" for details.
+ *
+ * ShortcircuitXT is inspired by, and shares code with, the
+ * commercial product Shortcircuit 1 and 2, released by VemberTech
+ * in the mid 2000s. The code for Shortcircuit 2 was opensourced in
+ * 2020 at the outset of this project.
+ *
+ * All source for ShortcircuitXT is available at
+ * https://github.com/surge-synthesizer/shortcircuit-xt
+ */
+
+
+#include "waveform_summary.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#include "sample.h"
+#include "dsp/resampling.h"
+#include "infrastructure/half_float.h"
+
+namespace scxt::sample
+{
+namespace
+{
+// Call f(value) for frames [from, to) of a channel, whatever the storage
+template <typename F>
+void forEachValue(const Sample &s, int channel, size_t from, size_t to, F &&f)
+{
+    auto raw = s.sampleData[channel];
+    if (!raw)
+        return;
+    switch (s.bitDepth)
+    {
+    case Sample::BD_I16:
+    {
+        auto d = (const int16_t *)raw + dsp::FIRoffset;
+        for (auto i = from; i < to; ++i)
+            f(d[i] * (1.f / 32768.f));
+    }
+    break;
+    case Sample::BD_F32:
+    {
+        auto d = (const float *)raw + dsp::FIRoffset;
+        for (auto i = from; i < to; ++i)
+            f(d[i]);
+    }
+    break;
+    case Sample::BD_F16:
+    {
+        auto d = (const uint16_t *)raw + dsp::FIRoffset;
+        for (auto i = from; i < to; ++i)
+            f(infrastructure::halfToFloat(d[i]));
+    }
+    break;
+    }
+}
+} // namespace
+
+std::shared_ptr<WaveformSummary> WaveformSummary::build(const Sample &s)
+{
+    auto res = std::make_shared<WaveformSummary>();
+    res->sampleLength = s.getSampleLength();
+    res->channels = std::min((int)s.channels, 2);
+    if (res->sampleLength == 0)
+        return res;
+
+    auto nBuckets = (res->sampleLength + baseBlock - 1) / baseBlock;
+    res->levels.emplace_back();
+    for (int c = 0; c < res->channels; ++c)
+    {
+        auto &l0 = res->levels[0][c];
+        l0.resize(nBuckets);
+        for (size_t b = 0; b < nBuckets; ++b)
+        {
+            float mn = std::numeric_limits<float>::max();
+            float mx = std::numeric_limits<float>::lowest();
+            double sq{0};
+            auto from = b * baseBlock;
+            auto to = std::min(from + baseBlock, res->sampleLength);
+            forEachValue(s, c, from, to, [&](float v) {
+                mn = std::min(mn, v);
+                mx = std::max(mx, v);
+                sq += (double)v * v;
+            });
+            l0[b] = {mn, mx, (float)sq};
+        }
+    }
+
+    while (res->levels.back()[0].size() > 1)
+    {
+        auto &prev = res->levels.back();
+        std::array<std::vector<Bucket>, 2> next;
+        for (int c = 0; c < res->channels; ++c)
+        {
+            auto &p = prev[c];
+            auto &n = next[c];
+            n.resize((p.size() + 1) / 2);
+            for (size_t b = 0; b < n.size(); ++b)
+            {
+                n[b] = p[2 * b];
+                if (2 * b + 1 < p.size())
+                {
+                    auto &o = p[2 * b + 1];
+                    n[b].min = std::min(n[b].min, o.min);
+                    n[b].max = std::max(n[b].max, o.max);
+                    n[b].sumSquares += o.sumSquares;
+                }
+            }
+        }
+        res->levels.push_back(std::move(next));
+    }
+    return res;
+}
+
+std::vector<WaveformSummary::Span> WaveformSummary::spansForPixels(const Sample &s, int channel,
+                                                                   size_t start, size_t end,
+                                                                   int pixels) const
+{
+    std::vector<Span> res;
+    if (pixels <= 0 || channel < 0 || channel >= channels || levels.empty())
+        return res;
+    end = std::min(end, sampleLength);
+    if (start >= end)
+        return res;
+
+    res.resize(pixels);
+    auto framesPerPixel = 1.0 * (end - start) / pixels;
+
+    // Pick the level once, from the nominal pixel width, so the spans are consistent
+    size_t level{0};
+    while (level + 1 < levels.size() && (baseBlock << (level + 1)) <= framesPerPixel)
+        level++;
+    auto bucketSize = baseBlock << level;
+    const auto &buckets = levels[level][channel];
+
+    for (int p = 0; p < pixels; ++p)
+    {
+        auto from = start + (size_t)(p * framesPerPixel);
+        auto to = std::min(end, std::max(from + 1, start + (size_t)((p + 1) * framesPerPixel)));
+        if (from >= end)
+        {
+            res[p] = p > 0 ? res[p - 1] : Span{};
+            continue;
+        }
+
+        float mn = std::numeric_limits<float>::max();
+        float mx = std::numeric_limits<float>::lowest();
+        double sq{0};
+        size_t counted{0};
+        if (framesPerPixel < baseBlock)
+        {
+            // a residency head only holds the start of the data the summary covers
+            auto rawTo = std::min(to, (size_t)s.getSampleLength());
+            if (from >= rawTo)
+            {
+                res[p] = Span{};
+                continue;
+            }
+            forEachValue(s, channel, from, rawTo, [&](float v) {
+                mn = std::min(mn, v);
+                mx = std::max(mx, v);
+                sq += (double)v * v;
+            });
+            counted = rawTo - from;
+        }
+        else
+        {
+            auto b0 = from / bucketSize;
+            auto b1 = std::min(buckets.size(), (to + bucketSize - 1) / bucketSize);
+            for (auto b = b0; b < b1; ++b)
+            {
+                mn = std::min(mn, buckets[b].min);
+                mx = std::max(mx, buckets[b].max);
+                sq += buckets[b].sumSquares;
+            }
+            counted = std::min(b1 * bucketSize, sampleLength) - b0 * bucketSize;
+        }
+        res[p] = {mn, mx, counted ? (float)std::sqrt(sq / counted) : 0.f};
+    }
+    return res;
+}
+
+size_t WaveformSummary::getMemoryBytes() const
+{
+    size_t res{sizeof(*this)};
+    for (const auto &l : levels)
+        for (const auto &c : l)
+            res += c.capacity() * sizeof(Bucket);
+    return res;
+}
+} // namespace scxt::sample
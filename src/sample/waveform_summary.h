@@ -0,0 +1,86 @@
+/*
+ * Shortcircuit XT - a Surge Synth Team product
+ *
+ * A fully featured creative sampler, available as a standalone
+ * and plugin for multiple platforms.
+ *
+ * Copyright 2019 - 2023, Various authors, as described in the github
+ * transaction log.
+ *
+ * ShortcircuitXT is released under the Gnu General Public Licence
+ * V3 or later (GPL-3.0-or-later). The license is found in the file
+ * "LICENSE" in the root of this repository or at
+ * https://www.gnu.org/licenses/gpl-3.0.en.html
+ *
+ * Individual sections of code which comprises ShortcircuitXT in this
+ * repository may also be used under an MIT license. Please see the
+ * section  "Licensing" in "README.md" for details.
+ *
+ * ShortcircuitXT is inspired by, and shares code with, the
+ * commercial product Shortcircuit 1 and 2, released by VemberTech
+ * in the mid 2000s. The code for Shortcircuit 2 was opensourced in
+ * 2020 at the outset of this project.
+ *
+ * All source for ShortcircuitXT is available at
+ * https://github.com/surge-synthesizer/shortcircuit-xt
+ */
+
+
+#ifndef SCXT_SRC_SAMPLE_WAVEFORM_SUMMARY_H
+#define SCXT_SRC_SAMPLE_WAVEFORM_SUMMARY_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace scxt::sample
+{
+struct Sample;
+
+/*
+ * A min / max / RMS pyramid of a sample's data, for drawing. Level 0 summarizes
+ * blocks of baseBlock frames and each level above halves the bucket count, so
+ * a view of any width can be drawn by touching a couple of buckets per pixel
+ * rather than every frame.
+ *
+ * A summary is immutable once built; Sample hands them out as shared pointers
+ * so the UI can hold one while the engine replaces or drops the sample.
+ */
+struct WaveformSummary
+{
+    static constexpr size_t baseBlock{64};
+
+    struct Bucket
+    {
+        float min{0.f}, max{0.f};
+        float sumSquares{0.f};
+    };
+
+    struct Span
+    {
+        float min{0.f}, max{0.f}, rms{0.f};
+    };
+
+    size_t sampleLength{0};
+    int channels{0};
+    // levels[k][channel] has buckets of (baseBlock << k) frames; the last may be partial
+    std::vector<std::array<std::vector<Bucket>, 2>> levels;
+
+    static std::shared_ptr<WaveformSummary> build(const Sample &s);
+
+    /*
+     * One span per pixel covering frames [start, end) of a channel. Zoomed out, this
+     * reads from the coarsest level whose buckets still fit in a pixel, so pixel
+     * edges snap to bucket edges; zoomed in past baseBlock frames per pixel it reads
+     * the sample itself, which must be the one this summary was built from.
+     */
+    std::vector<Span> spansForPixels(const Sample &s, int channel, size_t start, size_t end,
+                                     int pixels) const;
+
+    size_t getMemoryBytes() const;
+};
+} // namespace scxt::sample
+
+#endif // SHORTCIRCUITXT_WAVEFORM_SUMMARY_H
@@ -566,6 +566,10 @@ void SelectionManager::copyZoneProcessorLeadToAll(int which)
     if (allSelectedZones.size() < 2)
         return;
 
+    const auto &lead = engine.getPatch()->getPart(lz->part)->getGroup(lz->group)->getZone(lz->zone);
+    engine.reserveProcessorMemory(lead->processorStorage[which].type, true,
+                                  allSelectedZones.size() - 1);
+
     auto &cont = engine.getMessageController();
     cont->scheduleAudioThreadCallback(
         [asz = allSelectedZones, from = *lz, which](auto &e) {
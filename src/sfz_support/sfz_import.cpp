@@ -42,20 +42,70 @@ int parseMidiNote(const std::string &s)
     return std::atol(s.c_str());
 }
 
-bool importSFZ(const fs::path &f, engine::Engine &e)
+std::string regionSampleFile(const SFZParser::opCodes_t &list)
 {
-    assert(e.getMessageController()->threadingChecker.isSerialThread());
+    std::string sampleFile = "<-->";
+    for (auto &oc : list)
+    {
+        if (oc.name == "sample")
+        {
+            sampleFile = oc.value;
+        }
+    }
+    // fs always works with / and on windows also works with back
+    std::replace(sampleFile.begin(), sampleFile.end(), '\\', '/');
+    return sampleFile;
+}
 
+std::vector<fs::path> findSFZSamplePaths(const fs::path &f)
+{
     SFZParser parser;
 
     auto doc = parser.parse(f);
     auto rootDir = f.parent_path();
     auto sampleDir = rootDir;
-    SCLOG(SCD(rootDir.u8string()));
 
-    auto pt = std::clamp(e.getSelectionManager()->selectedPart, 0, (int)numParts);
+    std::vector<fs::path> res;
+    for (const auto &[r, list] : doc)
+    {
+        if (r.type == SFZParser::Header::control)
+        {
+            for (const auto &oc : list)
+            {
+                if (oc.name == "default_path")
+                {
+                    auto vv = oc.value;
+                    std::replace(vv.begin(), vv.end(), '\\', '/');
+                    sampleDir = rootDir / vv;
+                }
+            }
+        }
+        else if (r.type == SFZParser::Header::region)
+        {
+            auto sampleFile = regionSampleFile(list);
+            if (fs::exists(sampleDir / sampleFile))
+                res.push_back(sampleDir / sampleFile);
+            else if (fs::exists(sampleFile))
+                res.push_back(sampleFile);
+        }
+    }
+
+    // regions commonly share samples
+    std::sort(res.begin(), res.end());
+    res.erase(std::unique(res.begin(), res.end()), res.end());
+    return res;
+}
 
-    auto &part = e.getPatch()->getPart(pt);
+bool importSFZ(const fs::path &f, engine::Engine &e, engine::Part &part, int &firstGroup)
+{
+    assert(e.getMessageController()->threadingChecker.isSerialThread());
+
+    SFZParser parser;
+
+    auto doc = parser.parse(f);
+    auto rootDir = f.parent_path();
+    auto sampleDir = rootDir;
+    SCLOG(SCD(rootDir.u8string()));
 
     int groupId = -1;
     int firstGroupWithZonesAdded = -1;
@@ -69,8 +119,8 @@ bool importSFZ(const fs::path &f, engine::Engine &e)
         {
         case SFZParser::Header::group:
         {
-            groupId = part->addGroup() - 1;
-            auto &group = part->getGroup(groupId);
+            groupId = part.addGroup() - 1;
+            auto &group = part.getGroup(groupId);
             for (auto &oc : list)
             {
                 if (oc.name == "group_label" || oc.name == "name")
@@ -88,21 +138,12 @@ bool importSFZ(const fs::path &f, engine::Engine &e)
         {
             if (groupId < 0)
             {
-                groupId = part->addGroup() - 1;
+                groupId = part.addGroup() - 1;
             }
-            auto &group = part->getGroup(groupId);
+            auto &group = part.getGroup(groupId);
 
             // Find the sample
-            std::string sampleFile = "<-->";
-            for (auto &oc : list)
-            {
-                if (oc.name == "sample")
-                {
-                    sampleFile = oc.value;
-                }
-            }
-            // fs always works with / and on windows also works with back
-            std::replace(sampleFile.begin(), sampleFile.end(), '\\', '/');
+            auto sampleFile = regionSampleFile(list);
             if (!fs::exists(sampleDir / sampleFile) && !fs::exists(sampleFile))
             {
                 SCLOG("Cannot find SampleFile [" << (sampleDir / sampleFile).u8string() << "]");
@@ -210,8 +251,7 @@ bool importSFZ(const fs::path &f, engine::Engine &e)
         }
     }
 
-    e.getSelectionManager()->selectAction(selection::SelectionManager::SelectActionContents(
-        pt, firstGroupWithZonesAdded, 0, true, true, true));
+    firstGroup = firstGroupWithZonesAdded;
     return true;
 }
 } // namespace scxt::sfz_support
\ No newline at end of file
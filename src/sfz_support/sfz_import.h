@@ -33,7 +33,17 @@
 
 namespace scxt::sfz_support
 {
-bool importSFZ(const fs::path &, engine::Engine &);
+/*
+ * Import an sfz into part, which is normally a detached part from
+ * Engine::makeDetachedPart. firstGroup is set to the first group which got zones.
+ */
+bool importSFZ(const fs::path &, engine::Engine &, engine::Part &part, int &firstGroup);
+
+/*
+ * The resolved, existing sample files an sfz refers to, without importing
+ * anything. Used to pre-load the samples in parallel ahead of importSFZ.
+ */
+std::vector<fs::path> findSFZSamplePaths(const fs::path &);
 }
 
 #endif // SHORTCIRCUITXT_SFZ_IMPORT_H
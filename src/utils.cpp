@@ -66,8 +66,10 @@ void printStackTrace(int fd) { SCLOG("printStackTrace unavailable on this platfo
 
 #if USE_SIMPLE_LEAK_DETECTOR
 std::map<std::string, std::pair<int, int>> allocLog;
+std::mutex allocLogMutex;
 void showLeakLog()
 {
+    std::lock_guard<std::mutex> g(allocLogMutex);
     for (const auto &[k, v] : allocLog)
     {
         auto [a, d] = v;
@@ -38,6 +38,7 @@
 
 #include <iostream>
 #include <map>
+#include <mutex>
 #include <thread>
 #include "unordered_map"
 #include "filesystem/import.h"
@@ -95,6 +96,7 @@ template <> inline const std::string EngineID::display_name() const { return "En
 #define USE_SIMPLE_LEAK_DETECTOR 1
 #if USE_SIMPLE_LEAK_DETECTOR
 extern std::map<std::string, std::pair<int, int>> allocLog;
+extern std::mutex allocLogMutex; // samples (and more) are created on loader threads
 void showLeakLog();
 #else
 inline void showLeakLog() {}
@@ -132,6 +134,7 @@ template <typename T> class LeakDetected
     void leakDetect(int dir)
     {
         auto tn = typeid(T).name();
+        std::lock_guard<std::mutex> g(allocLogMutex);
         if (dir == 1)
             allocLog[tn].first++;
         else if (dir == -1)
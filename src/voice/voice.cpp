@@ -33,6 +33,7 @@
 #include "sst/basic-blocks/mechanics/block-ops.h"
 #include "sst/basic-blocks/dsp/PanLaws.h"
 #include "engine/engine.h"
+#include "dsp/processor/filter/supersvf.h"
 
 namespace scxt::voice
 {
@@ -79,13 +80,24 @@ void Voice::voiceStarted()
 }
 
 bool Voice::process()
+{
+    if (processUpToProcessors())
+    {
+        for (auto i = 0; i < engine::processorCount; ++i)
+            processProcessor(i);
+        processAfterProcessors();
+    }
+    return true;
+}
+
+bool Voice::processUpToProcessors()
 {
     namespace mech = sst::basic_blocks::mechanics;
 
     if (!isVoicePlaying || !isVoiceAssigned || !zone)
     {
         memset(output, 0, sizeof(output));
-        return true;
+        return false;
     }
     // TODO round robin state
     auto &s = zone->samplePointers[0];
@@ -131,13 +143,15 @@ bool Voice::process()
 
     auto fpitch = calculateVoicePitch();
     calculateGeneratorRatio(fpitch);
+    selectGeneratorLevel();
+    GD.ratio = GD.ratio >> generatorLevel;
     if (useOversampling)
         GD.ratio = GD.ratio >> 1;
-    fpitch -= 69;
+    processorPitch = fpitch - 69;
 
     // TODO : Start and End Points
     GD.sampleStart = 0;
-    GD.sampleStop = s->sample_length;
+    GD.sampleStop = GDIO.waveSize;
 
     GD.gated = isGated;
     GD.loopInvertedBounds = 1.f / std::max(1, GD.loopUpperBound - GD.loopLowerBound);
@@ -160,8 +174,6 @@ bool Voice::process()
         isGeneratorRunning = false;
     }
 
-    float tempbuf alignas(16)[2][BLOCK_SIZE], postfader_buf alignas(16)[2][BLOCK_SIZE];
-
     /*
      * Alright so time to document the logic. Remember all processors are required to do
      * stereo to stereo but may optionally do mono to mono or mono to stereo. Also this is
@@ -174,7 +186,7 @@ bool Voice::process()
      * toggle
      *    if the processor cannot consume mono, copy and proceed and toggle chainIsMon
      */
-    bool chainIsMono{monoGenerator};
+    chainIsMono = monoGenerator;
 
     /*
      * Implement Sample Pan
@@ -204,51 +216,134 @@ bool Voice::process()
         sampleAmp.multiply_2_blocks(output[0], output[1]);
     }
 
-    for (auto i = 0; i < engine::processorCount; ++i)
+    return true;
+}
+
+Voice::ProcessorRouting Voice::startProcessor(int i)
+{
+    namespace mech = sst::basic_blocks::mechanics;
+
+    processorMix[i].set_target(modMatrix.getValue(modulation::vmd_Processor_Mix, i));
+
+    if (chainIsMono && processorConsumesMono[i] && !processorProducesStereo[i])
+        return ProcessorRouting::MONO_TO_MONO;
+    if (chainIsMono && processorConsumesMono[i] && processorProducesStereo[i])
+        return ProcessorRouting::MONO_TO_STEREO;
+    if (chainIsMono)
     {
-        if (processors[i])
-        {
-            processorMix[i].set_target(modMatrix.getValue(modulation::vmd_Processor_Mix, i));
+        // stereo to stereo. copy L to R then process
+        mech::copy_from_to<blockSize>(output[0], output[1]);
+        chainIsMono = false;
+    }
+    return ProcessorRouting::STEREO_TO_STEREO;
+}
 
-            if (chainIsMono && processorConsumesMono[i] && !processorProducesStereo[i])
-            {
-                // mono to mono
-                processors[i]->process_mono(output[0], tempbuf[0], tempbuf[1], fpitch);
-                processorMix[i].fade_blocks(output[0], tempbuf[0], output[0]);
-            }
-            else if (chainIsMono && processorConsumesMono[i] && processorProducesStereo[i])
-            {
-                // mono to stereo. process then toggle
-                processors[i]->process_mono(output[0], tempbuf[0], tempbuf[1], fpitch);
-                processorMix[i].fade_blocks(output[0], tempbuf[0], output[0]);
-                processorMix[i].fade_blocks(output[0], tempbuf[1], output[1]);
-                // this out[0] is NOT a typo. Input is mono
+void Voice::finishProcessor(int i, ProcessorRouting r)
+{
+    switch (r)
+    {
+    case ProcessorRouting::MONO_TO_MONO:
+        processorMix[i].fade_blocks(output[0], processorOutput[0], output[0]);
+        break;
+    case ProcessorRouting::MONO_TO_STEREO:
+        // mono to stereo. process then toggle
+        processorMix[i].fade_blocks(output[0], processorOutput[0], output[0]);
+        processorMix[i].fade_blocks(output[0], processorOutput[1], output[1]);
+        // this out[0] is NOT a typo. Input is mono
 
-                chainIsMono = false;
-            }
-            else if (chainIsMono)
-            {
-                // stereo to stereo. copy L to R then process
-                mech::copy_from_to<blockSize>(output[0], output[1]);
-                chainIsMono = false;
-                processors[i]->process_stereo(output[0], output[1], tempbuf[0], tempbuf[1], fpitch);
-                processorMix[i].fade_blocks(output[0], tempbuf[0], output[0]);
-                processorMix[i].fade_blocks(output[1], tempbuf[1], output[1]);
-            }
-            else
-            {
-                // stereo to stereo. process
-                processors[i]->process_stereo(output[0], output[1], tempbuf[0], tempbuf[1], fpitch);
-                processorMix[i].fade_blocks(output[0], tempbuf[0], output[0]);
-                processorMix[i].fade_blocks(output[1], tempbuf[1], output[1]);
-            }
-            // TODO: What was the filter_modout? Seems SC2 never finished it
-            /*
-            filter_modout[0] = voice_filter[0]->modulation_output;
-                                   */
+        chainIsMono = false;
+        break;
+    case ProcessorRouting::STEREO_TO_STEREO:
+        processorMix[i].fade_blocks(output[0], processorOutput[0], output[0]);
+        processorMix[i].fade_blocks(output[1], processorOutput[1], output[1]);
+        break;
+    }
+    // TODO: What was the filter_modout? Seems SC2 never finished it
+    /*
+    filter_modout[0] = voice_filter[0]->modulation_output;
+                           */
+}
+
+void Voice::processProcessor(int i)
+{
+    if (!processors[i])
+        return;
+
+    auto r = startProcessor(i);
+    if (r == ProcessorRouting::STEREO_TO_STEREO)
+        processors[i]->process_stereo(output[0], output[1], processorOutput[0],
+                                      processorOutput[1], processorPitch);
+    else
+        processors[i]->process_mono(output[0], processorOutput[0], processorOutput[1],
+                                    processorPitch);
+    finishProcessor(i, r);
+}
+
+/*
+ * Run processor slot i of a set of voices. Where several of them have the same
+ * filter in the slot we run it as a batch across them (see SuperSVF::processBatch);
+ * everything else runs voice by voice. Either way each voice gets what
+ * processProcessor would have given it.
+ */
+void Voice::processProcessorAcrossVoices(Voice *const *voices, size_t n, int i)
+{
+    using svf_t = dsp::processor::filter::SuperSVF;
+    static constexpr int batchSize{svf_t::maxBatchSize};
+
+    struct Batch
+    {
+        Voice *voices[batchSize];
+        ProcessorRouting routing[batchSize];
+        svf_t *filters[batchSize];
+        float *inL[batchSize], *inR[batchSize], *outL[batchSize], *outR[batchSize];
+        int count{0};
+
+        void run(int slot, bool stereo)
+        {
+            svf_t::processBatch(filters, count, stereo, inL, inR, outL, outR);
+            for (int k = 0; k < count; ++k)
+                voices[k]->finishProcessor(slot, routing[k]);
+            count = 0;
         }
+    };
+    Batch batches[svf_t::nBatchKeys];
+
+    for (size_t k = 0; k < n; ++k)
+    {
+        auto v = voices[k];
+        if (!v->processors[i])
+            continue;
+        if (v->processorType[i] != dsp::processor::proct_SuperSVF)
+        {
+            v->processProcessor(i);
+            continue;
+        }
+
+        auto r = v->startProcessor(i);
+        auto stereo = r == ProcessorRouting::STEREO_TO_STEREO;
+        auto svf = static_cast<svf_t *>(v->processors[i]);
+        auto key = svf->batchKey(stereo);
+        auto &b = batches[key];
+        b.voices[b.count] = v;
+        b.routing[b.count] = r;
+        b.filters[b.count] = svf;
+        b.inL[b.count] = v->output[0];
+        b.inR[b.count] = v->output[1];
+        b.outL[b.count] = v->processorOutput[0];
+        b.outR[b.count] = v->processorOutput[1];
+        if (++b.count == batchSize)
+            b.run(i, stereo);
     }
 
+    for (auto key = 0; key < svf_t::nBatchKeys; ++key)
+        if (batches[key].count)
+            batches[key].run(i, key & 1);
+}
+
+void Voice::processAfterProcessors()
+{
+    namespace mech = sst::basic_blocks::mechanics;
+
     /*
      * Implement output pan
      */
@@ -289,8 +384,6 @@ bool Voice::process()
         isVoicePlaying = true;
     else
         isVoicePlaying = false;
-
-    return true;
 }
 
 void Voice::panOutputsBy(bool chainIsMono, const lipol &plip)
@@ -335,6 +428,10 @@ void Voice::initializeGenerator()
     GDIO.sampleDataL = s->sampleData[0];
     GDIO.sampleDataR = s->sampleData[1];
     GDIO.waveSize = s->sample_length;
+    GDIO.loopSeam = nullptr;
+    loopSeams.reset();
+    playingSample = s.get();
+    s->markUsed();
 
     GD.samplePos = sampleData.startSample;
     GD.sampleSubPos = 0;
@@ -351,6 +448,27 @@ void Voice::initializeGenerator()
         GD.loopUpperBound = sampleData.endLoop;
     }
 
+    if (s->isRateConverted())
+    {
+        // Zone positions count frames of the file, which this sample holds converted
+        GD.samplePos = s->toStoredPosition(GD.samplePos);
+        GD.loopLowerBound = s->toStoredPosition(GD.loopLowerBound);
+        GD.loopUpperBound = s->toStoredPosition(GD.loopUpperBound);
+        GD.playbackLowerBound = s->toStoredPosition(GD.playbackLowerBound);
+        GD.playbackUpperBound = s->toStoredPosition(GD.playbackUpperBound);
+    }
+
+    if (s->isResidencyHead())
+    {
+        // Only the start of the sample is in memory, so play that much of it
+        int32_t last = std::max((int32_t)s->sample_length - 1, 0);
+        GD.playbackUpperBound = std::min(GD.playbackUpperBound, last);
+        GD.playbackLowerBound = std::min(GD.playbackLowerBound, GD.playbackUpperBound);
+        GD.loopUpperBound = std::min(GD.loopUpperBound, last);
+        GD.loopLowerBound = std::min(GD.loopLowerBound, GD.loopUpperBound);
+        GD.samplePos = std::min(GD.samplePos, last);
+    }
+
     if (sampleData.playReverse)
     {
         GD.samplePos = GD.playbackUpperBound;
@@ -358,20 +476,74 @@ void Voice::initializeGenerator()
     }
     GD.directionAtOutset = GD.direction;
 
+    sampleBounds.playbackLower = GD.playbackLowerBound;
+    sampleBounds.playbackUpper = GD.playbackUpperBound;
+    sampleBounds.loopLower = GD.loopLowerBound;
+    sampleBounds.loopUpper = GD.loopUpperBound;
+    generatorLevel = 0;
+    maxGeneratorLevel = s->getMipmapLevelCount() - 1;
+    if (sampleData.loopActive)
+    {
+        // A level's loop points land on its own frames, which detunes a loop by up to a
+        // frame a cycle. Only read levels where that is well under a cent.
+        auto loopLength = sampleBounds.loopUpper - sampleBounds.loopLower;
+        while (maxGeneratorLevel > 0 && (loopLength >> maxGeneratorLevel) < 2048)
+            maxGeneratorLevel--;
+    }
+
     calculateGeneratorRatio(calculateVoicePitch());
+    selectGeneratorLevel();
 
-    // TODO: This constant came from SC. Wonder why it is this value. There was a comment comparing
-    // with 167777216 so any speedup at all.
-    useOversampling = std::abs(GD.ratio) > 18000000;
+    // With mipmaps this only happens past the top level
+    useOversampling = std::abs(GD.ratio >> generatorLevel) > oversamplingRatio;
     GD.blockSize = blockSize * (useOversampling ? 2 : 1);
 
     Generator = nullptr;
 
     monoGenerator = s->channels == 1;
-    Generator = dsp::GetFPtrGeneratorSample(!monoGenerator, s->bitDepth == sample::Sample::BD_F32,
-                                            sampleData.loopActive,
+    generatorFormat = dsp::GSF_I16;
+    if (s->bitDepth == sample::Sample::BD_F32)
+        generatorFormat = dsp::GSF_F32;
+    else if (s->bitDepth == sample::Sample::BD_F16)
+        generatorFormat = dsp::GSF_F16;
+    auto interpolation = dsp::GSI_SINC;
+    switch (sampleData.interpolationType)
+    {
+    case engine::Zone::ZERO_ORDER_HOLD:
+        interpolation = dsp::GSI_ZERO_ORDER_HOLD;
+        break;
+    case engine::Zone::LINEAR:
+        interpolation = dsp::GSI_LINEAR;
+        break;
+    case engine::Zone::HERMITE_CUBIC:
+        interpolation = dsp::GSI_CUBIC;
+        break;
+    case engine::Zone::SINC:
+        interpolation = dsp::GSI_SINC;
+        break;
+    case engine::Zone::LONG_SINC:
+        interpolation = dsp::GSI_LONG_SINC;
+        break;
+    }
+    if (interpolation == dsp::GSI_SINC && zone->getEngine()->isRenderingOffline)
+        interpolation = dsp::GSI_LONG_SINC;
+    Generator = dsp::GetFPtrGeneratorSample(!monoGenerator, generatorFormat, sampleData.loopActive,
                                             sampleData.loopDirection == engine::Zone::FORWARD_ONLY,
-                                            sampleData.loopMode == engine::Zone::LOOP_WHILE_GATED);
+                                            sampleData.loopMode == engine::Zone::LOOP_WHILE_GATED,
+                                            interpolation);
+
+    auto &zoneSeams = zone->loopSeams[0];
+    if (sampleData.loopActive && sampleData.loopDirection == engine::Zone::FORWARD_ONLY &&
+        zoneSeams && zoneSeams->builtFor(playingSample, sampleData))
+        loopSeams = zoneSeams;
+    attachLoopSeam();
+}
+
+void Voice::attachLoopSeam()
+{
+    GDIO.loopSeam = nullptr;
+    if (loopSeams && loopSeams->levels[generatorLevel].length > 0)
+        GDIO.loopSeam = &loopSeams->levels[generatorLevel];
 }
 
 float Voice::calculateVoicePitch()
@@ -411,11 +583,56 @@ void Voice::calculateGeneratorRatio(float pitch)
     float ndiff = pitch - zone->mapping.rootKey;
     auto fac = tuning::equalTuning.note_to_pitch(ndiff);
     // TODO round robin
-    GD.ratio = (int32_t)((1 << 24) * fac * zone->samplePointers[0]->sample_rate * sampleRateInv *
-                         (1.0 + modMatrix.getValue(modulation::vmd_Sample_Playback_Ratio, 0)));
+    auto ratio = (1 << 24) * fac * zone->samplePointers[0]->sample_rate * sampleRateInv *
+                 (1.0 + modMatrix.getValue(modulation::vmd_Sample_Playback_Ratio, 0));
+    // Rounding in the rate and tuning maths shouldn't cost us the generator's unity path.
+    // Anything within a part per million (a few thousandths of a cent) is unity
+    if (std::fabs(ratio - (1 << 24)) < (1 << 24) * 1e-6)
+        ratio = 1 << 24;
+    GD.ratio = (int32_t)ratio;
 #endif
 }
 
+void Voice::selectGeneratorLevel()
+{
+    // Climb to the first level which brings the ratio under the oversampling threshold.
+    // Only come back down once the level below would play at unity or slower, so a ratio
+    // wobbling around the threshold doesn't switch levels every block.
+    auto ratio = std::abs(GD.ratio);
+    auto level = generatorLevel;
+    while (level < maxGeneratorLevel && (ratio >> level) > oversamplingRatio)
+        level++;
+    while (level > 0 && (ratio >> (level - 1)) <= (1 << 24))
+        level--;
+    if (level != generatorLevel)
+        moveToGeneratorLevel(level);
+}
+
+void Voice::moveToGeneratorLevel(int level)
+{
+    // Carry the position over exactly, as a 24 bit fraction, and round the bounds
+    int64_t pos = (int64_t)GD.samplePos * (1 << 24) + GD.sampleSubPos;
+    if (level < generatorLevel)
+        pos = pos * (1 << (generatorLevel - level));
+    else
+        pos = pos >> (level - generatorLevel);
+    GD.samplePos = (int32_t)(pos >> 24);
+    GD.sampleSubPos = (int32_t)(pos & ((1 << 24) - 1));
+
+    auto data = playingSample->getMipmapLevel(level);
+    auto toLevel = [this, level](int32_t p) { return playingSample->toMipmapPosition(p, level); };
+    GD.playbackLowerBound = toLevel(sampleBounds.playbackLower);
+    GD.playbackUpperBound = toLevel(sampleBounds.playbackUpper);
+    GD.loopLowerBound = toLevel(sampleBounds.loopLower);
+    GD.loopUpperBound = toLevel(sampleBounds.loopUpper);
+
+    GDIO.sampleDataL = data.sampleData[0];
+    GDIO.sampleDataR = data.sampleData[1];
+    GDIO.waveSize = data.sample_length;
+    generatorLevel = level;
+    attachLoopSeam();
+}
+
 void Voice::initializeProcessors()
 {
     assert(zone);
@@ -451,6 +668,13 @@ void Voice::initializeProcessors()
         {
             processors[i]->setSampleRate(sampleRate);
             processors[i]->init();
+            if (processors[i]->memoryPoolFailed)
+            {
+                // play on without it rather than allocate here
+                dsp::processor::unspawnProcessor(processors[i]);
+                processors[i] = nullptr;
+                continue;
+            }
 
             processorConsumesMono[i] = monoGenerator && processors[i]->canProcessMono();
             processorProducesStereo[i] = processors[i]->monoInputCreatesStereoOutput();
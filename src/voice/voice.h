@@ -55,11 +55,23 @@ struct alignas(16) Voice : MoveableOnly<Voice>, SampleRateSupport
     engine::Zone *zone{nullptr};
     engine::Engine *engine{nullptr};
     engine::Engine::pathToZone_t zonePath{};
+    // The sample the generator reads. The zone may swap in another version of it
+    // (see SampleManager residency) while we play, so we keep to this one.
+    const sample::Sample *playingSample{nullptr};
 
     dsp::GeneratorState GD;
     dsp::GeneratorIO GDIO;
     dsp::GeneratorFPtr Generator;
     bool monoGenerator{false};
+    dsp::GeneratorSampleFormat generatorFormat{dsp::GSF_I16};
+    /*
+     * The zone's loop seams for the sample we play, if it has them built for its
+     * current loop, which we read the level we are on from. We hold them so the zone
+     * can swap in new ones while we play; the zone or the engine holds them until no
+     * voice does, so they are never freed here.
+     */
+    std::shared_ptr<const engine::Zone::LoopSeams> loopSeams;
+    void attachLoopSeam();
 
     sst::filters::HalfRate::HalfRateFilter halfRate;
 
@@ -96,6 +108,17 @@ struct alignas(16) Voice : MoveableOnly<Voice>, SampleRateSupport
      */
     bool process();
 
+    /*
+     * process() in three steps. The zone runs each step across all its voices so that
+     * processors which can run several voices at once get to (see
+     * processProcessorAcrossVoices). If processUpToProcessors returns false the
+     * voice is silent this block; skip the other two.
+     */
+    bool processUpToProcessors();
+    void processProcessor(int i);
+    void processAfterProcessors();
+    static void processProcessorAcrossVoices(Voice *const *voices, size_t n, int i);
+
     /**
      * Voice Setup
      */
@@ -130,6 +153,19 @@ struct alignas(16) Voice : MoveableOnly<Voice>, SampleRateSupport
     bool processorConsumesMono[engine::processorCount]{false, false, false, false};
     bool processorProducesStereo[engine::processorCount]{false, false, false, false};
 
+    // Where we are in the processor chain between the steps of process()
+    enum struct ProcessorRouting
+    {
+        MONO_TO_MONO,
+        MONO_TO_STEREO,
+        STEREO_TO_STEREO
+    };
+    bool chainIsMono{false};
+    float processorPitch{0};
+    float processorOutput alignas(16)[2][blockSize];
+    ProcessorRouting startProcessor(int i);
+    void finishProcessor(int i, ProcessorRouting r);
+
     void initializeProcessors();
 
     using lipol = sst::basic_blocks::dsp::lipol_sse<blockSize, false>;
@@ -144,6 +180,22 @@ struct alignas(16) Voice : MoveableOnly<Voice>, SampleRateSupport
      * Voice State on Creation
      */
     bool useOversampling{false};
+    // TODO: This constant came from SC. Wonder why it is this value. There was a comment comparing
+    // with 167777216 so any speedup at all.
+    static constexpr int32_t oversamplingRatio{18000000};
+
+    /*
+     * Octave mipmaps (see Sample::buildMipmaps). The generator reads level generatorLevel
+     * of playingSample, so GD's positions and bounds count that level's frames. We keep
+     * the bounds in the sample's own frames to derive each level's from as we move.
+     */
+    int generatorLevel{0}, maxGeneratorLevel{0};
+    struct
+    {
+        int32_t playbackLower{0}, playbackUpper{0}, loopLower{0}, loopUpper{0};
+    } sampleBounds;
+    void selectGeneratorLevel();
+    void moveToGeneratorLevel(int level);
 
     /*
      * Voice Playback State Model.
@@ -169,8 +221,11 @@ struct alignas(16) Voice : MoveableOnly<Voice>, SampleRateSupport
     void release() { isGated = false; }
     void cleanupVoice()
     {
+        loopSeams.reset();
+        GDIO.loopSeam = nullptr;
         zone->removeVoice(this);
         zone = nullptr;
+        playingSample = nullptr;
         isVoiceAssigned = false;
     }
 };
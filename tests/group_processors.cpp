@@ -0,0 +1,122 @@
+/*
+ * Shortcircuit XT - a Surge Synth Team product
+ *
+ * A fully featured creative sampler, available as a standalone
+ * and plugin for multiple platforms.
+ *
+ * Copyright 2019 - 2023, Various authors, as described in the github
+ * transaction log.
+ *
+ * ShortcircuitXT is released under the Gnu General Public Licence
+ * V3 or later (GPL-3.0-or-later). The license is found in the file
+ * "LICENSE" in the root of this repository or at
+ * https://www.gnu.org/licenses/gpl-3.0.en.html
+ *
+ * Individual sections of code which comprises ShortcircuitXT in this
+ * repository may also be used under an MIT license. Please see the
+ * section  "Licensing" in "README.md" for details.
+ *
+ * ShortcircuitXT is inspired by, and shares code with, the
+ * commercial product Shortcircuit 1 and 2, released by VemberTech
+ * in the mid 2000s. The code for Shortcircuit 2 was opensourced in
+ * 2020 at the outset of this project.
+ *
+ * All source for ShortcircuitXT is available at
+ * https://github.com/surge-synthesizer/shortcircuit-xt
+ */
+
+#include "catch2/catch2.hpp"
+#include "engine/engine.h"
+#include "engine/patch.h"
+#include "json/engine_traits.h"
+#include "json/stream.h"
+
+#include <cmath>
+
+using namespace scxt;
+
+namespace
+{
+// A new group at the end of part 0 with a filter in its first processor slot
+size_t addFilteredGroup(engine::Engine &e)
+{
+    const auto &part = e.getPatch()->getPart(0);
+    auto idx = part->addGroup() - 1;
+    part->getGroup(idx)->setProcessorType(0, dsp::processor::proct_SuperSVF);
+    return idx;
+}
+} // namespace
+
+TEST_CASE("Group Processors Respawn After Unstreaming")
+{
+    engine::Engine e;
+    e.prepareToPlay(48000);
+    auto idx = addFilteredGroup(e);
+    REQUIRE(e.getPatch()->getPart(0)->getGroup(idx)->processors[0]);
+
+    auto state = json::streamPatch(*e.getPatch());
+    tao::json::events::transformer<tao::json::events::to_basic_value<json::scxt_traits>> consumer;
+    tao::json::events::from_string(consumer, state);
+    consumer.value.to(*e.getPatch());
+
+    // Unstreaming restores the storage; the processor waits for the patch to go live
+    const auto &g = e.getPatch()->getPart(0)->getGroup(idx);
+    REQUIRE(g->processorStorage[0].type == dsp::processor::proct_SuperSVF);
+    REQUIRE(!g->processors[0]);
+
+    e.getPatch()->respawnGroupProcessors();
+    REQUIRE(g->processors[0]);
+    REQUIRE(g->processors[0]->getType() == dsp::processor::proct_SuperSVF);
+    REQUIRE(!g->processors[1]);
+}
+
+TEST_CASE("Group Processors Ring Out After The Last Zone")
+{
+    engine::Engine e;
+    e.prepareToPlay(48000);
+    const auto &part = e.getPatch()->getPart(0);
+    const auto &g = part->getGroup(addFilteredGroup(e));
+
+    SECTION("Rings Out Then Goes Idle")
+    {
+        g->addActiveZone();
+        g->removeActiveZone();
+        REQUIRE(g->isRingingOut());
+        REQUIRE(g->isActive());
+        REQUIRE(part->isActive());
+
+        // Nothing is playing into the filter so it is silent from the start
+        auto silentBlocks = (int)std::ceil(engine::Group::ringOutSilentSeconds * 48000 /
+                                           blockSize);
+        int blocks{0};
+        while (g->isActive() && blocks < 4 * silentBlocks)
+        {
+            g->process(e);
+            blocks++;
+        }
+        REQUIRE(blocks == silentBlocks);
+        REQUIRE(!g->isActive());
+        REQUIRE(!part->isActive());
+    }
+
+    SECTION("A New Zone Picks Up A Ringing Group")
+    {
+        g->addActiveZone();
+        g->removeActiveZone();
+        g->addActiveZone();
+        REQUIRE(!g->isRingingOut());
+        REQUIRE(part->activeGroups == 1);
+        g->removeActiveZone();
+        g->stopRingingOut();
+        REQUIRE(!part->isActive());
+    }
+
+    SECTION("Without Active Processors There Is No Tail")
+    {
+        g->processorStorage[0].isActive = false;
+        g->addActiveZone();
+        g->removeActiveZone();
+        REQUIRE(!g->isActive());
+        REQUIRE(!part->isActive());
+    }
+}
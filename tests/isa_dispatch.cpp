@@ -0,0 +1,199 @@
+/*
+ * Shortcircuit XT - a Surge Synth Team product
+ *
+ * A fully featured creative sampler, available as a standalone
+ * and plugin for multiple platforms.
+ *
+ * Copyright 2019 - 2023, Various authors, as described in the github
+ * transaction log.
+ *
+ * ShortcircuitXT is released under the Gnu General Public Licence
+ * V3 or later (GPL-3.0-or-later). The license is found in the file
+ * "LICENSE" in the root of this repository or at
+ * https://www.gnu.org/licenses/gpl-3.0.en.html
+ *
+ * Individual sections of code which comprises ShortcircuitXT in this
+ * repository may also be used under an MIT license. Please see the
+ * section  "Licensing" in "README.md" for details.
+ *
+ * ShortcircuitXT is inspired by, and shares code with, the
+ * commercial product Shortcircuit 1 and 2, released by VemberTech
+ * in the mid 2000s. The code for Shortcircuit 2 was opensourced in
+ * 2020 at the outset of this project.
+ *
+ * All source for ShortcircuitXT is available at
+ * https://github.com/surge-synthesizer/shortcircuit-xt
+ */
+
+
+#include "catch2/catch2.hpp"
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "infrastructure/cpu_isa.h"
+#include "infrastructure/half_float.h"
+#include "dsp/generator.h"
+#include "dsp/block_mix.h"
+#include "dsp/resampling.h"
+
+using namespace scxt;
+using infrastructure::Isa;
+
+namespace
+{
+struct StereoSource
+{
+    static constexpr int frames{4096};
+    std::vector<float> f32[2];
+    std::vector<uint16_t> f16[2];
+    std::vector<int16_t> i16[2];
+
+    StereoSource()
+    {
+        std::mt19937 gen(46);
+        std::uniform_real_distribution<float> dist(-1.f, 1.f);
+        for (int c = 0; c < 2; ++c)
+        {
+            // frame f lives at f + FIRoffset, with FIRipol_N frames of padding in all
+            f32[c].assign(frames + dsp::FIRipol_N, 0.f);
+            f16[c].assign(frames + dsp::FIRipol_N, 0);
+            i16[c].assign(frames + dsp::FIRipol_N, 0);
+            for (int i = 0; i < frames; ++i)
+            {
+                auto v = dist(gen);
+                f32[c][i + dsp::FIRoffset] = v;
+                f16[c][i + dsp::FIRoffset] = infrastructure::floatToHalf(v);
+                i16[c][i + dsp::FIRoffset] = (int16_t)(v * 32000);
+            }
+        }
+    }
+
+    void *data(dsp::GeneratorSampleFormat format, int c)
+    {
+        switch (format)
+        {
+        case dsp::GSF_I16:
+            return i16[c].data();
+        case dsp::GSF_F16:
+            return f16[c].data();
+        default:
+            return f32[c].data();
+        }
+    }
+};
+
+std::vector<float> render(StereoSource &src, dsp::GeneratorSampleFormat format, bool stereo,
+                          bool loopActive, bool loopForward, int32_t ratio, int blocks)
+{
+    auto fn = dsp::GetFPtrGeneratorSample(stereo, format, loopActive, loopForward, false,
+                                          dsp::GSI_SINC);
+    dsp::GeneratorState gs;
+    gs.direction = 1;
+    gs.ratio = ratio;
+    gs.isFinished = false;
+    gs.samplePos = 100;
+    gs.playbackUpperBound = StereoSource::frames - 1;
+    gs.loopLowerBound = 1000;
+    gs.loopUpperBound = 3000;
+
+    dsp::GeneratorIO io;
+    io.waveSize = StereoSource::frames;
+    io.sampleDataL = src.data(format, 0);
+    io.sampleDataR = src.data(format, 1);
+
+    std::vector<float> res;
+    float out[2][blockSize];
+    io.outputL = out[0];
+    io.outputR = out[1];
+    for (int b = 0; b < blocks; ++b)
+    {
+        fn(&gs, &io);
+        res.insert(res.end(), out[0], out[0] + blockSize);
+        if (stereo)
+            res.insert(res.end(), out[1], out[1] + blockSize);
+    }
+    return res;
+}
+} // namespace
+
+TEST_CASE("Generator ISA Variants Match")
+{
+    if (!infrastructure::isIsaAvailable(Isa::AVX2))
+        return;
+
+    StereoSource src;
+    for (auto format : {dsp::GSF_I16, dsp::GSF_F32, dsp::GSF_F16})
+    {
+        for (auto [loopActive, loopForward] : {std::pair{false, true}, {true, true}, {true, false}})
+        {
+            for (auto ratio : {(1 << 24) + 1, 17893211, 9731234, 41234567})
+            {
+                for (auto stereo : {false, true})
+                {
+                    INFO("format " << format << " loop " << loopActive << loopForward
+                                   << " ratio " << ratio << " stereo " << stereo);
+                    REQUIRE(infrastructure::forceIsa(Isa::SSE2));
+                    auto ref = render(src, format, stereo, loopActive, loopForward, ratio, 200);
+                    REQUIRE(infrastructure::forceIsa(Isa::AVX2));
+                    auto res = render(src, format, stereo, loopActive, loopForward, ratio, 200);
+                    REQUIRE(ref.size() == res.size());
+                    REQUIRE(memcmp(ref.data(), res.data(), ref.size() * sizeof(float)) == 0);
+                }
+            }
+        }
+    }
+    infrastructure::clearForcedIsa();
+}
+
+TEST_CASE("Block Mix ISA Variants Match")
+{
+    std::mt19937 gen(2);
+    std::uniform_real_distribution<float> dist(-2.f, 2.f);
+    float src alignas(16)[2][blockSize], dst alignas(16)[2][blockSize];
+    for (auto &c : src)
+        for (auto &v : c)
+            v = dist(gen);
+    for (auto &c : dst)
+        for (auto &v : c)
+            v = dist(gen);
+
+    auto run = [&](Isa isa, float res[3][2][blockSize], float absMax[2]) {
+        const auto &mix = dsp::blockMix(isa);
+        memcpy(res[0], dst, sizeof(dst));
+        mix.accumulate(src[0], src[1], res[0][0], res[0][1]);
+        memcpy(res[1], dst, sizeof(dst));
+        mix.scaleAccumulate(src[0], src[1], 0.3173f, res[1][0], res[1][1]);
+        memcpy(res[2], dst, sizeof(dst));
+        mix.scale(1.7311f, res[2][0], res[2][1]);
+        absMax[0] = mix.absMax(src[0]);
+        absMax[1] = mix.absMax(src[1]);
+    };
+
+    float ref[3][2][blockSize], refMax[2];
+    run(Isa::SCALAR, ref, refMax);
+    for (auto isa : {Isa::SSE2, Isa::AVX2})
+    {
+        if (!infrastructure::isIsaAvailable(isa))
+            continue;
+        INFO("isa " << infrastructure::isaName(isa));
+        float res[3][2][blockSize], resMax[2];
+        run(isa, res, resMax);
+        REQUIRE(memcmp(ref, res, sizeof(ref)) == 0);
+        REQUIRE(memcmp(refMax, resMax, sizeof(refMax)) == 0);
+    }
+}
+
+TEST_CASE("Forcing An ISA")
+{
+    REQUIRE(infrastructure::forceIsa(Isa::SCALAR));
+    REQUIRE(infrastructure::activeIsa() == Isa::SCALAR);
+    if (!infrastructure::isIsaAvailable(Isa::AVX2))
+    {
+        REQUIRE(!infrastructure::forceIsa(Isa::AVX2));
+        REQUIRE(infrastructure::activeIsa() == Isa::SCALAR);
+    }
+    infrastructure::clearForcedIsa();
+    REQUIRE(infrastructure::activeIsa() == infrastructure::bestAvailableIsa());
+}
@@ -0,0 +1,152 @@
+/*
+ * Shortcircuit XT - a Surge Synth Team product
+ *
+ * A fully featured creative sampler, available as a standalone
+ * and plugin for multiple platforms.
+ *
+ * Copyright 2019 - 2023, Various authors, as described in the github
+ * transaction log.
+ *
+ * ShortcircuitXT is released under the Gnu General Public Licence
+ * V3 or later (GPL-3.0-or-later). The license is found in the file
+ * "LICENSE" in the root of this repository or at
+ * https://www.gnu.org/licenses/gpl-3.0.en.html
+ *
+ * Individual sections of code which comprises ShortcircuitXT in this
+ * repository may also be used under an MIT license. Please see the
+ * section  "Licensing" in "README.md" for details.
+ *
+ * ShortcircuitXT is inspired by, and shares code with, the
+ * commercial product Shortcircuit 1 and 2, released by VemberTech
+ * in the mid 2000s. The code for Shortcircuit 2 was opensourced in
+ * 2020 at the outset of this project.
+ *
+ * All source for ShortcircuitXT is available at
+ * https://github.com/surge-synthesizer/shortcircuit-xt
+ */
+
+
+#include "catch2/catch2.hpp"
+#include "engine/memory_pool.h"
+
+#include <thread>
+#include <vector>
+
+using scxt::engine::MemoryPool;
+
+TEST_CASE("Memory Pool Size Classes")
+{
+    REQUIRE(MemoryPool::sizeClassFor(1) == 0);
+    REQUIRE(MemoryPool::sizeClassFor(1024) == 0);
+    REQUIRE(MemoryPool::sizeClassFor(1025) == 1);
+    REQUIRE(MemoryPool::sizeClassFor(MemoryPool::sizeClassBytes(MemoryPool::nSizeClasses - 1)) ==
+            MemoryPool::nSizeClasses - 1);
+    REQUIRE(MemoryPool::sizeClassFor(MemoryPool::sizeClassBytes(MemoryPool::nSizeClasses - 1) +
+                                     1) == MemoryPool::nSizeClasses);
+}
+
+TEST_CASE("Memory Pool Reserve, Checkout and Refill")
+{
+    MemoryPool pool;
+    auto sc = MemoryPool::sizeClassFor(3000);
+    pool.reserve(3000, 2);
+    REQUIRE(pool.getStats(sc).free == 2);
+
+    // The third finds the class empty and gets nothing rather than an allocation
+    std::vector<MemoryPool::data_t *> blocks;
+    for (int i = 0; i < 3; ++i)
+        blocks.push_back(pool.checkoutBlock(3000));
+    REQUIRE(blocks[0]);
+    REQUIRE(blocks[1]);
+    REQUIRE(!blocks[2]);
+    auto st = pool.getStats(sc);
+    REQUIRE(st.blockSize == 4096);
+    REQUIRE(st.free == 0);
+    REQUIRE(st.checkedOut == 2);
+    REQUIRE(st.highWater == 2);
+    REQUIRE(st.failures == 1);
+
+    for (auto b : blocks)
+        pool.returnBlock(b, 3000);
+    st = pool.getStats(sc);
+    REQUIRE(st.free == 2);
+    REQUIRE(st.checkedOut == 0);
+
+    // The miss grows the spare count, so the same burst then fits
+    pool.refill();
+    REQUIRE(pool.getStats(sc).free == 3);
+    for (auto &b : blocks)
+    {
+        b = pool.checkoutBlock(3000);
+        REQUIRE(b);
+    }
+    REQUIRE(pool.getStats(sc).failures == 1);
+    for (auto b : blocks)
+        pool.returnBlock(b, 3000);
+
+    auto big = MemoryPool::sizeClassBytes(MemoryPool::nSizeClasses - 1) + 1;
+    REQUIRE(!pool.checkoutBlock(big));
+    REQUIRE(pool.getOversizedRequests() == 1);
+}
+
+TEST_CASE("Memory Pool Returns From Another Thread")
+{
+    MemoryPool pool;
+    pool.reserve(1024, 64);
+    std::vector<MemoryPool::data_t *> out;
+    for (int round = 0; round < 100; ++round)
+    {
+        for (int i = 0; i < 32; ++i)
+            out.push_back(pool.checkoutBlock(1024));
+        std::thread returner([&pool, give = out]() {
+            for (auto b : give)
+                pool.returnBlock(b, 1024);
+        });
+        out.clear();
+        for (int i = 0; i < 16; ++i)
+            out.push_back(pool.checkoutBlock(1024));
+        returner.join();
+        for (auto b : out)
+            pool.returnBlock(b, 1024);
+        out.clear();
+    }
+    auto st = pool.getStats(0);
+    // at most 48 are ever out, so the 64 reserved always cover it
+    REQUIRE(st.checkedOut == 0);
+    REQUIRE(st.failures == 0);
+    REQUIRE(st.free == 64);
+}
+
+TEST_CASE("Memory Pool Probe and Added Blocks")
+{
+    // A probing pool allocates when dry, and its high water is what a spawn needs
+    MemoryPool probe(true);
+    auto sc = MemoryPool::sizeClassFor(70000);
+    auto a = probe.checkoutBlock(70000);
+    auto b = probe.checkoutBlock(70000);
+    REQUIRE(a);
+    REQUIRE(b);
+    probe.returnBlock(a, 70000);
+    probe.returnBlock(b, 70000);
+    auto st = probe.getStats(sc);
+    REQUIRE(st.highWater == 2);
+    REQUIRE(st.failures == 0);
+    REQUIRE(st.free == 2);
+
+    // Added blocks are on top of what is there, and refill leaves them be
+    MemoryPool pool;
+    pool.reserve(70000, 1);
+    pool.addBlocks(70000, 3);
+    REQUIRE(pool.getStats(sc).free == 4);
+    pool.refill();
+    REQUIRE(pool.getStats(sc).free == 4);
+    std::vector<MemoryPool::data_t *> blocks;
+    for (int i = 0; i < 4; ++i)
+        blocks.push_back(pool.checkoutBlock(70000));
+    for (auto bl : blocks)
+    {
+        REQUIRE(bl);
+        pool.returnBlock(bl, 70000);
+    }
+    REQUIRE(pool.getStats(sc).failures == 0);
+}
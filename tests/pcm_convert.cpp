@@ -0,0 +1,211 @@
+/*
+ * Shortcircuit XT - a Surge Synth Team product
+ *
+ * A fully featured creative sampler, available as a standalone
+ * and plugin for multiple platforms.
+ *
+ * Copyright 2019 - 2023, Various authors, as described in the github
+ * transaction log.
+ *
+ * ShortcircuitXT is released under the Gnu General Public Licence
+ * V3 or later (GPL-3.0-or-later). The license is found in the file
+ * "LICENSE" in the root of this repository or at
+ * https://www.gnu.org/licenses/gpl-3.0.en.html
+ *
+ * Individual sections of code which comprises ShortcircuitXT in this
+ * repository may also be used under an MIT license. Please see the
+ * section  "Licensing" in "README.md" for details.
+ *
+ * ShortcircuitXT is inspired by, and shares code with, the
+ * commercial product Shortcircuit 1 and 2, released by VemberTech
+ * in the mid 2000s. The code for Shortcircuit 2 was opensourced in
+ * 2020 at the outset of this project.
+ *
+ * All source for ShortcircuitXT is available at
+ * https://github.com/surge-synthesizer/shortcircuit-xt
+ */
+
+
+#include "catch2/catch2.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "sample/pcm_convert.h"
+#include "sample/sample.h"
+#include "infrastructure/half_float.h"
+
+using namespace scxt::sample;
+
+namespace
+{
+std::vector<uint8_t> randomSource(pcm::Format f, size_t frames, int channels, uint32_t seed)
+{
+    std::mt19937 gen(seed);
+    std::vector<uint8_t> res(frames * channels * pcm::bytesPerSample(f));
+    if (f == pcm::Format::F32LE || f == pcm::Format::F64LE)
+    {
+        // Keep the float formats away from NaN, whose payload bits are not ours to compare
+        std::uniform_real_distribution<double> dist(-1.5, 1.5);
+        for (size_t i = 0; i < frames * channels; ++i)
+        {
+            if (f == pcm::Format::F32LE)
+            {
+                float v = (float)dist(gen);
+                memcpy(res.data() + i * 4, &v, 4);
+            }
+            else
+            {
+                double v = dist(gen);
+                memcpy(res.data() + i * 8, &v, 8);
+            }
+        }
+    }
+    else
+    {
+        for (auto &b : res)
+            b = (uint8_t)gen();
+    }
+    return res;
+}
+
+struct Converted
+{
+    std::vector<uint8_t> data[2];
+};
+
+Converted run(pcm::Format f, const std::vector<uint8_t> &src, size_t frames, int channels,
+              pcm::Isa isa)
+{
+    Converted res;
+    void *dest[2]{nullptr, nullptr};
+    auto outBytes = pcm::convertsToFloat(f) ? sizeof(float) : sizeof(int16_t);
+    for (int c = 0; c < channels; ++c)
+    {
+        res.data[c].resize(frames * outBytes + 1);
+        dest[c] = res.data[c].data();
+    }
+    pcm::convert(f, src.data(), frames, channels, dest, isa);
+    return res;
+}
+
+const std::vector<pcm::Format> allFormats{
+    pcm::Format::UI8,   pcm::Format::I8,    pcm::Format::I16LE, pcm::Format::I16BE,
+    pcm::Format::I24LE, pcm::Format::I24BE, pcm::Format::I32LE, pcm::Format::I32BE,
+    pcm::Format::F32LE, pcm::Format::F64LE};
+} // namespace
+
+TEST_CASE("PCM Conversion Kernels Match Scalar")
+{
+    for (auto isa : {pcm::Isa::SSE2, pcm::Isa::AVX2})
+    {
+        if (!pcm::isIsaAvailable(isa))
+            continue;
+
+        for (auto f : allFormats)
+        {
+            for (int channels = 1; channels <= 2; ++channels)
+            {
+                // lengths around every block size, including the tails
+                for (size_t frames : {0, 1, 3, 4, 7, 8, 9, 15, 16, 17, 31, 33, 63, 65, 1027})
+                {
+                    INFO("isa=" << (int)isa << " format=" << (int)f << " channels=" << channels
+                                << " frames=" << frames);
+                    auto src = randomSource(f, frames, channels, (uint32_t)(frames * 31 + (int)f));
+                    auto ref = run(f, src, frames, channels, pcm::Isa::SCALAR);
+                    auto vec = run(f, src, frames, channels, isa);
+                    for (int c = 0; c < channels; ++c)
+                        REQUIRE(ref.data[c] == vec.data[c]);
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("PCM Scalar Conversion Matches Sample Loaders")
+{
+    using loader_t = bool (Sample::*)(int, void *, unsigned int, unsigned int);
+    std::vector<std::pair<pcm::Format, loader_t>> pairs{
+        {pcm::Format::UI8, &Sample::load_data_ui8},
+        {pcm::Format::I8, &Sample::load_data_i8},
+        {pcm::Format::I16LE, &Sample::load_data_i16},
+        {pcm::Format::I16BE, &Sample::load_data_i16BE},
+        {pcm::Format::I24LE, &Sample::load_data_i24},
+        {pcm::Format::I24BE, &Sample::load_data_i24BE},
+        {pcm::Format::I32LE, &Sample::load_data_i32},
+        {pcm::Format::I32BE, &Sample::load_data_i32BE},
+        {pcm::Format::F32LE, &Sample::load_data_f32},
+        {pcm::Format::F64LE, &Sample::load_data_f64}};
+
+    const size_t frames{517};
+    for (auto &[f, loader] : pairs)
+    {
+        for (int channels = 1; channels <= 2; ++channels)
+        {
+            INFO("format=" << (int)f << " channels=" << channels);
+            auto bps = pcm::bytesPerSample(f);
+            auto src = randomSource(f, frames, channels, 8675309);
+
+            Sample s;
+            for (int c = 0; c < channels; ++c)
+                (s.*loader)(c, src.data() + c * bps, frames, bps * channels);
+
+            auto ref = run(f, src, frames, channels, pcm::Isa::SCALAR);
+            for (int c = 0; c < channels; ++c)
+            {
+                const void *legacy = pcm::convertsToFloat(f) ? (const void *)s.GetSamplePtrF32(c)
+                                                             : (const void *)s.GetSamplePtrI16(c);
+                auto outBytes = pcm::convertsToFloat(f) ? sizeof(float) : sizeof(int16_t);
+                REQUIRE(memcmp(legacy, ref.data[c].data(), frames * outBytes) == 0);
+            }
+        }
+    }
+}
+
+TEST_CASE("Half Float Conversion")
+{
+    SECTION("Vector Widening Matches Scalar For Every Half")
+    {
+        for (uint32_t i = 0; i < 65536; i += 4)
+        {
+            uint16_t h[4];
+            for (int k = 0; k < 4; ++k)
+                h[k] = (uint16_t)(i + k);
+            float v[4];
+            _mm_storeu_ps(v, scxt::infrastructure::halfToFloat4(h));
+            for (int k = 0; k < 4; ++k)
+            {
+                INFO("half=" << h[k]);
+                auto f = scxt::infrastructure::halfToFloat(h[k]);
+                REQUIRE(memcmp(&f, &v[k], sizeof(float)) == 0);
+                if (std::isnan(f))
+                    continue;
+                REQUIRE(scxt::infrastructure::floatToHalf(f) == h[k]);
+            }
+        }
+    }
+
+    SECTION("Narrowing Matches Across ISAs")
+    {
+        std::mt19937 gen(2112);
+        // a spread of magnitudes covering the subnormal, normal and overflow cases
+        std::uniform_real_distribution<float> mant(-1.f, 1.f);
+        std::uniform_int_distribution<int> ex(-30, 18);
+        std::vector<float> src(4099);
+        for (auto &f : src)
+            f = std::ldexp(mant(gen), ex(gen));
+
+        std::vector<uint16_t> ref(src.size());
+        pcm::floatToHalf(src.data(), ref.data(), src.size(), pcm::Isa::SCALAR);
+        for (auto isa : {pcm::Isa::SSE2, pcm::Isa::AVX2})
+        {
+            if (!pcm::isIsaAvailable(isa))
+                continue;
+            std::vector<uint16_t> res(src.size());
+            pcm::floatToHalf(src.data(), res.data(), src.size(), isa);
+            REQUIRE(res == ref);
+        }
+    }
+}
@@ -0,0 +1,120 @@
+/*
+ * Shortcircuit XT - a Surge Synth Team product
+ *
+ * A fully featured creative sampler, available as a standalone
+ * and plugin for multiple platforms.
+ *
+ * Copyright 2019 - 2023, Various authors, as described in the github
+ * transaction log.
+ *
+ * ShortcircuitXT is released under the Gnu General Public Licence
+ * V3 or later (GPL-3.0-or-later). The license is found in the file
+ * "LICENSE" in the root of this repository or at
+ * https://www.gnu.org/licenses/gpl-3.0.en.html
+ *
+ * Individual sections of code which comprises ShortcircuitXT in this
+ * repository may also be used under an MIT license. Please see the
+ * section  "Licensing" in "README.md" for details.
+ *
+ * ShortcircuitXT is inspired by, and shares code with, the
+ * commercial product Shortcircuit 1 and 2, released by VemberTech
+ * in the mid 2000s. The code for Shortcircuit 2 was opensourced in
+ * 2020 at the outset of this project.
+ *
+ * All source for ShortcircuitXT is available at
+ * https://github.com/surge-synthesizer/shortcircuit-xt
+ */
+
+
+#include "catch2/catch2.hpp"
+#include "dsp/processor/filter/supersvf.h"
+#include "tuning/equal.h"
+
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+using scxt::dsp::processor::filter::SuperSVF;
+
+TEST_CASE("SuperSVF Batch Matches Lone Filters")
+{
+    scxt::tuning::equalTuning.init();
+    std::mt19937 gen(5);
+    std::uniform_real_distribution<float> dist(-1, 1);
+    static constexpr int nVoices{7}, bs{scxt::blockSize};
+
+    for (int mode = 0; mode < 3; ++mode)
+    {
+        DYNAMIC_SECTION("Mode " << mode)
+        {
+            float params[2][nVoices][scxt::dsp::processor::maxProcessorFloatParams];
+            int iparams[2][nVoices][scxt::dsp::processor::maxProcessorIntParams];
+            std::vector<std::unique_ptr<SuperSVF>> lone, batched;
+            for (int v = 0; v < nVoices; ++v)
+            {
+                lone.emplace_back(new SuperSVF(nullptr, params[0][v], iparams[0][v]));
+                batched.emplace_back(new SuperSVF(nullptr, params[1][v], iparams[1][v]));
+                for (auto &f : {lone[v].get(), batched[v].get()})
+                {
+                    f->setSampleRate(48000);
+                    f->init_params();
+                    f->iparam[0] = mode;
+                }
+            }
+
+            // Switching between stereo and mono and between two and four pole wakes the
+            // lanes a batch skips while they're at rest
+            int mismatches{0};
+            for (int block = 0; block < 400; ++block)
+            {
+                bool stereo = (block / 37) % 2 == 0;
+                for (int v = 0; v < nVoices; ++v)
+                {
+                    iparams[0][v][1] = iparams[1][v][1] = (block / 53) % 2;
+                    if (block % 5 == 0)
+                    {
+                        params[0][v][0] = params[1][v][0] = dist(gen) * 3;
+                        params[0][v][1] = params[1][v][1] = (dist(gen) + 1) * 0.5f;
+                    }
+                }
+
+                float in alignas(16)[nVoices][2][bs];
+                float out alignas(16)[2][nVoices][2][bs];
+                for (auto &v : in)
+                    for (auto &c : v)
+                        for (auto &s : c)
+                            s = dist(gen);
+                memset(out, 0, sizeof(out));
+
+                for (int v = 0; v < nVoices; ++v)
+                {
+                    auto &o = out[0][v];
+                    if (stereo)
+                        lone[v]->process_stereo(in[v][0], in[v][1], o[0], o[1], 0);
+                    else
+                        lone[v]->process_mono(in[v][0], o[0], o[1], 0);
+                }
+                for (int v0 = 0; v0 < nVoices; v0 += SuperSVF::maxBatchSize)
+                {
+                    auto n = std::min(SuperSVF::maxBatchSize, nVoices - v0);
+                    SuperSVF *f[SuperSVF::maxBatchSize];
+                    float *inL[SuperSVF::maxBatchSize], *inR[SuperSVF::maxBatchSize];
+                    float *outL[SuperSVF::maxBatchSize], *outR[SuperSVF::maxBatchSize];
+                    for (int k = 0; k < n; ++k)
+                    {
+                        f[k] = batched[v0 + k].get();
+                        inL[k] = in[v0 + k][0];
+                        inR[k] = in[v0 + k][1];
+                        outL[k] = out[1][v0 + k][0];
+                        outR[k] = out[1][v0 + k][1];
+                    }
+                    SuperSVF::processBatch(f, n, stereo, inL, inR, outL, outR);
+                }
+                if (memcmp(out[0], out[1], sizeof(out[0])) != 0)
+                    mismatches++;
+            }
+            REQUIRE(mismatches == 0);
+        }
+    }
+}